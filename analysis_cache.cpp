@@ -0,0 +1,300 @@
+#include "analysis_cache.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <sys/stat.h>
+#if defined(_WIN32)
+#include <direct.h>
+#endif
+
+//----------------------------------------------------//
+//        Hashing (xxHash64-style, four lanes)
+//----------------------------------------------------//
+
+static const uint64_t kPrime1 = 11400714785074694791ull;
+static const uint64_t kPrime2 = 14029467366897019727ull;
+static const uint64_t kPrime3 = 1609587929392839161ull;
+static const uint64_t kPrime4 = 9650029242287828579ull;
+static const uint64_t kPrime5 = 2870177450012600261ull;
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const unsigned char* p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t hashRound(uint64_t acc, uint64_t input)
+{
+    acc += input * kPrime2;
+    acc = rotl64(acc, 31);
+    return acc * kPrime1;
+}
+
+static inline uint64_t mergeRound(uint64_t acc, uint64_t val)
+{
+    acc ^= hashRound(0, val);
+    return acc * kPrime1 + kPrime4;
+}
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + size;
+    uint64_t h;
+
+    if (size >= 32) {
+        uint64_t v1 = seed + kPrime1 + kPrime2;
+        uint64_t v2 = seed + kPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - kPrime1;
+        const unsigned char* limit = end - 32;
+        do {
+            v1 = hashRound(v1, read64(p));
+            v2 = hashRound(v2, read64(p + 8));
+            v3 = hashRound(v3, read64(p + 16));
+            v4 = hashRound(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    }
+    else {
+        h = seed + kPrime5;
+    }
+    h += static_cast<uint64_t>(size);
+
+    while (p + 8 <= end) {
+        h ^= hashRound(0, read64(p));
+        h = rotl64(h, 27) * kPrime1 + kPrime4;
+        p += 8;
+    }
+    while (p < end) {
+        h ^= (*p) * kPrime5;
+        h = rotl64(h, 11) * kPrime1;
+        ++p;
+    }
+
+    // Final avalanche
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+bool hashFile(const std::string& path, uint64_t& hash)
+{
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        std::cerr << "Failed to open file for hashing: " << path << "\n";
+        return false;
+    }
+
+    // Hash 1 MB blocks and chain the block hashes
+    std::vector<unsigned char> buffer(1 << 20);
+    hash = 0;
+    size_t got;
+    while ((got = std::fread(buffer.data(), 1, buffer.size(), f)) > 0) {
+        uint64_t block = hashBytes(buffer.data(), got, hash);
+        hash = hashBytes(&block, sizeof(block), hash);
+    }
+    bool ok = !std::ferror(f);
+    std::fclose(f);
+    return ok;
+}
+
+//----------------------------------------------------//
+//                 File System Helpers
+//----------------------------------------------------//
+
+static bool statFile(const std::string& path, uint64_t& size, int64_t& mtime)
+{
+#if defined(_WIN32)
+    struct _stat64 st;
+    if (_stat64(path.c_str(), &st) != 0) {
+        return false;
+    }
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+#endif
+    size = static_cast<uint64_t>(st.st_size);
+    mtime = static_cast<int64_t>(st.st_mtime);
+    return true;
+}
+
+static void makeDirectory(const std::string& dir)
+{
+#if defined(_WIN32)
+    _mkdir(dir.c_str());
+#else
+    mkdir(dir.c_str(), 0755);
+#endif
+}
+
+static std::string toHex(uint64_t v)
+{
+    std::ostringstream oss;
+    oss << std::hex;
+    oss.width(16);
+    oss.fill('0');
+    oss << v;
+    return oss.str();
+}
+
+//----------------------------------------------------//
+//             AnalysisCache Implementation
+//----------------------------------------------------//
+
+AnalysisCache::AnalysisCache(const std::string& dir)
+    : m_dir(dir)
+{
+    makeDirectory(m_dir); // fine if it already exists
+    loadIndex();
+}
+
+AnalysisCache::~AnalysisCache()
+{
+    saveIndex();
+}
+
+void AnalysisCache::loadIndex()
+{
+    std::ifstream ifs(m_dir + "/index.txt");
+    if (!ifs.is_open()) {
+        return; // fresh cache
+    }
+
+    // "size mtime hash path" (path last, it may contain spaces)
+    std::string line;
+    while (std::getline(ifs, line)) {
+        std::istringstream iss(line);
+        IndexEntry e;
+        std::string hex, path;
+        if (!(iss >> e.size >> e.mtime >> hex)) {
+            continue;
+        }
+        std::getline(iss >> std::ws, path);
+        try {
+            e.hash = std::stoull(hex, nullptr, 16);
+        }
+        catch (...) {
+            continue;
+        }
+        m_index[path] = e;
+    }
+}
+
+void AnalysisCache::saveIndex()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_indexDirty) {
+        return;
+    }
+
+    std::ofstream ofs(m_dir + "/index.txt", std::ios::trunc);
+    if (!ofs.is_open()) {
+        std::cerr << "Failed to write cache index in " << m_dir << "\n";
+        return;
+    }
+    for (const auto& kv : m_index) {
+        ofs << kv.second.size << " " << kv.second.mtime << " "
+            << toHex(kv.second.hash) << " " << kv.first << "\n";
+    }
+    m_indexDirty = false;
+}
+
+bool AnalysisCache::sessionHash(const std::string& path, uint64_t& contentHash)
+{
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    if (!statFile(path, size, mtime)) {
+        std::cerr << "Failed to stat session file: " << path << "\n";
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(path);
+        if (it != m_index.end() && it->second.size == size && it->second.mtime == mtime) {
+            contentHash = it->second.hash;
+            return true;
+        }
+    }
+
+    // Changed or never seen: hash outside the lock
+    if (!hashFile(path, contentHash)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_index[path] = IndexEntry{ size, mtime, contentHash };
+    m_indexDirty = true;
+    return true;
+}
+
+std::string AnalysisCache::entryPath(uint64_t contentHash, const AnalyzerId& id) const
+{
+    return m_dir + "/" + toHex(contentHash) + "-" + id.name + "-v" +
+        std::to_string(id.version) + "-" + toHex(id.paramsHash) + ".bin";
+}
+
+bool AnalysisCache::load(uint64_t contentHash, const AnalyzerId& id, std::string& payload)
+{
+    std::ifstream ifs(entryPath(contentHash, id), std::ios::binary);
+    bool hit = ifs.is_open();
+    if (hit) {
+        std::ostringstream oss;
+        oss << ifs.rdbuf();
+        payload = oss.str();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++(hit ? m_hits : m_misses);
+    return hit;
+}
+
+bool AnalysisCache::store(uint64_t contentHash, const AnalyzerId& id, const std::string& payload)
+{
+    // Write a temp file and rename it, so readers never see a partial entry
+    static std::atomic<uint64_t> s_tempCounter{ 0 };
+    const std::string path = entryPath(contentHash, id);
+    const std::string temp = path + ".tmp" + std::to_string(s_tempCounter.fetch_add(1));
+    {
+        std::ofstream ofs(temp, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open()) {
+            std::cerr << "Failed to write cache entry: " << temp << "\n";
+            return false;
+        }
+        ofs.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        if (!ofs) {
+            std::cerr << "Failed to write cache entry: " << temp << "\n";
+            return false;
+        }
+    }
+
+    std::remove(path.c_str()); // rename() does not replace on Windows
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,76 @@
+// analysis_cache.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+//----------------------------------------------------//
+//                 Content Hashing
+//----------------------------------------------------//
+
+// Fast non-cryptographic 64-bit hash (four independent lanes, so it runs
+// at memory speed). Good for cache keys, not for anything adversarial.
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0);
+
+// Hash of a whole file's contents; returns false if it cannot be read
+bool hashFile(const std::string& path, uint64_t& hash);
+
+//----------------------------------------------------//
+//             Incremental Analysis Cache
+//----------------------------------------------------//
+
+// Identifies one analyzer configuration. Bump 'version' whenever the
+// analyzer's output changes; 'paramsHash' covers its tunable parameters.
+struct AnalyzerId
+{
+    std::string name;
+    uint32_t    version = 1;
+    uint64_t    paramsHash = 0;
+};
+
+// On-disk cache of analysis results, keyed by (session content hash,
+// analyzer id). A renamed or copied session still hits; an edited one or a
+// changed analyzer misses.
+//
+// Hashing a session means reading it, so the content hash is memoized per
+// path together with the file's size and modification time; unchanged files
+// are not even re-read. All methods are thread-safe.
+class AnalysisCache {
+public:
+    explicit AnalysisCache(const std::string& dir);
+    ~AnalysisCache();
+
+    // Content hash of a session file (memoized)
+    bool sessionHash(const std::string& path, uint64_t& contentHash);
+
+    bool load(uint64_t contentHash, const AnalyzerId& id, std::string& payload);
+    bool store(uint64_t contentHash, const AnalyzerId& id, const std::string& payload);
+
+    // Persists the path -> hash memo (also done by the destructor)
+    void saveIndex();
+
+    uint64_t hits() const { return m_hits; }
+    uint64_t misses() const { return m_misses; }
+
+private:
+    struct IndexEntry
+    {
+        uint64_t size;
+        int64_t  mtime;
+        uint64_t hash;
+    };
+
+    std::string entryPath(uint64_t contentHash, const AnalyzerId& id) const;
+    void loadIndex();
+
+private:
+    std::string                       m_dir;
+    std::mutex                        m_mutex;
+    std::map<std::string, IndexEntry> m_index;
+    bool                              m_indexDirty = false;
+    uint64_t                          m_hits = 0;
+    uint64_t                          m_misses = 0;
+};
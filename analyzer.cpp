@@ -0,0 +1,1978 @@
+// analyzer.cpp
+// Offline analysis of recorded sessions (input_log_*.csv).
+// Portable: builds without Win32 so archives can be processed anywhere.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "session_event.h"
+#include "session_reader.h"
+#include "panic_detector.h"
+#include "path_simplify.h"
+#include "timeline_lod.h"
+#include "spatial_index.h"
+#include "cast_features.h"
+#include "kmeans.h"
+#include "batch_driver.h"
+#include "analysis_cache.h"
+#include "event_query.h"
+#include "session_segments.h"
+#include "asof_join.h"
+#include "clock_align.h"
+#include "session_header.h"
+#include "change_points.h"
+#include "cursor_spectrum.h"
+#include "movement_states.h"
+#include "gesture_recognizer.h"
+#include "movement_entropy.h"
+#include "cast_labels.h"
+#include "key_timing.h"
+#include "csv_logger.h"
+#include "session_replay.h"
+#include "flight_recorder.h"
+#include "capture_metrics.h"
+#include "capture_trace.h"
+#include "thread_pool.h"
+
+//----------------------------------------------------//
+//               Argument Helpers
+//----------------------------------------------------//
+
+// Removes "--name value" from args; returns false if it is not present
+static bool takeOption(std::vector<std::string>& args, const std::string& name,
+    std::string& value)
+{
+    for (size_t i = 0; i + 1 < args.size(); ++i) {
+        if (args[i] == name) {
+            value = args[i + 1];
+            args.erase(args.begin() + i, args.begin() + i + 2);
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint32_t takeUintOption(std::vector<std::string>& args, const std::string& name,
+    uint32_t defaultValue)
+{
+    std::string value;
+    if (!takeOption(args, name, value)) {
+        return defaultValue;
+    }
+    try {
+        return static_cast<uint32_t>(std::stoul(value));
+    }
+    catch (...) {
+        std::cerr << "Ignoring bad value for " << name << ": " << value << "\n";
+        return defaultValue;
+    }
+}
+
+//----------------------------------------------------//
+//                    Commands
+//----------------------------------------------------//
+
+// panic [--window ms] [--bucket ms] [--trigger n] [--release n] files...
+static int runPanic(std::vector<std::string> args)
+{
+    PanicRule rule;
+    rule.windowMs     = takeUintOption(args, "--window", rule.windowMs);
+    rule.bucketMs     = takeUintOption(args, "--bucket", rule.bucketMs);
+    rule.triggerCount = takeUintOption(args, "--trigger", rule.triggerCount);
+    rule.releaseCount = takeUintOption(args, "--release", rule.releaseCount);
+
+    std::cout << "file,channel,start_ms,end_ms,duration_ms,presses,peak_rate_hz,intensity\n";
+    int failures = 0;
+    for (const auto& path : args) {
+        PanicDetector detector(rule);
+        std::vector<PanicEpisode> episodes;
+        bool ok = forEachSessionEvent(path, [&](const SessionEvent& evt) {
+            detector.onEvent(evt, episodes);
+        });
+        if (!ok) {
+            ++failures;
+            continue;
+        }
+        detector.finish(episodes);
+
+        for (const auto& ep : episodes) {
+            std::cout << path << ","
+                << channelName(ep.channel) << ","
+                << ep.startMs << ","
+                << ep.endMs << ","
+                << (ep.endMs - ep.startMs) << ","
+                << ep.pressCount << ","
+                << ep.peakRateHz << ","
+                << ep.intensity << "\n";
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// simplify [--tolerance px] [--method rdp|vw] [--metric perp|sync] [--out file] files...
+static int runSimplify(std::vector<std::string> args)
+{
+    SimplifyOptions options;
+    std::string value;
+    if (takeOption(args, "--tolerance", value)) {
+        try {
+            options.tolerancePx = std::stod(value);
+        }
+        catch (...) {
+            std::cerr << "Ignoring bad value for --tolerance: " << value << "\n";
+        }
+    }
+    if (takeOption(args, "--method", value) && value == "vw") {
+        options.method = SimplifyMethod::Visvalingam;
+    }
+    if (takeOption(args, "--metric", value) && value == "sync") {
+        options.metric = DeviationMetric::Synchronized;
+    }
+    std::string outPath;
+    takeOption(args, "--out", outPath);
+    if (!outPath.empty() && args.size() != 1) {
+        std::cerr << "--out needs exactly one input file.\n";
+        return 1;
+    }
+
+    std::cout << "file,points_in,points_out,compression,max_deviation_px\n";
+    int failures = 0;
+    for (const auto& path : args) {
+        std::vector<SessionEvent> events;
+        if (!readSession(path, events)) {
+            ++failures;
+            continue;
+        }
+
+        std::vector<SessionEvent> simplified;
+        SimplifyStats stats = simplifySessionPath(events, options, simplified);
+        std::cout << path << ","
+            << stats.inputPoints << ","
+            << stats.outputPoints << ","
+            << stats.compressionRatio() << ","
+            << stats.maxDeviationPx << "\n";
+
+        // Both methods promise the tolerance as a hard bound
+        if (stats.maxDeviationPx > options.tolerancePx) {
+            std::cerr << path << ": deviation " << stats.maxDeviationPx
+                << " px exceeds the tolerance of " << options.tolerancePx << " px\n";
+            ++failures;
+            continue;
+        }
+
+        if (!outPath.empty() && !writeSession(outPath, simplified)) {
+            ++failures;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// Loads the cached pyramid for a column, rebuilding it if missing or stale
+static bool loadOrBuildTimeline(const std::string& path, const std::string& column,
+    TimelineCache& cache, bool forceRebuild)
+{
+    const uint64_t size = sessionFileSize(path);
+    const int64_t mtime = sessionFileMtime(path);
+    const std::string cachePath = timelineCachePath(path, column);
+
+    uint64_t cachedSize = 0;
+    int64_t cachedMtime = 0;
+    if (!forceRebuild && cache.load(cachePath, cachedSize, cachedMtime) &&
+        cachedSize == size && cachedMtime == mtime) {
+        return true;
+    }
+
+    std::vector<SessionEvent> events;
+    std::vector<SeriesPoint> raw;
+    if (!readSession(path, events) || !extractSeries(events, column, raw)) {
+        return false;
+    }
+    cache.build(raw);
+    return cache.save(cachePath, size, mtime);
+}
+
+// timeline build [--column c] files...
+// timeline query --column c [--from ms] [--to ms] [--points n] file
+static int runTimeline(std::vector<std::string> args)
+{
+    if (args.empty() || (args[0] != "build" && args[0] != "query")) {
+        std::cerr << "Usage: timeline build|query ...\n";
+        return 1;
+    }
+    const bool build = args[0] == "build";
+    args.erase(args.begin());
+
+    std::vector<std::string> columns = { "x", "y", "speed", "clickrate", "keyrate" };
+    std::string column;
+    if (takeOption(args, "--column", column)) {
+        columns.assign(1, column);
+    }
+
+    if (build) {
+        int failures = 0;
+        for (const auto& path : args) {
+            for (const auto& c : columns) {
+                TimelineCache cache;
+                if (!loadOrBuildTimeline(path, c, cache, true)) {
+                    ++failures;
+                    continue;
+                }
+                std::cout << timelineCachePath(path, c) << ": " << cache.levelCount() << " levels (";
+                for (size_t l = 0; l < cache.levelCount(); ++l) {
+                    std::cout << (l ? " " : "") << cache.levelSize(l);
+                }
+                std::cout << " points)\n";
+            }
+        }
+        return failures == 0 ? 0 : 1;
+    }
+
+    uint32_t from = takeUintOption(args, "--from", 0);
+    uint32_t to = takeUintOption(args, "--to", 0xFFFFFFFF);
+    uint32_t points = takeUintOption(args, "--points", 1000);
+    if (column.empty() || args.size() != 1) {
+        std::cerr << "Usage: timeline query --column c [--from ms] [--to ms] [--points n] file\n";
+        return 1;
+    }
+
+    TimelineCache cache;
+    if (!loadOrBuildTimeline(args[0], column, cache, false)) {
+        return 1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<SeriesPoint> out;
+    size_t level = cache.query(from, to, points, out);
+    double elapsedMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << "t_ms," << column << "\n";
+    for (const auto& p : out) {
+        std::cout << static_cast<uint64_t>(p.t) << "," << p.v << "\n";
+    }
+    std::cerr << out.size() << " points from level " << level
+        << " in " << elapsedMs << " ms\n";
+    return 0;
+}
+
+// near [--key K] [--radius px] [--window ms] [--click left|right|any] [--threads n] files...
+// For each press of K: clicks within the radius, and the closest earlier click
+static int runNear(std::vector<std::string> args)
+{
+    std::string keyName = "E";
+    takeOption(args, "--key", keyName);
+    uint32_t castKey = keyNameToVk(keyName);
+    if (castKey == 0) {
+        std::cerr << "Unknown key: " << keyName << "\n";
+        return 1;
+    }
+    double radius = takeUintOption(args, "--radius", 50);
+    const uint32_t windowMs = takeUintOption(args, "--window", 2000);
+    unsigned threads = takeUintOption(args, "--threads", 4);
+    std::string click = "right";
+    takeOption(args, "--click", click);
+
+    auto isClick = [click](const SpatialPoint& p) {
+        if (click == "left")  return p.kind == EventKind::MouseLeftDown;
+        if (click == "right") return p.kind == EventKind::MouseRightDown;
+        return p.kind == EventKind::MouseLeftDown || p.kind == EventKind::MouseRightDown;
+    };
+    // Only clicks in the window leading up to the cast: a click from
+    // minutes earlier (or after the cast) says nothing about its aim.
+    // The window prunes the tree by time; the filter drops clicks at the cast's own ms.
+    const SpatialTimeWindow recent = { windowMs, 0 };
+    SpatialIndex::Filter beforeCast = [](const SpatialPoint& q, const SpatialPoint& c) {
+        return c.timestamp < q.timestamp;
+    };
+
+    std::cout << "file,cast_ms,x,y,recent_clicks_within_radius,nearest_recent_click_px,"
+        "nearest_recent_click_age_ms\n";
+    int failures = 0;
+    for (const auto& path : args) {
+        std::vector<SessionEvent> events;
+        if (!readSession(path, events)) {
+            ++failures;
+            continue;
+        }
+
+        std::vector<SpatialPoint> points, clicks, casts;
+        collectSpatialPoints(events, points);
+        for (const auto& p : points) {
+            if (p.kind == EventKind::KeyDown && p.keyCode == castKey) {
+                casts.push_back(p);
+            }
+            else if (isClick(p)) {
+                clicks.push_back(p);
+            }
+        }
+
+        SpatialIndex index;
+        index.build(std::move(clicks), threads);
+
+        std::vector<std::vector<uint32_t>> within, prior;
+        index.radiusBatch(casts, radius, within, threads, recent, beforeCast);
+        index.nearestBatch(casts, 1, prior, threads, recent, beforeCast);
+
+        for (size_t i = 0; i < casts.size(); ++i) {
+            std::cout << path << ","
+                << casts[i].timestamp << ","
+                << casts[i].x << ","
+                << casts[i].y << ","
+                << within[i].size() << ",";
+            if (prior[i].empty()) {
+                std::cout << ",\n";
+                continue;
+            }
+            const SpatialPoint& c = index.points()[prior[i][0]];
+            std::cout << std::hypot(static_cast<double>(c.x) - casts[i].x,
+                    static_cast<double>(c.y) - casts[i].y) << ","
+                << (casts[i].timestamp - c.timestamp) << "\n";
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// cluster [--k n] [--keys QWER] [--lookback ms] [--batch n] [--iterations n]
+//         [--threads n] [--out file] files...
+// Clusters aim vectors (cursor movement over the lookback before each cast)
+static int runCluster(std::vector<std::string> args)
+{
+    KMeansOptions km;
+    km.k             = takeUintOption(args, "--k", 8);
+    km.batchSize     = takeUintOption(args, "--batch", 0);
+    km.maxIterations = takeUintOption(args, "--iterations", 100);
+    km.threads       = takeUintOption(args, "--threads", 4);
+
+    CastFeatureOptions cf;
+    cf.lookbackMs = takeUintOption(args, "--lookback", cf.lookbackMs);
+    std::string keys;
+    if (takeOption(args, "--keys", keys)) {
+        cf.castKeys = parseKeyList(keys);
+    }
+    std::string outPath;
+    takeOption(args, "--out", outPath);
+
+    // Gather features from every session
+    std::vector<CastRecord> allCasts;
+    std::vector<size_t> castFile;
+    int failures = 0;
+    for (size_t f = 0; f < args.size(); ++f) {
+        std::vector<SessionEvent> events;
+        if (!readSession(args[f], events)) {
+            ++failures;
+            continue;
+        }
+        std::vector<CastRecord> casts;
+        extractCasts(events, cf, casts);
+        allCasts.insert(allCasts.end(), casts.begin(), casts.end());
+        castFile.insert(castFile.end(), casts.size(), f);
+    }
+
+    std::vector<float> features(allCasts.size() * kCastFeatureDim);
+    for (size_t i = 0; i < allCasts.size(); ++i) {
+        castFeatureVector(allCasts[i], &features[i * kCastFeatureDim]);
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    KMeansResult result;
+    if (!runKMeans(features, kCastFeatureDim, km, result)) {
+        return 1;
+    }
+    double elapsedMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << "cluster,casts,aim_dx,aim_dy\n";
+    for (size_t c = 0; c < km.k; ++c) {
+        std::cout << c << ","
+            << result.counts[c] << ","
+            << result.centroids[c * kCastFeatureDim] << ","
+            << result.centroids[c * kCastFeatureDim + 1] << "\n";
+    }
+    std::cerr << allCasts.size() << " casts, " << result.iterations << " iterations, inertia "
+        << result.inertia << ", " << elapsedMs << " ms\n";
+
+    if (!outPath.empty()) {
+        std::ofstream ofs(outPath, std::ios::trunc);
+        if (!ofs.is_open()) {
+            std::cerr << "Failed to open output file: " << outPath << "\n";
+            return 1;
+        }
+        ofs << "file,cast_ms,key,aim_dx,aim_dy,cluster\n";
+        for (size_t i = 0; i < allCasts.size(); ++i) {
+            ofs << args[castFile[i]] << ","
+                << allCasts[i].timestamp << ","
+                << vkToKeyName(allCasts[i].keyCode) << ","
+                << allCasts[i].aimDx << ","
+                << allCasts[i].aimDy << ","
+                << result.assignments[i] << "\n";
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// batch [--threads n] [--chunk-mb n] [--per-file] [--cache dir] [--dir d]... files...
+// Every per-session analysis over a whole archive on a work-stealing pool
+static int runBatchCommand(std::vector<std::string> args)
+{
+    BatchOptions options;
+    options.threads = takeUintOption(args, "--threads", 0);
+    options.chunkBytes = static_cast<uint64_t>(takeUintOption(args, "--chunk-mb", 8)) << 20;
+
+    auto perFileFlag = std::find(args.begin(), args.end(), "--per-file");
+    if (perFileFlag != args.end()) {
+        options.keepPerFile = true;
+        args.erase(perFileFlag);
+    }
+
+    std::unique_ptr<AnalysisCache> cache;
+    std::string cacheDir;
+    if (takeOption(args, "--cache", cacheDir)) {
+        cache.reset(new AnalysisCache(cacheDir));
+        options.cache = cache.get();
+    }
+
+    std::vector<std::string> paths;
+    std::string dir;
+    while (takeOption(args, "--dir", dir)) {
+        listSessionFiles(dir, paths);
+    }
+    paths.insert(paths.end(), args.begin(), args.end());
+    if (paths.empty()) {
+        std::cerr << "No session files given.\n";
+        return 1;
+    }
+
+    BatchReport report;
+    bool ok = runBatch(paths, options, report);
+
+    auto printSummary = [](const std::string& label, const SessionSummary& s) {
+        std::cout << label << ","
+            << s.events << ","
+            << s.durationMs / 1000.0 << ","
+            << s.kindCounts[static_cast<size_t>(EventKind::MousePos)] << ","
+            << s.kindCounts[static_cast<size_t>(EventKind::MouseLeftDown)] << ","
+            << s.kindCounts[static_cast<size_t>(EventKind::MouseRightDown)] << ","
+            << s.kindCounts[static_cast<size_t>(EventKind::KeyDown)] << ","
+            << s.cursorPathPx << ","
+            << s.panicEpisodes << "\n";
+    };
+
+    std::cout << "session,events,duration_s,mouse_pos,left_clicks,right_clicks,key_presses,"
+        << "cursor_path_px,panic_episodes\n";
+    for (const auto& f : report.perFile) {
+        printSummary(f.first, f.second);
+    }
+    printSummary("TOTAL", report.total);
+
+    // Throughput and per-stage CPU time go to stderr
+    double seconds = report.wallMs / 1000.0;
+    std::cerr << report.total.files << " files, " << report.bytes / 1048576.0 << " MB, "
+        << report.total.events << " events in " << report.wallMs << " ms on "
+        << report.threads << " threads ("
+        << (seconds > 0 ? report.bytes / 1048576.0 / seconds : 0.0) << " MB/s, "
+        << (seconds > 0 ? report.total.events / seconds / 1e6 : 0.0) << " M events/s)\n";
+    std::cerr << report.tasks << " tasks, " << report.steals << " steals\n";
+    if (cache) {
+        std::cerr << report.cachedFiles << " sessions from cache, "
+            << report.computedFiles << " recomputed\n";
+    }
+    uint64_t cpuTotal = 0;
+    for (int s = 0; s < kStageCount; ++s) {
+        cpuTotal += report.stageCpuNs[s];
+        std::cerr << "  " << batchStageName(s) << ": " << report.stageCpuNs[s] / 1e6 << " ms CPU\n";
+    }
+    std::cerr << "  total: " << cpuTotal / 1e6 << " ms CPU ("
+        << (report.wallMs > 0 ? cpuTotal / 1e6 / report.wallMs : 0.0) << "x wall)\n";
+    if (report.failures > 0) {
+        std::cerr << report.failures << " files failed.\n";
+    }
+    return ok ? 0 : 1;
+}
+
+// segments [--bin s] [--idle-gap s] [--min-game s] [--rebuild] files...
+// Idle / active / game segments of each session (index saved next to it)
+static int runSegments(std::vector<std::string> args)
+{
+    SegmentOptions options;
+    options.binMs = takeUintOption(args, "--bin", options.binMs / 1000) * 1000;
+    options.idleGapMs = takeUintOption(args, "--idle-gap", options.idleGapMs / 1000) * 1000;
+    options.minGameMs = takeUintOption(args, "--min-game", options.minGameMs / 1000) * 1000;
+
+    bool rebuild = false;
+    auto flag = std::find(args.begin(), args.end(), "--rebuild");
+    if (flag != args.end()) {
+        rebuild = true;
+        args.erase(flag);
+    }
+    if (args.empty()) {
+        std::cerr << "No session files given.\n";
+        return 1;
+    }
+
+    int failures = 0;
+    std::cout << "session,segment,kind,game,start_ms,end_ms,duration_s,events,casts,bytes\n";
+    for (const auto& path : args) {
+        SegmentIndex index;
+        if (!loadOrBuildSegmentIndex(path, options, index, rebuild)) {
+            ++failures;
+            continue;
+        }
+        const auto& segments = index.segments();
+        for (size_t i = 0; i < segments.size(); ++i) {
+            const SessionSegment& s = segments[i];
+            std::cout << path << "," << i << "," << segmentKindToString(s.kind) << ","
+                << s.game << "," << s.startMs << "," << s.endMs << ","
+                << (s.endMs - s.startMs) / 1000.0 << "," << s.events << "," << s.casts << ","
+                << (s.endOffset - s.beginOffset) << "\n";
+        }
+        std::cerr << path << ": " << index.gameCount() << " games in "
+            << segments.size() << " segments\n";
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// query [--explain] [--threads n] [--no-store] [--game n] [--dir d]... "<query>" files...
+// Ad-hoc questions over the columnar store (see event_query.h for the syntax)
+static int runQueryCommand(std::vector<std::string> args)
+{
+    QueryRunOptions options;
+    options.threads = takeUintOption(args, "--threads", 0);
+    options.game = takeUintOption(args, "--game", 0);
+
+    bool explainOnly = false;
+    auto flag = std::find(args.begin(), args.end(), "--explain");
+    if (flag != args.end()) {
+        explainOnly = true;
+        args.erase(flag);
+    }
+    flag = std::find(args.begin(), args.end(), "--no-store");
+    if (flag != args.end()) {
+        options.storeColumns = false;
+        args.erase(flag);
+    }
+
+    std::vector<std::string> paths;
+    std::string dir;
+    while (takeOption(args, "--dir", dir)) {
+        listSessionFiles(dir, paths);
+    }
+    if (args.empty()) {
+        std::cerr << "Usage: query [--explain] [--threads n] [--no-store] [--game n] [--dir d]... \"<query>\" files...\n";
+        return 1;
+    }
+
+    EventQuery query;
+    std::string error;
+    if (!query.compile(args[0], error)) {
+        std::cerr << "Query error: " << error << "\n";
+        return 1;
+    }
+    if (explainOnly) {
+        std::cout << query.explain();
+        return 0;
+    }
+
+    paths.insert(paths.end(), args.begin() + 1, args.end());
+    if (paths.empty()) {
+        std::cerr << "No session files given.\n";
+        return 1;
+    }
+
+    QueryReport report;
+    bool ok = runQuery(query, paths, options, report);
+
+    const QueryStage& last = query.stage(query.stageCount() - 1);
+    const QueryStats& st = report.stats;
+    if (last.kind == QueryStageKind::Head) {
+        std::cout << "session,timestamp_ms,event_type,x,y,key_code\n";
+        for (const auto& r : report.rows) {
+            std::cout << r.first << "," << r.second.timestamp << ","
+                << eventKindToString(r.second.kind) << "," << r.second.x << ","
+                << r.second.y << "," << r.second.keyCode << "\n";
+        }
+    }
+    else {
+        std::cout << "rows," << st.rows << "\n"
+            << "sessions," << st.sessions << "\n";
+    }
+    if (last.kind == QueryStageKind::Stats && st.rows > 0) {
+        std::cout << "rows_per_min," << (st.spanMs > 0 ? st.rows * 60000.0 / st.spanMs : 0.0) << "\n"
+            << "mean_x," << static_cast<double>(st.sumX) / st.rows << "\n"
+            << "mean_y," << static_cast<double>(st.sumY) / st.rows << "\n";
+        for (size_t k = 0; k < st.kinds.size(); ++k) {
+            if (st.kinds[k] > 0) {
+                std::cout << "type:" << eventKindToString(static_cast<EventKind>(k))
+                    << "," << st.kinds[k] << "\n";
+            }
+        }
+        for (size_t k = 0; k < st.keys.size(); ++k) {
+            if (st.keys[k] > 0) {
+                std::cout << "key:" << vkToKeyName(static_cast<uint32_t>(k)) << "," << st.keys[k] << "\n";
+            }
+        }
+    }
+
+    // Per-operator timing goes to stderr
+    std::cerr << paths.size() << " sessions in " << report.wallMs << " ms\n";
+    std::cerr << "  load: " << report.profile[0].rowsOut << " rows, "
+        << report.profile[0].cpuNs / 1e6 << " ms CPU\n";
+    for (size_t i = 0; i < query.stageCount(); ++i) {
+        const QueryStageProfile& p = report.profile[i + 1];
+        std::cerr << "  " << query.stageLabel(i) << ": " << p.rowsIn << " -> " << p.rowsOut
+            << " rows, " << p.cpuNs / 1e6 << " ms CPU\n";
+    }
+    if (report.failures > 0) {
+        std::cerr << report.failures << " files failed.\n";
+    }
+    return ok ? 0 : 1;
+}
+
+// --time-col, --time-unit, --by and --all of the timeline commands
+static void takeTimelineOptions(std::vector<std::string>& args, AsOfOptions& options)
+{
+    std::string value;
+    takeOption(args, "--time-col", options.timeColumn);
+    if (takeOption(args, "--time-unit", value)) {
+        options.timeScale = value == "s" ? 1000.0 : 1.0;
+    }
+    while (takeOption(args, "--by", value)) {
+        const size_t eq = value.find('=');
+        if (eq == std::string::npos) {
+            options.by.emplace_back(value, value);
+        }
+        else {
+            options.by.emplace_back(value.substr(0, eq), value.substr(eq + 1));
+        }
+    }
+    auto flag = std::find(args.begin(), args.end(), "--all");
+    if (flag != args.end()) {
+        options.pressesOnly = false;
+        args.erase(flag);
+    }
+}
+
+// asof --with timeline [--time-col c] [--time-unit ms|s] [--by field=column]...
+//      [--tolerance ms] [--offset ms|auto] [--all] session
+// Attaches the latest timeline row at or before each press (as-of join)
+static int runAsOf(std::vector<std::string> args)
+{
+    AsOfOptions options;
+    std::string timeline, value;
+    if (!takeOption(args, "--with", timeline)) {
+        std::cerr << "Usage: asof --with timeline [--time-col c] [--time-unit ms|s] [--by field=column]... "
+            "[--tolerance ms] [--offset ms|auto] [--all] session\n";
+        return 1;
+    }
+    takeTimelineOptions(args, options);
+    options.toleranceMs = takeUintOption(args, "--tolerance", options.toleranceMs);
+    if (takeOption(args, "--offset", value)) {
+        options.useSessionClock = false;
+        if (value == "auto") {
+            options.estimateOffset = true;
+        }
+        else {
+            try {
+                options.offsetMs = std::stoll(value);
+            }
+            catch (...) {
+                std::cerr << "Ignoring bad value for --offset: " << value << "\n";
+            }
+        }
+    }
+    if (args.size() != 1) {
+        std::cerr << "asof takes exactly one session file.\n";
+        return 1;
+    }
+
+    auto csvField = [](const std::string& s) {
+        if (s.find_first_of(",\"\n") == std::string::npos) {
+            return s;
+        }
+        std::string quoted = "\"";
+        for (char c : s) {
+            quoted += c == '"' ? std::string("\"\"") : std::string(1, c);
+        }
+        return quoted + "\"";
+    };
+
+    std::vector<std::string> columns;
+    bool header = false;
+    AsOfStats stats;
+    bool ok = asofJoin(args[0], timeline, options,
+        [&](const SessionEvent& evt, const TimelineRow* match, int64_t lagMs) {
+            if (!header) {
+                std::cout << "timestamp_ms,event_type,x,y,key_code";
+                for (const auto& c : columns) {
+                    std::cout << "," << csvField(c);
+                }
+                std::cout << ",lag_ms\n";
+                header = true;
+            }
+            std::cout << evt.timestamp << "," << eventKindToString(evt.kind) << ","
+                << evt.x << "," << evt.y << "," << evt.keyCode;
+            for (size_t i = 0; i < columns.size(); ++i) {
+                std::cout << "," << (match ? csvField(match->values[i]) : std::string());
+            }
+            std::cout << ",";
+            if (match) {
+                std::cout << lagMs;
+            }
+            std::cout << "\n";
+        }, stats, &columns);
+
+    std::cerr << stats.matched << " of " << stats.events << " events matched, "
+        << stats.timelineRows << " timeline rows read, offset " << stats.offsetMs << " ms";
+    if (stats.sessionClock) {
+        std::cerr << ", drift " << (stats.clockScale - 1.0) * 1e6 << " ppm (stored by align)";
+    }
+    else if (options.estimateOffset) {
+        std::cerr << " (estimated, " << stats.offsetSupport * 100.0 << "% of anchors agree)";
+    }
+    std::cerr << "\n";
+    return ok ? 0 : 1;
+}
+
+// align --with timeline [--time-col c] [--time-unit ms|s] [--by field=column]...
+//       [--all] [--dry-run] session
+// Fits offset and drift against a timeline and stores them next to the session (.clock)
+static int runAlign(std::vector<std::string> args)
+{
+    AsOfOptions options;
+    std::string timeline;
+    if (!takeOption(args, "--with", timeline)) {
+        std::cerr << "Usage: align --with timeline [--time-col c] [--time-unit ms|s] [--by field=column]... "
+            "[--all] [--dry-run] session\n";
+        return 1;
+    }
+    takeTimelineOptions(args, options);
+
+    bool dryRun = false;
+    auto flag = std::find(args.begin(), args.end(), "--dry-run");
+    if (flag != args.end()) {
+        dryRun = true;
+        args.erase(flag);
+    }
+    if (args.size() != 1) {
+        std::cerr << "align takes exactly one session file.\n";
+        return 1;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    ClockFit fit;
+    if (!fitTimelineClock(args[0], timeline, options, fit)) {
+        return 1;
+    }
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << "offset_ms," << fit.offsetMs << "\n"
+        << "drift_ppm," << fit.driftPpm() << "\n"
+        << "rms_ms," << fit.rmsMs << "\n"
+        << "pairs," << fit.pairs << "\n"
+        << "inliers," << fit.inliers << "\n";
+    std::cerr << "Fitted in " << ms << " ms\n";
+
+    if (!dryRun && !storeSessionClock(args[0], fit, timeline)) {
+        return 1;
+    }
+    return 0;
+}
+
+// changes [--detector cusum|bayes|both] [--warmup n] [--threshold sd] [--hazard n]
+//         [--keys QWER] [--threads n] [--dir d]... files...
+// Change points in reaction time, flick overshoot and click rate per session
+static int runChanges(std::vector<std::string> args)
+{
+    ChangePointOptions options;
+    options.warmup = takeUintOption(args, "--warmup", options.warmup);
+    options.cusumThreshold = takeUintOption(args, "--threshold",
+        static_cast<uint32_t>(options.cusumThreshold));
+    options.hazard = 1.0 / std::max<uint32_t>(2, takeUintOption(args, "--hazard",
+        static_cast<uint32_t>(1.0 / options.hazard)));
+    unsigned threads = takeUintOption(args, "--threads", 0);
+
+    MetricOptions metrics;
+    std::string keys, detector = "both";
+    if (takeOption(args, "--keys", keys)) {
+        metrics.castKeys.clear();
+        for (char c : keys) {
+            metrics.castKeys.push_back(keyNameToVk(std::string(1, c)));
+        }
+    }
+    takeOption(args, "--detector", detector);
+    const bool cusum = detector != "bayes";
+    const bool bayes = detector != "cusum";
+
+    std::vector<std::string> paths;
+    std::string dir;
+    while (takeOption(args, "--dir", dir)) {
+        listSessionFiles(dir, paths);
+    }
+    paths.insert(paths.end(), args.begin(), args.end());
+    if (paths.empty()) {
+        std::cerr << "No session files given.\n";
+        return 1;
+    }
+
+    // Sessions are independent: one task each, results printed in order
+    std::vector<std::vector<ChangePoint>> changes(paths.size());
+    std::vector<char> ok(paths.size(), 0);
+    {
+        WorkStealingPool pool(threads > 0 ? threads : std::thread::hardware_concurrency());
+        for (size_t i = 0; i < paths.size(); ++i) {
+            pool.submit([&, i]() {
+                ok[i] = detectSessionChanges(paths[i], metrics, options, cusum, bayes, changes[i]);
+            });
+        }
+        pool.wait();
+    }
+
+    int failures = 0;
+    std::cout << "session,metric,detector,onset_ms,detected_ms,before,after\n";
+    for (size_t i = 0; i < paths.size(); ++i) {
+        failures += ok[i] ? 0 : 1;
+        for (const auto& cp : changes[i]) {
+            std::cout << paths[i] << "," << cp.metric << "," << cp.detector << ","
+                << cp.onsetMs << "," << cp.detectedMs << "," << cp.before << "," << cp.after << "\n";
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// spectrum [--rate hz] [--window n] [--hop n] [--min-speed px/s] [--spectrogram]
+//          [--threads n] [--dir d]... files...
+// Tremor and jitter: band shares of the cursor velocity spectrum per session
+static int runSpectrum(std::vector<std::string> args)
+{
+    SpectrumOptions options;
+    options.rateHz = takeUintOption(args, "--rate", static_cast<uint32_t>(options.rateHz));
+    options.window = takeUintOption(args, "--window", static_cast<uint32_t>(options.window));
+    options.hop = takeUintOption(args, "--hop", static_cast<uint32_t>(options.window / 2));
+    options.minSpeedPxPerS = takeUintOption(args, "--min-speed",
+        static_cast<uint32_t>(options.minSpeedPxPerS));
+    unsigned threads = takeUintOption(args, "--threads", 0);
+
+    bool spectrogram = false;
+    auto flag = std::find(args.begin(), args.end(), "--spectrogram");
+    if (flag != args.end()) {
+        spectrogram = true;
+        args.erase(flag);
+    }
+
+    std::vector<std::string> paths;
+    std::string dir;
+    while (takeOption(args, "--dir", dir)) {
+        listSessionFiles(dir, paths);
+    }
+    paths.insert(paths.end(), args.begin(), args.end());
+    if (paths.empty()) {
+        std::cerr << "No session files given.\n";
+        return 1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<SpectrumSummary> summaries(paths.size());
+    std::vector<char> ok(paths.size(), 0);
+    {
+        WorkStealingPool pool(threads > 0 ? threads : std::thread::hardware_concurrency());
+        for (size_t i = 0; i < paths.size(); ++i) {
+            pool.submit([&, i]() {
+                // Spectrogram rows go next to the session, one per frame
+                std::ofstream rows;
+                CursorSpectrum::FrameCallback onFrame;
+                if (spectrogram) {
+                    rows.open(paths[i] + ".spectrogram.csv", std::ios::trunc);
+                    const double binHz = options.rateHz / options.window;
+                    rows << "t_ms,speed_px_s";
+                    for (size_t k = 0; k <= options.window / 2; ++k) {
+                        rows << ",f" << k * binHz;
+                    }
+                    rows << "\n";
+                    onFrame = [&rows, &options](const SpectrumFrame& f) {
+                        rows << f.startMs << "," << f.rmsSpeed;
+                        for (size_t k = 0; k <= options.window / 2; ++k) {
+                            rows << "," << f.power[k];
+                        }
+                        rows << "\n";
+                    };
+                }
+                ok[i] = analyzeCursorSpectrum(paths[i], options, summaries[i], onFrame);
+            });
+        }
+        pool.wait();
+    }
+
+    int failures = 0;
+    std::cout << "session,samples,frames,active_frames,rms_speed,voluntary_share,tremor_share,"
+        "jitter_share,tremor_peak_hz,centroid_hz\n";
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!ok[i]) {
+            ++failures;
+            continue;
+        }
+        const SpectrumSummary& s = summaries[i];
+        std::cout << paths[i] << "," << s.samples << "," << s.frames << "," << s.activeFrames << ","
+            << s.rmsSpeed << "," << s.voluntaryShare << "," << s.tremorShare << ","
+            << s.jitterShare << "," << s.tremorPeakHz << "," << s.centroidHz << "\n";
+    }
+    std::cerr << paths.size() << " sessions in " << std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - begin).count() << " ms\n";
+    return failures == 0 ? 0 : 1;
+}
+
+// hmm train [--iterations n] [--bin ms] [--threads n] [--out model] [--dir d]... files...
+// hmm decode [--model file] [--bin ms] [--runs] [--threads n] [--dir d]... files...
+// Movement states (idle, drifting, aiming, kiting, panic) from a Gaussian HMM
+static int runHmm(std::vector<std::string> args)
+{
+    if (args.empty() || (args[0] != "train" && args[0] != "decode")) {
+        std::cerr << "Usage: analyzer hmm train|decode [options] files...\n";
+        return 1;
+    }
+    const bool train = args[0] == "train";
+    args.erase(args.begin());
+
+    MovementOptions options;
+    options.binMs = takeUintOption(args, "--bin", options.binMs);
+    uint32_t iterations = takeUintOption(args, "--iterations", 10);
+    unsigned threads = takeUintOption(args, "--threads", 0);
+    std::string modelPath, outPath = "movement.hmm";
+    takeOption(args, "--model", modelPath);
+    takeOption(args, "--out", outPath);
+
+    bool runs = false;
+    auto flag = std::find(args.begin(), args.end(), "--runs");
+    if (flag != args.end()) {
+        runs = true;
+        args.erase(flag);
+    }
+
+    std::vector<std::string> paths;
+    std::string dir;
+    while (takeOption(args, "--dir", dir)) {
+        listSessionFiles(dir, paths);
+    }
+    paths.insert(paths.end(), args.begin(), args.end());
+    if (paths.empty()) {
+        std::cerr << "No session files given.\n";
+        return 1;
+    }
+
+    GaussianHmm model = defaultMovementModel();
+    if (!modelPath.empty() && !model.load(modelPath)) {
+        return 1;
+    }
+    if (model.states() != static_cast<size_t>(MovementState::Count) || model.dims() != kMovementFeatureDims) {
+        std::cerr << "Model does not have the movement state layout: " << modelPath << "\n";
+        return 1;
+    }
+
+    WorkStealingPool pool(threads > 0 ? threads : std::thread::hardware_concurrency());
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<MovementFeatures> features(paths.size());
+    std::vector<char> ok(paths.size(), 0);
+    for (size_t i = 0; i < paths.size(); ++i) {
+        pool.submit([&, i]() { ok[i] = extractMovementFeatures(paths[i], options, features[i]); });
+    }
+    pool.wait();
+
+    int failures = 0;
+    std::vector<HmmSequence> sequences;
+    size_t bins = 0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        failures += ok[i] ? 0 : 1;
+        if (ok[i] && features[i].bins() > 0) {
+            sequences.push_back(features[i].sequence());
+            bins += features[i].bins();
+        }
+    }
+    auto elapsedMs = [&begin]() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - begin).count();
+    };
+    std::cerr << sequences.size() << " sessions, " << bins << " bins of " << options.binMs
+        << " ms, features in " << elapsedMs() << " ms\n";
+
+    if (train) {
+        double previous = 0.0;
+        for (uint32_t it = 0; it < iterations; ++it) {
+            const double logL = model.baumWelchStep(sequences, &pool);
+            std::cerr << "iteration " << it + 1 << ": log-likelihood " << logL << "\n";
+            if (it > 0 && std::fabs(logL - previous) < 1e-6 * std::fabs(previous)) {
+                break;
+            }
+            previous = logL;
+        }
+        std::cout << "state,initial,stay,speed,right_per_s,left_per_s,keys_per_s\n";
+        for (size_t k = 0; k < model.states(); ++k) {
+            const double* mu = model.mean(k);
+            // Means back on the natural scale (features are log1p)
+            std::cout << movementStateName(static_cast<MovementState>(k)) << ","
+                << model.initial(k) << "," << model.transition(k, k);
+            for (size_t d = 0; d < model.dims(); ++d) {
+                std::cout << "," << std::expm1(mu[d]);
+            }
+            std::cout << "\n";
+        }
+        std::cerr << "trained in " << elapsedMs() << " ms\n";
+        return model.save(outPath) && failures == 0 ? 0 : 1;
+    }
+
+    // Decode: one Viterbi pass per session, in parallel, printed in order
+    std::vector<MovementSummary> summaries(paths.size());
+    auto decodeBegin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < paths.size(); ++i) {
+        pool.submit([&, i]() {
+            std::vector<uint8_t> path;
+            model.viterbi(features[i].sequence(), path);
+            summarizeMovementPath(features[i], path, summaries[i]);
+        });
+    }
+    pool.wait();
+    const double decodeS = std::chrono::duration<double>(std::chrono::steady_clock::now() - decodeBegin).count();
+
+    const size_t K = static_cast<size_t>(MovementState::Count);
+    if (runs) {
+        std::cout << "session,state,start_ms,end_ms\n";
+    }
+    else {
+        std::cout << "session,state,share,mean_run_ms,switches\n";
+    }
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!ok[i]) {
+            continue;
+        }
+        const MovementSummary& s = summaries[i];
+        if (runs) {
+            for (const auto& run : s.runs) {
+                std::cout << paths[i] << "," << movementStateName(run.state) << ","
+                    << run.startMs << "," << run.endMs << "\n";
+            }
+            continue;
+        }
+        for (size_t k = 0; k < K; ++k) {
+            std::cout << paths[i] << "," << movementStateName(static_cast<MovementState>(k)) << ","
+                << s.share[k] << "," << s.meanRunMs[k] << "," << s.switches << "\n";
+        }
+    }
+    std::cerr << "decoded " << bins << " bins in " << decodeS * 1000.0 << " ms ("
+        << (decodeS > 0.0 ? bins / decodeS / 1e6 : 0.0) << " M bins/s)\n";
+    return failures == 0 ? 0 : 1;
+}
+
+// gestures [--templates file] [--no-builtin] [--min-score pct] [--pause ms] [--min-length px]
+//          [--threads n] [--dir d]... files...
+// gestures learn --name n --from ms --to ms [--templates file] session
+// Cursor gestures (circles, zig-zags, strafing, ...) matched against templates
+static int runGestures(std::vector<std::string> args)
+{
+    std::string templatesPath = "gestures.txt";
+    const bool haveTemplates = takeOption(args, "--templates", templatesPath);
+
+    if (!args.empty() && args[0] == "learn") {
+        args.erase(args.begin());
+        std::string name;
+        takeOption(args, "--name", name);
+        const uint32_t from = takeUintOption(args, "--from", 0);
+        const uint32_t to = takeUintOption(args, "--to", 0);
+        if (name.empty() || to <= from || args.size() != 1) {
+            std::cerr << "Usage: analyzer gestures learn --name n --from ms --to ms [--templates file] session\n";
+            return 1;
+        }
+        std::vector<PathPoint> points;
+        bool ok = forEachSessionEvent(args[0], [&](const SessionEvent& evt) {
+            if (evt.kind == EventKind::MousePos && evt.timestamp >= from && evt.timestamp <= to) {
+                points.push_back(PathPoint{ evt.x, evt.y, evt.timestamp });
+            }
+        });
+        GestureShape shape;
+        if (!ok || !shape.fromPath(points)) {
+            std::cerr << "No cursor motion between " << from << " and " << to << " ms\n";
+            return 1;
+        }
+        if (!GestureRecognizer::appendTemplate(templatesPath, name, points)) {
+            return 1;
+        }
+        std::cout << "Added '" << name << "' (" << points.size() << " points) to " << templatesPath << "\n";
+        return 0;
+    }
+
+    MotionSegmentOptions segmentOptions;
+    segmentOptions.pauseMs = takeUintOption(args, "--pause", segmentOptions.pauseMs);
+    segmentOptions.minLengthPx = takeUintOption(args, "--min-length",
+        static_cast<uint32_t>(segmentOptions.minLengthPx));
+    const double minScore = takeUintOption(args, "--min-score", 80) / 100.0;
+    unsigned threads = takeUintOption(args, "--threads", 0);
+
+    GestureRecognizer recognizer;
+    auto flag = std::find(args.begin(), args.end(), "--no-builtin");
+    if (flag != args.end()) {
+        args.erase(flag);
+    }
+    else {
+        recognizer.addBuiltinTemplates();
+    }
+    if (haveTemplates && !recognizer.loadTemplates(templatesPath)) {
+        return 1;
+    }
+    if (recognizer.size() == 0) {
+        std::cerr << "No gesture templates.\n";
+        return 1;
+    }
+
+    std::vector<std::string> paths;
+    std::string dir;
+    while (takeOption(args, "--dir", dir)) {
+        listSessionFiles(dir, paths);
+    }
+    paths.insert(paths.end(), args.begin(), args.end());
+    if (paths.empty()) {
+        std::cerr << "No session files given.\n";
+        return 1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::vector<GestureHit>> hits(paths.size());
+    std::vector<GestureStats> stats(paths.size());
+    std::vector<char> ok(paths.size(), 0);
+    {
+        WorkStealingPool pool(threads > 0 ? threads : std::thread::hardware_concurrency());
+        for (size_t i = 0; i < paths.size(); ++i) {
+            pool.submit([&, i]() {
+                ok[i] = recognizeSessionGestures(paths[i], recognizer, segmentOptions, minScore,
+                    hits[i], stats[i]);
+            });
+        }
+        pool.wait();
+    }
+
+    int failures = 0;
+    GestureStats total;
+    std::cout << "session,start_ms,end_ms,length_px,gesture,score,rotation_deg\n";
+    for (size_t i = 0; i < paths.size(); ++i) {
+        failures += ok[i] ? 0 : 1;
+        total.segments += stats[i].segments;
+        total.comparisons += stats[i].comparisons;
+        total.rejected += stats[i].rejected;
+        for (const auto& h : hits[i]) {
+            std::cout << paths[i] << "," << h.startMs << "," << h.endMs << ","
+                << static_cast<int>(h.lengthPx) << "," << h.name << "," << h.score << ","
+                << static_cast<int>(h.rotationDeg) << "\n";
+        }
+    }
+    std::cerr << paths.size() << " sessions, " << total.segments << " segments, "
+        << total.comparisons << " comparisons (" << total.rejected << " rejected early) in "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - begin).count() << " ms\n";
+    return failures == 0 ? 0 : 1;
+}
+
+// entropy [--order n] [--table-bits n] [--lookback ms] [--keys QWER] [--window s] [--windows]
+//         [--threads n] [--dir d]... files...
+// Movement predictability: entropy rate of quantized cursor steps under an
+// online context-mixing model, per session and before casts
+static int runEntropy(std::vector<std::string> args)
+{
+    PredictabilityOptions options;
+    options.model.maxOrder = takeUintOption(args, "--order", static_cast<uint32_t>(options.model.maxOrder));
+    options.model.tableBits = takeUintOption(args, "--table-bits", static_cast<uint32_t>(options.model.tableBits));
+    options.lookbackMs = takeUintOption(args, "--lookback", options.lookbackMs);
+    options.windowMs = takeUintOption(args, "--window", options.windowMs / 1000) * 1000;
+    unsigned threads = takeUintOption(args, "--threads", 0);
+    std::string keys;
+    if (takeOption(args, "--keys", keys)) {
+        options.castKeys = parseKeyList(keys);
+    }
+
+    bool windows = false;
+    auto flag = std::find(args.begin(), args.end(), "--windows");
+    if (flag != args.end()) {
+        windows = true;
+        args.erase(flag);
+    }
+
+    std::vector<std::string> paths;
+    std::string dir;
+    while (takeOption(args, "--dir", dir)) {
+        listSessionFiles(dir, paths);
+    }
+    paths.insert(paths.end(), args.begin(), args.end());
+    if (paths.empty()) {
+        std::cerr << "No session files given.\n";
+        return 1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<PredictabilityReport> reports(paths.size());
+    std::vector<char> ok(paths.size(), 0);
+    {
+        WorkStealingPool pool(threads > 0 ? threads : std::thread::hardware_concurrency());
+        for (size_t i = 0; i < paths.size(); ++i) {
+            pool.submit([&, i]() {
+                ok[i] = analyzeMovementPredictability(paths[i], options, reports[i]);
+            });
+        }
+        pool.wait();
+    }
+
+    int failures = 0;
+    uint64_t symbols = 0;
+    if (windows) {
+        std::cout << "session,start_ms,symbols,bits_per_symbol,predictability\n";
+    }
+    else {
+        std::cout << "session,symbols,bits_per_symbol,predictability,casts,precast_symbols,"
+            "precast_bits_per_symbol,precast_predictability\n";
+    }
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!ok[i]) {
+            ++failures;
+            continue;
+        }
+        const PredictabilityReport& r = reports[i];
+        symbols += r.symbols;
+        if (windows) {
+            for (const auto& w : r.windows) {
+                std::cout << paths[i] << "," << w.startMs << "," << w.symbols << ","
+                    << (w.symbols ? w.bits / w.symbols : 0.0) << ","
+                    << PredictabilityReport::score(w.bits, w.symbols) << "\n";
+            }
+            continue;
+        }
+        std::cout << paths[i] << "," << r.symbols << "," << (r.symbols ? r.bits / r.symbols : 0.0) << ","
+            << PredictabilityReport::score(r.bits, r.symbols) << "," << r.casts << ","
+            << r.preCastSymbols << "," << (r.preCastSymbols ? r.preCastBits / r.preCastSymbols : 0.0) << ","
+            << PredictabilityReport::score(r.preCastBits, r.preCastSymbols) << "\n";
+    }
+    std::cerr << paths.size() << " sessions, " << symbols << " symbols in "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - begin).count() << " ms\n";
+    return failures == 0 ? 0 : 1;
+}
+
+// castmodel train [--labels file] [--label-col c] [--time-col c] [--time-unit ms|s] [--offset ms]
+//                 [--tolerance ms] [--keys QWER] [--epochs n] [--batch n] [--holdout pct]
+//                 [--out model] [--dir d]... sessions...
+// castmodel score [--model file] [--keys QWER] [--threads n] [--dir d]... files...
+// Hit probability of each cast from its pre-cast features (logistic regression)
+static int runCastModel(std::vector<std::string> args)
+{
+    if (args.empty() || (args[0] != "train" && args[0] != "score")) {
+        std::cerr << "Usage: analyzer castmodel train|score [options] files...\n";
+        return 1;
+    }
+    const bool train = args[0] == "train";
+    args.erase(args.begin());
+
+    std::vector<uint32_t> castKeys = { 'Q', 'W', 'E', 'R' };
+    std::string value, labelsPath, modelPath = "cast_model.txt";
+    if (takeOption(args, "--keys", value)) {
+        castKeys = parseKeyList(value);
+    }
+    takeOption(args, "--labels", labelsPath);
+    takeOption(args, train ? "--out" : "--model", modelPath);
+
+    CastLabelOptions labelOptions;
+    takeOption(args, "--label-col", labelOptions.labelColumn);
+    takeOption(args, "--time-col", labelOptions.timeColumn);
+    if (takeOption(args, "--time-unit", value)) {
+        labelOptions.timeScale = value == "s" ? 1000.0 : 1.0;
+    }
+    if (takeOption(args, "--offset", value)) {
+        labelOptions.offsetMs = std::atoll(value.c_str());
+    }
+    labelOptions.toleranceMs = takeUintOption(args, "--tolerance", labelOptions.toleranceMs);
+
+    LogisticOptions trainOptions;
+    trainOptions.epochs = takeUintOption(args, "--epochs", trainOptions.epochs);
+    trainOptions.batch = takeUintOption(args, "--batch", trainOptions.batch);
+    const uint32_t holdoutPct = std::min<uint32_t>(90, takeUintOption(args, "--holdout", 20));
+    unsigned threads = takeUintOption(args, "--threads", 0);
+
+    std::vector<std::string> paths;
+    std::string dir;
+    while (takeOption(args, "--dir", dir)) {
+        listSessionFiles(dir, paths);
+    }
+    paths.insert(paths.end(), args.begin(), args.end());
+    if (paths.empty()) {
+        std::cerr << "No session files given.\n";
+        return 1;
+    }
+    if (!labelsPath.empty() && paths.size() != 1) {
+        std::cerr << "--labels takes one session; use <session>.labels.csv files for more.\n";
+        return 1;
+    }
+
+    std::vector<std::vector<CastSample>> casts(paths.size());
+    std::vector<char> ok(paths.size(), 0);
+    {
+        WorkStealingPool pool(threads > 0 ? threads : std::thread::hardware_concurrency());
+        for (size_t i = 0; i < paths.size(); ++i) {
+            pool.submit([&, i]() { ok[i] = extractCastSamples(paths[i], castKeys, casts[i]); });
+        }
+        pool.wait();
+    }
+
+    if (!train) {
+        LogisticModel model;
+        if (!model.load(modelPath)) {
+            return 1;
+        }
+        int failures = 0;
+        size_t scored = 0;
+        auto begin = std::chrono::steady_clock::now();
+        std::cout << "session,timestamp_ms,key,hit_probability\n";
+        for (size_t i = 0; i < paths.size(); ++i) {
+            failures += ok[i] ? 0 : 1;
+            for (const auto& c : casts[i]) {
+                std::cout << paths[i] << "," << c.timestamp << "," << vkToKeyName(c.keyCode) << ","
+                    << model.predict(c.features) << "\n";
+                ++scored;
+            }
+        }
+        std::cerr << scored << " casts scored in " << std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - begin).count() << " ms\n";
+        return failures == 0 ? 0 : 1;
+    }
+
+    // Label every session, then split rows into training and holdout
+    std::vector<float> x;
+    std::vector<uint8_t> y;
+    int failures = 0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        const std::string labels = labelsPath.empty() ? paths[i] + ".labels.csv" : labelsPath;
+        size_t labelCount = 0;
+        const size_t before = y.size();
+        if (!ok[i] || !labelCastSamples(paths[i], labels, casts[i], labelOptions, x, y, labelCount)) {
+            ++failures;
+            continue;
+        }
+        std::cerr << paths[i] << ": " << casts[i].size() << " casts, " << labelCount << " labels, "
+            << y.size() - before << " matched\n";
+    }
+    if (y.empty()) {
+        std::cerr << "No labelled casts.\n";
+        return 1;
+    }
+
+    std::vector<float> trainX, testX;
+    std::vector<uint8_t> trainY, testY;
+    std::mt19937 rng(trainOptions.seed);
+    for (size_t r = 0; r < y.size(); ++r) {
+        const bool test = rng() % 100 < holdoutPct;
+        std::vector<float>& dx = test ? testX : trainX;
+        dx.insert(dx.end(), x.begin() + r * kCastOutcomeDims, x.begin() + (r + 1) * kCastOutcomeDims);
+        (test ? testY : trainY).push_back(y[r]);
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    LogisticModel model;
+    model.train(trainX, trainY, trainOptions);
+    std::cerr << "trained on " << trainY.size() << " casts in " << std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - begin).count() << " ms\n";
+
+    std::cout << "split,rows,log_loss,accuracy,auc\n";
+    const LogisticMetrics trainMetrics = model.evaluate(trainX, trainY);
+    const LogisticMetrics testMetrics = model.evaluate(testX, testY);
+    std::cout << "train," << trainMetrics.rows << "," << trainMetrics.logLoss << ","
+        << trainMetrics.accuracy << "," << trainMetrics.auc << "\n";
+    std::cout << "holdout," << testMetrics.rows << "," << testMetrics.logLoss << ","
+        << testMetrics.accuracy << "," << testMetrics.auc << "\n";
+    std::cout << "\nfeature,weight\n";
+    for (size_t d = 0; d < kCastOutcomeDims; ++d) {
+        std::cout << castOutcomeFeatureName(d) << "," << model.weight(d) << "\n";
+    }
+    return model.save(modelPath) && failures == 0 ? 0 : 1;
+}
+
+// keys [--by-game] [--keys QWER] [--repeat-gap ms] [--sketches] [--threads n] [--dir d]... files...
+// Hold-duration and repeat-interval distributions per key (and per game)
+static int runKeys(std::vector<std::string> args)
+{
+    KeyTimingOptions options;
+    options.repeatGapMs = takeUintOption(args, "--repeat-gap", options.repeatGapMs);
+    unsigned threads = takeUintOption(args, "--threads", 0);
+    std::vector<uint32_t> keys;
+    std::string value;
+    if (takeOption(args, "--keys", value)) {
+        keys = parseKeyList(value);
+    }
+
+    bool byGame = false, sketches = false;
+    auto flag = std::find(args.begin(), args.end(), "--by-game");
+    if (flag != args.end()) {
+        byGame = true;
+        args.erase(flag);
+    }
+    flag = std::find(args.begin(), args.end(), "--sketches");
+    if (flag != args.end()) {
+        sketches = true;
+        args.erase(flag);
+    }
+
+    std::vector<std::string> paths;
+    std::string dir;
+    while (takeOption(args, "--dir", dir)) {
+        listSessionFiles(dir, paths);
+    }
+    paths.insert(paths.end(), args.begin(), args.end());
+    if (paths.empty()) {
+        std::cerr << "No session files given.\n";
+        return 1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<KeyTimingAggregator> results(paths.size());
+    std::vector<char> ok(paths.size(), 0);
+    {
+        WorkStealingPool pool(threads > 0 ? threads : std::thread::hardware_concurrency());
+        for (size_t i = 0; i < paths.size(); ++i) {
+            pool.submit([&, i]() { ok[i] = aggregateKeyTiming(paths[i], options, byGame, results[i]); });
+        }
+        pool.wait();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    int failures = 0;
+    uint64_t bytes = 0;
+    std::cout << "session,game,key,presses,repeats,missing_ups,orphan_ups,holds,hold_p50,hold_p90,hold_p99,"
+        "hold_mean,interval_p50,interval_p90,interval_p99" << (sketches ? ",hold_sketch,interval_sketch" : "") << "\n";
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!ok[i]) {
+            ++failures;
+            continue;
+        }
+        bytes += sessionFileSize(paths[i]);
+        for (size_t g = 0; g < results[i].groups(); ++g) {
+            std::vector<KeyTimingStats> rows = results[i].group(g).rows();
+            std::sort(rows.begin(), rows.end(), [](const KeyTimingStats& a, const KeyTimingStats& b) {
+                return a.channel < b.channel;
+            });
+            for (const auto& k : rows) {
+                if (!keys.empty() && std::find(keys.begin(), keys.end(), k.channel) == keys.end()) {
+                    continue;
+                }
+                std::cout << paths[i] << "," << (g == 0 ? std::string("all") : std::to_string(g)) << ","
+                    << channelName(k.channel) << "," << k.presses << "," << k.repeats << ","
+                    << k.missingUps << "," << k.orphanUps << "," << k.hold.count() << ","
+                    << k.hold.quantile(0.5) << "," << k.hold.quantile(0.9) << "," << k.hold.quantile(0.99) << ","
+                    << k.hold.mean() << "," << k.interval.quantile(0.5) << "," << k.interval.quantile(0.9) << ","
+                    << k.interval.quantile(0.99);
+                if (sketches) {
+                    std::cout << "," << k.hold.encode() << "," << k.interval.encode();
+                }
+                std::cout << "\n";
+            }
+        }
+    }
+    std::cerr << paths.size() << " sessions, " << bytes / (1024 * 1024) << " MB in "
+        << static_cast<int>(seconds * 1000.0) << " ms ("
+        << (seconds > 0.0 ? bytes / seconds / (1024.0 * 1024.0) : 0.0) << " MB/s)\n";
+    return failures == 0 ? 0 : 1;
+}
+
+// replay [--speed x|max] [--max-gap ms] [--spin us] [--out file] [--flush s] [--tolerance px]
+//        [--restamp] [--live] [--flight] [--metrics] [--trace file] session
+// Pushes a recorded session through the capture pipeline (CSVLogger) with
+// its original timing and reports pacing error
+static int runReplay(std::vector<std::string> args)
+{
+    ReplayOptions options;
+    std::string value, outPath;
+    if (takeOption(args, "--speed", value)) {
+        options.speed = value == "max" ? 0.0 : std::atof(value.c_str());
+        if (value != "max" && options.speed <= 0.0) {
+            std::cerr << "Bad speed: " << value << "\n";
+            return 1;
+        }
+    }
+    options.maxGapMs = takeUintOption(args, "--max-gap", options.maxGapMs);
+    options.spinUs = takeUintOption(args, "--spin", options.spinUs);
+    const uint32_t flushSec = std::max<uint32_t>(1, takeUintOption(args, "--flush", 1));
+    const uint32_t tolerance = takeUintOption(args, "--tolerance", 0);
+    takeOption(args, "--out", outPath);
+    std::string tracePath;
+    takeOption(args, "--trace", tracePath);
+
+    bool restamp = false, live = false, flight = false, metrics = false;
+    auto flag = std::find(args.begin(), args.end(), "--restamp");
+    if (flag != args.end()) {
+        restamp = true;
+        args.erase(flag);
+    }
+    flag = std::find(args.begin(), args.end(), "--live");
+    if (flag != args.end()) {
+        live = true;
+        args.erase(flag);
+    }
+    flag = std::find(args.begin(), args.end(), "--flight");
+    if (flag != args.end()) {
+        flight = true;
+        args.erase(flag);
+    }
+    flag = std::find(args.begin(), args.end(), "--metrics");
+    if (flag != args.end()) {
+        metrics = true;
+        args.erase(flag);
+    }
+    if (args.size() != 1) {
+        std::cerr << "Usage: analyzer replay [options] session\n";
+        return 1;
+    }
+    const std::string& session = args[0];
+    if (outPath.empty()) {
+        outPath = session + ".replay.csv";
+    }
+
+    // Published like the tracker's, so 'analyzer metrics' can watch a replay
+    std::unique_ptr<CaptureMetrics> registry;
+    if (metrics) {
+        registry.reset(new CaptureMetrics(kDefaultMetricsName));
+    }
+
+    CSVLogger logger(outPath, static_cast<int>(flushSec));
+    logger.setMetrics(registry.get());
+    logger.setPathTolerance(tolerance);
+    if (flight) {
+        FlightOptions flightOptions;
+        flightOptions.triggerKeys = { 'Q', 'W', 'E', 'R' };
+        logger.setFlightRecorder(&flightOptions);
+    }
+
+    std::unique_ptr<LiveAnalyzer> analyzer;
+    std::map<std::string, uint64_t> liveResults;
+    std::mutex liveMutex;
+    if (live) {
+        analyzer.reset(new LiveAnalyzer(LiveOptions(), [&](const LiveResult& r) {
+            std::lock_guard<std::mutex> lock(liveMutex);
+            ++liveResults[r.op];
+        }));
+        const std::vector<uint32_t> castKeys = { 'Q', 'W', 'E', 'R' };
+        analyzer->addOperator(std::unique_ptr<LiveOperator>(new FlickOperator()));
+        analyzer->addOperator(std::unique_ptr<LiveOperator>(new ReactionTimeOperator(castKeys)));
+        analyzer->addOperator(std::unique_ptr<LiveOperator>(new SpamOperator()));
+        analyzer->addOperator(std::unique_ptr<LiveOperator>(new ChangePointOperator()));
+        analyzer->start();
+        logger.setLiveTap(analyzer.get());
+    }
+
+    // Restamped events get a GetTickCount-like clock that starts with the replay
+    const auto begin = std::chrono::steady_clock::now();
+    bool haveBase = false;
+    uint32_t base = 0;
+    if (!tracePath.empty()) {
+        captureTrace().setThreadName("replay");
+        captureTrace().start();
+    }
+    logger.start();
+    ReplayStats stats;
+    bool ok = replaySession(session, options, [&](const SessionEvent& evt) {
+        if (!haveBase) {
+            haveBase = true;
+            base = evt.timestamp;
+        }
+        const uint32_t t = restamp ? base + static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count())
+            : evt.timestamp;
+        const CaptureSource source = captureSourceOf(evt.kind);
+        logger.logEvent(InputEvent{ eventKindToString(evt.kind), t, CursorPos{ evt.x, evt.y }, evt.keyCode,
+            source, logger.nextSequence(source) });
+    }, stats);
+    logger.stop();
+    if (!tracePath.empty()) {
+        captureTrace().stop();
+        uint64_t spans = 0, dropped = 0;
+        if (captureTrace().write(tracePath, &spans, &dropped)) {
+            std::cerr << "trace: " << spans << " spans (" << dropped << " dropped) in " << tracePath << "\n";
+        }
+    }
+    if (analyzer) {
+        logger.setLiveTap(nullptr);
+        analyzer->stop();
+    }
+
+    uint64_t written = 0, lost = 0;
+    forEachSessionEvent(outPath, [&written](const SessionEvent&) { ++written; });
+    for (size_t k = 0; k < static_cast<size_t>(CaptureSource::Count); ++k) {
+        lost += logger.captureCounts(static_cast<CaptureSource>(k)).lost();
+    }
+
+    std::cout << "events," << stats.events << "\n"
+        << "written," << written << "\n"
+        << "lost," << lost << "\n"
+        << "session_ms," << stats.spanMs << "\n"
+        << "wall_ms," << stats.wallMs << "\n"
+        << "events_per_s," << (stats.wallMs > 0.0 ? stats.events * 1000.0 / stats.wallMs : 0.0) << "\n";
+    if (options.speed > 0.0) {
+        std::cout << "speed," << options.speed << "\n"
+            << "achieved_speed," << (stats.wallMs > 0.0 ? stats.spanMs / stats.wallMs : 0.0) << "\n"
+            << "late_p50_us," << stats.lateUs.quantile(0.5) << "\n"
+            << "late_p99_us," << stats.lateUs.quantile(0.99) << "\n"
+            << "late_max_us," << stats.lateUs.max() << "\n"
+            << "late_mean_us," << stats.lateUs.mean() << "\n"
+            << "late_over_1ms," << stats.lateEvents << "\n";
+    }
+    if (registry) {
+        MetricsSnapshot snapshot;
+        registry->snapshot(snapshot);
+        printMetrics(std::cerr, snapshot, nullptr);
+    }
+    if (analyzer) {
+        const LiveStats ls = analyzer->stats();
+        std::cout << "live_events," << ls.events << "\n"
+            << "live_dropped," << ls.dropped << "\n"
+            << "live_over_budget," << ls.overBudget << "\n"
+            << "live_max_latency_ms," << ls.maxLatencyMs << "\n";
+        for (const auto& r : liveResults) {
+            std::cout << "live_" << r.first << "," << r.second << "\n";
+        }
+    }
+    return ok ? 0 : 1;
+}
+
+// flight [--pre ms] [--post ms] [--background ms] [--keys QWER] [--clicks] [--out file]
+//        [--threads n] [--dir d]... files...
+// What flight-recorder capture would have stored for recorded sessions
+static int runFlight(std::vector<std::string> args)
+{
+    FlightOptions options;
+    options.preMs = takeUintOption(args, "--pre", options.preMs);
+    options.postMs = takeUintOption(args, "--post", options.postMs);
+    options.backgroundMs = takeUintOption(args, "--background", options.backgroundMs);
+    unsigned threads = takeUintOption(args, "--threads", 0);
+    std::string value = "QWER", outPath;
+    takeOption(args, "--keys", value);
+    options.triggerKeys = parseKeyList(value);
+    takeOption(args, "--out", outPath);
+
+    auto flag = std::find(args.begin(), args.end(), "--clicks");
+    if (flag != args.end()) {
+        options.clickTriggers = true;
+        args.erase(flag);
+    }
+
+    std::vector<std::string> paths;
+    std::string dir;
+    while (takeOption(args, "--dir", dir)) {
+        listSessionFiles(dir, paths);
+    }
+    paths.insert(paths.end(), args.begin(), args.end());
+    if (paths.empty()) {
+        std::cerr << "No session files given.\n";
+        return 1;
+    }
+    if (!outPath.empty() && paths.size() != 1) {
+        std::cerr << "--out needs exactly one session\n";
+        return 1;
+    }
+
+    std::ofstream out;
+    if (!outPath.empty()) {
+        out.open(outPath, std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "Failed to open " << outPath << "\n";
+            return 1;
+        }
+        out << "timestamp_ms,event_type,x,y,key_code\n";
+    }
+
+    // Same ordering contract as the logger: events wait in a FIFO next to
+    // the recorder and leave with its decisions
+    auto simulate = [&](const std::string& path, FlightStats& stats) {
+        FlightRecorder recorder(options);
+        std::deque<SessionEvent> held;
+        auto drain = [&]() {
+            bool keep = false;
+            while (recorder.pop(keep)) {
+                if (keep && out.is_open()) {
+                    const SessionEvent& e = held.front();
+                    out << e.timestamp << "," << eventKindToString(e.kind) << ","
+                        << e.x << "," << e.y << "," << e.keyCode << "\n";
+                }
+                held.pop_front();
+            }
+        };
+        bool ok = forEachSessionEvent(path, [&](const SessionEvent& evt) {
+            recorder.push(evt);
+            held.push_back(evt);
+            drain();
+        });
+        recorder.finish();
+        drain();
+        stats = recorder.stats();
+        return ok;
+    };
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<FlightStats> results(paths.size());
+    std::vector<char> ok(paths.size(), 0);
+    {
+        WorkStealingPool pool(threads > 0 ? threads : std::thread::hardware_concurrency());
+        for (size_t i = 0; i < paths.size(); ++i) {
+            pool.submit([&, i]() { ok[i] = simulate(paths[i], results[i]); });
+        }
+        pool.wait();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    int failures = 0;
+    FlightStats total;
+    std::cout << "session,events,samples,triggers,window_samples,background_samples,kept_samples,"
+        "kept_events,kept_share\n";
+    auto row = [](const std::string& name, const FlightStats& f) {
+        std::cout << name << "," << f.events << "," << f.samples << "," << f.triggers << ","
+            << f.windowSamples << "," << f.backgroundSamples << "," << f.keptSamples() << ","
+            << f.keptEvents() << "," << (f.events > 0 ? static_cast<double>(f.keptEvents()) / f.events : 0.0)
+            << "\n";
+    };
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!ok[i]) {
+            ++failures;
+            continue;
+        }
+        row(paths[i], results[i]);
+        total.add(results[i]);
+    }
+    if (paths.size() > 1) {
+        row("total", total);
+    }
+    std::cerr << total.events << " events in " << static_cast<int>(seconds * 1000.0) << " ms; "
+        << total.overflows << " decided early on a full ring\n";
+    return failures == 0 ? 0 : 1;
+}
+
+// loss [--threads n] [--dir d]... files...
+// Per-source capture accounting from the session trailers, checked against
+// the rows actually in the file
+static int runLoss(std::vector<std::string> args)
+{
+    unsigned threads = takeUintOption(args, "--threads", 0);
+    std::vector<std::string> paths;
+    std::string dir;
+    while (takeOption(args, "--dir", dir)) {
+        listSessionFiles(dir, paths);
+    }
+    paths.insert(paths.end(), args.begin(), args.end());
+    if (paths.empty()) {
+        std::cerr << "No session files given.\n";
+        return 1;
+    }
+
+    const size_t kSources = static_cast<size_t>(CaptureSource::Count);
+    struct SessionLoss
+    {
+        bool          hasTrailer = false;
+        CaptureCounts counts[static_cast<size_t>(CaptureSource::Count)];
+        uint64_t      rows = 0;
+    };
+    std::vector<SessionLoss> results(paths.size());
+    std::vector<char> ok(paths.size(), 0);
+    {
+        WorkStealingPool pool(threads > 0 ? threads : std::thread::hardware_concurrency());
+        for (size_t i = 0; i < paths.size(); ++i) {
+            pool.submit([&, i]() {
+                SessionLoss& r = results[i];
+                SessionHeader trailer;
+                if (!readSessionTrailer(paths[i], trailer)) {
+                    return;
+                }
+                for (size_t k = 0; k < kSources; ++k) {
+                    const std::string* value = trailer.get(
+                        std::string("capture.") + captureSourceName(static_cast<CaptureSource>(k)));
+                    if (value && parseCaptureCounts(*value, r.counts[k])) {
+                        r.hasTrailer = true;
+                    }
+                }
+                ok[i] = forEachSessionEvent(paths[i], [&r](const SessionEvent&) { ++r.rows; });
+            });
+        }
+        pool.wait();
+    }
+
+    int failures = 0;
+    std::cout << "session,source,captured,received,gaps,reordered,filtered,failed,written,lost,lost_share\n";
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!ok[i]) {
+            ++failures;
+            continue;
+        }
+        const SessionLoss& r = results[i];
+        if (!r.hasTrailer) {
+            std::cerr << paths[i] << ": no capture trailer (recorded before loss accounting, "
+                "or the capture did not stop cleanly)\n";
+            continue;
+        }
+        uint64_t written = 0;
+        for (size_t k = 0; k < kSources; ++k) {
+            const CaptureCounts& c = r.counts[k];
+            written += c.written;
+            std::cout << paths[i] << "," << captureSourceName(static_cast<CaptureSource>(k)) << ","
+                << c.captured << "," << c.received << "," << c.gaps << "," << c.reordered << ","
+                << c.filtered << "," << c.failed << "," << c.written << "," << c.lost() << ","
+                << (c.captured > 0 ? static_cast<double>(c.lost()) / c.captured : 0.0) << "\n";
+        }
+        if (r.rows != written) {
+            std::cerr << paths[i] << ": trailer says " << written << " rows were written, file has "
+                << r.rows << "\n";
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+// metrics [--name n] [--watch ms] [--count n]
+// Reads the capture metrics a running tracker (or replay --metrics)
+// publishes in shared memory; read-only, the capture never notices
+static int runMetrics(std::vector<std::string> args)
+{
+    std::string name = kDefaultMetricsName;
+    takeOption(args, "--name", name);
+    const uint32_t watchMs = takeUintOption(args, "--watch", 0);
+    const uint32_t count = takeUintOption(args, "--count", 0);
+    if (!args.empty()) {
+        std::cerr << "Usage: analyzer metrics [--name n] [--watch ms] [--count n]\n";
+        return 1;
+    }
+
+    MetricsSnapshot previous, now;
+    bool havePrevious = false;
+    for (uint32_t i = 0; watchMs == 0 ? i < 1 : (count == 0 || i < count); ++i) {
+        if (i > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(watchMs));
+        }
+        if (!readSharedMetrics(name, now)) {
+            std::cerr << "No capture metrics published as " << name << "\n";
+            return 1;
+        }
+        printMetrics(std::cout, now, havePrevious ? &previous : nullptr);
+        std::cout.flush();
+        previous = now;
+        havePrevious = true;
+    }
+    return 0;
+}
+
+//----------------------------------------------------//
+//                      main()
+//----------------------------------------------------//
+
+static void printUsage()
+{
+    std::cout << "Skillshot session analyzer\n"
+        << "Usage: analyzer <command> [options] files...\n"
+        << "Commands:\n"
+        << "  panic [--window ms] [--bucket ms] [--trigger n] [--release n] files...\n"
+        << "  simplify [--tolerance px] [--method rdp|vw] [--metric perp|sync] [--out file] files...\n"
+        << "  timeline build [--column c] files...\n"
+        << "  timeline query --column c [--from ms] [--to ms] [--points n] file\n"
+        << "  near [--key K] [--radius px] [--window ms] [--click left|right|any] [--threads n] files...\n"
+        << "  cluster [--k n] [--keys QWER] [--lookback ms] [--batch n] [--iterations n] [--threads n] [--out file] files...\n"
+        << "  batch [--threads n] [--chunk-mb n] [--per-file] [--cache dir] [--dir d]... files...\n"
+        << "  query [--explain] [--threads n] [--no-store] [--game n] [--dir d]... \"<query>\" files...\n"
+        << "  segments [--bin s] [--idle-gap s] [--min-game s] [--rebuild] files...\n"
+        << "  asof --with timeline [--time-col c] [--time-unit ms|s] [--by field=column]... [--tolerance ms] [--offset ms|auto] [--all] session\n"
+        << "  align --with timeline [--time-col c] [--time-unit ms|s] [--by field=column]... [--all] [--dry-run] session\n"
+        << "  changes [--detector cusum|bayes|both] [--warmup n] [--threshold sd] [--hazard n] [--keys QWER] [--threads n] [--dir d]... files...\n"
+        << "  spectrum [--rate hz] [--window n] [--hop n] [--min-speed px/s] [--spectrogram] [--threads n] [--dir d]... files...\n"
+        << "  hmm train [--iterations n] [--bin ms] [--threads n] [--out model] [--dir d]... files...\n"
+        << "  hmm decode [--model file] [--bin ms] [--runs] [--threads n] [--dir d]... files...\n"
+        << "  gestures [--templates file] [--no-builtin] [--min-score pct] [--pause ms] [--min-length px] [--threads n] [--dir d]... files...\n"
+        << "  gestures learn --name n --from ms --to ms [--templates file] session\n"
+        << "  entropy [--order n] [--table-bits n] [--lookback ms] [--keys QWER] [--window s] [--windows] [--threads n] [--dir d]... files...\n"
+        << "  castmodel train [--labels file] [--label-col c] [--time-col c] [--time-unit ms|s] [--offset ms] [--tolerance ms] [--keys QWER] [--epochs n] [--batch n] [--holdout pct] [--out model] [--dir d]... sessions...\n"
+        << "  castmodel score [--model file] [--keys QWER] [--threads n] [--dir d]... files...\n"
+        << "  keys [--by-game] [--keys QWER] [--repeat-gap ms] [--sketches] [--threads n] [--dir d]... files...\n"
+        << "  replay [--speed x|max] [--max-gap ms] [--spin us] [--out file] [--flush s] [--tolerance px] [--restamp] [--live] [--flight] [--metrics] [--trace file] session\n"
+        << "  flight [--pre ms] [--post ms] [--background ms] [--keys QWER] [--clicks] [--out file] [--threads n] [--dir d]... files...\n"
+        << "  loss [--threads n] [--dir d]... files...\n"
+        << "  metrics [--name n] [--watch ms] [--count n]\n";
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+
+    std::string cmd = argv[1];
+    std::vector<std::string> args(argv + 2, argv + argc);
+
+    if (cmd == "panic") {
+        return runPanic(args);
+    }
+    if (cmd == "simplify") {
+        return runSimplify(args);
+    }
+    if (cmd == "timeline") {
+        return runTimeline(args);
+    }
+    if (cmd == "near") {
+        return runNear(args);
+    }
+    if (cmd == "cluster") {
+        return runCluster(args);
+    }
+    if (cmd == "batch") {
+        return runBatchCommand(args);
+    }
+    if (cmd == "query") {
+        return runQueryCommand(args);
+    }
+    if (cmd == "segments") {
+        return runSegments(args);
+    }
+    if (cmd == "asof") {
+        return runAsOf(args);
+    }
+    if (cmd == "align") {
+        return runAlign(args);
+    }
+    if (cmd == "changes") {
+        return runChanges(args);
+    }
+    if (cmd == "spectrum") {
+        return runSpectrum(args);
+    }
+    if (cmd == "hmm") {
+        return runHmm(args);
+    }
+    if (cmd == "gestures") {
+        return runGestures(args);
+    }
+    if (cmd == "entropy") {
+        return runEntropy(args);
+    }
+    if (cmd == "castmodel") {
+        return runCastModel(args);
+    }
+    if (cmd == "keys") {
+        return runKeys(args);
+    }
+    if (cmd == "replay") {
+        return runReplay(args);
+    }
+    if (cmd == "flight") {
+        return runFlight(args);
+    }
+    if (cmd == "loss") {
+        return runLoss(args);
+    }
+    if (cmd == "metrics") {
+        return runMetrics(args);
+    }
+
+    std::cerr << "Unknown command: " << cmd << "\n";
+    printUsage();
+    return 1;
+}
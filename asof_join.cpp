@@ -0,0 +1,570 @@
+#include "asof_join.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <unordered_map>
+
+#include "clock_align.h"
+#include "session_reader.h"
+
+//----------------------------------------------------//
+//            TimelineReader Implementation
+//----------------------------------------------------//
+
+TimelineReader::~TimelineReader()
+{
+    if (m_file) {
+        std::fclose(m_file);
+    }
+}
+
+int TimelineReader::get()
+{
+    if (m_pos == m_len) {
+        m_len = std::fread(m_buffer.data(), 1, m_buffer.size(), m_file);
+        m_pos = 0;
+        if (m_len == 0) {
+            return EOF;
+        }
+    }
+    return static_cast<unsigned char>(m_buffer[m_pos++]);
+}
+
+int TimelineReader::peekChar()
+{
+    int c = get();
+    if (c != EOF) {
+        --m_pos;
+    }
+    return c;
+}
+
+void TimelineReader::skipSpace()
+{
+    int c;
+    while ((c = peekChar()) != EOF && std::isspace(c)) {
+        get();
+    }
+}
+
+bool TimelineReader::readCsvLine(std::vector<std::string>& fields)
+{
+    fields.clear();
+    std::string field;
+    bool quoted = false, any = false;
+    int c;
+    while ((c = get()) != EOF) {
+        any = true;
+        if (quoted) {
+            if (c == '"') {
+                if (peekChar() == '"') {
+                    field.push_back('"');
+                    get();
+                }
+                else {
+                    quoted = false;
+                }
+            }
+            else {
+                field.push_back(static_cast<char>(c));
+            }
+            continue;
+        }
+        if (c == '"') {
+            quoted = true;
+        }
+        else if (c == ',') {
+            fields.push_back(field);
+            field.clear();
+        }
+        else if (c == '\n') {
+            break;
+        }
+        else if (c != '\r') {
+            field.push_back(static_cast<char>(c));
+        }
+    }
+    if (!any) {
+        return false;
+    }
+    fields.push_back(field);
+    return true;
+}
+
+bool TimelineReader::readJsonString(std::string& out)
+{
+    out.clear();
+    if (get() != '"') {
+        return false;
+    }
+    int c;
+    while ((c = get()) != EOF) {
+        if (c == '"') {
+            return true;
+        }
+        if (c == '\\') {
+            c = get();
+            switch (c) {
+            case 'n': out.push_back('\n'); break;
+            case 't': out.push_back('\t'); break;
+            case 'r': out.push_back('\r'); break;
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'u':
+                // Non-ASCII escapes are not needed for timelines; keep them verbatim
+                out += "\\u";
+                break;
+            case EOF: return false;
+            default:  out.push_back(static_cast<char>(c)); break;
+            }
+            continue;
+        }
+        out.push_back(static_cast<char>(c));
+    }
+    return false;
+}
+
+bool TimelineReader::readJsonValue(std::string& out)
+{
+    skipSpace();
+    int c = peekChar();
+    if (c == '"') {
+        return readJsonString(out);
+    }
+
+    out.clear();
+    if (c == '{' || c == '[') {
+        // Nested value: keep the raw text
+        int depth = 0;
+        bool inString = false;
+        while ((c = get()) != EOF) {
+            out.push_back(static_cast<char>(c));
+            if (inString) {
+                if (c == '\\') {
+                    c = get();
+                    if (c == EOF) return false;
+                    out.push_back(static_cast<char>(c));
+                }
+                else if (c == '"') {
+                    inString = false;
+                }
+                continue;
+            }
+            if (c == '"') inString = true;
+            else if (c == '{' || c == '[') ++depth;
+            else if ((c == '}' || c == ']') && --depth == 0) return true;
+        }
+        return false;
+    }
+
+    // Number, true, false or null
+    while ((c = peekChar()) != EOF && c != ',' && c != '}' && c != ']' && !std::isspace(c)) {
+        out.push_back(static_cast<char>(get()));
+    }
+    if (out == "null") {
+        out.clear();
+    }
+    return true;
+}
+
+bool TimelineReader::readJsonObject(std::vector<std::pair<std::string, std::string>>& fields)
+{
+    fields.clear();
+
+    // Skip separators between objects (array commas, newlines, the closing ']')
+    int c;
+    while ((c = peekChar()) != EOF && c != '{') {
+        get();
+    }
+    if (c == EOF) {
+        return false;
+    }
+    get();
+
+    while (true) {
+        skipSpace();
+        c = peekChar();
+        if (c == '}') {
+            get();
+            return true;
+        }
+        std::string key, value;
+        if (!readJsonString(key)) {
+            break;
+        }
+        skipSpace();
+        if (get() != ':' || !readJsonValue(value)) {
+            break;
+        }
+        fields.emplace_back(key, value);
+        skipSpace();
+        c = get();
+        if (c == '}') {
+            return true;
+        }
+        if (c != ',') {
+            break;
+        }
+    }
+    std::cerr << "Malformed JSON object in " << m_path << " (row " << m_row << ")\n";
+    return false;
+}
+
+bool TimelineReader::open(const std::string& path, const std::string& timeColumn, double timeScale)
+{
+    m_path = path;
+    m_timeScale = timeScale;
+    m_file = std::fopen(path.c_str(), "rb");
+    if (!m_file) {
+        std::cerr << "Failed to open timeline: " << path << "\n";
+        return false;
+    }
+    m_buffer.resize(1 << 20);
+
+    // The first non-blank character tells the format apart
+    skipSpace();
+    int c = peekChar();
+    m_json = c == '[' || c == '{';
+
+    if (m_json) {
+        // Columns come from the first object; rewind so next() reads it again
+        // (the object scan skips the leading '[')
+        std::vector<std::pair<std::string, std::string>> fields;
+        if (!readJsonObject(fields)) {
+            std::cerr << "Timeline has no rows: " << path << "\n";
+            return false;
+        }
+        for (const auto& f : fields) {
+            m_columns.push_back(f.first);
+        }
+        if (std::fseek(m_file, 0, SEEK_SET) != 0) {
+            std::cerr << "Failed to rewind timeline: " << path << "\n";
+            return false;
+        }
+        m_pos = m_len = 0;
+    }
+    else if (!readCsvLine(m_columns)) {
+        std::cerr << "Timeline has no header: " << path << "\n";
+        return false;
+    }
+
+    m_timeIndex = columnIndex(timeColumn);
+    if (m_timeIndex < 0) {
+        std::cerr << "Timeline " << path << " has no '" << timeColumn << "' column\n";
+        return false;
+    }
+    return true;
+}
+
+int TimelineReader::columnIndex(const std::string& name) const
+{
+    for (size_t i = 0; i < m_columns.size(); ++i) {
+        if (m_columns[i] == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool TimelineReader::toRow(std::vector<std::string>& fields, TimelineRow& row)
+{
+    if (static_cast<size_t>(m_timeIndex) >= fields.size()) {
+        return false;
+    }
+    const char* text = fields[m_timeIndex].c_str();
+    char* end = nullptr;
+    double t = std::strtod(text, &end);
+    if (end == text) {
+        return false; // no usable time
+    }
+    fields.resize(m_columns.size());
+    row.timeMs = t * m_timeScale;
+    row.values.swap(fields);
+    return true;
+}
+
+bool TimelineReader::next(TimelineRow& row)
+{
+    std::vector<std::string> fields;
+    while (true) {
+        ++m_row;
+        if (m_json) {
+            std::vector<std::pair<std::string, std::string>> object;
+            if (!readJsonObject(object)) {
+                return false;
+            }
+            fields.assign(m_columns.size(), std::string());
+            for (auto& kv : object) {
+                int i = columnIndex(kv.first);
+                if (i >= 0) {
+                    fields[i].swap(kv.second);
+                }
+            }
+        }
+        else if (!readCsvLine(fields)) {
+            return false;
+        }
+        if (toRow(fields, row)) {
+            return true;
+        }
+        // Blank or malformed row: skip it
+    }
+}
+
+//----------------------------------------------------//
+//                   Join Keys
+//----------------------------------------------------//
+
+namespace {
+
+const char kKeySeparator = '\x1f';
+
+std::string upper(const std::string& s)
+{
+    std::string out(s);
+    for (auto& c : out) {
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    return out;
+}
+
+// Value of an event field used as a join key
+std::string eventField(const SessionEvent& evt, const std::string& field)
+{
+    if (field == "type") {
+        return eventKindToString(evt.kind);
+    }
+    if (field == "key") {
+        switch (evt.kind) {
+        case EventKind::KeyDown:
+        case EventKind::KeyUp:
+            return vkToKeyName(evt.keyCode);
+        case EventKind::MouseLeftDown:
+        case EventKind::MouseLeftUp:
+            return "LMB";
+        case EventKind::MouseRightDown:
+        case EventKind::MouseRightUp:
+            return "RMB";
+        default:
+            return "";
+        }
+    }
+    return "";
+}
+
+} // namespace
+
+//----------------------------------------------------//
+//              AsOfKeys Implementation
+//----------------------------------------------------//
+
+bool AsOfKeys::init(const AsOfOptions& options, const TimelineReader& reader)
+{
+    m_eventFields.clear();
+    m_columns.clear();
+    for (const auto& b : options.by) {
+        if (b.first != "key" && b.first != "type") {
+            std::cerr << "Unknown event field for --by: " << b.first << " (use key or type)\n";
+            return false;
+        }
+        int c = reader.columnIndex(b.second);
+        if (c < 0) {
+            std::cerr << "Timeline has no '" << b.second << "' column\n";
+            return false;
+        }
+        m_eventFields.push_back(b.first);
+        m_columns.push_back(c);
+    }
+    return true;
+}
+
+std::string AsOfKeys::ofEvent(const SessionEvent& evt) const
+{
+    std::string key;
+    for (const auto& f : m_eventFields) {
+        key += upper(eventField(evt, f));
+        key.push_back(kKeySeparator);
+    }
+    return key;
+}
+
+std::string AsOfKeys::ofRow(const TimelineRow& row) const
+{
+    std::string key;
+    for (int c : m_columns) {
+        key += upper(row.values[c]);
+        key.push_back(kKeySeparator);
+    }
+    return key;
+}
+
+bool isJoinedEvent(const AsOfOptions& options, const SessionEvent& evt)
+{
+    return !options.pressesOnly || isPressEvent(evt.kind);
+}
+
+//----------------------------------------------------//
+//                Offset Estimation
+//----------------------------------------------------//
+
+bool estimateTimelineOffset(const std::string& sessionPath, const std::string& timelinePath,
+    const AsOfOptions& options, int64_t& offsetMs, double& support)
+{
+    const size_t kMaxAnchors = 1000;        // events from the start of the session
+    const size_t kMaxRows = 10000;          // rows from the start of the timeline
+    const uint64_t kMaxPairs = 20000000;
+    const int64_t kBinMs = 50;
+
+    TimelineReader reader;
+    AsOfKeys keys;
+    if (!reader.open(timelinePath, options.timeColumn, options.timeScale) ||
+        !keys.init(options, reader)) {
+        return false;
+    }
+
+    std::unordered_map<std::string, std::vector<double>> rowsByKey;
+    TimelineRow row;
+    for (size_t i = 0; i < kMaxRows && reader.next(row); ++i) {
+        rowsByKey[keys.ofRow(row)].push_back(row.timeMs);
+    }
+
+    std::vector<std::pair<uint32_t, std::string>> anchors;
+    forEachSessionEventInRange(sessionPath, 0, 8ull << 20, [&](const SessionEvent& evt) {
+        if (anchors.size() < kMaxAnchors && isJoinedEvent(options, evt)) {
+            anchors.emplace_back(evt.timestamp, keys.ofEvent(evt));
+        }
+    });
+    if (anchors.empty() || rowsByKey.empty()) {
+        return false;
+    }
+
+    // Every (event, row) pair with the same keys votes for its time difference
+    std::unordered_map<int64_t, uint32_t> votes;
+    uint64_t pairs = 0;
+    for (const auto& a : anchors) {
+        auto it = rowsByKey.find(a.second);
+        if (it == rowsByKey.end()) {
+            continue;
+        }
+        for (double t : it->second) {
+            const int64_t diff = static_cast<int64_t>(std::floor(a.first - t));
+            ++votes[diff >= 0 ? diff / kBinMs : (diff - kBinMs + 1) / kBinMs];
+        }
+        if ((pairs += it->second.size()) > kMaxPairs) {
+            break;
+        }
+    }
+    if (votes.empty()) {
+        return false;
+    }
+
+    int64_t peak = 0;
+    uint32_t best = 0;
+    for (const auto& v : votes) {
+        if (v.second > best) {
+            best = v.second;
+            peak = v.first;
+        }
+    }
+
+    // Refine: median of the differences around the peak; support = share of
+    // the anchors that could pair at all which have a partner there
+    std::vector<double> near;
+    size_t agreeing = 0, pairable = 0;
+    for (const auto& a : anchors) {
+        auto it = rowsByKey.find(a.second);
+        if (it == rowsByKey.end()) {
+            continue;
+        }
+        ++pairable;
+        bool agrees = false;
+        for (double t : it->second) {
+            const double diff = a.first - t;
+            if (diff >= (peak - 1) * kBinMs && diff < (peak + 2) * kBinMs) {
+                near.push_back(diff);
+                agrees = true;
+            }
+        }
+        agreeing += agrees ? 1 : 0;
+    }
+    std::nth_element(near.begin(), near.begin() + near.size() / 2, near.end());
+    offsetMs = static_cast<int64_t>(std::llround(near[near.size() / 2]));
+    support = static_cast<double>(agreeing) / pairable;
+    return true;
+}
+
+//----------------------------------------------------//
+//                  Merge Join
+//----------------------------------------------------//
+
+bool asofJoin(const std::string& sessionPath, const std::string& timelinePath,
+    const AsOfOptions& options, const AsOfCallback& fn, AsOfStats& stats,
+    std::vector<std::string>* timelineColumns)
+{
+    stats = AsOfStats();
+    stats.offsetMs = options.offsetMs;
+    stats.clockScale = options.clockScale;
+
+    // The clock stored by align wins over a quick estimate
+    double offset = static_cast<double>(options.offsetMs);
+    ClockFit clock;
+    if (options.useSessionClock && loadSessionClock(sessionPath, clock)) {
+        offset = clock.offsetMs;
+        stats.offsetMs = static_cast<int64_t>(std::llround(offset));
+        stats.clockScale = clock.scale;
+        stats.sessionClock = true;
+    }
+    else if (options.estimateOffset) {
+        if (!estimateTimelineOffset(sessionPath, timelinePath, options, stats.offsetMs, stats.offsetSupport)) {
+            std::cerr << "Could not estimate the clock offset; using " << options.offsetMs << " ms\n";
+            stats.offsetMs = options.offsetMs;
+        }
+        offset = static_cast<double>(stats.offsetMs);
+    }
+
+    TimelineReader reader;
+    AsOfKeys keys;
+    if (!reader.open(timelinePath, options.timeColumn, options.timeScale) ||
+        !keys.init(options, reader)) {
+        return false;
+    }
+    if (timelineColumns) {
+        *timelineColumns = reader.columns();
+    }
+
+    // Latest row per key value seen so far
+    std::unordered_map<std::string, TimelineRow> latest;
+    TimelineRow pending;
+    bool hasPending = reader.next(pending);
+
+    return forEachSessionEvent(sessionPath, [&](const SessionEvent& evt) {
+        if (!isJoinedEvent(options, evt)) {
+            return;
+        }
+        ++stats.events;
+
+        // Advance the timeline up to the event (in timeline time)
+        const double t = (static_cast<double>(evt.timestamp) - offset) / stats.clockScale;
+        while (hasPending && pending.timeMs <= t) {
+            ++stats.timelineRows;
+            std::string key = keys.ofRow(pending);
+            latest[key] = std::move(pending);
+            pending = TimelineRow();
+            hasPending = reader.next(pending);
+        }
+
+        auto it = latest.find(keys.ofEvent(evt));
+        if (it != latest.end()) {
+            const int64_t lag = static_cast<int64_t>(std::llround(t - it->second.timeMs));
+            if (lag <= static_cast<int64_t>(options.toleranceMs)) {
+                ++stats.matched;
+                fn(evt, &it->second, lag);
+                return;
+            }
+        }
+        fn(evt, nullptr, 0);
+    });
+}
@@ -0,0 +1,132 @@
+// asof_join.h
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "session_event.h"
+
+//----------------------------------------------------//
+//            External Timelines (CSV / JSON)
+//----------------------------------------------------//
+
+// One row of an external timeline (replay export: positions, cooldowns, ...)
+struct TimelineRow
+{
+    double                   timeMs = 0.0;  // already scaled to ms
+    std::vector<std::string> values;        // one per column, as text
+};
+
+// Streams a timeline without loading it. Accepts CSV with a header row, or
+// JSON: an array of flat objects or one object per line. Nested values are
+// kept as raw JSON text. Rows must be sorted by time.
+class TimelineReader {
+public:
+    TimelineReader() {}
+    ~TimelineReader();
+
+    TimelineReader(const TimelineReader&) = delete;
+    TimelineReader& operator=(const TimelineReader&) = delete;
+
+    // 'timeScale' converts the time column to ms (1000 for seconds)
+    bool open(const std::string& path, const std::string& timeColumn, double timeScale = 1.0);
+    bool next(TimelineRow& row);
+
+    const std::vector<std::string>& columns() const { return m_columns; }
+    int columnIndex(const std::string& name) const;   // -1 if absent
+
+private:
+    int  get();
+    int  peekChar();
+    void skipSpace();
+    bool readCsvLine(std::vector<std::string>& fields);
+    bool readJsonObject(std::vector<std::pair<std::string, std::string>>& fields);
+    bool readJsonString(std::string& out);
+    bool readJsonValue(std::string& out);
+    bool toRow(std::vector<std::string>& fields, TimelineRow& row);
+
+private:
+    FILE*                    m_file = nullptr;
+    std::string              m_path;
+    std::vector<char>        m_buffer;
+    size_t                   m_pos = 0;
+    size_t                   m_len = 0;
+    bool                     m_json = false;
+    std::vector<std::string> m_columns;
+    int                      m_timeIndex = -1;
+    double                   m_timeScale = 1.0;
+    uint64_t                 m_row = 0;
+};
+
+//----------------------------------------------------//
+//                  As-Of Join
+//----------------------------------------------------//
+
+struct AsOfOptions
+{
+    std::string timeColumn = "timestamp_ms";
+    double      timeScale = 1.0;
+
+    // Equality keys: (event field, timeline column). Event fields: key (key
+    // name, LMB/RMB for clicks), type (event type).
+    std::vector<std::pair<std::string, std::string>> by;
+
+    uint32_t    toleranceMs = UINT32_MAX;   // older matches are treated as missing
+    bool        pressesOnly = true;         // join key/button presses only
+
+    // Event time = offsetMs + clockScale * timeline time. With estimateOffset
+    // the offset is found by voting over the first pairs of both sides
+    // instead; with useSessionClock a clock fit stored by align
+    // (see clock_align.h) takes precedence over both.
+    int64_t     offsetMs = 0;
+    double      clockScale = 1.0;
+    bool        estimateOffset = false;
+    bool        useSessionClock = true;
+};
+
+struct AsOfStats
+{
+    uint64_t events = 0;     // left rows joined
+    uint64_t matched = 0;
+    uint64_t timelineRows = 0;
+    int64_t  offsetMs = 0;   // the offset used
+    double   clockScale = 1.0;
+    double   offsetSupport = 0.0; // share of anchor events that agree with it
+    bool     sessionClock = false; // mapping came from the clock stored by align
+};
+
+// Join key values of events and timeline rows ("by" columns, upper-cased)
+class AsOfKeys {
+public:
+    bool init(const AsOfOptions& options, const TimelineReader& reader);
+
+    std::string ofEvent(const SessionEvent& evt) const;
+    std::string ofRow(const TimelineRow& row) const;
+
+private:
+    std::vector<std::string> m_eventFields;
+    std::vector<int>         m_columns;
+};
+
+// Whether the join considers this event at all (presses unless pressesOnly is off)
+bool isJoinedEvent(const AsOfOptions& options, const SessionEvent& evt);
+
+// Called for every joined event; 'match' is the latest timeline row at or
+// before the event (same keys), or nullptr
+using AsOfCallback = std::function<void(const SessionEvent& evt, const TimelineRow* match,
+    int64_t lagMs)>;
+
+// Estimates event time minus timeline time from the first few thousand rows
+// of each side. Returns false if nothing lines up.
+bool estimateTimelineOffset(const std::string& sessionPath, const std::string& timelinePath,
+    const AsOfOptions& options, int64_t& offsetMs, double& support);
+
+// Merge join in one pass over both sides: O(events + timeline rows), memory
+// proportional to the number of distinct key values
+bool asofJoin(const std::string& sessionPath, const std::string& timelinePath,
+    const AsOfOptions& options, const AsOfCallback& fn, AsOfStats& stats,
+    std::vector<std::string>* timelineColumns = nullptr);
@@ -0,0 +1,436 @@
+#include "batch_driver.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+#if defined(_WIN32)
+#define NOMINMAX // keep std::min/std::max usable
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#include "analysis_cache.h"
+#include "session_reader.h"
+#include "thread_pool.h"
+
+//----------------------------------------------------//
+//            SessionSummary Implementation
+//----------------------------------------------------//
+
+static double cursorStep(const PathPoint& a, const PathPoint& b)
+{
+    return std::hypot(static_cast<double>(b.x) - a.x, static_cast<double>(b.y) - a.y);
+}
+
+void SessionSummary::add(const SessionEvent& evt)
+{
+    ++events;
+    ++kindCounts[static_cast<size_t>(evt.kind)];
+
+    uint32_t ch = pressChannel(evt);
+    if (ch != kNoChannel) {
+        ++presses[ch];
+    }
+
+    if (!hasEvents) {
+        firstMs = evt.timestamp;
+        hasEvents = true;
+    }
+    lastMs = evt.timestamp;
+
+    if (evt.kind == EventKind::MousePos) {
+        PathPoint p{ evt.x, evt.y, evt.timestamp };
+        if (hasCursor) {
+            cursorPathPx += cursorStep(lastCursor, p);
+        }
+        else {
+            firstCursor = p;
+            hasCursor = true;
+        }
+        lastCursor = p;
+    }
+}
+
+void SessionSummary::combine(const SessionSummary& other)
+{
+    files += other.files;
+    events += other.events;
+    durationMs += other.durationMs;
+    for (size_t i = 0; i < kindCounts.size(); ++i) {
+        kindCounts[i] += other.kindCounts[i];
+    }
+    for (size_t i = 0; i < presses.size(); ++i) {
+        presses[i] += other.presses[i];
+    }
+    cursorPathPx += other.cursorPathPx;
+    panicEpisodes += other.panicEpisodes;
+    panicPresses += other.panicPresses;
+}
+
+void SessionSummary::append(const SessionSummary& later)
+{
+    // The segment that crosses the chunk boundary belongs to neither chunk
+    if (hasCursor && later.hasCursor) {
+        cursorPathPx += cursorStep(lastCursor, later.firstCursor);
+    }
+    combine(later);
+
+    if (later.hasEvents) {
+        if (!hasEvents) {
+            firstMs = later.firstMs;
+            hasEvents = true;
+        }
+        lastMs = later.lastMs;
+    }
+    if (later.hasCursor) {
+        if (!hasCursor) {
+            firstCursor = later.firstCursor;
+            hasCursor = true;
+        }
+        lastCursor = later.lastCursor;
+    }
+}
+
+void SessionSummary::finishFile()
+{
+    ++files;
+    if (hasEvents) {
+        durationMs += lastMs - firstMs;
+    }
+}
+
+//----------------------------------------------------//
+//                  Batch Driver
+//----------------------------------------------------//
+
+const char* batchStageName(int stage)
+{
+    switch (stage) {
+    case kStageParse:     return "parse";
+    case kStageSummarize: return "summarize";
+    case kStageAnalyze:   return "analyze";
+    case kStageMerge:     return "merge";
+    case kStageCache:     return "cache";
+    default:              return "?";
+    }
+}
+
+namespace {
+
+using StageClock = std::array<std::atomic<uint64_t>, kStageCount>;
+
+// Adds the calling thread's CPU time for the scope to one stage
+class StageTimer {
+public:
+    StageTimer(StageClock& clock, BatchStage stage)
+        : m_clock(clock), m_stage(stage), m_start(threadCpuTimeNs())
+    {
+    }
+    ~StageTimer()
+    {
+        m_clock[m_stage].fetch_add(threadCpuTimeNs() - m_start);
+    }
+
+private:
+    StageClock& m_clock;
+    BatchStage  m_stage;
+    uint64_t    m_start;
+};
+
+struct FileJob
+{
+    std::string                                 path;
+    uint64_t                                    size = 0;
+    bool                                        hashed = false;
+    uint64_t                                    contentHash = 0;
+    std::vector<std::pair<uint64_t, uint64_t>>  chunks;
+    std::vector<SessionSummary>                 chunkSummaries;
+    std::vector<std::vector<SessionEvent>>      chunkPresses;   // presses and releases, for per-file analyzers
+    std::atomic<size_t>                         remaining{ 0 };
+    std::atomic<bool>                           failed{ false };
+};
+
+// Bump when SessionSummary or the way it is computed changes
+const uint32_t kSummaryVersion = 2;   // 2: panic detection skips auto-repeat
+
+static_assert(std::is_trivially_copyable<SessionSummary>::value,
+    "SessionSummary is cached as raw bytes");
+
+AnalyzerId summaryAnalyzerId(const BatchOptions& options)
+{
+    const uint64_t params[] = {
+        sizeof(SessionSummary),
+        options.panicRule.windowMs,
+        options.panicRule.bucketMs,
+        options.panicRule.triggerCount,
+        options.panicRule.releaseCount,
+        options.panicRule.repeatGapMs
+    };
+    AnalyzerId id;
+    id.name = "summary";
+    id.version = kSummaryVersion;
+    id.paramsHash = hashBytes(params, sizeof(params));
+    return id;
+}
+
+std::string serializeSummary(const SessionSummary& summary)
+{
+    return std::string(reinterpret_cast<const char*>(&summary), sizeof(summary));
+}
+
+bool deserializeSummary(const std::string& payload, SessionSummary& summary)
+{
+    if (payload.size() != sizeof(summary)) {
+        return false;
+    }
+    std::memcpy(&summary, payload.data(), sizeof(summary));
+    return true;
+}
+
+} // namespace
+
+bool runBatch(const std::vector<std::string>& paths, const BatchOptions& options,
+    BatchReport& report)
+{
+    report = BatchReport();
+    const auto wallStart = std::chrono::steady_clock::now();
+
+    unsigned threads = options.threads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Largest files first so the long poles start early
+    std::vector<std::unique_ptr<FileJob>> jobs;
+    for (const auto& path : paths) {
+        std::unique_ptr<FileJob> job(new FileJob());
+        job->path = path;
+        job->size = sessionFileSize(path);
+        splitSessionFile(job->size, options.chunkBytes, job->chunks);
+        job->chunkSummaries.resize(job->chunks.size());
+        job->chunkPresses.resize(job->chunks.size());
+        job->remaining.store(job->chunks.size());
+        report.bytes += job->size;
+        jobs.push_back(std::move(job));
+    }
+    std::sort(jobs.begin(), jobs.end(),
+        [](const std::unique_ptr<FileJob>& a, const std::unique_ptr<FileJob>& b) {
+            return a->size > b->size;
+        });
+
+    StageClock stageCpu;
+    for (auto& s : stageCpu) {
+        s.store(0);
+    }
+    std::vector<SessionSummary> perWorker(threads);
+    std::mutex perFileMutex;
+    std::atomic<size_t> failures{ 0 };
+    std::atomic<size_t> cachedFiles{ 0 };
+    std::atomic<size_t> computedFiles{ 0 };
+    std::atomic<uint64_t> tasks{ 0 };
+    const AnalyzerId analyzerId = summaryAnalyzerId(options);
+
+    WorkStealingPool pool(threads);
+
+    // Folds a finished session into this worker's accumulator
+    auto publish = [&](FileJob* job, const SessionSummary& summary) {
+        StageTimer timer(stageCpu, kStageMerge);
+        perWorker[static_cast<size_t>(WorkStealingPool::currentWorker())].combine(summary);
+        if (options.keepPerFile) {
+            std::lock_guard<std::mutex> lock(perFileMutex);
+            report.perFile.emplace_back(job->path, summary);
+        }
+    };
+
+    // Per-file task: stitch the chunks, run the stateful analyzers, fold the
+    // result into this worker's accumulator
+    auto finishFile = [&](FileJob* job) {
+        if (job->failed.load()) {
+            failures.fetch_add(1);
+            return;
+        }
+
+        SessionSummary summary;
+        {
+            StageTimer timer(stageCpu, kStageMerge);
+            for (const auto& part : job->chunkSummaries) {
+                summary.append(part);
+            }
+        }
+        {
+            StageTimer timer(stageCpu, kStageAnalyze);
+            PanicDetector detector(options.panicRule);
+            std::vector<PanicEpisode> episodes;
+            for (const auto& presses : job->chunkPresses) {
+                for (const auto& evt : presses) {
+                    detector.onEvent(evt, episodes);
+                }
+            }
+            detector.finish(episodes);
+            summary.panicEpisodes = episodes.size();
+            for (const auto& ep : episodes) {
+                summary.panicPresses += ep.pressCount;
+            }
+        }
+        summary.finishFile();
+        publish(job, summary);
+        computedFiles.fetch_add(1);
+
+        if (options.cache && job->hashed) {
+            StageTimer timer(stageCpu, kStageCache);
+            options.cache->store(job->contentHash, analyzerId, serializeSummary(summary));
+        }
+
+        std::vector<SessionSummary>().swap(job->chunkSummaries);
+        std::vector<std::vector<SessionEvent>>().swap(job->chunkPresses);
+    };
+
+    // Per-chunk task: parse a byte range and summarize it
+    auto runChunk = [&](FileJob* job, size_t index) {
+        std::vector<SessionEvent> events;
+        bool ok = true;
+        {
+            StageTimer timer(stageCpu, kStageParse);
+            ok = forEachSessionEventInRange(job->path,
+                job->chunks[index].first, job->chunks[index].second,
+                [&events](const SessionEvent& evt) { events.push_back(evt); });
+        }
+        if (!ok) {
+            job->failed.store(true);
+        }
+        else {
+            StageTimer timer(stageCpu, kStageSummarize);
+            SessionSummary& part = job->chunkSummaries[index];
+            std::vector<SessionEvent>& presses = job->chunkPresses[index];
+            for (const auto& evt : events) {
+                part.add(evt);
+                // Releases too: PanicDetector needs them to tell a new
+                // press from auto-repeat of a held key
+                if (pressChannel(evt) != kNoChannel || releaseChannel(evt) != kNoChannel) {
+                    presses.push_back(evt);
+                }
+            }
+        }
+
+        // Last chunk in: the file's own task goes on this worker's deque
+        if (job->remaining.fetch_sub(1) == 1) {
+            tasks.fetch_add(1);
+            pool.submit([&finishFile, job]() { finishFile(job); });
+        }
+    };
+
+    auto submitChunks = [&](FileJob* job) {
+        for (size_t c = 0; c < job->chunks.size(); ++c) {
+            tasks.fetch_add(1);
+            pool.submit([&runChunk, job, c]() { runChunk(job, c); });
+        }
+    };
+
+    // Cache probe: serve the file from the cache or queue its chunks
+    auto probeFile = [&](FileJob* job) {
+        SessionSummary cached;
+        bool hit = false;
+        {
+            StageTimer timer(stageCpu, kStageCache);
+            std::string payload;
+            job->hashed = options.cache->sessionHash(job->path, job->contentHash);
+            hit = job->hashed &&
+                options.cache->load(job->contentHash, analyzerId, payload) &&
+                deserializeSummary(payload, cached);
+        }
+        if (hit) {
+            publish(job, cached);
+            cachedFiles.fetch_add(1);
+            return;
+        }
+        submitChunks(job);
+    };
+
+    for (auto& job : jobs) {
+        FileJob* j = job.get();
+        if (options.cache) {
+            tasks.fetch_add(1);
+            pool.submit([&probeFile, j]() { probeFile(j); });
+        }
+        else {
+            submitChunks(j);
+        }
+    }
+    pool.wait();
+    if (options.cache) {
+        options.cache->saveIndex();
+    }
+
+    for (const auto& w : perWorker) {
+        report.total.combine(w);
+    }
+    for (int s = 0; s < kStageCount; ++s) {
+        report.stageCpuNs[s] = stageCpu[s].load();
+    }
+    report.failures = failures.load();
+    report.cachedFiles = cachedFiles.load();
+    report.computedFiles = computedFiles.load();
+    report.tasks = tasks.load();
+    report.steals = pool.stealCount();
+    report.threads = threads;
+    report.wallMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - wallStart).count();
+    return report.failures == 0;
+}
+
+//----------------------------------------------------//
+//                 Directory Listing
+//----------------------------------------------------//
+
+static bool isSessionFileName(const std::string& name)
+{
+    const std::string prefix = "input_log_";
+    const std::string suffix = ".csv";
+    return name.size() > prefix.size() + suffix.size() &&
+        name.compare(0, prefix.size(), prefix) == 0 &&
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool listSessionFiles(const std::string& dir, std::vector<std::string>& out)
+{
+    std::vector<std::string> found;
+#if defined(_WIN32)
+    WIN32_FIND_DATAA data;
+    HANDLE h = FindFirstFileA((dir + "\\*").c_str(), &data);
+    if (h == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to list directory: " << dir << "\n";
+        return false;
+    }
+    do {
+        std::string name = data.cFileName;
+        if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && isSessionFileName(name)) {
+            found.push_back(dir + "\\" + name);
+        }
+    } while (FindNextFileA(h, &data));
+    FindClose(h);
+#else
+    DIR* d = opendir(dir.c_str());
+    if (!d) {
+        std::cerr << "Failed to list directory: " << dir << "\n";
+        return false;
+    }
+    while (dirent* entry = readdir(d)) {
+        std::string name = entry->d_name;
+        if (isSessionFileName(name)) {
+            found.push_back(dir + "/" + name);
+        }
+    }
+    closedir(d);
+#endif
+    std::sort(found.begin(), found.end());
+    out.insert(out.end(), found.begin(), found.end());
+    return true;
+}
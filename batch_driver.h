@@ -0,0 +1,105 @@
+// batch_driver.h
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "session_event.h"
+#include "panic_detector.h"
+#include "path_simplify.h"
+
+class AnalysisCache;
+
+//----------------------------------------------------//
+//             Mergeable Session Summary
+//----------------------------------------------------//
+
+// Everything the nightly job reports per session. Partial summaries of
+// consecutive chunks of one file are joined with append() (which stitches
+// the cursor path across the cut); summaries of different files are joined
+// with combine().
+struct SessionSummary
+{
+    uint64_t files  = 0;
+    uint64_t events = 0;
+    uint64_t durationMs = 0;                       // first to last event, summed over files
+    std::array<uint64_t, 8> kindCounts{};          // indexed by EventKind
+    std::array<uint64_t, kChannelCount> presses{}; // indexed by press channel
+
+    double    cursorPathPx = 0.0;
+    uint64_t  panicEpisodes = 0;
+    uint64_t  panicPresses = 0;
+
+    // Chunk boundary state (meaningful while a file is being assembled)
+    bool      hasEvents = false;
+    uint32_t  firstMs = 0;
+    uint32_t  lastMs = 0;
+    bool      hasCursor = false;
+    PathPoint firstCursor{};
+    PathPoint lastCursor{};
+
+    void add(const SessionEvent& evt);
+    void append(const SessionSummary& later);
+    void combine(const SessionSummary& other);
+
+    // Closes a fully assembled file (counts it and its duration)
+    void finishFile();
+};
+
+//----------------------------------------------------//
+//                  Batch Driver
+//----------------------------------------------------//
+
+enum BatchStage {
+    kStageParse,      // reading and parsing CSV chunks
+    kStageSummarize,  // per-chunk counters
+    kStageAnalyze,    // per-file stateful analyzers (panic detection)
+    kStageMerge,      // stitching chunks and combining results
+    kStageCache,      // hashing sessions, loading and storing cached results
+    kStageCount
+};
+
+const char* batchStageName(int stage);
+
+struct BatchOptions
+{
+    unsigned  threads    = 0;              // 0 = all hardware threads
+    uint64_t  chunkBytes = 8ull << 20;     // files larger than this are parsed in parallel pieces
+    PanicRule panicRule;
+    bool      keepPerFile = false;
+
+    // When set, unchanged sessions are served from the cache and only new or
+    // modified ones are parsed and analyzed
+    AnalysisCache* cache = nullptr;
+};
+
+struct BatchReport
+{
+    SessionSummary total;
+    std::vector<std::pair<std::string, SessionSummary>> perFile; // only with keepPerFile
+
+    uint64_t bytes = 0;
+    size_t   failures = 0;
+    size_t   cachedFiles = 0;   // served from the analysis cache
+    size_t   computedFiles = 0; // parsed and analyzed this run
+    double   wallMs = 0.0;
+    std::array<uint64_t, kStageCount> stageCpuNs{};
+    uint64_t tasks = 0;
+    uint64_t steals = 0;
+    unsigned threads = 0;
+};
+
+// Runs every per-session analysis over all files on a work-stealing pool.
+// Big files are split into chunk tasks; each file's stateful analysis runs
+// as soon as its last chunk is parsed. Returns false if any file failed.
+// Cached results are keyed by the summary format version and the analyzer
+// parameters (panic rule), so changing either recomputes everything.
+bool runBatch(const std::vector<std::string>& paths, const BatchOptions& options,
+    BatchReport& report);
+
+// Appends every input_log_*.csv in 'dir' (not recursive)
+bool listSessionFiles(const std::string& dir, std::vector<std::string>& out);
@@ -0,0 +1,398 @@
+#include "capture_metrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <new>
+
+#if defined(_WIN32)
+#define NOMINMAX // keep std::min/std::max usable
+#include <windows.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Readers in other processes map the same memory: the counters must be
+// plain lock-free words, not guarded by a process-local lock
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "metrics need lock-free 64-bit atomics");
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "metrics need lock-free 32-bit atomics");
+
+#if defined(_WIN32)
+const char* const kDefaultMetricsName = "Local\\SkillshotCaptureMetrics";
+#else
+const char* const kDefaultMetricsName = "/skillshot_capture_metrics";
+#endif
+
+const char* captureSourceName(CaptureSource source)
+{
+    switch (source) {
+    case CaptureSource::MouseHook:    return "mouse_hook";
+    case CaptureSource::KeyboardHook: return "keyboard_hook";
+    case CaptureSource::CursorPoll:   return "cursor_poll";
+    default:                          return "unknown";
+    }
+}
+
+//----------------------------------------------------//
+//                    Histograms
+//----------------------------------------------------//
+
+static size_t bucketOf(uint64_t v)
+{
+    if (v < 4) {
+        return static_cast<size_t>(v);
+    }
+    unsigned e = 2;
+    while (e < 63 && (v >> (e + 1)) != 0) {
+        ++e;
+    }
+    const size_t sub = static_cast<size_t>((v >> (e - 2)) & 3);
+    return std::min(kHistogramBuckets - 1, 4 + (e - 2) * 4 + sub);
+}
+
+static double bucketMid(size_t b)
+{
+    if (b < 4) {
+        return static_cast<double>(b);
+    }
+    const unsigned e = static_cast<unsigned>((b - 4) / 4 + 2);
+    const double width = static_cast<double>(uint64_t(1) << (e - 2));
+    const double lower = static_cast<double>((4 + (b - 4) % 4) * (uint64_t(1) << (e - 2)));
+    return lower + width / 2.0;
+}
+
+void MetricsHistogram::record(uint64_t value)
+{
+    buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+    uint64_t seen = max.load(std::memory_order_relaxed);
+    while (value > seen && !max.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+double HistogramSnapshot::quantile(double q) const
+{
+    if (count == 0) {
+        return 0.0;
+    }
+    const double rank = q * count;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < kHistogramBuckets; ++b) {
+        seen += buckets[b];
+        if (seen > 0 && seen >= rank) {
+            return std::min(bucketMid(b), static_cast<double>(max));
+        }
+    }
+    return static_cast<double>(max);
+}
+
+HistogramSnapshot HistogramSnapshot::since(const HistogramSnapshot& earlier) const
+{
+    HistogramSnapshot d;
+    for (size_t b = 0; b < kHistogramBuckets; ++b) {
+        d.buckets[b] = buckets[b] - std::min(buckets[b], earlier.buckets[b]);
+    }
+    d.count = count - std::min(count, earlier.count);
+    d.sum = sum - std::min(sum, earlier.sum);
+    d.max = max;
+    return d;
+}
+
+static void copyHistogram(const MetricsHistogram& h, HistogramSnapshot& out)
+{
+    for (size_t b = 0; b < kHistogramBuckets; ++b) {
+        out.buckets[b] = h.buckets[b].load(std::memory_order_relaxed);
+    }
+    out.count = h.count.load(std::memory_order_relaxed);
+    out.sum = h.sum.load(std::memory_order_relaxed);
+    out.max = h.max.load(std::memory_order_relaxed);
+}
+
+static void copyBlock(const MetricsBlock& block, MetricsSnapshot& out)
+{
+    out.takenUnixMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    out.startUnixMs = block.startUnixMs.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < kMetricsSources; ++i) {
+        out.events[i] = block.events[i].load(std::memory_order_relaxed);
+    }
+    out.queueDepth = block.queueDepth.load(std::memory_order_relaxed);
+    out.queueDepthMax = block.queueDepthMax.load(std::memory_order_relaxed);
+    out.flushes = block.flushes.load(std::memory_order_relaxed);
+    out.rowsWritten = block.rowsWritten.load(std::memory_order_relaxed);
+    out.bytesWritten = block.bytesWritten.load(std::memory_order_relaxed);
+    copyHistogram(block.flushUs, out.flushUs);
+    copyHistogram(block.hookUs, out.hookUs);
+    copyHistogram(block.hookDelayMs, out.hookDelayMs);
+    copyHistogram(block.pollJitterUs, out.pollJitterUs);
+}
+
+//----------------------------------------------------//
+//            CaptureMetrics Implementation
+//----------------------------------------------------//
+
+static uint32_t currentProcessId()
+{
+#if defined(_WIN32)
+    return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+    return static_cast<uint32_t>(getpid());
+#endif
+}
+
+#if !defined(_WIN32)
+// Claims an existing block whose writer is known to have exited. A block
+// without a writer pid (just created, or by an older build) is left alone,
+// and of two processes claiming the same dead block only one wins.
+static bool claimStaleBlock(MetricsBlock* block)
+{
+    if (block->magic != kMetricsMagic || block->version != kMetricsVersion) {
+        return false;
+    }
+    uint32_t pid = block->writerPid.load();
+    if (pid == 0 || kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH) {
+        return false; // alive (EPERM: alive, another user's)
+    }
+    return block->writerPid.compare_exchange_strong(pid, currentProcessId());
+}
+#endif
+
+CaptureMetrics::CaptureMetrics(const std::string& sharedName)
+    : m_name(sharedName)
+{
+    const size_t bytes = sizeof(MetricsBlock);
+    void* memory = nullptr;
+    if (!m_name.empty()) {
+#if defined(_WIN32)
+        HANDLE h = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0,
+            static_cast<DWORD>(bytes), m_name.c_str());
+        if (h && GetLastError() == ERROR_ALREADY_EXISTS) {
+            std::cerr << "Metrics block " << m_name << " is already published by another process\n";
+            CloseHandle(h);
+            h = NULL;
+        }
+        if (h) {
+            memory = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+            if (memory) {
+                m_mapping = h;
+            }
+            else {
+                CloseHandle(h);
+            }
+        }
+#else
+        // An existing block is reused, never unlinked: readers and its
+        // writer may still map it
+        bool created = true;
+        int fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0 && errno == EEXIST) {
+            created = false;
+            fd = shm_open(m_name.c_str(), O_RDWR, 0);
+        }
+        if (fd >= 0) {
+            struct stat st;
+            if ((!created || ftruncate(fd, static_cast<off_t>(bytes)) == 0) &&
+                fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= bytes) {
+                void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                if (p != MAP_FAILED) {
+                    if (created || claimStaleBlock(static_cast<MetricsBlock*>(p))) {
+                        memory = p;
+                        m_mapping = p;
+                        m_inode = static_cast<uint64_t>(st.st_ino);
+                        m_device = static_cast<uint64_t>(st.st_dev);
+                    }
+                    else {
+                        std::cerr << "Metrics block " << m_name << " is already published by another process\n";
+                        munmap(p, bytes);
+                    }
+                }
+            }
+            close(fd);
+            if (!memory && created) {
+                shm_unlink(m_name.c_str());
+            }
+        }
+#endif
+        if (!memory) {
+            std::cerr << "Failed to publish metrics as " << m_name << "; keeping them private\n";
+        }
+    }
+    if (!memory) {
+        memory = ::operator new(bytes);
+    }
+
+    m_block = new (memory) MetricsBlock();
+    m_block->magic = kMetricsMagic;
+    m_block->version = kMetricsVersion;
+    m_block->size = static_cast<uint32_t>(bytes);
+    m_block->writerPid.store(currentProcessId());
+    m_block->startUnixMs.store(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count()));
+}
+
+CaptureMetrics::~CaptureMetrics()
+{
+#if !defined(_WIN32)
+    const bool owner = m_block->writerPid.load() == currentProcessId();
+#endif
+    m_block->~MetricsBlock();
+    if (!m_mapping) {
+        ::operator delete(m_block);
+        return;
+    }
+#if defined(_WIN32)
+    UnmapViewOfFile(m_block);
+    CloseHandle(static_cast<HANDLE>(m_mapping));
+#else
+    // Unlink only the object this process published, and only while it
+    // still owns it: the name may since point to another writer's block
+    munmap(m_block, sizeof(MetricsBlock));
+    const int fd = shm_open(m_name.c_str(), O_RDONLY, 0);
+    if (fd >= 0) {
+        struct stat st;
+        if (owner && fstat(fd, &st) == 0 && static_cast<uint64_t>(st.st_ino) == m_inode &&
+            static_cast<uint64_t>(st.st_dev) == m_device) {
+            shm_unlink(m_name.c_str());
+        }
+        close(fd);
+    }
+#endif
+}
+
+void CaptureMetrics::onEvent(CaptureSource source, size_t queueDepth)
+{
+    m_block->events[static_cast<size_t>(source)].fetch_add(1, std::memory_order_relaxed);
+    m_block->queueDepth.store(queueDepth, std::memory_order_relaxed);
+    if (queueDepth > m_block->queueDepthMax.load(std::memory_order_relaxed)) {
+        // Only the thread holding the queue lock gets here, so no CAS loop
+        m_block->queueDepthMax.store(queueDepth, std::memory_order_relaxed);
+    }
+}
+
+void CaptureMetrics::onDequeue()
+{
+    m_block->queueDepth.store(0, std::memory_order_relaxed);
+}
+
+void CaptureMetrics::onFlush(uint64_t micros, uint64_t rows, uint64_t bytes)
+{
+    m_block->flushes.fetch_add(1, std::memory_order_relaxed);
+    m_block->rowsWritten.fetch_add(rows, std::memory_order_relaxed);
+    m_block->bytesWritten.fetch_add(bytes, std::memory_order_relaxed);
+    m_block->flushUs.record(micros);
+}
+
+void CaptureMetrics::onHook(uint64_t micros, uint64_t delayMs)
+{
+    m_block->hookUs.record(micros);
+    m_block->hookDelayMs.record(delayMs);
+}
+
+void CaptureMetrics::onPoll(uint64_t jitterUs)
+{
+    m_block->pollJitterUs.record(jitterUs);
+}
+
+void CaptureMetrics::snapshot(MetricsSnapshot& out) const
+{
+    copyBlock(*m_block, out);
+}
+
+//----------------------------------------------------//
+//                 Shared Snapshots
+//----------------------------------------------------//
+
+static bool usableBlock(const MetricsBlock* block)
+{
+    return block->magic == kMetricsMagic && block->version == kMetricsVersion &&
+        block->size == sizeof(MetricsBlock);
+}
+
+bool readSharedMetrics(const std::string& name, MetricsSnapshot& out)
+{
+    const size_t bytes = sizeof(MetricsBlock);
+    bool ok = false;
+#if defined(_WIN32)
+    HANDLE h = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+    if (!h) {
+        return false;
+    }
+    const void* view = MapViewOfFile(h, FILE_MAP_READ, 0, 0, bytes);
+    if (view) {
+        const MetricsBlock* block = static_cast<const MetricsBlock*>(view);
+        ok = usableBlock(block);
+        if (ok) {
+            copyBlock(*block, out);
+        }
+        UnmapViewOfFile(view);
+    }
+    CloseHandle(h);
+#else
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= bytes) {
+        void* p = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) {
+            const MetricsBlock* block = static_cast<const MetricsBlock*>(p);
+            ok = usableBlock(block);
+            if (ok) {
+                copyBlock(*block, out);
+            }
+            munmap(p, bytes);
+        }
+    }
+    close(fd);
+#endif
+    return ok;
+}
+
+//----------------------------------------------------//
+//                     Report
+//----------------------------------------------------//
+
+static void printDistribution(std::ostream& os, const HistogramSnapshot& h, const char* unit)
+{
+    os << "p50 " << h.quantile(0.5) << " " << unit << ", p99 " << h.quantile(0.99) << " " << unit
+        << ", max " << h.max << " " << unit << " (" << h.count << ")";
+}
+
+void printMetrics(std::ostream& os, const MetricsSnapshot& now, const MetricsSnapshot* previous)
+{
+    const uint64_t sinceMs = previous ? previous->takenUnixMs : now.startUnixMs;
+    const double seconds = now.takenUnixMs > sinceMs ? (now.takenUnixMs - sinceMs) / 1000.0 : 0.0;
+    const double uptime = now.takenUnixMs > now.startUnixMs ? (now.takenUnixMs - now.startUnixMs) / 1000.0 : 0.0;
+    auto delta = [previous](uint64_t value, uint64_t MetricsSnapshot::* field) {
+        return previous ? value - std::min(value, previous->*field) : value;
+    };
+
+    os << "Capture metrics (up " << uptime << " s; rates and distributions over the last "
+        << seconds << " s):\n";
+    os << "  events/s:";
+    for (size_t i = 0; i < static_cast<size_t>(CaptureSource::Count); ++i) {
+        const uint64_t n = now.events[i] - (previous ? std::min(now.events[i], previous->events[i]) : 0);
+        os << (i > 0 ? "," : "") << " " << captureSourceName(static_cast<CaptureSource>(i)) << " "
+            << (seconds > 0.0 ? n / seconds : 0.0);
+    }
+    os << "\n  queue depth: " << now.queueDepth << " now, " << now.queueDepthMax << " max\n";
+    os << "  flushes: " << delta(now.flushes, &MetricsSnapshot::flushes) << ", "
+        << delta(now.rowsWritten, &MetricsSnapshot::rowsWritten) << " rows, "
+        << delta(now.bytesWritten, &MetricsSnapshot::bytesWritten) << " bytes; duration ";
+    const HistogramSnapshot empty;
+    printDistribution(os, now.flushUs.since(previous ? previous->flushUs : empty), "us");
+    os << "\n  hook time: ";
+    printDistribution(os, now.hookUs.since(previous ? previous->hookUs : empty), "us");
+    os << "\n  hook delay: ";
+    printDistribution(os, now.hookDelayMs.since(previous ? previous->hookDelayMs : empty), "ms");
+    os << "\n  poll jitter: ";
+    printDistribution(os, now.pollJitterUs.since(previous ? previous->pollJitterUs : empty), "us");
+    os << "\n";
+}
@@ -0,0 +1,141 @@
+// capture_metrics.h
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+//----------------------------------------------------//
+//                 Capture Sources
+//----------------------------------------------------//
+
+// Where an event was captured; each source numbers its events
+enum class CaptureSource : uint8_t {
+    MouseHook,
+    KeyboardHook,
+    CursorPoll,
+    Count
+};
+
+// CaptureSource::CursorPoll -> "cursor_poll"
+const char* captureSourceName(CaptureSource source);
+
+//----------------------------------------------------//
+//             Lock-Free Capture Metrics
+//----------------------------------------------------//
+
+const uint32_t kMetricsMagic = 0x544D4B53;   // "SKMT"
+const uint32_t kMetricsVersion = 1;
+const size_t   kMetricsSources = 4;          // room for one more CaptureSource
+const size_t   kHistogramBuckets = 128;
+
+// Shared-memory name the tracker publishes under
+extern const char* const kDefaultMetricsName;
+
+// Four buckets per power of two (values 0..3 exact), so a quantile is off
+// by at most an eighth of its value. Covers up to 2^32.
+struct MetricsHistogram
+{
+    std::atomic<uint64_t> buckets[kHistogramBuckets];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> max;
+
+    void record(uint64_t value);
+};
+
+// Everything the capture threads update. Each field is a lock-free atomic
+// written with relaxed ordering, so the block can live in shared memory and
+// readers in other processes take plain loads: they never lock anything or
+// write to a line the capture threads use. A snapshot is consistent per
+// field, not across fields.
+struct MetricsBlock
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;            // sizeof(MetricsBlock) of the writer
+    std::atomic<uint32_t> writerPid;   // publishing process; a block is only
+                                       // taken over once this one has exited
+    std::atomic<uint64_t> startUnixMs;
+
+    std::atomic<uint64_t> events[kMetricsSources];
+    std::atomic<uint64_t> queueDepth;       // events waiting for the flush thread
+    std::atomic<uint64_t> queueDepthMax;
+    std::atomic<uint64_t> flushes;
+    std::atomic<uint64_t> rowsWritten;
+    std::atomic<uint64_t> bytesWritten;
+
+    MetricsHistogram flushUs;       // one flush, dequeue to file closed
+    MetricsHistogram hookUs;        // time spent inside a hook callback
+    MetricsHistogram hookDelayMs;   // OS event time to hook entry
+    MetricsHistogram pollJitterUs;  // |poll period - configured interval|
+};
+
+// Plain copy of a histogram
+struct HistogramSnapshot
+{
+    uint64_t buckets[kHistogramBuckets] = {};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+
+    double quantile(double q) const;    // bucket midpoint, at most 'max'
+    double mean() const { return count > 0 ? static_cast<double>(sum) / count : 0.0; }
+
+    // What was recorded after 'earlier' (max stays the all-time max)
+    HistogramSnapshot since(const HistogramSnapshot& earlier) const;
+};
+
+struct MetricsSnapshot
+{
+    uint64_t takenUnixMs = 0;
+    uint64_t startUnixMs = 0;
+    uint64_t events[kMetricsSources] = {};
+    uint64_t queueDepth = 0;
+    uint64_t queueDepthMax = 0;
+    uint64_t flushes = 0;
+    uint64_t rowsWritten = 0;
+    uint64_t bytesWritten = 0;
+    HistogramSnapshot flushUs, hookUs, hookDelayMs, pollJitterUs;
+};
+
+// Owner of a metrics block: in shared memory under 'sharedName', or private
+// when the name is empty or the mapping fails. A name another live process
+// publishes is refused; on POSIX a block whose writer has exited (crashed)
+// is taken over. The destructor removes the block only if it is still the
+// one this process published.
+class CaptureMetrics {
+public:
+    explicit CaptureMetrics(const std::string& sharedName = "");
+    ~CaptureMetrics();
+
+    CaptureMetrics(const CaptureMetrics&) = delete;
+    CaptureMetrics& operator=(const CaptureMetrics&) = delete;
+
+    bool shared() const { return m_mapping != nullptr; }
+
+    void onEvent(CaptureSource source, size_t queueDepth);
+    void onDequeue();                      // the flush thread took the queue
+    void onFlush(uint64_t micros, uint64_t rows, uint64_t bytes);
+    void onHook(uint64_t micros, uint64_t delayMs);
+    void onPoll(uint64_t jitterUs);
+
+    void snapshot(MetricsSnapshot& out) const;
+
+private:
+    MetricsBlock* m_block = nullptr;
+    void*         m_mapping = nullptr;     // platform handle of the shared block
+    std::string   m_name;
+    uint64_t      m_inode = 0;             // POSIX: identity of the published object
+    uint64_t      m_device = 0;
+};
+
+// Reads a block another process published; false if there is none (or it
+// has another layout)
+bool readSharedMetrics(const std::string& name, MetricsSnapshot& out);
+
+// Human-readable report; rates and distributions cover the time since
+// 'previous' when given, the whole capture otherwise
+void printMetrics(std::ostream& os, const MetricsSnapshot& now, const MetricsSnapshot* previous);
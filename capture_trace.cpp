@@ -0,0 +1,239 @@
+#include "capture_trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+//----------------------------------------------------//
+//                 Per-Thread Buffers
+//----------------------------------------------------//
+
+struct TraceSpan
+{
+    const char* name;
+    uint64_t    startNs;
+    uint64_t    endNs;
+    uint64_t    arg;
+};
+
+// Written only by its owning thread. 'count' is published with release
+// ordering, so write() sees every span below it complete.
+struct TraceBuffer
+{
+    std::unique_ptr<TraceSpan[]> spans;        // left uninitialized: pages commit as used
+    size_t                   capacity = 0;
+    std::atomic<size_t>      count{ 0 };
+    std::atomic<uint64_t>    dropped{ 0 };
+    std::atomic<uint64_t>    generation{ 0 };   // trace the spans belong to
+    std::atomic<const char*> name{ nullptr };
+    std::atomic<bool>        finished{ false }; // owner exited; start() may free it
+    uint32_t                 tid = 0;
+};
+
+namespace {
+
+// Marks the buffer finished when its thread exits (the spans are kept until
+// the next start(), since the poll and flush threads end before stop writes)
+struct ThreadSlot
+{
+    TraceBuffer* buffer = nullptr;
+    const char*  name = nullptr;
+
+    ~ThreadSlot()
+    {
+        if (buffer) {
+            buffer->finished.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadSlot t_slot;
+
+} // namespace
+
+CaptureTrace& captureTrace()
+{
+    // Never destroyed: thread_local slots may still point into it at exit
+    static CaptureTrace* trace = new CaptureTrace();
+    return *trace;
+}
+
+//----------------------------------------------------//
+//             CaptureTrace Implementation
+//----------------------------------------------------//
+
+uint64_t CaptureTrace::nowNs() const
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void CaptureTrace::start(size_t spansPerThread)
+{
+    std::lock_guard<std::mutex> lock(m_registryMutex);
+    for (size_t i = 0; i < m_buffers.size();) {
+        if (m_buffers[i]->finished.load(std::memory_order_acquire)) {
+            delete m_buffers[i];
+            m_buffers[i] = m_buffers.back();
+            m_buffers.pop_back();
+        }
+        else {
+            ++i;
+        }
+    }
+    m_capacity.store(spansPerThread > 0 ? spansPerThread : 1);
+    m_epochNs = nowNs();
+    m_generation.fetch_add(1, std::memory_order_release);
+    m_enabled.store(true);
+}
+
+void CaptureTrace::stop()
+{
+    m_enabled.store(false);
+}
+
+TraceBuffer* CaptureTrace::threadBuffer()
+{
+    const uint64_t generation = m_generation.load(std::memory_order_acquire);
+    TraceBuffer* b = t_slot.buffer;
+    if (b && b->generation.load(std::memory_order_relaxed) == generation) {
+        return b;
+    }
+
+    if (!b) {
+        // First span of this thread: the only time the hot path locks
+        b = new TraceBuffer();
+        std::lock_guard<std::mutex> lock(m_registryMutex);
+        b->tid = m_nextTid++;
+        m_buffers.push_back(b);
+        t_slot.buffer = b;
+    }
+    // A new trace: the owner resets its own buffer, so nobody else writes it
+    const size_t capacity = m_capacity.load();
+    if (b->capacity != capacity) {
+        b->spans.reset(new TraceSpan[capacity]);
+        b->capacity = capacity;
+    }
+    b->count.store(0, std::memory_order_relaxed);
+    b->dropped.store(0, std::memory_order_relaxed);
+    b->name.store(t_slot.name, std::memory_order_relaxed);
+    b->generation.store(generation, std::memory_order_release);
+    return b;
+}
+
+void CaptureTrace::record(const char* name, uint64_t startNs, uint64_t endNs, uint64_t arg)
+{
+    if (!enabled()) {
+        return;
+    }
+    TraceBuffer* b = threadBuffer();
+    const size_t n = b->count.load(std::memory_order_relaxed);
+    if (n >= b->capacity) {
+        b->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    b->spans[n] = TraceSpan{ name, startNs, endNs, arg };
+    b->count.store(n + 1, std::memory_order_release);
+}
+
+void CaptureTrace::setThreadName(const char* name)
+{
+    t_slot.name = name;
+    if (t_slot.buffer) {
+        t_slot.buffer->name.store(name, std::memory_order_relaxed);
+    }
+}
+
+//----------------------------------------------------//
+//                  Chrome JSON Output
+//----------------------------------------------------//
+
+// Names are literals from this code base; quote anything odd anyway
+static void writeJsonString(std::ostream& os, const char* s)
+{
+    os << '"';
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') {
+            os << '\\' << *s;
+        }
+        else if (static_cast<unsigned char>(*s) >= 0x20) {
+            os << *s;
+        }
+    }
+    os << '"';
+}
+
+// Nanoseconds as Chrome's microseconds with three decimals
+static void writeMicros(std::ostream& os, uint64_t ns)
+{
+    char text[32];
+    std::snprintf(text, sizeof(text), "%llu.%03u",
+        static_cast<unsigned long long>(ns / 1000), static_cast<unsigned>(ns % 1000));
+    os << text;
+}
+
+bool CaptureTrace::write(const std::string& path, uint64_t* spans, uint64_t* dropped)
+{
+    std::ofstream os(path, std::ios::trunc);
+    if (!os.is_open()) {
+        std::cerr << "Failed to open trace file: " << path << "\n";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_registryMutex);
+    const uint64_t generation = m_generation.load(std::memory_order_acquire);
+    uint64_t total = 0, lost = 0;
+    bool first = true;
+    auto separator = [&]() {
+        os << (first ? "\n" : ",\n");
+        first = false;
+    };
+
+    os << "{\"traceEvents\":[";
+    for (const TraceBuffer* b : m_buffers) {
+        if (b->generation.load(std::memory_order_acquire) != generation) {
+            continue; // no span in this trace
+        }
+        const size_t n = b->count.load(std::memory_order_acquire);
+        const char* name = b->name.load(std::memory_order_relaxed);
+        separator();
+        os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->tid
+            << ",\"args\":{\"name\":";
+        writeJsonString(os, name ? name : "thread");
+        os << "}}";
+
+        for (size_t i = 0; i < n; ++i) {
+            const TraceSpan& s = b->spans[i];
+            const uint64_t start = s.startNs > m_epochNs ? s.startNs - m_epochNs : 0;
+            separator();
+            os << "{\"name\":";
+            writeJsonString(os, s.name);
+            os << ",\"cat\":\"capture\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->tid << ",\"ts\":";
+            writeMicros(os, start);
+            os << ",\"dur\":";
+            writeMicros(os, s.endNs > s.startNs ? s.endNs - s.startNs : 0);
+            if (s.arg != 0) {
+                os << ",\"args\":{\"n\":" << s.arg << "}";
+            }
+            os << "}";
+        }
+        total += n;
+        lost += b->dropped.load(std::memory_order_relaxed);
+    }
+    os << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_spans\":" << lost << "}}\n";
+    os.close();
+
+    if (spans) {
+        *spans = total;
+    }
+    if (dropped) {
+        *dropped = lost;
+    }
+    if (os.fail()) {
+        std::cerr << "Failed to write trace file: " << path << "\n";
+        return false;
+    }
+    return true;
+}
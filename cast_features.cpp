@@ -0,0 +1,77 @@
+#include "cast_features.h"
+
+#include <algorithm>
+
+bool cursorPositionAt(const std::vector<PathPoint>& path, uint32_t t, double& x, double& y)
+{
+    if (path.empty()) {
+        return false;
+    }
+
+    // First sample at or after t
+    auto it = std::lower_bound(path.begin(), path.end(), t,
+        [](const PathPoint& p, uint32_t time) { return p.timestamp < time; });
+    if (it == path.begin() || it == path.end()) {
+        const PathPoint& p = (it == path.end()) ? path.back() : path.front();
+        x = p.x;
+        y = p.y;
+        return true;
+    }
+
+    const PathPoint& b = *it;
+    const PathPoint& a = *(it - 1);
+    double u = (b.timestamp == a.timestamp)
+        ? 1.0 : static_cast<double>(t - a.timestamp) / (b.timestamp - a.timestamp);
+    x = a.x + u * (static_cast<double>(b.x) - a.x);
+    y = a.y + u * (static_cast<double>(b.y) - a.y);
+    return true;
+}
+
+void extractCasts(const std::vector<SessionEvent>& events, const CastFeatureOptions& options,
+    std::vector<CastRecord>& out)
+{
+    out.clear();
+    std::vector<PathPoint> path;
+    extractCursorPath(events, path);
+
+    bool isCastKey[256] = {};
+    for (uint32_t key : options.castKeys) {
+        if (key < 256) {
+            isCastKey[key] = true;
+        }
+    }
+
+    PressFilter presses;
+    for (const auto& evt : events) {
+        const bool newPress = presses.isNewPress(evt);
+        if (!newPress || evt.kind != EventKind::KeyDown || evt.keyCode >= 256 || !isCastKey[evt.keyCode]) {
+            continue;
+        }
+
+        double priorX = evt.x, priorY = evt.y;
+        uint32_t priorT = evt.timestamp >= options.lookbackMs
+            ? evt.timestamp - options.lookbackMs : 0;
+        cursorPositionAt(path, priorT, priorX, priorY);
+
+        out.push_back(CastRecord{ evt.timestamp, evt.keyCode, evt.x, evt.y,
+            evt.x - priorX, evt.y - priorY });
+    }
+}
+
+void castFeatureVector(const CastRecord& cast, float* out)
+{
+    out[0] = static_cast<float>(cast.aimDx);
+    out[1] = static_cast<float>(cast.aimDy);
+}
+
+std::vector<uint32_t> parseKeyList(const std::string& keys)
+{
+    std::vector<uint32_t> out;
+    for (char c : keys) {
+        uint32_t vk = keyNameToVk(std::string(1, c));
+        if (vk != 0) {
+            out.push_back(vk);
+        }
+    }
+    return out;
+}
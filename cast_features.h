@@ -0,0 +1,48 @@
+// cast_features.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "session_event.h"
+#include "path_simplify.h"
+
+//----------------------------------------------------//
+//            Per-Cast Aim Features
+//----------------------------------------------------//
+
+struct CastFeatureOptions
+{
+    std::vector<uint32_t> castKeys = { 'Q', 'W', 'E', 'R' };
+    uint32_t              lookbackMs = 150; // "prior" cursor position is this long before the cast
+};
+
+// One ability press with where the player was aiming
+struct CastRecord
+{
+    uint32_t timestamp;
+    uint32_t keyCode;
+    int32_t  x;        // cursor at the cast
+    int32_t  y;
+    double   aimDx;    // cursor at the cast minus cursor 'lookbackMs' earlier
+    double   aimDy;
+};
+
+// Number of floats castFeatureVector() writes
+const size_t kCastFeatureDim = 2;
+
+// Interpolated cursor position at time t (clamped to the ends of the path).
+// Returns false for an empty path.
+bool cursorPositionAt(const std::vector<PathPoint>& path, uint32_t t, double& x, double& y);
+
+// All casts of a session in time order
+void extractCasts(const std::vector<SessionEvent>& events, const CastFeatureOptions& options,
+    std::vector<CastRecord>& out);
+
+// Feature vector used for clustering (aim dx, aim dy)
+void castFeatureVector(const CastRecord& cast, float* out);
+
+// "QWER" -> { 'Q', 'W', 'E', 'R' } (unknown characters are skipped)
+std::vector<uint32_t> parseKeyList(const std::string& keys);
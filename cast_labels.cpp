@@ -0,0 +1,95 @@
+#include "cast_labels.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <iostream>
+
+#include "asof_join.h"
+#include "clock_align.h"
+#include "session_reader.h"
+
+//----------------------------------------------------//
+//                 Labelled Casts
+//----------------------------------------------------//
+
+bool extractCastSamples(const std::string& path, const std::vector<uint32_t>& castKeys,
+    std::vector<CastSample>& out)
+{
+    PreCastFeatures features(castKeys);
+    CastSample sample;
+    return forEachSessionEvent(path, [&](const SessionEvent& evt) {
+        if (features.onEvent(evt, sample.features)) {
+            sample.timestamp = evt.timestamp;
+            sample.keyCode = evt.keyCode;
+            out.push_back(sample);
+        }
+    });
+}
+
+// "1", "true", "hit", "yes" -> 1; "0", "false", "miss", "no" -> 0; else -1
+static int parseLabel(std::string value)
+{
+    value.erase(std::remove(value.begin(), value.end(), '"'), value.end());
+    std::transform(value.begin(), value.end(), value.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (value == "1" || value == "true" || value == "hit" || value == "yes") {
+        return 1;
+    }
+    if (value == "0" || value == "false" || value == "miss" || value == "no") {
+        return 0;
+    }
+    return -1;
+}
+
+bool labelCastSamples(const std::string& sessionPath, const std::string& labelPath,
+    const std::vector<CastSample>& casts, const CastLabelOptions& options,
+    std::vector<float>& x, std::vector<uint8_t>& y, size_t& labels)
+{
+    TimelineReader reader;
+    if (!reader.open(labelPath, options.timeColumn, options.timeScale)) {
+        return false;
+    }
+    const int labelIndex = reader.columnIndex(options.labelColumn);
+    if (labelIndex < 0) {
+        std::cerr << "Label column '" << options.labelColumn << "' not found in " << labelPath << "\n";
+        return false;
+    }
+
+    ClockFit clock;
+    if (!loadSessionClock(sessionPath, clock)) {
+        clock.offsetMs = static_cast<double>(options.offsetMs);
+    }
+
+    // Casts are in time order: nearest one by binary search, each used once
+    std::vector<char> used(casts.size(), 0);
+    TimelineRow row;
+    labels = 0;
+    while (reader.next(row)) {
+        const int label = parseLabel(row.values[labelIndex]);
+        if (label < 0) {
+            continue;
+        }
+        ++labels;
+        const double t = clock.toCapture(row.timeMs);
+        auto it = std::lower_bound(casts.begin(), casts.end(), t,
+            [](const CastSample& c, double v) { return c.timestamp < v; });
+        size_t best = casts.size();
+        double bestDist = options.toleranceMs + 0.5;
+        for (auto c = (it == casts.begin() ? it : it - 1); c != casts.end() && c <= it; ++c) {
+            const double dist = std::fabs(c->timestamp - t);
+            const size_t i = c - casts.begin();
+            if (dist < bestDist && !used[i]) {
+                best = i;
+                bestDist = dist;
+            }
+        }
+        if (best == casts.size()) {
+            continue;
+        }
+        used[best] = 1;
+        x.insert(x.end(), casts[best].features, casts[best].features + kCastOutcomeDims);
+        y.push_back(static_cast<uint8_t>(label));
+    }
+    return true;
+}
@@ -0,0 +1,40 @@
+// cast_labels.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "skill_model.h"
+
+//----------------------------------------------------//
+//            Labelled Casts (training data)
+//----------------------------------------------------//
+
+struct CastLabelOptions
+{
+    std::string timeColumn = "timestamp_ms";
+    double      timeScale = 1.0;
+    std::string labelColumn = "hit";
+    uint32_t    toleranceMs = 250;   // label to cast press distance
+    int64_t     offsetMs = 0;        // capture time = label time + offset,
+                                     // unless align stored a clock fit
+};
+
+struct CastSample
+{
+    uint32_t timestamp;
+    uint32_t keyCode;
+    float    features[kCastOutcomeDims];
+};
+
+// All casts of a session with their features
+bool extractCastSamples(const std::string& path, const std::vector<uint32_t>& castKeys,
+    std::vector<CastSample>& out);
+
+// Pairs each hit/miss label (timeline file, see asof_join.h) with the nearest
+// cast of the session and appends the labelled rows to x / y
+bool labelCastSamples(const std::string& sessionPath, const std::string& labelPath,
+    const std::vector<CastSample>& casts, const CastLabelOptions& options,
+    std::vector<float>& x, std::vector<uint8_t>& y, size_t& labels);
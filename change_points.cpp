@@ -0,0 +1,395 @@
+#include "change_points.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "session_reader.h"
+
+// Metrics such as click rate can sit almost still for minutes; treat
+// anything within a few percent of the level as noise
+static const double kMinRelativeSpread = 0.05;
+
+// One wild sample (a cursor thrown across the screen) must not raise an
+// alarm on its own: standardized CUSUM steps are clipped to this
+static const double kMaxScore = 3.0;
+
+//----------------------------------------------------//
+//             CusumDetector Implementation
+//----------------------------------------------------//
+
+CusumDetector::CusumDetector(const ChangePointOptions& options)
+    : m_options(options)
+{
+}
+
+void CusumDetector::restart()
+{
+    m_count = 0;
+    m_mean = m_m2 = 0.0;
+    m_high = m_low = 0.0;
+    m_highSum = m_lowSum = 0.0;
+    m_highN = m_lowN = 0;
+}
+
+bool CusumDetector::update(double x, uint32_t timeMs, ChangePoint& out)
+{
+    // Learn the baseline first
+    if (m_count < std::max<uint32_t>(2, m_options.warmup)) {
+        ++m_count;
+        const double delta = x - m_mean;
+        m_mean += delta / m_count;
+        m_m2 += delta * (x - m_mean);
+        return false;
+    }
+
+    // A flat baseline still needs a scale
+    const double sigma = std::max(std::sqrt(m_m2 / (m_count - 1)),
+        kMinRelativeSpread * std::fabs(m_mean) + 1e-6);
+    const double z = std::max(-kMaxScore, std::min(kMaxScore, (x - m_mean) / sigma));
+
+    auto step = [&](double& sum, double v, uint32_t& startMs, double& raw, uint32_t& n) {
+        if (sum == 0.0) {
+            startMs = timeMs;
+            raw = 0.0;
+            n = 0;
+        }
+        sum = std::max(0.0, sum + v - m_options.cusumSlack);
+        if (sum > 0.0) {
+            raw += x;
+            ++n;
+        }
+    };
+    step(m_high, z, m_highStartMs, m_highSum, m_highN);
+    step(m_low, -z, m_lowStartMs, m_lowSum, m_lowN);
+
+    const bool up = m_high > m_options.cusumThreshold;
+    if (!up && m_low <= m_options.cusumThreshold) {
+        return false;
+    }
+    out.detector = "cusum";
+    out.onsetMs = up ? m_highStartMs : m_lowStartMs;
+    out.detectedMs = timeMs;
+    out.before = m_mean;
+    out.after = up ? m_highSum / std::max<uint32_t>(1, m_highN) : m_lowSum / std::max<uint32_t>(1, m_lowN);
+    restart(); // the new level becomes the next baseline
+    return true;
+}
+
+//----------------------------------------------------//
+//          BayesChangeDetector Implementation
+//----------------------------------------------------//
+
+namespace {
+
+const double kPriorKappa = 1.0;
+const double kPriorAlpha = 1.0;
+
+// Log density of the Normal-Gamma posterior predictive (a Student t). The
+// floor keeps a run of identical samples from claiming certainty.
+double logPredictive(double x, double mu, double kappa, double alpha, double beta, double minScale2)
+{
+    const double nu = 2.0 * alpha;
+    const double scale2 = std::max(minScale2, beta * (kappa + 1.0) / (alpha * kappa));
+    const double d = x - mu;
+    return std::lgamma(alpha + 0.5) - std::lgamma(alpha) - 0.5 * std::log(nu * 3.14159265358979 * scale2)
+        - (alpha + 0.5) * std::log1p(d * d / (nu * scale2));
+}
+
+} // namespace
+
+BayesChangeDetector::BayesChangeDetector(const ChangePointOptions& options)
+    : m_options(options)
+{
+}
+
+void BayesChangeDetector::resetPrior()
+{
+    // Prior level and spread from the warmup samples
+    double mean = 0.0, m2 = 0.0;
+    for (size_t i = 0; i < m_warmup.size(); ++i) {
+        const double delta = m_warmup[i] - mean;
+        mean += delta / (i + 1);
+        m2 += delta * (m_warmup[i] - mean);
+    }
+    const double var = m_warmup.size() > 1 ? m2 / (m_warmup.size() - 1) : 1.0;
+    m_priorMu = mean;
+    const double minSpread = kMinRelativeSpread * std::fabs(mean) + 1e-6;
+    m_priorBeta = std::max(var, minSpread * minSpread) * kPriorAlpha;
+    m_minScale2 = minSpread * minSpread;
+}
+
+bool BayesChangeDetector::update(double x, uint32_t timeMs, ChangePoint& out)
+{
+    if (m_runs.empty()) {
+        m_warmup.push_back(x);
+        if (m_warmup.size() < std::max<uint32_t>(2, m_options.warmup)) {
+            return false;
+        }
+        resetPrior();
+        m_runs.push_back(Run{ 1.0, m_priorMu, kPriorKappa, kPriorAlpha, m_priorBeta, 0.0, timeMs });
+        m_levelSum = 0.0;
+        m_levelN = 0;
+        return false;
+    }
+
+    // Predictive weight of every run length, in log space so outliers
+    // cannot underflow all of them at once
+    const size_t n = m_runs.size();
+    std::vector<double> logw(n);
+    double top = -INFINITY;
+    for (size_t r = 0; r < n; ++r) {
+        const Run& run = m_runs[r];
+        logw[r] = std::log(std::max(run.prob, 1e-300)) +
+            logPredictive(x, run.mu, run.kappa, run.alpha, run.beta, m_minScale2);
+        top = std::max(top, logw[r]);
+    }
+
+    // Growth (run continues) and change (new run starts with x)
+    const size_t cap = std::max<uint32_t>(2, m_options.maxRunLength);
+    m_next.resize(std::min(n + 1, cap));
+    double changeMass = 0.0, total = 0.0;
+    for (size_t r = 0; r < n; ++r) {
+        const Run& run = m_runs[r];
+        const double w = std::exp(logw[r] - top);
+        changeMass += w * m_options.hazard;
+
+        Run grown;
+        grown.prob = w * (1.0 - m_options.hazard);
+        grown.mu = (run.kappa * run.mu + x) / (run.kappa + 1.0);
+        grown.kappa = run.kappa + 1.0;
+        grown.alpha = run.alpha + 0.5;
+        grown.beta = run.beta + run.kappa * (x - run.mu) * (x - run.mu) / (2.0 * (run.kappa + 1.0));
+        grown.sum = run.sum + x;
+        grown.startMs = run.startMs;
+
+        const size_t slot = std::min(r + 1, cap - 1);
+        if (slot == r + 1) {
+            m_next[slot] = grown;
+        }
+        else {
+            m_next[slot].prob += grown.prob; // merged tail keeps the older run's level
+        }
+    }
+    const double d = x - m_priorMu;
+    m_next[0] = Run{ changeMass, (kPriorKappa * m_priorMu + x) / (kPriorKappa + 1.0), kPriorKappa + 1.0,
+        kPriorAlpha + 0.5, m_priorBeta + kPriorKappa * d * d / (2.0 * (kPriorKappa + 1.0)), x, timeMs };
+
+    size_t mapRun = 0;
+    for (size_t r = 0; r < m_next.size(); ++r) {
+        total += m_next[r].prob;
+        if (m_next[r].prob > m_next[mapRun].prob) {
+            mapRun = r;
+        }
+    }
+    for (auto& run : m_next) {
+        run.prob /= total;
+    }
+    m_runs.swap(m_next);
+
+    ++m_levelN;
+    m_levelSum += x;
+
+    // Report once the most probable run started well after the current level
+    // and has lasted long enough not to be a burst of outliers
+    const uint32_t samples = static_cast<uint32_t>(mapRun + 1);
+    if (samples >= m_options.confirmSamples && samples + m_options.confirmSamples <= m_levelN &&
+        mapRun + 1 < cap) {
+        const Run& run = m_runs[mapRun];
+        out.detector = "bayes";
+        out.onsetMs = run.startMs;
+        out.detectedMs = timeMs;
+        out.before = (m_levelSum - run.sum) / (m_levelN - samples);
+        out.after = run.sum / samples;
+        m_levelN = samples;
+        m_levelSum = run.sum;
+        return true;
+    }
+    return false;
+}
+
+//----------------------------------------------------//
+//            MetricExtractor Implementation
+//----------------------------------------------------//
+
+const char* fatigueMetricName(FatigueMetric metric)
+{
+    switch (metric) {
+    case FatigueMetric::ReactionTime: return "reaction_ms";
+    case FatigueMetric::Overshoot:    return "overshoot_px";
+    case FatigueMetric::ClickRate:    return "clicks_per_min";
+    default:                          return "?";
+    }
+}
+
+MetricExtractor::MetricExtractor(const MetricOptions& options)
+    : m_options(options), m_reaction(options.castKeys, options.maxReactionMs)
+{
+}
+
+void MetricExtractor::closeRateBin(uint32_t nowMs, std::vector<MetricSample>& out)
+{
+    const uint32_t binMs = std::max<uint32_t>(1, m_options.rateBinMs);
+    if (!m_binStarted || nowMs - m_binStartMs < binMs) {
+        return;
+    }
+    if (m_binEvents > 0) {
+        out.push_back(MetricSample{ FatigueMetric::ClickRate, m_binStartMs + binMs,
+            m_binClicks * 60000.0 / binMs });
+    }
+    // Skip straight over idle stretches
+    m_binStartMs = nowMs - (nowMs - m_binStartMs) % binMs;
+    m_binClicks = 0;
+    m_binEvents = 0;
+}
+
+void MetricExtractor::onEvent(const SessionEvent& evt, std::vector<MetricSample>& out)
+{
+    if (!m_binStarted) {
+        m_binStarted = true;
+        m_binStartMs = evt.timestamp;
+    }
+    closeRateBin(evt.timestamp, out);
+
+    m_reaction.onEvent(evt, m_results);
+    for (const auto& r : m_results) {
+        out.push_back(MetricSample{ FatigueMetric::ReactionTime, r.endMs, r.value });
+    }
+    m_results.clear();
+
+    if (evt.kind == EventKind::MousePos) {
+        Flick f;
+        if (m_flicks.onSample(PathPoint{ evt.x, evt.y, evt.timestamp }, f)) {
+            m_flick = f;
+            m_hasFlick = true;
+        }
+        return;
+    }
+    if (!m_pressFilter.isNewPress(evt)) {
+        return;     // releases and auto-repeat
+    }
+
+    ++m_binEvents;
+    const bool click = evt.kind == EventKind::MouseLeftDown || evt.kind == EventKind::MouseRightDown;
+    m_binClicks += click ? 1 : 0;
+
+    // Overshoot: the part of the way back against the flick direction
+    // before acting on the target
+    const bool cast = evt.kind == EventKind::KeyDown &&
+        std::find(m_options.castKeys.begin(), m_options.castKeys.end(), evt.keyCode) != m_options.castKeys.end();
+    if ((click || cast) && m_hasFlick && !m_flicks.inFlick()) {
+        m_hasFlick = false;
+        const double dx = static_cast<double>(m_flick.to.x) - m_flick.from.x;
+        const double dy = static_cast<double>(m_flick.to.y) - m_flick.from.y;
+        const double len = std::hypot(dx, dy);
+        if (len > 0.0 && evt.timestamp - m_flick.endMs <= m_options.overshootWindowMs) {
+            const double along = ((evt.x - m_flick.to.x) * dx + (evt.y - m_flick.to.y) * dy) / len;
+            m_overshootSum += std::max(0.0, -along);
+            if (++m_overshootN >= std::max<uint32_t>(1, m_options.overshootBlock)) {
+                out.push_back(MetricSample{ FatigueMetric::Overshoot, evt.timestamp,
+                    m_overshootSum / m_overshootN });
+                m_overshootSum = 0.0;
+                m_overshootN = 0;
+            }
+        }
+    }
+}
+
+void MetricExtractor::onIdle(uint32_t nowMs, std::vector<MetricSample>& out)
+{
+    m_reaction.onIdle(nowMs, m_results);
+    m_results.clear();
+    Flick f;
+    if (m_flicks.onIdle(nowMs, f)) {
+        m_flick = f;
+        m_hasFlick = true;
+    }
+    closeRateBin(nowMs, out);
+}
+
+//----------------------------------------------------//
+//             FatigueMonitor Implementation
+//----------------------------------------------------//
+
+FatigueMonitor::FatigueMonitor(const MetricOptions& metrics, const ChangePointOptions& options,
+    bool cusum, bool bayes)
+    : m_extractor(metrics), m_cusumOn(cusum), m_bayesOn(bayes),
+      m_cusum(kMetrics, CusumDetector(options)), m_bayes(kMetrics, BayesChangeDetector(options))
+{
+}
+
+void FatigueMonitor::feed(std::vector<ChangePoint>& out)
+{
+    for (const auto& s : m_pending) {
+        const size_t m = static_cast<size_t>(s.metric);
+        ++m_samples[m];
+        ChangePoint cp;
+        if (m_cusumOn && m_cusum[m].update(s.value, s.timeMs, cp)) {
+            cp.metric = fatigueMetricName(s.metric);
+            out.push_back(cp);
+        }
+        if (m_bayesOn && m_bayes[m].update(s.value, s.timeMs, cp)) {
+            cp.metric = fatigueMetricName(s.metric);
+            out.push_back(cp);
+        }
+    }
+    m_pending.clear();
+}
+
+void FatigueMonitor::onEvent(const SessionEvent& evt, std::vector<ChangePoint>& out)
+{
+    m_extractor.onEvent(evt, m_pending);
+    feed(out);
+}
+
+void FatigueMonitor::onIdle(uint32_t nowMs, std::vector<ChangePoint>& out)
+{
+    m_extractor.onIdle(nowMs, m_pending);
+    feed(out);
+}
+
+//----------------------------------------------------//
+//          ChangePointOperator Implementation
+//----------------------------------------------------//
+
+ChangePointOperator::ChangePointOperator(const MetricOptions& metrics,
+    const ChangePointOptions& options)
+    : m_monitor(metrics, options)
+{
+}
+
+void ChangePointOperator::report(std::vector<LiveResult>& out)
+{
+    for (const auto& cp : m_changes) {
+        std::ostringstream oss;
+        oss << cp.metric << " " << cp.before << " -> " << cp.after << " since "
+            << (cp.detectedMs - cp.onsetMs) << " ms ago (" << cp.detector << ")";
+        out.push_back(LiveResult{ name(), cp.onsetMs, cp.detectedMs, cp.after, oss.str() });
+    }
+    m_changes.clear();
+}
+
+void ChangePointOperator::onEvent(const SessionEvent& evt, std::vector<LiveResult>& out)
+{
+    m_monitor.onEvent(evt, m_changes);
+    report(out);
+}
+
+void ChangePointOperator::onIdle(uint32_t nowMs, std::vector<LiveResult>& out)
+{
+    // The final UINT32_MAX tick of stop() would close a partial rate bin
+    if (nowMs != UINT32_MAX) {
+        m_monitor.onIdle(nowMs, m_changes);
+    }
+    report(out);
+}
+
+bool detectSessionChanges(const std::string& path, const MetricOptions& metrics,
+    const ChangePointOptions& options, bool cusum, bool bayes,
+    std::vector<ChangePoint>& out)
+{
+    FatigueMonitor monitor(metrics, options, cusum, bayes);
+    return forEachSessionEvent(path, [&](const SessionEvent& evt) {
+        monitor.onEvent(evt, out);
+    });
+}
@@ -0,0 +1,205 @@
+// change_points.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "session_event.h"
+#include "live_analysis.h"
+
+//----------------------------------------------------//
+//              Streaming Change Points
+//----------------------------------------------------//
+
+// A detected shift in the level of one metric
+struct ChangePoint
+{
+    const char* metric;      // "reaction_ms", "overshoot_px", "clicks_per_min"
+    const char* detector;    // "cusum" or "bayes"
+    uint32_t    onsetMs;     // estimated start of the new level
+    uint32_t    detectedMs;  // sample that raised the alarm
+    double      before;      // mean before the change
+    double      after;       // mean since onset
+};
+
+struct ChangePointOptions
+{
+    uint32_t warmup = 50;         // samples that set the baseline of each level
+
+    // CUSUM: slack and alarm threshold in baseline standard deviations
+    double   cusumSlack = 0.5;
+    double   cusumThreshold = 8.0;
+
+    // Bayesian online detection: change probability per sample and the
+    // longest run length tracked (bounds the per-sample cost)
+    double   hazard = 1.0 / 250.0;
+    uint32_t maxRunLength = 300;
+    uint32_t confirmSamples = 10; // new run must be this long before it is reported
+};
+
+// Two-sided Page CUSUM on standardized samples. The baseline comes from the
+// first 'warmup' samples and is re-learned after each alarm. O(1) per sample.
+class CusumDetector {
+public:
+    explicit CusumDetector(const ChangePointOptions& options = ChangePointOptions());
+
+    // Returns true and fills onset/before/after when a change is confirmed
+    bool update(double x, uint32_t timeMs, ChangePoint& out);
+
+private:
+    void restart();
+
+private:
+    ChangePointOptions m_options;
+    uint32_t m_count = 0;          // warmup samples seen
+    double   m_mean = 0.0;         // baseline (Welford)
+    double   m_m2 = 0.0;
+    double   m_high = 0.0;         // upper and lower cumulative sums
+    double   m_low = 0.0;
+    uint32_t m_highStartMs = 0;    // where each sum last left zero
+    uint32_t m_lowStartMs = 0;
+    double   m_highSum = 0.0;      // raw samples since then, for 'after'
+    double   m_lowSum = 0.0;
+    uint32_t m_highN = 0;
+    uint32_t m_lowN = 0;
+};
+
+// Bayesian online change-point detection (Adams & MacKay) with a
+// Normal-Gamma model. Run lengths beyond maxRunLength are merged into the
+// last one, so each sample costs O(maxRunLength): constant, not O(samples).
+class BayesChangeDetector {
+public:
+    explicit BayesChangeDetector(const ChangePointOptions& options = ChangePointOptions());
+
+    bool update(double x, uint32_t timeMs, ChangePoint& out);
+
+private:
+    struct Run
+    {
+        double prob;
+        double mu, kappa, alpha, beta;   // posterior of the run's level
+        double sum;                      // raw samples, for 'after'
+        uint32_t startMs;
+    };
+
+    void resetPrior();
+
+private:
+    ChangePointOptions m_options;
+    std::vector<Run>   m_runs;          // indexed by run length
+    std::vector<Run>   m_next;
+    std::vector<double> m_warmup;
+    double   m_priorMu = 0.0;
+    double   m_priorBeta = 1.0;
+    double   m_minScale2 = 0.0;         // floor of the predictive variance
+    double   m_levelSum = 0.0;          // samples of the current level
+    uint32_t m_levelN = 0;
+};
+
+//----------------------------------------------------//
+//                Fatigue Metrics
+//----------------------------------------------------//
+
+enum class FatigueMetric : uint8_t {
+    ReactionTime,   // flick landing to cast press (ms)
+    Overshoot,      // how far the cursor came back after flicks (px, block mean)
+    ClickRate,      // clicks per minute over active bins
+    Count
+};
+
+const char* fatigueMetricName(FatigueMetric metric);
+
+struct MetricSample
+{
+    FatigueMetric metric;
+    uint32_t      timeMs;
+    double        value;
+};
+
+struct MetricOptions
+{
+    std::vector<uint32_t> castKeys = { 'Q', 'W', 'E', 'R' };
+    uint32_t maxReactionMs = 1000;
+    uint32_t overshootWindowMs = 500;   // the correcting click must follow this soon
+    uint32_t overshootBlock = 8;        // most flicks need no correction: average blocks
+    uint32_t rateBinMs = 10000;         // click rate per bin; idle bins are skipped
+};
+
+// Turns the event stream into metric samples in one pass
+class MetricExtractor {
+public:
+    explicit MetricExtractor(const MetricOptions& options = MetricOptions());
+
+    void onEvent(const SessionEvent& evt, std::vector<MetricSample>& out);
+    void onIdle(uint32_t nowMs, std::vector<MetricSample>& out);
+
+private:
+    void closeRateBin(uint32_t nowMs, std::vector<MetricSample>& out);
+
+private:
+    MetricOptions        m_options;
+    ReactionTimeOperator m_reaction;
+    std::vector<LiveResult> m_results;
+    FlickTracker         m_flicks;
+    PressFilter          m_pressFilter;
+    bool                 m_hasFlick = false;
+    Flick                m_flick{};
+    double               m_overshootSum = 0.0;
+    uint32_t             m_overshootN = 0;
+    bool                 m_binStarted = false;
+    uint32_t             m_binStartMs = 0;
+    uint32_t             m_binClicks = 0;
+    uint32_t             m_binEvents = 0;
+};
+
+// Metrics plus one CUSUM and one Bayesian detector per metric
+class FatigueMonitor {
+public:
+    FatigueMonitor(const MetricOptions& metrics = MetricOptions(),
+        const ChangePointOptions& options = ChangePointOptions(),
+        bool cusum = true, bool bayes = true);
+
+    void onEvent(const SessionEvent& evt, std::vector<ChangePoint>& out);
+    void onIdle(uint32_t nowMs, std::vector<ChangePoint>& out);
+
+    uint64_t samples(FatigueMetric metric) const { return m_samples[static_cast<size_t>(metric)]; }
+
+private:
+    void feed(std::vector<ChangePoint>& out);
+
+private:
+    static const size_t kMetrics = static_cast<size_t>(FatigueMetric::Count);
+
+    MetricExtractor            m_extractor;
+    std::vector<MetricSample>  m_pending;
+    bool                       m_cusumOn;
+    bool                       m_bayesOn;
+    std::vector<CusumDetector> m_cusum;
+    std::vector<BayesChangeDetector> m_bayes;
+    uint64_t                   m_samples[kMetrics] = {};
+};
+
+// Reports change points on the live stream ("change")
+class ChangePointOperator : public LiveOperator {
+public:
+    ChangePointOperator(const MetricOptions& metrics = MetricOptions(),
+        const ChangePointOptions& options = ChangePointOptions());
+
+    const char* name() const override { return "change"; }
+    void onEvent(const SessionEvent& evt, std::vector<LiveResult>& out) override;
+    void onIdle(uint32_t nowMs, std::vector<LiveResult>& out) override;
+
+private:
+    void report(std::vector<LiveResult>& out);
+
+private:
+    FatigueMonitor           m_monitor;
+    std::vector<ChangePoint> m_changes;
+};
+
+// Runs the monitor over a recorded session
+bool detectSessionChanges(const std::string& path, const MetricOptions& metrics,
+    const ChangePointOptions& options, bool cusum, bool bayes,
+    std::vector<ChangePoint>& out);
@@ -0,0 +1,268 @@
+#include "clock_align.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include "session_header.h"
+#include "session_reader.h"
+
+//----------------------------------------------------//
+//                Robust Line Fit
+//----------------------------------------------------//
+
+namespace {
+
+struct ClockPair
+{
+    double timelineMs;
+    double captureMs;
+};
+
+const double kSeedGateMs = 250.0;      // first round: around the voted offset
+const double kMinGateMs = 20.0;
+const double kMinDriftSpanMs = 60000.0; // shorter overlaps only fit the offset
+const int    kPairingRounds = 4;
+const int    kReweightIterations = 20;
+
+double median(std::vector<double> values)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    auto mid = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), mid, values.end());
+    return *mid;
+}
+
+// Weighted least squares of capture time on timeline time (centred, so
+// hour-long sessions keep full precision)
+void weightedLine(const std::vector<ClockPair>& pairs, const std::vector<double>& weights,
+    bool fitDrift, double& offset, double& scale)
+{
+    double sw = 0.0, st = 0.0, sc = 0.0;
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        sw += weights[i];
+        st += weights[i] * pairs[i].timelineMs;
+        sc += weights[i] * pairs[i].captureMs;
+    }
+    if (sw <= 0.0) {
+        return;
+    }
+    const double mt = st / sw, mc = sc / sw;
+
+    scale = 1.0;
+    if (fitDrift) {
+        double stt = 0.0, stc = 0.0;
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            const double dt = pairs[i].timelineMs - mt;
+            stt += weights[i] * dt * dt;
+            stc += weights[i] * dt * (pairs[i].captureMs - mc);
+        }
+        if (stt > 0.0) {
+            scale = stc / stt;
+        }
+    }
+    offset = mc - scale * mt;
+}
+
+// Tukey biweight by iterative reweighting; returns the robust residual scale
+double robustFit(const std::vector<ClockPair>& pairs, ClockFit& fit)
+{
+    double lo = pairs.front().timelineMs, hi = lo;
+    for (const auto& p : pairs) {
+        lo = std::min(lo, p.timelineMs);
+        hi = std::max(hi, p.timelineMs);
+    }
+    const bool fitDrift = hi - lo >= kMinDriftSpanMs;
+
+    std::vector<double> weights(pairs.size(), 1.0), residuals(pairs.size());
+    double sigma = 0.0;
+    for (int iter = 0; iter < kReweightIterations; ++iter) {
+        const double oldOffset = fit.offsetMs, oldScale = fit.scale;
+        weightedLine(pairs, weights, fitDrift, fit.offsetMs, fit.scale);
+
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            residuals[i] = std::fabs(pairs[i].captureMs - fit.toCapture(pairs[i].timelineMs));
+        }
+        // MAD scale; capture timestamps only resolve whole milliseconds
+        sigma = std::max(1.0, 1.4826 * median(residuals));
+        const double c = 4.685 * sigma;
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            const double u = residuals[i] / c;
+            weights[i] = u < 1.0 ? (1.0 - u * u) * (1.0 - u * u) : 0.0;
+        }
+
+        if (iter > 0 && std::fabs(fit.offsetMs - oldOffset) < 1e-3 &&
+            std::fabs(fit.scale - oldScale) < 1e-12) {
+            break;
+        }
+    }
+
+    double sumSq = 0.0;
+    fit.inliers = 0;
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        if (weights[i] > 0.0) {
+            sumSq += residuals[i] * residuals[i];
+            ++fit.inliers;
+        }
+    }
+    fit.rmsMs = fit.inliers > 0 ? std::sqrt(sumSq / fit.inliers) : 0.0;
+    return sigma;
+}
+
+} // namespace
+
+//----------------------------------------------------//
+//                  Clock Fitting
+//----------------------------------------------------//
+
+bool fitTimelineClock(const std::string& sessionPath, const std::string& timelinePath,
+    const AsOfOptions& options, ClockFit& fit)
+{
+    int64_t seed = 0;
+    double support = 0.0;
+    if (!estimateTimelineOffset(sessionPath, timelinePath, options, seed, support)) {
+        std::cerr << "No events of " << sessionPath << " line up with " << timelinePath << "\n";
+        return false;
+    }
+
+    // Timeline times per key value (sorted, as the file is)
+    TimelineReader reader;
+    AsOfKeys keys;
+    if (!reader.open(timelinePath, options.timeColumn, options.timeScale) ||
+        !keys.init(options, reader)) {
+        return false;
+    }
+    std::unordered_map<std::string, std::vector<double>> rowsByKey;
+    TimelineRow row;
+    while (reader.next(row)) {
+        rowsByKey[keys.ofRow(row)].push_back(row.timeMs);
+    }
+
+    // Events that have candidate rows at all
+    std::vector<std::pair<double, const std::vector<double>*>> events;
+    bool ok = forEachSessionEvent(sessionPath, [&](const SessionEvent& evt) {
+        if (!isJoinedEvent(options, evt)) {
+            return;
+        }
+        auto it = rowsByKey.find(keys.ofEvent(evt));
+        if (it != rowsByKey.end()) {
+            events.emplace_back(static_cast<double>(evt.timestamp), &it->second);
+        }
+    });
+    if (!ok) {
+        return false;
+    }
+
+    fit = ClockFit();
+    fit.offsetMs = static_cast<double>(seed);
+    double gate = kSeedGateMs;
+    std::vector<ClockPair> pairs;
+    for (int round = 0; round < kPairingRounds; ++round) {
+        // Nearest same-key row under the current mapping
+        pairs.clear();
+        for (const auto& e : events) {
+            const std::vector<double>& times = *e.second;
+            const double predicted = fit.toTimeline(e.first);
+            auto it = std::lower_bound(times.begin(), times.end(), predicted);
+            double best = 0.0, bestDist = gate;
+            bool found = false;
+            if (it != times.end()) {
+                bestDist = std::fabs(e.first - fit.toCapture(*it));
+                best = *it;
+                found = bestDist <= gate;
+            }
+            if (it != times.begin()) {
+                const double d = std::fabs(e.first - fit.toCapture(*(it - 1)));
+                if (d <= gate && (!found || d < bestDist)) {
+                    best = *(it - 1);
+                    found = true;
+                }
+            }
+            if (found) {
+                pairs.push_back(ClockPair{ best, e.first });
+            }
+        }
+        if (pairs.size() < 2) {
+            std::cerr << "Too few matching pairs to fit a clock (" << pairs.size() << ")\n";
+            return false;
+        }
+
+        const double sigma = robustFit(pairs, fit);
+        gate = std::max(kMinGateMs, 6.0 * sigma);
+    }
+    fit.pairs = pairs.size();
+    return true;
+}
+
+//----------------------------------------------------//
+//                 Stored Clock Fit
+//----------------------------------------------------//
+
+std::string sessionClockPath(const std::string& sessionPath)
+{
+    return sessionPath + ".clock";
+}
+
+bool loadSessionClock(const std::string& sessionPath, ClockFit& fit)
+{
+    // Same "# key: value" lines as a session header
+    SessionHeader header;
+    const std::string clockPath = sessionClockPath(sessionPath);
+    const bool sidecar = std::ifstream(clockPath).is_open();
+    if (!readSessionHeader(sidecar ? clockPath : sessionPath, header)) {
+        return false;
+    }
+    const std::string* offset = header.get("clock_offset_ms");
+    const std::string* drift = header.get("clock_drift_ppm");
+    if (!offset || !drift) {
+        return false;
+    }
+
+    fit = ClockFit();
+    fit.offsetMs = std::strtod(offset->c_str(), nullptr);
+    fit.scale = 1.0 + std::strtod(drift->c_str(), nullptr) / 1e6;
+    if (const std::string* rms = header.get("clock_rms_ms")) {
+        fit.rmsMs = std::strtod(rms->c_str(), nullptr);
+    }
+    if (const std::string* pairs = header.get("clock_pairs")) {
+        fit.pairs = static_cast<size_t>(std::strtoull(pairs->c_str(), nullptr, 10));
+        fit.inliers = fit.pairs;
+    }
+    return true;
+}
+
+bool storeSessionClock(const std::string& sessionPath, const ClockFit& fit,
+    const std::string& reference)
+{
+    SessionHeader header;
+    auto fixed = [](double v, int digits) {
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(digits) << v;
+        return oss.str();
+    };
+    header.set("clock_offset_ms", fixed(fit.offsetMs, 3));
+    header.set("clock_drift_ppm", fixed(fit.driftPpm(), 4));
+    header.set("clock_rms_ms", fixed(fit.rmsMs, 2));
+    header.set("clock_pairs", std::to_string(fit.inliers));
+    header.set("clock_reference", reference);
+
+    const std::string clockPath = sessionClockPath(sessionPath);
+    std::ofstream ofs(clockPath, std::ios::trunc);
+    for (const auto& field : header.fields) {
+        ofs << "# " << field.first << ": " << field.second << "\n";
+    }
+    ofs.close();
+    if (!ofs) {
+        std::cerr << "Failed to write clock file: " << clockPath << "\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+// clock_align.h
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "asof_join.h"
+
+//----------------------------------------------------//
+//        Capture Clock vs. External Timelines
+//----------------------------------------------------//
+
+// Capture time = offsetMs + scale * timeline time. GetTickCount and a
+// replay's game clock start at unrelated points and tick at slightly
+// different rates; scale carries the drift (1 + ppm / 1e6).
+struct ClockFit
+{
+    double offsetMs = 0.0;
+    double scale = 1.0;
+    double rmsMs = 0.0;       // residual of the inlier pairs
+    size_t pairs = 0;         // matched pairs in the final round
+    size_t inliers = 0;       // pairs that kept a non-zero weight
+
+    double driftPpm() const { return (scale - 1.0) * 1e6; }
+    double toCapture(double timelineMs) const { return offsetMs + scale * timelineMs; }
+    double toTimeline(double captureMs) const { return (captureMs - offsetMs) / scale; }
+};
+
+// Pairs each joined event with the nearest timeline row with the same keys
+// (options.by), then fits offset and drift with a Tukey-biweight regression
+// so unrelated pairs are ignored. The voted offset of estimateTimelineOffset
+// seeds the first round; later rounds re-pair with the tighter fit.
+bool fitTimelineClock(const std::string& sessionPath, const std::string& timelinePath,
+    const AsOfOptions& options, ClockFit& fit);
+
+// The fit is kept next to the session ("clock_*" fields in <session>.clock)
+// so every later join uses it; the raw capture is never edited. Sessions
+// aligned before the sidecar existed carry the fields in their header, which
+// is still read. loadSessionClock returns false if the session has none.
+std::string sessionClockPath(const std::string& sessionPath);
+bool loadSessionClock(const std::string& sessionPath, ClockFit& fit);
+bool storeSessionClock(const std::string& sessionPath, const ClockFit& fit,
+    const std::string& reference);
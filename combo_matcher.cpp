@@ -0,0 +1,308 @@
+#include "combo_matcher.h"
+
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include <sstream>
+
+//----------------------------------------------------//
+//              Pattern Parsing Helpers
+//----------------------------------------------------//
+
+static std::string trim(const std::string& s)
+{
+    size_t begin = s.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(begin, end - begin + 1);
+}
+
+static bool parseUnsigned(const std::string& s, uint32_t& out)
+{
+    try {
+        size_t used = 0;
+        unsigned long v = std::stoul(s, &used);
+        if (used != s.size()) {
+            return false;
+        }
+        out = static_cast<uint32_t>(v);
+        return true;
+    }
+    catch (...) {
+        return false;
+    }
+}
+
+bool parseComboPattern(const std::string& line, ComboPattern& out)
+{
+    size_t eq = line.find('=');
+    if (eq == std::string::npos) {
+        std::cerr << "Combo pattern is missing '=': " << line << "\n";
+        return false;
+    }
+
+    ComboPattern pat;
+    pat.name = trim(line.substr(0, eq));
+    if (pat.name.empty()) {
+        std::cerr << "Combo pattern has no name: " << line << "\n";
+        return false;
+    }
+
+    std::istringstream iss(line.substr(eq + 1));
+    std::string token;
+    uint32_t pendingGap = 0;
+    while (iss >> token) {
+        if (token == "within") {
+            std::string value;
+            if (!(iss >> value) || !parseUnsigned(value, pat.maxTotalMs)) {
+                std::cerr << "Bad 'within' value in combo '" << pat.name << "'\n";
+                return false;
+            }
+            continue;
+        }
+        if (token[0] == '<') {
+            if (!parseUnsigned(token.substr(1), pendingGap)) {
+                std::cerr << "Bad gap '" << token << "' in combo '" << pat.name << "'\n";
+                return false;
+            }
+            continue;
+        }
+
+        ComboStep step;
+        if (token == "LMB" || token == "lmb") {
+            step.symbol = kComboSymbolLeftClick;
+        }
+        else if (token == "RMB" || token == "rmb") {
+            step.symbol = kComboSymbolRightClick;
+        }
+        else {
+            step.symbol = keyNameToVk(token);
+            if (step.symbol == 0) {
+                std::cerr << "Unknown key '" << token << "' in combo '" << pat.name << "'\n";
+                return false;
+            }
+        }
+        // A gap before the first step has nothing to measure against
+        step.maxGapMs = pat.steps.empty() ? 0 : pendingGap;
+        pendingGap = 0;
+        pat.steps.push_back(step);
+    }
+
+    if (pat.steps.empty()) {
+        std::cerr << "Combo '" << pat.name << "' has no steps.\n";
+        return false;
+    }
+
+    out = pat;
+    return true;
+}
+
+bool loadComboPatterns(const std::string& path, std::vector<ComboPattern>& out)
+{
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) {
+        std::cerr << "Failed to open combo file: " << path << "\n";
+        return false;
+    }
+
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(ifs, line)) {
+        ++lineNo;
+        std::string t = trim(line);
+        if (t.empty() || t[0] == '#') {
+            continue;
+        }
+        ComboPattern pat;
+        if (parseComboPattern(t, pat)) {
+            out.push_back(pat);
+        }
+        else {
+            std::cerr << "  (skipped line " << lineNo << " of " << path << ")\n";
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------//
+//             ComboMatcher Implementation
+//----------------------------------------------------//
+
+const uint32_t ComboMatcher::kNoState;
+
+ComboMatcher::ComboMatcher(const std::vector<ComboPattern>& patterns)
+    : m_patterns(patterns)
+{
+    build();
+}
+
+void ComboMatcher::reset()
+{
+    m_state = 0;
+    m_eventCount = 0;
+}
+
+void ComboMatcher::build()
+{
+    // 1) Give every symbol used by a pattern a dense class index, and all
+    //    other symbols one shared class after them
+    std::vector<int32_t> used(kComboAlphabetSize, -1);
+    m_classCount = 0;
+    size_t maxLen = 1;
+    for (const auto& pat : m_patterns) {
+        for (const auto& step : pat.steps) {
+            if (used[step.symbol] < 0) {
+                used[step.symbol] = static_cast<int32_t>(m_classCount++);
+            }
+        }
+        if (pat.steps.size() > maxLen) {
+            maxLen = pat.steps.size();
+        }
+    }
+    const uint32_t otherClass = static_cast<uint32_t>(m_classCount++);
+    m_symbolClass.resize(kComboAlphabetSize);
+    for (size_t sym = 0; sym < kComboAlphabetSize; ++sym) {
+        m_symbolClass[sym] = used[sym] < 0 ? otherClass : static_cast<uint32_t>(used[sym]);
+    }
+
+    // 2) Build the trie directly in the transition table
+    const size_t C = m_classCount;
+    m_delta.assign(C, kNoState);
+    std::vector<std::vector<uint32_t>> ends(1);
+    uint32_t stateCount = 1;
+
+    for (size_t p = 0; p < m_patterns.size(); ++p) {
+        uint32_t s = 0;
+        for (const auto& step : m_patterns[p].steps) {
+            size_t cls = m_symbolClass[step.symbol];
+            uint32_t next = m_delta[s * C + cls];
+            if (next == kNoState) {
+                next = stateCount++;
+                m_delta.resize(static_cast<size_t>(stateCount) * C, kNoState);
+                ends.emplace_back();
+                m_delta[s * C + cls] = next;
+            }
+            s = next;
+        }
+        ends[s].push_back(static_cast<uint32_t>(p));
+    }
+
+    // 3) BFS: failure links become DFA transitions, plus dictionary links
+    std::vector<uint32_t> fail(stateCount, 0);
+    m_dictLink.assign(stateCount, kNoState);
+    std::queue<uint32_t> bfs;
+
+    for (size_t c = 0; c < C; ++c) {
+        uint32_t v = m_delta[c];
+        if (v == kNoState) {
+            m_delta[c] = 0;
+        }
+        else {
+            fail[v] = 0;
+            bfs.push(v);
+        }
+    }
+    while (!bfs.empty()) {
+        uint32_t u = bfs.front();
+        bfs.pop();
+        for (size_t c = 0; c < C; ++c) {
+            uint32_t v = m_delta[u * C + c];
+            uint32_t viaFail = m_delta[fail[u] * C + c];
+            if (v == kNoState) {
+                m_delta[u * C + c] = viaFail;
+            }
+            else {
+                fail[v] = viaFail;
+                m_dictLink[v] = ends[viaFail].empty() ? m_dictLink[viaFail] : viaFail;
+                bfs.push(v);
+            }
+        }
+    }
+
+    // 4) Flatten the per-state outputs
+    m_outputBegin.assign(static_cast<size_t>(stateCount) + 1, 0);
+    m_outputList.clear();
+    for (uint32_t s = 0; s < stateCount; ++s) {
+        m_outputBegin[s] = static_cast<uint32_t>(m_outputList.size());
+        m_outputList.insert(m_outputList.end(), ends[s].begin(), ends[s].end());
+    }
+    m_outputBegin[stateCount] = static_cast<uint32_t>(m_outputList.size());
+
+    // History ring large enough for the longest pattern (power of two)
+    size_t ringSize = 1;
+    while (ringSize < maxLen) {
+        ringSize <<= 1;
+    }
+    m_history.assign(ringSize, 0);
+    m_historyMask = ringSize - 1;
+
+    reset();
+}
+
+bool ComboMatcher::guardsHold(const ComboPattern& pat, uint32_t& startMs) const
+{
+    const size_t len = pat.steps.size();
+    const size_t first = m_eventCount - len;
+
+    uint32_t prev = m_history[first & m_historyMask];
+    startMs = prev;
+    for (size_t i = 1; i < len; ++i) {
+        uint32_t t = m_history[(first + i) & m_historyMask];
+        uint32_t gap = pat.steps[i].maxGapMs;
+        if (gap != 0 && t - prev > gap) {
+            return false;
+        }
+        prev = t;
+    }
+    return pat.maxTotalMs == 0 || prev - startMs <= pat.maxTotalMs;
+}
+
+void ComboMatcher::onEvent(const SessionEvent& evt, std::vector<ComboMatch>& matches)
+{
+    uint32_t sym = pressChannel(evt);
+    if (sym == kComboNoSymbol) {
+        return;
+    }
+    // An "other" press leads back to the root: no combo spans it
+    m_state = m_delta[m_state * m_classCount + m_symbolClass[sym]];
+    m_history[m_eventCount & m_historyMask] = evt.timestamp;
+    ++m_eventCount;
+
+    // Walk every pattern that ends here: this state, then its dictionary links
+    uint32_t s = (m_outputBegin[m_state] != m_outputBegin[m_state + 1])
+        ? m_state : m_dictLink[m_state];
+    while (s != kNoState) {
+        for (uint32_t i = m_outputBegin[s]; i < m_outputBegin[s + 1]; ++i) {
+            uint32_t p = m_outputList[i];
+            uint32_t startMs = 0;
+            if (guardsHold(m_patterns[p], startMs)) {
+                matches.push_back(ComboMatch{ p, startMs, evt.timestamp });
+            }
+        }
+        s = m_dictLink[s];
+    }
+}
+
+//----------------------------------------------------//
+//                  ComboOperator
+//----------------------------------------------------//
+
+ComboOperator::ComboOperator(const std::vector<ComboPattern>& patterns)
+    : m_matcher(patterns)
+{
+}
+
+void ComboOperator::onEvent(const SessionEvent& evt, std::vector<LiveResult>& out)
+{
+    m_matches.clear();
+    m_matcher.onEvent(evt, m_matches);
+    for (const auto& m : m_matches) {
+        std::ostringstream oss;
+        oss << m_matcher.pattern(m.patternIndex).name
+            << " (" << (m.endMs - m.startMs) << " ms, ended at " << m.endMs << ")";
+        out.push_back(LiveResult{ name(), m.startMs, m.endMs,
+            static_cast<double>(m.endMs - m.startMs), oss.str() });
+    }
+}
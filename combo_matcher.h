@@ -0,0 +1,117 @@
+// combo_matcher.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "session_event.h"
+#include "live_analysis.h"
+
+//----------------------------------------------------//
+//                 Combo Definitions
+//----------------------------------------------------//
+
+// Combo symbols are the press channels from session_event.h
+const uint32_t kComboSymbolLeftClick  = kChannelLeftClick;
+const uint32_t kComboSymbolRightClick = kChannelRightClick;
+const uint32_t kComboAlphabetSize     = kChannelCount;
+const uint32_t kComboNoSymbol         = kNoChannel;
+
+struct ComboStep
+{
+    uint32_t symbol;    // see kComboSymbol* above
+    uint32_t maxGapMs;  // max time since the previous step (0 = unlimited)
+};
+
+struct ComboPattern
+{
+    std::string            name;
+    std::vector<ComboStep> steps;
+    uint32_t               maxTotalMs = 0; // first to last step (0 = unlimited)
+};
+
+struct ComboMatch
+{
+    size_t   patternIndex;
+    uint32_t startMs;  // timestamp of the first step
+    uint32_t endMs;    // timestamp of the last step
+};
+
+// Parses "name = Q <250 E <400 RMB within 1000"
+//   - steps are key names (see keyNameToVk) or LMB / RMB
+//   - "<N" limits the gap between the previous step and the next one
+//   - "within N" limits first-to-last step duration
+bool parseComboPattern(const std::string& line, ComboPattern& out);
+
+// One pattern per line; blank lines and lines starting with '#' are skipped
+bool loadComboPatterns(const std::string& path, std::vector<ComboPattern>& out);
+
+//----------------------------------------------------//
+//      ComboMatcher (Aho-Corasick + timing guards)
+//----------------------------------------------------//
+
+// All patterns are compiled into one automaton with a dense transition table,
+// so each event costs one table lookup plus the number of patterns that end
+// on it. Every press advances the automaton: presses no pattern uses share
+// one "other" class, which breaks any combo in progress, so a pattern means
+// the same whatever else is loaded. Mouse moves and key ups are ignored.
+class ComboMatcher {
+public:
+    explicit ComboMatcher(const std::vector<ComboPattern>& patterns);
+
+    // Back to the root state (e.g. between sessions)
+    void reset();
+
+    // Advances the automaton; appends completed combos to 'matches'
+    void onEvent(const SessionEvent& evt, std::vector<ComboMatch>& matches);
+
+    const ComboPattern& pattern(size_t index) const { return m_patterns[index]; }
+    size_t patternCount() const { return m_patterns.size(); }
+    size_t stateCount() const { return m_outputBegin.size() - 1; }
+
+private:
+    void build();
+    bool guardsHold(const ComboPattern& pat, uint32_t& startMs) const;
+
+private:
+    static const uint32_t kNoState = 0xFFFFFFFF;
+
+    std::vector<ComboPattern> m_patterns;
+
+    // Symbol -> dense class index; symbols no pattern uses map to the last
+    // class ("other")
+    std::vector<uint32_t>     m_symbolClass;
+    size_t                    m_classCount = 0;
+
+    // Full DFA: m_delta[state * m_classCount + cls]
+    std::vector<uint32_t>     m_delta;
+
+    // Patterns ending exactly at a state (CSR layout) and the nearest proper
+    // suffix state that has any output ("dictionary link")
+    std::vector<uint32_t>     m_outputBegin;
+    std::vector<uint32_t>     m_outputList;
+    std::vector<uint32_t>     m_dictLink;
+
+    // Timestamps of the last accepted events, for the timing guards
+    std::vector<uint32_t>     m_history;
+    size_t                    m_historyMask = 0;
+    size_t                    m_eventCount  = 0;
+
+    uint32_t                  m_state = 0;
+};
+
+// Reports completed combos on the live stream ("combo")
+class ComboOperator : public LiveOperator {
+public:
+    explicit ComboOperator(const std::vector<ComboPattern>& patterns);
+
+    const char* name() const override { return "combo"; }
+    void onEvent(const SessionEvent& evt, std::vector<LiveResult>& out) override;
+    void onIdle(uint32_t, std::vector<LiveResult>&) override {}
+
+private:
+    ComboMatcher            m_matcher;
+    std::vector<ComboMatch> m_matches;
+};
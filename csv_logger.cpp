@@ -0,0 +1,574 @@
+#include "csv_logger.h"
+#include "capture_trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+//----------------------------------------------------//
+//                 Event Helpers
+//----------------------------------------------------//
+
+// Converts a captured event to the portable record the analyzers consume
+SessionEvent toSessionEvent(const InputEvent& evt)
+{
+    return SessionEvent{
+        static_cast<uint32_t>(evt.timestamp),
+        eventKindFromString(evt.eventType),
+        static_cast<int32_t>(evt.mousePos.x),
+        static_cast<int32_t>(evt.mousePos.y),
+        static_cast<uint32_t>(evt.keyCode)
+    };
+}
+
+CaptureSource captureSourceOf(EventKind kind)
+{
+    switch (kind) {
+    case EventKind::MousePos: return CaptureSource::CursorPoll;
+    case EventKind::KeyDown:
+    case EventKind::KeyUp:    return CaptureSource::KeyboardHook;
+    default:                  return CaptureSource::MouseHook;
+    }
+}
+
+std::string formatCaptureCounts(const CaptureCounts& c)
+{
+    std::ostringstream oss;
+    oss << "captured=" << c.captured << " received=" << c.received << " gaps=" << c.gaps
+        << " reordered=" << c.reordered << " filtered=" << c.filtered << " failed=" << c.failed
+        << " written=" << c.written;
+    return oss.str();
+}
+
+bool parseCaptureCounts(const std::string& text, CaptureCounts& c)
+{
+    c = CaptureCounts();
+    std::istringstream iss(text);
+    std::string item;
+    bool any = false;
+    while (iss >> item) {
+        const size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            return false;
+        }
+        const std::string name = item.substr(0, eq);
+        uint64_t value = 0;
+        try {
+            value = std::stoull(item.substr(eq + 1));
+        }
+        catch (...) {
+            return false;
+        }
+        uint64_t* field =
+            name == "captured" ? &c.captured : name == "received" ? &c.received :
+            name == "gaps" ? &c.gaps : name == "reordered" ? &c.reordered :
+            name == "filtered" ? &c.filtered : name == "failed" ? &c.failed :
+            name == "written" ? &c.written : nullptr;
+        if (field) {   // unknown names are left for newer writers
+            *field = value;
+            any = true;
+        }
+    }
+    return any;
+}
+
+// Returns a string like "20250118_162453"
+std::string getTimestampString()
+{
+    std::time_t now = std::time(nullptr);
+    std::tm localTime;
+#if defined(_WIN32) || defined(_MSC_VER)
+    localtime_s(&localTime, &now);
+#else
+    localtime_r(&now, &localTime);
+#endif
+
+    std::ostringstream oss;
+    oss << std::put_time(&localTime, "%Y%m%d_%H%M%S");
+    return oss.str();
+}
+
+//----------------------------------------------------//
+//             CSVLogger Implementation
+//----------------------------------------------------//
+
+CSVLogger::CSVLogger(const std::string& filename, int flushIntervalSeconds)
+    : m_flushIntervalSec(flushIntervalSeconds)
+{
+    if (filename.empty()) {
+        // Generate a unique filename based on timestamp
+        std::string ts = getTimestampString();  // e.g. "20250118_162453"
+        m_filename = "input_log_" + ts + ".csv";
+    }
+    else {
+        m_filename = filename;
+    }
+    for (size_t i = 0; i < kSources; ++i) {
+        m_sequence[i].store(0);
+        m_expected[i] = 0;
+    }
+}
+
+
+CSVLogger::~CSVLogger()
+{
+    // Make sure to stop and flush if the user forgot
+    if (m_running.load()) {
+        stop();
+    }
+}
+
+void CSVLogger::start()
+{
+    if (m_running.load()) {
+        return; // already running
+    }
+    m_running.store(true);
+    m_pathStats = SimplifyStats();
+    {
+        // A new capture starts a new timeline
+        std::lock_guard<std::mutex> lock(m_flightMutex);
+        m_flightStats = FlightStats();
+        if (m_flightOptions) {
+            m_flight.reset(new FlightRecorder(*m_flightOptions));
+        }
+    }
+    {
+        // Events that came in after the previous stop() belong to no
+        // capture; left here they would land in this file with stale
+        // sequence numbers
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        if (!m_eventQueue.empty()) {
+            std::queue<InputEvent>().swap(m_eventQueue);
+            if (m_metrics) {
+                m_metrics->onDequeue();
+            }
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_countsMutex);
+        for (size_t i = 0; i < kSources; ++i) {
+            m_sequence[i].store(0);
+            m_expected[i] = 0;
+            m_counts[i] = CaptureCounts();
+        }
+    }
+
+    // Optionally, create or truncate the CSV file if you want a clean start:
+    {
+        std::ofstream ofs(m_filename, std::ios::trunc);
+        // Write header if desired
+        ofs << "timestamp_ms,event_type,x,y,key_code\n";
+    }
+
+    // Launch background flush thread
+    m_flushThread = std::thread(&CSVLogger::flushThreadFunc, this);
+}
+
+void CSVLogger::stop()
+{
+    if (!m_running.load()) {
+        return; // not running
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_running.store(false);
+    }
+    m_wake.notify_all();
+
+    // Wait for the flush thread to exit
+    if (m_flushThread.joinable()) {
+        m_flushThread.join();
+    }
+
+    // Final flush in case there are leftover events
+    flushToDisk(true);
+    writeTrailer();
+
+    if (m_pathStats.inputPoints > 0 && m_pathStats.outputPoints < m_pathStats.inputPoints) {
+        std::cout << "Lossy path mode kept " << m_pathStats.outputPoints << " of "
+            << m_pathStats.inputPoints << " cursor samples (max deviation "
+            << m_pathStats.maxDeviationPx << " px).\n";
+    }
+    for (size_t i = 0; i < kSources; ++i) {
+        const CaptureCounts c = captureCounts(static_cast<CaptureSource>(i));
+        if (c.lost() > 0) {
+            std::cout << "Lost " << c.lost() << " of " << c.captured << " "
+                << captureSourceName(static_cast<CaptureSource>(i)) << " events ("
+                << c.missing() << " never reached the logger, " << c.failed << " failed to write).\n";
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_flightMutex);
+    if (m_flightStats.samples > 0) {
+        std::cout << "Flight recorder kept " << m_flightStats.keptSamples() << " of "
+            << m_flightStats.samples << " cursor samples (" << m_flightStats.windowSamples
+            << " around " << m_flightStats.triggers << " triggers, "
+            << m_flightStats.backgroundSamples << " background).\n";
+    }
+}
+
+void CSVLogger::logEvent(const InputEvent& evt)
+{
+    TraceScope trace("enqueue");
+
+    // Thread-safe insertion
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    m_eventQueue.push(evt);
+    if (m_metrics) {
+        m_metrics->onEvent(evt.source, m_eventQueue.size());
+    }
+
+    // The queue lock also makes us the live ring's single producer
+    if (m_liveTap) {
+        m_liveTap->push(toSessionEvent(evt));
+    }
+}
+
+uint32_t CSVLogger::nextSequence(CaptureSource source)
+{
+    return m_sequence[static_cast<size_t>(source)].fetch_add(1, std::memory_order_relaxed);
+}
+
+CaptureCounts CSVLogger::captureCounts(CaptureSource source) const
+{
+    const size_t i = static_cast<size_t>(source);
+    std::lock_guard<std::mutex> lock(m_countsMutex);
+    CaptureCounts c = m_counts[i];
+    c.captured = m_sequence[i].load();
+    return c;
+}
+
+void CSVLogger::checkSequences(const std::vector<InputEvent>& batch)
+{
+    uint64_t gaps[kSources] = {};
+    {
+        std::lock_guard<std::mutex> lock(m_countsMutex);
+        for (const auto& evt : batch) {
+            const size_t i = static_cast<size_t>(evt.source);
+            CaptureCounts& c = m_counts[i];
+            ++c.received;
+            if (evt.sequence < m_expected[i]) {
+                ++c.reordered;   // a gap counted earlier was only a late arrival
+                continue;
+            }
+            if (evt.sequence > m_expected[i]) {
+                gaps[i] += evt.sequence - m_expected[i];
+                c.gaps += evt.sequence - m_expected[i];
+            }
+            m_expected[i] = evt.sequence + 1;
+        }
+    }
+    for (size_t i = 0; i < kSources; ++i) {
+        if (gaps[i] > 0) {
+            std::cerr << "[LOSS] " << gaps[i] << " " << captureSourceName(static_cast<CaptureSource>(i))
+                << " events missing from this batch\n";
+        }
+    }
+}
+
+void CSVLogger::writeTrailer()
+{
+    std::ofstream ofs(m_filename, std::ios::app);
+    if (!ofs.is_open()) {
+        std::cerr << "Failed to append the session trailer: " << m_filename << "\n";
+        return;
+    }
+    ofs << "# capture.ended: " << getTimestampString() << "\n";
+    for (size_t i = 0; i < kSources; ++i) {
+        const CaptureSource source = static_cast<CaptureSource>(i);
+        const CaptureCounts c = captureCounts(source);
+        ofs << "# capture." << captureSourceName(source) << ": " << formatCaptureCounts(c) << "\n";
+    }
+}
+
+void CSVLogger::setLiveTap(LiveAnalyzer* live)
+{
+    // Once this returns no push to the previous analyzer is in flight
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    m_liveTap = live;
+}
+
+void CSVLogger::addConsumer(EventConsumer consumer)
+{
+    std::lock_guard<std::mutex> lock(m_consumerMutex);
+    m_consumers.push_back(std::move(consumer));
+}
+
+void CSVLogger::setPathTolerance(double tolerancePx)
+{
+    m_pathTolerancePx.store(tolerancePx > 0.0 ? tolerancePx : 0.0);
+}
+
+void CSVLogger::setFlightRecorder(const FlightOptions* options)
+{
+    std::lock_guard<std::mutex> lock(m_flightMutex);
+    retireFlightRecorder();
+    if (options) {
+        m_flightOptions.reset(new FlightOptions(*options));
+        m_flight.reset(new FlightRecorder(*options));
+    }
+    else {
+        m_flightOptions.reset();
+    }
+}
+
+void CSVLogger::retireFlightRecorder()
+{
+    if (!m_flight) {
+        return;
+    }
+    m_flight->finish();
+    uint64_t filtered[kSources] = {};
+    bool keep = false;
+    while (m_flight->pop(keep)) {
+        if (keep) {
+            m_flightReleased.push_back(std::move(m_flightHeld.front()));
+        }
+        else {
+            ++filtered[static_cast<size_t>(m_flightHeld.front().source)];
+        }
+        m_flightHeld.pop_front();
+    }
+    m_flightStats.add(m_flight->stats());
+    countFiltered(filtered);
+    m_flight.reset();
+}
+
+void CSVLogger::recordBatch(std::vector<InputEvent>& batch, bool final)
+{
+    std::lock_guard<std::mutex> lock(m_flightMutex);
+    std::vector<InputEvent> out;
+    out.swap(m_flightReleased);
+
+    if (!m_flight) {
+        // Off (or switched off since the last flush): everything new is kept
+        out.insert(out.end(), batch.begin(), batch.end());
+        batch.swap(out);
+        return;
+    }
+
+    uint64_t filtered[kSources] = {};
+    bool keep = false;
+    auto drain = [&]() {
+        while (m_flight->pop(keep)) {
+            if (keep) {
+                out.push_back(std::move(m_flightHeld.front()));
+            }
+            else {
+                ++filtered[static_cast<size_t>(m_flightHeld.front().source)];
+            }
+            m_flightHeld.pop_front();
+        }
+    };
+    for (auto& evt : batch) {
+        m_flight->push(toSessionEvent(evt));
+        m_flightHeld.push_back(std::move(evt));
+        drain();
+    }
+    countFiltered(filtered);
+    if (final) {
+        retireFlightRecorder();
+        out.insert(out.end(), m_flightReleased.begin(), m_flightReleased.end());
+        m_flightReleased.clear();
+        if (m_flightOptions) {
+            m_flight.reset(new FlightRecorder(*m_flightOptions));
+        }
+    }
+    batch.swap(out);
+}
+
+void CSVLogger::countFiltered(const uint64_t* filtered)
+{
+    std::lock_guard<std::mutex> lock(m_countsMutex);
+    for (size_t i = 0; i < kSources; ++i) {
+        m_counts[i].filtered += filtered[i];
+    }
+}
+
+void CSVLogger::simplifyBatch(const std::vector<InputEvent>& batch, std::vector<char>& drop)
+{
+    SimplifyOptions options;
+    options.tolerancePx = m_pathTolerancePx.load();
+    options.metric = DeviationMetric::Synchronized; // keep timing usable for replays
+
+    std::vector<PathPoint> path;
+    std::vector<size_t> where; // batch index of each path point
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (batch[i].eventType == "MOUSE_POS") {
+            path.push_back(PathPoint{
+                static_cast<int32_t>(batch[i].mousePos.x),
+                static_cast<int32_t>(batch[i].mousePos.y),
+                static_cast<uint32_t>(batch[i].timestamp) });
+            where.push_back(i);
+        }
+    }
+
+    std::vector<size_t> keep;
+    simplifyPath(path, options, keep);
+
+    for (size_t i : where) {
+        drop[i] = 1;
+    }
+    for (size_t k : keep) {
+        drop[where[k]] = 0;
+    }
+
+    m_pathStats.inputPoints += path.size();
+    m_pathStats.outputPoints += keep.size();
+    m_pathStats.maxDeviationPx = std::max(m_pathStats.maxDeviationPx,
+        maxPathDeviation(path, keep, options.metric));
+}
+
+void CSVLogger::flushThreadFunc()
+{
+    captureTrace().setThreadName("flush");
+
+    // Loop until m_running is set to false
+    while (m_running.load()) {
+        // Sleep for flush interval (stop() cuts it short)
+        {
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            m_wake.wait_for(lock, std::chrono::seconds(m_flushIntervalSec),
+                [this]() { return !m_running.load(); });
+        }
+        if (!m_running.load()) {
+            break;
+        }
+        flushToDisk();
+    }
+}
+
+void CSVLogger::flushToDisk(bool final)
+{
+    TraceScope flushTrace("flush");
+    const auto begin = std::chrono::steady_clock::now();
+
+    // Move events from the queue into a local vector (so we don't hold the lock while writing)
+    std::vector<InputEvent> localBuffer;
+    {
+        TraceScope trace("drain");
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+
+        // Move all events from queue to localBuffer
+        while (!m_eventQueue.empty()) {
+            localBuffer.push_back(m_eventQueue.front());
+            m_eventQueue.pop();
+        }
+        if (m_metrics) {
+            m_metrics->onDequeue();
+        }
+        trace.setArg(localBuffer.size());
+    }
+    flushTrace.setArg(localBuffer.size());
+
+    checkSequences(localBuffer);
+
+    // Hand the batch to the analyzers (off the hook threads)
+    {
+        TraceScope trace("consumers");
+        std::lock_guard<std::mutex> lock(m_consumerMutex);
+        if (!m_consumers.empty()) {
+            for (const auto& evt : localBuffer) {
+                SessionEvent se = toSessionEvent(evt);
+                for (auto& consumer : m_consumers) {
+                    consumer(se);
+                }
+            }
+        }
+    }
+
+    std::vector<char> drop;
+    {
+        TraceScope trace("filter");
+
+        // Flight-recorder mode keeps back the samples that may still fall into
+        // a pre-trigger window and writes the ones a previous flush held back
+        recordBatch(localBuffer, final);
+        drop.assign(localBuffer.size(), 0);
+        if (!localBuffer.empty() && m_pathTolerancePx.load() > 0.0) {
+            simplifyBatch(localBuffer, drop);
+        }
+    }
+    if (localBuffer.empty()) {
+        return; // nothing to write
+    }
+
+    uint64_t filtered[kSources] = {};
+    uint64_t rows[kSources] = {};
+    for (size_t i = 0; i < localBuffer.size(); ++i) {
+        const size_t source = static_cast<size_t>(localBuffer[i].source);
+        if (drop[i]) {
+            ++filtered[source];
+        }
+        else {
+            ++rows[source];
+        }
+    }
+    countFiltered(filtered);
+
+    // Format the batch first, then hand the file one block
+    // CSV format: timestamp_ms,event_type,x,y,key_code
+    std::string text;
+    {
+        TraceScope trace("format");
+        text.reserve(localBuffer.size() * 32);
+        char line[128];
+        for (size_t i = 0; i < localBuffer.size(); ++i) {
+            if (drop[i]) {
+                continue;
+            }
+            const InputEvent& evt = localBuffer[i];
+            const int n = std::snprintf(line, sizeof(line), "%u,%s,%d,%d,%u\n",
+                static_cast<unsigned>(evt.timestamp), evt.eventType.c_str(),
+                static_cast<int>(evt.mousePos.x), static_cast<int>(evt.mousePos.y),
+                static_cast<unsigned>(evt.keyCode));
+            if (n > 0 && static_cast<size_t>(n) < sizeof(line)) {
+                text.append(line, static_cast<size_t>(n));
+            }
+            else {
+                text += std::to_string(evt.timestamp) + "," + evt.eventType + "," +
+                    std::to_string(evt.mousePos.x) + "," + std::to_string(evt.mousePos.y) + "," +
+                    std::to_string(evt.keyCode) + "\n";
+            }
+        }
+        trace.setArg(text.size());
+    }
+
+    // Open file in append mode
+    bool failed = true;
+    {
+        TraceScope trace("write", text.size());
+        std::ofstream ofs(m_filename, std::ios::app);
+        if (ofs.is_open()) {
+            ofs.write(text.data(), static_cast<std::streamsize>(text.size()));
+            ofs.close();
+            failed = ofs.fail();
+            if (failed) {
+                std::cerr << "Failed to write CSV file: " << m_filename << "\n";
+            }
+        }
+        else {
+            std::cerr << "Failed to open CSV file for appending: " << m_filename << "\n";
+        }
+    }
+
+    // A batch that did not make it to disk counts as failed, not written
+    uint64_t written = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_countsMutex);
+        for (size_t i = 0; i < kSources; ++i) {
+            (failed ? m_counts[i].failed : m_counts[i].written) += rows[i];
+            written += rows[i];
+        }
+    }
+    if (m_metrics && !failed) {
+        m_metrics->onFlush(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - begin).count()), written, text.size());
+    }
+}
@@ -0,0 +1,183 @@
+// csv_logger.h
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "session_event.h"
+#include "path_simplify.h"
+#include "live_analysis.h"
+#include "flight_recorder.h"
+#include "capture_metrics.h"
+
+//----------------------------------------------------//
+//                  Data Structures
+//----------------------------------------------------//
+
+struct CursorPos
+{
+    int32_t x;
+    int32_t y;
+};
+
+// Source a recorded event would have come from (for replays)
+CaptureSource captureSourceOf(EventKind kind);
+
+// Event structure to store any input event
+struct InputEvent
+{
+    std::string   eventType;  // e.g. "MOUSE_LEFT_DOWN", "KEY_UP", "MOUSE_POS", etc.
+    uint32_t      timestamp;  // in ms, from GetTickCount() (or the replayed session)
+    CursorPos     mousePos;   // relevant for mouse or for reference on keyboard
+    uint32_t      keyCode;    // relevant for keyboard events
+    CaptureSource source;
+    uint32_t      sequence;   // from CSVLogger::nextSequence(source) at capture
+};
+
+// Per-source accounting of one capture. Sequence numbers the sink never
+// saw are missing; filtered events were dropped on purpose (lossy path or
+// flight-recorder mode); failed ones were lost to a write error.
+struct CaptureCounts
+{
+    uint64_t captured = 0;    // sequence numbers handed out
+    uint64_t received = 0;    // reached the flush thread
+    uint64_t gaps = 0;        // sequence jumps seen in arrival order
+    uint64_t reordered = 0;   // arrived after a later sequence number
+    uint64_t filtered = 0;
+    uint64_t failed = 0;
+    uint64_t written = 0;
+
+    uint64_t missing() const { return captured > received ? captured - received : 0; }
+    uint64_t lost() const { return missing() + failed; }
+};
+
+// "captured=120 received=120 ..." as in the session trailer, and back
+std::string formatCaptureCounts(const CaptureCounts& counts);
+bool parseCaptureCounts(const std::string& text, CaptureCounts& counts);
+
+// Converts a captured event to the portable record the analyzers consume
+SessionEvent toSessionEvent(const InputEvent& evt);
+
+// Returns a string like "20250118_162453"
+std::string getTimestampString();
+
+//----------------------------------------------------//
+//              CSVLogger Class Declaration
+//----------------------------------------------------//
+
+// The capture pipeline: logEvent() queues (hook threads), a background
+// thread flushes batches to consumers and to the CSV file. No Win32 in here,
+// so a session replay can drive the same code anywhere.
+class CSVLogger {
+public:
+    CSVLogger(const std::string& filename = "input_log.csv",
+        int flushIntervalSeconds = 60);
+    ~CSVLogger();
+
+    void start();           // Starts the background flush thread
+    void stop();            // Stops the background flush thread (flushes remaining events)
+
+    // Thread-safe method to queue an event
+    void logEvent(const InputEvent& evt);
+
+    // Next sequence number of a source. Capture sites take one per capture
+    // attempt, so an attempt that never becomes an event shows up as a gap.
+    uint32_t nextSequence(CaptureSource source);
+
+    // Consumers see every event on the flush thread, just before it is written
+    using EventConsumer = std::function<void(const SessionEvent&)>;
+    void addConsumer(EventConsumer consumer);
+
+    // Lossy storage: simplify each batch's cursor track to within this many
+    // pixels before writing (0 = keep every sample)
+    void setPathTolerance(double tolerancePx);
+
+    // Flight-recorder storage: dense cursor samples only around trigger
+    // events, a sparse background track elsewhere (nullptr = keep every
+    // sample). Samples younger than the pre-window wait for the next flush.
+    void setFlightRecorder(const FlightOptions* options);
+
+    // Live analysis: every queued event is also pushed to this analyzer as it
+    // is logged (nullptr = off). The push never blocks the hook threads.
+    void setLiveTap(LiveAnalyzer* live);
+
+    // Metrics registry updated by the capture path (nullptr = none). Set it
+    // before start(); the logger does not own it.
+    void setMetrics(CaptureMetrics* metrics) { m_metrics = metrics; }
+
+    const std::string& filename() const { return m_filename; }
+
+    // Accounting of the current (or last) capture; complete after stop()
+    CaptureCounts captureCounts(CaptureSource source) const;
+
+private:
+    void flushThreadFunc(); // Thread loop that periodically flushes
+    void flushToDisk(bool final = false); // Writes buffered events to file
+
+    // Runs a batch through the flight recorder and replaces it with the
+    // events that are decided and kept, oldest first
+    void recordBatch(std::vector<InputEvent>& batch, bool final);
+    void retireFlightRecorder(); // caller holds m_flightMutex
+
+    // Marks the MOUSE_POS samples of a batch that lossy mode drops
+    void simplifyBatch(const std::vector<InputEvent>& batch, std::vector<char>& drop);
+
+    // Sequence checks on a batch as it reaches the flush thread
+    void checkSequences(const std::vector<InputEvent>& batch);
+
+    void countFiltered(const uint64_t* filtered);   // one count per source
+
+    // "# capture.<source>: ..." lines appended by stop()
+    void writeTrailer();
+
+private:
+    std::string                     m_filename;
+    int                             m_flushIntervalSec;
+    std::atomic<bool>               m_running{ false };
+
+    // A thread-safe queue for events
+    std::mutex                      m_queueMutex;
+    std::queue<InputEvent>          m_eventQueue;
+    LiveAnalyzer*                   m_liveTap = nullptr; // guarded by m_queueMutex
+    CaptureMetrics*                 m_metrics = nullptr;
+
+    // Analyzers fed from the flush thread
+    std::mutex                      m_consumerMutex;
+    std::vector<EventConsumer>      m_consumers;
+
+    // Background flush thread; stop() wakes it instead of waiting out the interval
+    std::thread                     m_flushThread;
+    std::mutex                      m_wakeMutex;
+    std::condition_variable         m_wake;
+
+    // Lossy path mode (stats are only touched by the flushing thread)
+    std::atomic<double>             m_pathTolerancePx{ 0.0 };
+    SimplifyStats                   m_pathStats;
+
+    // Flight-recorder mode. m_flightHeld mirrors the recorder's pending
+    // events; m_flightReleased holds kept events of a retired recorder until
+    // the next flush writes them.
+    std::mutex                      m_flightMutex;
+    std::unique_ptr<FlightOptions>  m_flightOptions;
+    std::unique_ptr<FlightRecorder> m_flight;
+    std::deque<InputEvent>          m_flightHeld;
+    std::vector<InputEvent>         m_flightReleased;
+    FlightStats                     m_flightStats;  // retired recorders of this capture
+
+    // Loss accounting. Sequence counters are taken by the capture threads;
+    // the counts are updated by the flushing thread and read under the mutex.
+    static const size_t             kSources = static_cast<size_t>(CaptureSource::Count);
+    std::atomic<uint32_t>           m_sequence[kSources];
+    uint32_t                        m_expected[kSources];
+    mutable std::mutex              m_countsMutex;
+    CaptureCounts                   m_counts[kSources];
+};
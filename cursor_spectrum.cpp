@@ -0,0 +1,191 @@
+#include "cursor_spectrum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "session_reader.h"
+
+//----------------------------------------------------//
+//            CursorSpectrum Implementation
+//----------------------------------------------------//
+
+static bool usableWindow(size_t n)
+{
+    return n >= 4 && isPowerOfTwo(n);
+}
+
+CursorSpectrum::CursorSpectrum(const SpectrumOptions& options, FrameCallback onFrame)
+    : m_options(options), m_onFrame(std::move(onFrame)),
+      m_valid(usableWindow(options.window) && options.rateHz > 0.0),
+      m_plan(usableWindow(options.window) ? options.window : 4)
+{
+    const size_t n = m_plan.size();
+    m_options.hop = std::max<size_t>(1, std::min(m_options.hop, n));
+    m_stepMs = m_valid ? 1000.0 / m_options.rateHz : 1.0;
+
+    const double pi = 3.14159265358979323846;
+    m_window.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        m_window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * pi * i / n));
+        m_windowPower += static_cast<double>(m_window[i]) * m_window[i];
+    }
+
+    m_vx.resize(n);
+    m_vy.resize(n);
+    m_vt.resize(n);
+    m_re.resize(n);
+    m_im.resize(n);
+    m_power.resize(n / 2 + 1);
+    m_sum.assign(n / 2 + 1, 0.0);
+}
+
+void CursorSpectrum::onEvent(const SessionEvent& evt)
+{
+    if (!m_valid || evt.kind != EventKind::MousePos) {
+        return;
+    }
+    const double x = evt.x, y = evt.y;
+    const uint32_t t = evt.timestamp;
+
+    if (m_hasLast && t == m_lastT) {
+        // Same timer tick: the later position wins
+        m_lastX = x;
+        m_lastY = y;
+        return;
+    }
+    if (!m_hasLast || t < m_lastT || t - m_lastT > m_options.maxGapMs) {
+        // Start (or restart after a gap): the track begins again here
+        m_filled = 0;
+        m_sinceFrame = 0;
+        m_hasPrevGrid = false;
+        m_gridT = t;
+    }
+    else {
+        const double span = static_cast<double>(t - m_lastT);
+        while (m_gridT < t) {
+            const double a = (m_gridT - m_lastT) / span;
+            pushSample(m_lastX + a * (x - m_lastX), m_lastY + a * (y - m_lastY),
+                static_cast<uint32_t>(m_gridT));
+            m_gridT += m_stepMs;
+        }
+    }
+    if (m_gridT <= t) {
+        pushSample(x, y, t);
+        m_gridT += m_stepMs;
+    }
+
+    m_hasLast = true;
+    m_lastX = x;
+    m_lastY = y;
+    m_lastT = t;
+}
+
+void CursorSpectrum::pushSample(double x, double y, uint32_t t)
+{
+    ++m_summary.samples;
+    if (m_hasPrevGrid) {
+        const size_t n = m_vx.size();
+        m_vx[m_head] = static_cast<float>((x - m_prevX) * m_options.rateHz);
+        m_vy[m_head] = static_cast<float>((y - m_prevY) * m_options.rateHz);
+        m_vt[m_head] = t;
+        m_head = (m_head + 1) % n;
+        m_filled = std::min(m_filled + 1, n);
+        ++m_sinceFrame;
+        if (m_filled == n && m_sinceFrame >= m_options.hop) {
+            frame(m_vt[m_head]); // oldest sample of the window
+            m_sinceFrame = 0;
+        }
+    }
+    m_prevX = x;
+    m_prevY = y;
+    m_hasPrevGrid = true;
+}
+
+void CursorSpectrum::frame(uint32_t startMs)
+{
+    const size_t n = m_vx.size();
+    double speedSq = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        const size_t j = (m_head + i) % n;
+        speedSq += static_cast<double>(m_vx[j]) * m_vx[j] + static_cast<double>(m_vy[j]) * m_vy[j];
+        m_re[i] = m_vx[j] * m_window[i];
+        m_im[i] = m_vy[j] * m_window[i];
+    }
+    m_plan.forward(m_re.data(), m_im.data());
+
+    // One-sided 2D power density: bins k and n - k together
+    const double scale = 1.0 / (m_options.rateHz * m_windowPower);
+    auto mag = [this](size_t k) {
+        return static_cast<double>(m_re[k]) * m_re[k] + static_cast<double>(m_im[k]) * m_im[k];
+    };
+    m_power[0] = static_cast<float>(mag(0) * scale);
+    for (size_t k = 1; k < n / 2; ++k) {
+        m_power[k] = static_cast<float>((mag(k) + mag(n - k)) * scale);
+    }
+    m_power[n / 2] = static_cast<float>(mag(n / 2) * scale);
+
+    const double rms = std::sqrt(speedSq / n);
+    ++m_summary.frames;
+    if (rms >= m_options.minSpeedPxPerS) {
+        ++m_summary.activeFrames;
+        m_speedSq += rms * rms;
+        for (size_t k = 0; k < m_power.size(); ++k) {
+            m_sum[k] += m_power[k];
+        }
+    }
+    if (m_onFrame) {
+        m_onFrame(SpectrumFrame{ startMs, rms, m_power.data() });
+    }
+}
+
+void CursorSpectrum::finish(SpectrumSummary& out)
+{
+    out = m_summary;
+    out.binHz = m_options.rateHz / m_vx.size();
+    out.meanPower.assign(m_sum.size(), 0.0);
+    if (out.activeFrames == 0) {
+        return;
+    }
+
+    double total = 0.0, voluntary = 0.0, tremor = 0.0, weighted = 0.0, peak = -1.0;
+    for (size_t k = 0; k < m_sum.size(); ++k) {
+        const double p = m_sum[k] / out.activeFrames;
+        const double f = k * out.binHz;
+        out.meanPower[k] = p;
+        total += p;
+        weighted += p * f;
+        if (f < m_options.tremorLowHz) {
+            voluntary += p;
+        }
+        else if (f <= m_options.tremorHighHz) {
+            tremor += p;
+            if (p > peak) {
+                peak = p;
+                out.tremorPeakHz = f;
+            }
+        }
+    }
+    out.rmsSpeed = std::sqrt(m_speedSq / out.activeFrames);
+    if (total > 0.0) {
+        out.voluntaryShare = voluntary / total;
+        out.tremorShare = tremor / total;
+        out.jitterShare = 1.0 - out.voluntaryShare - out.tremorShare;
+        out.centroidHz = weighted / total;
+    }
+}
+
+bool analyzeCursorSpectrum(const std::string& path, const SpectrumOptions& options,
+    SpectrumSummary& out, const CursorSpectrum::FrameCallback& onFrame)
+{
+    CursorSpectrum spectrum(options, onFrame);
+    if (!spectrum.valid()) {
+        std::cerr << "Spectrum window must be a power of two >= 4 and the rate positive\n";
+        return false;
+    }
+    bool ok = forEachSessionEvent(path, [&spectrum](const SessionEvent& evt) {
+        spectrum.onEvent(evt);
+    });
+    spectrum.finish(out);
+    return ok;
+}
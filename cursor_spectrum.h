@@ -0,0 +1,106 @@
+// cursor_spectrum.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "session_event.h"
+#include "fft.h"
+
+//----------------------------------------------------//
+//          Cursor Motion Power Spectra
+//----------------------------------------------------//
+
+struct SpectrumOptions
+{
+    double   rateHz = 50.0;          // resampling rate (default poll is 20 ms)
+    size_t   window = 128;           // STFT frame, samples (power of two)
+    size_t   hop = 64;
+    uint32_t maxGapMs = 200;         // longer sample gaps break the track
+    double   minSpeedPxPerS = 20.0;  // quieter frames count as idle
+
+    // Bands: voluntary motion below tremorLowHz, physiological tremor up to
+    // tremorHighHz, sensor/hand jitter above
+    double   tremorLowHz = 4.0;
+    double   tremorHighHz = 12.0;
+};
+
+// One STFT frame of the cursor velocity
+struct SpectrumFrame
+{
+    uint32_t startMs;
+    double   rmsSpeed;            // px/s over the frame
+    const float* power;           // window / 2 + 1 bins, (px/s)^2 per Hz
+};
+
+struct SpectrumSummary
+{
+    uint64_t samples = 0;         // resampled positions
+    uint64_t frames = 0;
+    uint64_t activeFrames = 0;    // frames that went into the mean spectrum
+    double   binHz = 0.0;
+    std::vector<double> meanPower;    // over active frames
+
+    double   rmsSpeed = 0.0;          // over active frames, px/s
+    double   voluntaryShare = 0.0;    // shares of the mean power per band
+    double   tremorShare = 0.0;
+    double   jitterShare = 0.0;
+    double   tremorPeakHz = 0.0;      // strongest bin inside the tremor band
+    double   centroidHz = 0.0;
+};
+
+// Streams MOUSE_POS samples: linear resampling onto a fixed grid, velocity
+// by first difference, Hann-windowed STFT. x and y go into one complex FFT
+// (x + iy); the power at +f and -f together is the 2D motion power at f.
+// Memory is one window, whatever the session length.
+class CursorSpectrum {
+public:
+    using FrameCallback = std::function<void(const SpectrumFrame&)>;
+
+    explicit CursorSpectrum(const SpectrumOptions& options = SpectrumOptions(),
+        FrameCallback onFrame = FrameCallback());
+
+    void onEvent(const SessionEvent& evt);
+    void finish(SpectrumSummary& out);
+
+    bool valid() const { return m_valid; }   // false if options.window is unusable
+
+private:
+    void pushSample(double x, double y, uint32_t t);
+    void frame(uint32_t startMs);
+
+private:
+    SpectrumOptions    m_options;
+    FrameCallback      m_onFrame;
+    bool               m_valid;
+    FftPlan            m_plan;
+    std::vector<float> m_window;      // Hann coefficients
+    double             m_windowPower = 0.0;
+
+    // Resampling state
+    bool     m_hasLast = false;
+    double   m_lastX = 0.0, m_lastY = 0.0;
+    uint32_t m_lastT = 0;
+    double   m_gridT = 0.0;           // next grid time, ms
+    double   m_stepMs;
+    bool     m_hasPrevGrid = false;
+    double   m_prevX = 0.0, m_prevY = 0.0;
+
+    // Velocity ring of one window
+    std::vector<float>    m_vx, m_vy;
+    std::vector<uint32_t> m_vt;
+    size_t   m_head = 0;
+    size_t   m_filled = 0;
+    size_t   m_sinceFrame = 0;
+
+    std::vector<float>  m_re, m_im, m_power;
+    std::vector<double> m_sum;
+    double   m_speedSq = 0.0;
+    SpectrumSummary m_summary;
+};
+
+bool analyzeCursorSpectrum(const std::string& path, const SpectrumOptions& options,
+    SpectrumSummary& out, const CursorSpectrum::FrameCallback& onFrame = CursorSpectrum::FrameCallback());
@@ -0,0 +1,142 @@
+#include "event_columns.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "session_reader.h"
+
+static const char     kColumnsMagic[4] = { 'S', 'S', 'E', 'C' };
+static const uint32_t kColumnsVersion = 1;
+
+//----------------------------------------------------//
+//             EventColumns Implementation
+//----------------------------------------------------//
+
+void EventColumns::clear()
+{
+    baseMs = 0;
+    hasBase = false;
+    for (auto& c : columns) {
+        c.clear();
+    }
+}
+
+void EventColumns::reserve(size_t n)
+{
+    for (auto& c : columns) {
+        c.reserve(n);
+    }
+}
+
+void EventColumns::append(const SessionEvent& evt)
+{
+    if (!hasBase) {
+        baseMs = evt.timestamp;
+        hasBase = true;
+    }
+    columns[kTime].push_back(static_cast<int32_t>(evt.timestamp - baseMs));
+    columns[kType].push_back(static_cast<int32_t>(evt.kind));
+    columns[kKey].push_back(static_cast<int32_t>(evt.keyCode));
+    columns[kX].push_back(evt.x);
+    columns[kY].push_back(evt.y);
+}
+
+SessionEvent EventColumns::row(size_t i) const
+{
+    SessionEvent evt;
+    evt.timestamp = baseMs + static_cast<uint32_t>(columns[kTime][i]);
+    evt.kind = static_cast<EventKind>(columns[kType][i]);
+    evt.x = columns[kX][i];
+    evt.y = columns[kY][i];
+    evt.keyCode = static_cast<uint32_t>(columns[kKey][i]);
+    return evt;
+}
+
+//----------------------------------------------------//
+//                 Sidecar Files
+//----------------------------------------------------//
+
+bool saveEventColumns(const std::string& path, const EventColumns& cols, uint64_t sourceSize)
+{
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open()) {
+        std::cerr << "Failed to open column store for writing: " << path << "\n";
+        return false;
+    }
+
+    uint64_t n = cols.size();
+    ofs.write(kColumnsMagic, sizeof(kColumnsMagic));
+    ofs.write(reinterpret_cast<const char*>(&kColumnsVersion), sizeof(kColumnsVersion));
+    ofs.write(reinterpret_cast<const char*>(&sourceSize), sizeof(sourceSize));
+    ofs.write(reinterpret_cast<const char*>(&cols.baseMs), sizeof(cols.baseMs));
+    ofs.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    for (const auto& c : cols.columns) {
+        ofs.write(reinterpret_cast<const char*>(c.data()),
+            static_cast<std::streamsize>(n * sizeof(int32_t)));
+    }
+    return static_cast<bool>(ofs);
+}
+
+bool loadEventColumns(const std::string& path, EventColumns& cols, uint64_t& sourceSize)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open()) {
+        return false; // no sidecar yet; not an error
+    }
+
+    char magic[4] = {};
+    uint32_t version = 0;
+    uint64_t n = 0;
+    ifs.read(magic, sizeof(magic));
+    ifs.read(reinterpret_cast<char*>(&version), sizeof(version));
+    ifs.read(reinterpret_cast<char*>(&sourceSize), sizeof(sourceSize));
+    ifs.read(reinterpret_cast<char*>(&cols.baseMs), sizeof(cols.baseMs));
+    ifs.read(reinterpret_cast<char*>(&n), sizeof(n));
+    cols.hasBase = true;
+    if (!ifs || std::memcmp(magic, kColumnsMagic, sizeof(magic)) != 0 || version != kColumnsVersion) {
+        std::cerr << "Ignoring unreadable column store: " << path << "\n";
+        return false;
+    }
+
+    for (auto& c : cols.columns) {
+        c.resize(static_cast<size_t>(n));
+        ifs.read(reinterpret_cast<char*>(c.data()),
+            static_cast<std::streamsize>(n * sizeof(int32_t)));
+    }
+    if (!ifs) {
+        std::cerr << "Truncated column store: " << path << "\n";
+        cols.clear();
+        return false;
+    }
+    return true;
+}
+
+std::string eventColumnsPath(const std::string& sessionPath)
+{
+    return sessionPath + ".cols";
+}
+
+bool loadSessionColumns(const std::string& sessionPath, EventColumns& cols, bool store)
+{
+    const uint64_t size = sessionFileSize(sessionPath);
+    const std::string sidecar = eventColumnsPath(sessionPath);
+
+    uint64_t storedSize = 0;
+    if (loadEventColumns(sidecar, cols, storedSize) && storedSize == size) {
+        return true;
+    }
+
+    cols.clear();
+    cols.reserve(static_cast<size_t>(size / 24)); // typical row length
+    bool ok = forEachSessionEvent(sessionPath, [&cols](const SessionEvent& evt) {
+        cols.append(evt);
+    });
+    if (!ok) {
+        return false;
+    }
+    if (store) {
+        saveEventColumns(sidecar, cols, size);
+    }
+    return true;
+}
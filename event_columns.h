@@ -0,0 +1,44 @@
+// event_columns.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "session_event.h"
+
+//----------------------------------------------------//
+//              Columnar Session Store
+//----------------------------------------------------//
+
+// Struct-of-arrays copy of one session: a contiguous int32 column per field,
+// so a scan only touches the fields it filters on and the loops vectorize.
+struct EventColumns
+{
+    enum Field { kTime, kType, kKey, kX, kY, kFieldCount };
+
+    uint32_t baseMs = 0;                            // timestamp of the first event
+    bool     hasBase = false;                       // set baseMs before appending to pin it
+    std::vector<int32_t> columns[kFieldCount];      // time is ms since baseMs
+
+    size_t size() const { return columns[kTime].size(); }
+    const int32_t* column(int field) const { return columns[field].data(); }
+
+    void clear();
+    void reserve(size_t n);
+    void append(const SessionEvent& evt);
+    SessionEvent row(size_t i) const;
+};
+
+// Binary sidecar next to the session; 'sourceSize' is the session file size
+// it was built from (a mismatch means the session changed)
+bool saveEventColumns(const std::string& path, const EventColumns& cols, uint64_t sourceSize);
+bool loadEventColumns(const std::string& path, EventColumns& cols, uint64_t& sourceSize);
+
+// "<session>.cols"
+std::string eventColumnsPath(const std::string& sessionPath);
+
+// Loads a session in columnar form: from the sidecar when it is current,
+// otherwise by parsing the CSV (writing a fresh sidecar if 'store' is set)
+bool loadSessionColumns(const std::string& sessionPath, EventColumns& cols, bool store);
@@ -0,0 +1,1068 @@
+#include "event_query.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+#include "session_segments.h"
+#include "thread_pool.h"
+
+static const char* const kFieldNames[EventColumns::kFieldCount] = { "t", "type", "key", "x", "y" };
+
+static const char* cmpName(QueryCmp cmp)
+{
+    switch (cmp) {
+    case QueryCmp::Eq: return "=";
+    case QueryCmp::Ne: return "!=";
+    case QueryCmp::Lt: return "<";
+    case QueryCmp::Le: return "<=";
+    case QueryCmp::Gt: return ">";
+    case QueryCmp::Ge: return ">=";
+    default:           return "?";
+    }
+}
+
+static std::string toLower(const std::string& s)
+{
+    std::string out(s);
+    for (auto& c : out) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return out;
+}
+
+static std::string toUpper(const std::string& s)
+{
+    std::string out(s);
+    for (auto& c : out) {
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    return out;
+}
+
+static int32_t clampToInt32(double v)
+{
+    if (v <= std::numeric_limits<int32_t>::min()) return std::numeric_limits<int32_t>::min();
+    if (v >= std::numeric_limits<int32_t>::max()) return std::numeric_limits<int32_t>::max();
+    return static_cast<int32_t>(std::llround(v));
+}
+
+// Field value as it reads in a query (event and key names where they apply)
+static std::string formatValue(uint8_t field, int32_t v)
+{
+    if (field == EventColumns::kType) {
+        return eventKindToString(static_cast<EventKind>(v));
+    }
+    if (field == EventColumns::kKey) {
+        return vkToKeyName(static_cast<uint32_t>(v));
+    }
+    if (field == EventColumns::kTime) {
+        return std::to_string(v) + "ms";
+    }
+    return std::to_string(v);
+}
+
+//----------------------------------------------------//
+//                     Lexer
+//----------------------------------------------------//
+
+namespace {
+
+enum class TokenKind { Word, Number, Cmp, LParen, RParen, Comma, DotDot, Pipe, End };
+
+struct Token
+{
+    TokenKind   kind;
+    std::string text;
+    size_t      pos;
+    double      value = 0.0;  // Number: in ms when a unit was given
+    QueryCmp    cmp = QueryCmp::Eq;
+};
+
+bool tokenize(const std::string& text, std::vector<Token>& tokens, std::string& error)
+{
+    size_t i = 0;
+    const size_t n = text.size();
+    while (i < n) {
+        const char c = text[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+            continue;
+        }
+
+        Token tok{ TokenKind::End, "", i };
+        const bool signedNumber = (c == '-' || c == '+') && i + 1 < n &&
+            std::isdigit(static_cast<unsigned char>(text[i + 1]));
+        if (std::isdigit(static_cast<unsigned char>(c)) || signedNumber) {
+            size_t j = i + 1;
+            while (j < n && std::isdigit(static_cast<unsigned char>(text[j]))) ++j;
+            if (j + 1 < n && text[j] == '.' && std::isdigit(static_cast<unsigned char>(text[j + 1]))) {
+                ++j;
+                while (j < n && std::isdigit(static_cast<unsigned char>(text[j]))) ++j;
+            }
+            const double number = std::stod(text.substr(i, j - i));
+            size_t k = j;
+            while (k < n && std::isalpha(static_cast<unsigned char>(text[k]))) ++k;
+            const std::string unit = toLower(text.substr(j, k - j));
+
+            double scale = 1.0;
+            if (unit == "s") scale = 1000.0;
+            else if (unit == "m") scale = 60000.0;
+            else if (unit == "h") scale = 3600000.0;
+            else if (!unit.empty() && unit != "ms") {
+                error = "unknown unit '" + unit + "' at " + std::to_string(j);
+                return false;
+            }
+            tok.kind = TokenKind::Number;
+            tok.text = text.substr(i, k - i);
+            tok.value = number * scale;
+            i = k;
+        }
+        else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            size_t j = i;
+            while (j < n && (std::isalnum(static_cast<unsigned char>(text[j])) || text[j] == '_')) ++j;
+            tok.kind = TokenKind::Word;
+            tok.text = text.substr(i, j - i);
+            i = j;
+        }
+        else if (c == '(' || c == ')' || c == ',' || c == '|') {
+            tok.kind = c == '(' ? TokenKind::LParen : c == ')' ? TokenKind::RParen
+                : c == ',' ? TokenKind::Comma : TokenKind::Pipe;
+            tok.text = std::string(1, c);
+            ++i;
+        }
+        else if (c == '.' && i + 1 < n && text[i + 1] == '.') {
+            tok.kind = TokenKind::DotDot;
+            tok.text = "..";
+            i += 2;
+        }
+        else if (c == '=' || c == '!' || c == '<' || c == '>') {
+            const bool eq = i + 1 < n && text[i + 1] == '=';
+            tok.kind = TokenKind::Cmp;
+            if (c == '=') tok.cmp = QueryCmp::Eq;
+            else if (c == '!') {
+                if (!eq) {
+                    error = "expected '!=' at " + std::to_string(i);
+                    return false;
+                }
+                tok.cmp = QueryCmp::Ne;
+            }
+            else if (c == '<') tok.cmp = eq ? QueryCmp::Le : QueryCmp::Lt;
+            else tok.cmp = eq ? QueryCmp::Ge : QueryCmp::Gt;
+            tok.text = text.substr(i, eq ? 2 : 1);
+            i += eq ? 2 : 1; // "==" reads as "="
+        }
+        else {
+            error = std::string("unexpected '") + c + "' at " + std::to_string(i);
+            return false;
+        }
+        tokens.push_back(tok);
+    }
+    tokens.push_back(Token{ TokenKind::End, "", n });
+    return true;
+}
+
+} // namespace
+
+//----------------------------------------------------//
+//               Parser / Compiler
+//----------------------------------------------------//
+
+class QueryParser {
+public:
+    QueryParser(std::vector<Token> tokens, EventQuery& query)
+        : m_tokens(std::move(tokens)), m_query(query)
+    {
+    }
+
+    bool parse(std::string& error)
+    {
+        if (!parseQuery()) {
+            error = m_error;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    const Token& peek() const { return m_tokens[m_pos]; }
+    const Token& next() { return m_tokens[m_pos++]; }
+
+    bool isWord(const char* word) const
+    {
+        return peek().kind == TokenKind::Word && toLower(peek().text) == word;
+    }
+
+    bool fail(const std::string& what)
+    {
+        if (m_error.empty()) {
+            const Token& t = peek();
+            m_error = what + " at " + std::to_string(t.pos) +
+                (t.kind == TokenKind::End ? " (end of query)" : " ('" + t.text + "')");
+        }
+        return false;
+    }
+
+    bool expect(TokenKind kind, const char* what)
+    {
+        if (peek().kind != kind) {
+            return fail(std::string("expected ") + what);
+        }
+        ++m_pos;
+        return true;
+    }
+
+    bool isStageWord() const
+    {
+        return isWord("where") || isWord("window") || isWord("head") ||
+            isWord("count") || isWord("stats");
+    }
+
+    bool parseQuery()
+    {
+        if (peek().kind != TokenKind::End && peek().kind != TokenKind::Pipe && !isStageWord()) {
+            if (!parseWhere()) {
+                return false;
+            }
+        }
+        else if (isStageWord() && !parseStage()) {
+            return false;
+        }
+
+        while (peek().kind == TokenKind::Pipe) {
+            ++m_pos;
+            if (!parseStage()) {
+                return false;
+            }
+        }
+        if (peek().kind != TokenKind::End) {
+            return fail("expected '|' or end of query");
+        }
+
+        // Terminal stages only make sense last; default to counting rows
+        auto& stages = m_query.m_stages;
+        for (size_t i = 0; i + 1 < stages.size(); ++i) {
+            if (stages[i].kind == QueryStageKind::Head || stages[i].kind == QueryStageKind::Count ||
+                stages[i].kind == QueryStageKind::Stats) {
+                m_error = "head, count and stats must be the last stage";
+                return false;
+            }
+        }
+        if (stages.empty() || stages.back().kind == QueryStageKind::Where ||
+            stages.back().kind == QueryStageKind::Window) {
+            stages.push_back(QueryStage{ QueryStageKind::Count });
+        }
+        return true;
+    }
+
+    bool parseStage()
+    {
+        if (isWord("where")) {
+            ++m_pos;
+            return parseWhere();
+        }
+
+        QueryStage stage{ QueryStageKind::Count };
+        if (isWord("window")) {
+            ++m_pos;
+            double from = 0.0, to = 0.0;
+            if (!parseNumber(from) || !expect(TokenKind::DotDot, "'..'") || !parseNumber(to)) {
+                return false;
+            }
+            if (from > to) {
+                return fail("window start is after its end");
+            }
+            stage.kind = QueryStageKind::Window;
+            stage.fromMs = clampToInt32(from);
+            stage.toMs = clampToInt32(to);
+        }
+        else if (isWord("head")) {
+            ++m_pos;
+            double n = 10.0;
+            if (peek().kind == TokenKind::Number && !parseNumber(n)) {
+                return false;
+            }
+            stage.kind = QueryStageKind::Head;
+            stage.limit = static_cast<uint32_t>(std::max(0.0, n));
+        }
+        else if (isWord("count")) {
+            ++m_pos;
+            stage.kind = QueryStageKind::Count;
+        }
+        else if (isWord("stats")) {
+            ++m_pos;
+            stage.kind = QueryStageKind::Stats;
+        }
+        else {
+            return fail("expected where, window, head, count or stats");
+        }
+        m_query.m_stages.push_back(stage);
+        return true;
+    }
+
+    bool parseWhere()
+    {
+        m_program = QueryProgram();
+        m_depth = 0;
+        if (!parseOr()) {
+            return false;
+        }
+        QueryStage stage{ QueryStageKind::Where };
+        stage.program = m_query.m_programs.size();
+        m_query.m_programs.push_back(std::move(m_program));
+        m_query.m_stages.push_back(stage);
+        return true;
+    }
+
+    void emit(const QueryInstr& instr)
+    {
+        switch (instr.op) {
+        case QueryOpcode::And:
+        case QueryOpcode::Or:
+            --m_depth;
+            break;
+        case QueryOpcode::Not:
+            break;
+        default:
+            ++m_depth;
+            m_program.fieldMask |= 1u << instr.field;
+            break;
+        }
+        m_program.stackDepth = std::max(m_program.stackDepth, m_depth);
+        m_program.code.push_back(instr);
+    }
+
+    void emitOp(QueryOpcode op)
+    {
+        emit(QueryInstr{ op, 0, QueryCmp::Eq, 0, 0, 0 });
+    }
+
+    bool parseOr()
+    {
+        if (!parseAnd()) {
+            return false;
+        }
+        while (isWord("or")) {
+            ++m_pos;
+            if (!parseAnd()) {
+                return false;
+            }
+            emitOp(QueryOpcode::Or);
+        }
+        return true;
+    }
+
+    bool parseAnd()
+    {
+        if (!parseUnary()) {
+            return false;
+        }
+        while (isWord("and")) {
+            ++m_pos;
+            if (!parseUnary()) {
+                return false;
+            }
+            emitOp(QueryOpcode::And);
+        }
+        return true;
+    }
+
+    bool parseUnary()
+    {
+        if (isWord("not")) {
+            ++m_pos;
+            if (!parseUnary()) {
+                return false;
+            }
+            emitOp(QueryOpcode::Not);
+            return true;
+        }
+        if (peek().kind == TokenKind::LParen) {
+            ++m_pos;
+            return parseOr() && expect(TokenKind::RParen, "')'");
+        }
+        return parseComparison();
+    }
+
+    bool parseNumber(double& value)
+    {
+        if (peek().kind != TokenKind::Number) {
+            return fail("expected a number");
+        }
+        value = next().value;
+        return true;
+    }
+
+    // One literal for 'field', in the column's encoding
+    bool parseValue(uint8_t field, int32_t& value)
+    {
+        const Token& tok = peek();
+        if (field == EventColumns::kType) {
+            EventKind kind = tok.kind == TokenKind::Word ? eventKindFromString(toUpper(tok.text))
+                : EventKind::Unknown;
+            if (kind == EventKind::Unknown) {
+                return fail("expected an event type (KEY_DOWN, MOUSE_POS, ...)");
+            }
+            value = static_cast<int32_t>(kind);
+            ++m_pos;
+            return true;
+        }
+        if (field == EventColumns::kKey) {
+            uint32_t vk = 0;
+            if (tok.kind == TokenKind::Word || tok.kind == TokenKind::Number) {
+                vk = keyNameToVk(tok.text);
+            }
+            if (vk == 0) {
+                return fail("expected a key name (Q, CTRL, 1, ...)");
+            }
+            value = static_cast<int32_t>(vk);
+            ++m_pos;
+            return true;
+        }
+
+        double number = 0.0;
+        if (!parseNumber(number)) {
+            return false;
+        }
+        value = clampToInt32(number);
+        return true;
+    }
+
+    bool parseComparison()
+    {
+        if (peek().kind != TokenKind::Word) {
+            return fail("expected a field (t, type, key, x, y)");
+        }
+        const std::string name = toLower(peek().text);
+        uint8_t field = EventColumns::kFieldCount;
+        for (uint8_t f = 0; f < EventColumns::kFieldCount; ++f) {
+            if (name == kFieldNames[f]) {
+                field = f;
+            }
+        }
+        if (field == EventColumns::kFieldCount) {
+            return fail("unknown field");
+        }
+        ++m_pos;
+
+        QueryInstr instr{ QueryOpcode::Compare, field, QueryCmp::Eq, 0, 0, 0 };
+        if (peek().kind == TokenKind::Cmp) {
+            instr.cmp = next().cmp;
+            if (!parseValue(field, instr.a)) {
+                return false;
+            }
+        }
+        else if (isWord("between")) {
+            ++m_pos;
+            instr.op = QueryOpcode::Range;
+            if (!parseValue(field, instr.a)) {
+                return false;
+            }
+            if (!isWord("and")) {
+                return fail("expected 'and'");
+            }
+            ++m_pos;
+            if (!parseValue(field, instr.b)) {
+                return false;
+            }
+        }
+        else if (isWord("in")) {
+            ++m_pos;
+            if (!expect(TokenKind::LParen, "'('")) {
+                return false;
+            }
+            std::vector<int32_t> set;
+            do {
+                int32_t v = 0;
+                if (!parseValue(field, v)) {
+                    return false;
+                }
+                set.push_back(v);
+            } while (peek().kind == TokenKind::Comma && (++m_pos, true));
+            if (!expect(TokenKind::RParen, "')'")) {
+                return false;
+            }
+
+            std::sort(set.begin(), set.end());
+            set.erase(std::unique(set.begin(), set.end()), set.end());
+            if (set.size() == 1) {
+                instr.a = set[0]; // plain equality
+            }
+            else {
+                instr.op = QueryOpcode::InSet;
+                instr.set = static_cast<uint32_t>(m_program.sets.size());
+                m_program.sets.push_back(std::move(set));
+            }
+        }
+        else {
+            return fail("expected a comparison, 'in' or 'between'");
+        }
+        emit(instr);
+        return true;
+    }
+
+private:
+    std::vector<Token> m_tokens;
+    size_t             m_pos = 0;
+    EventQuery&        m_query;
+    QueryProgram       m_program;
+    size_t             m_depth = 0;
+    std::string        m_error;
+};
+
+bool EventQuery::compile(const std::string& text, std::string& error)
+{
+    m_programs.clear();
+    m_stages.clear();
+
+    std::vector<Token> tokens;
+    if (!tokenize(text, tokens, error)) {
+        return false;
+    }
+    QueryParser parser(std::move(tokens), *this);
+    return parser.parse(error);
+}
+
+std::string EventQuery::stageLabel(size_t i) const
+{
+    const QueryStage& s = m_stages[i];
+    switch (s.kind) {
+    case QueryStageKind::Where:  return "where #" + std::to_string(s.program);
+    case QueryStageKind::Window: return "window " + std::to_string(s.fromMs) + ".." +
+        std::to_string(s.toMs) + "ms";
+    case QueryStageKind::Head:   return "head " + std::to_string(s.limit);
+    case QueryStageKind::Count:  return "count";
+    case QueryStageKind::Stats:  return "stats";
+    default:                     return "?";
+    }
+}
+
+std::string EventQuery::explain() const
+{
+    std::ostringstream oss;
+    oss << "scan: columnar session store (one task per session)\n";
+    for (size_t i = 0; i < m_stages.size(); ++i) {
+        oss << "stage " << i << ": " << stageLabel(i) << "\n";
+        if (m_stages[i].kind != QueryStageKind::Where) {
+            continue;
+        }
+
+        const QueryProgram& p = m_programs[m_stages[i].program];
+        oss << "  predicate program: " << p.code.size() << " instructions, mask stack "
+            << p.stackDepth << ", columns";
+        for (int f = 0; f < EventColumns::kFieldCount; ++f) {
+            if (p.fieldMask & (1u << f)) {
+                oss << " " << kFieldNames[f];
+            }
+        }
+        oss << (i == 0 ? " (contiguous scan)\n" : " (gathered from the selection)\n");
+
+        for (size_t pc = 0; pc < p.code.size(); ++pc) {
+            const QueryInstr& in = p.code[pc];
+            oss << "    " << pc << "  ";
+            switch (in.op) {
+            case QueryOpcode::Compare:
+                oss << "cmp    " << kFieldNames[in.field] << " " << cmpName(in.cmp) << " "
+                    << formatValue(in.field, in.a);
+                break;
+            case QueryOpcode::Range:
+                oss << "range  " << kFieldNames[in.field] << " in [" << formatValue(in.field, in.a)
+                    << ", " << formatValue(in.field, in.b) << "]";
+                break;
+            case QueryOpcode::InSet:
+                oss << "in     " << kFieldNames[in.field] << " {";
+                for (size_t k = 0; k < p.sets[in.set].size(); ++k) {
+                    oss << (k ? ", " : "") << formatValue(in.field, p.sets[in.set][k]);
+                }
+                oss << "}";
+                break;
+            case QueryOpcode::And: oss << "and"; break;
+            case QueryOpcode::Or:  oss << "or";  break;
+            case QueryOpcode::Not: oss << "not"; break;
+            case QueryOpcode::All: oss << "all"; break;
+            }
+            oss << "\n";
+        }
+    }
+    return oss.str();
+}
+
+bool EventQuery::timeBounds(int64_t& lo, int64_t& hi) const
+{
+    const int64_t kInf = int64_t(1) << 40;
+    lo = -kInf;
+    hi = kInf;
+    if (m_stages.empty() || m_stages[0].kind != QueryStageKind::Where) {
+        return false;
+    }
+
+    // Interval over-approximation: every stack entry holds the t range
+    // outside of which it is certainly false
+    struct Interval { int64_t lo, hi; };
+    std::vector<Interval> stack;
+    const QueryProgram& p = m_programs[m_stages[0].program];
+    for (const QueryInstr& in : p.code) {
+        Interval v{ -kInf, kInf };
+        switch (in.op) {
+        case QueryOpcode::Compare:
+            if (in.field == EventColumns::kTime) {
+                switch (in.cmp) {
+                case QueryCmp::Eq: v = Interval{ in.a, in.a }; break;
+                case QueryCmp::Lt: v.hi = int64_t(in.a) - 1; break;
+                case QueryCmp::Le: v.hi = in.a; break;
+                case QueryCmp::Gt: v.lo = int64_t(in.a) + 1; break;
+                case QueryCmp::Ge: v.lo = in.a; break;
+                case QueryCmp::Ne: break;
+                }
+            }
+            stack.push_back(v);
+            break;
+        case QueryOpcode::Range:
+            if (in.field == EventColumns::kTime) {
+                v = Interval{ in.a, in.b };
+            }
+            stack.push_back(v);
+            break;
+        case QueryOpcode::InSet:
+            if (in.field == EventColumns::kTime) {
+                v = Interval{ p.sets[in.set].front(), p.sets[in.set].back() };
+            }
+            stack.push_back(v);
+            break;
+        case QueryOpcode::All:
+            stack.push_back(v);
+            break;
+        case QueryOpcode::And: {
+            Interval b = stack.back();
+            stack.pop_back();
+            stack.back().lo = std::max(stack.back().lo, b.lo);
+            stack.back().hi = std::min(stack.back().hi, b.hi);
+            break;
+        }
+        case QueryOpcode::Or: {
+            Interval b = stack.back();
+            stack.pop_back();
+            stack.back().lo = std::min(stack.back().lo, b.lo);
+            stack.back().hi = std::max(stack.back().hi, b.hi);
+            break;
+        }
+        case QueryOpcode::Not:
+            stack.back() = Interval{ -kInf, kInf };
+            break;
+        }
+    }
+    lo = stack.back().lo;
+    hi = stack.back().hi;
+
+    for (const auto& s : m_stages) {
+        if (s.kind == QueryStageKind::Window) {
+            lo += std::min(s.fromMs, 0);
+            hi += std::max(s.toMs, 0);
+        }
+    }
+    return lo > -kInf || hi < kInf;
+}
+
+//----------------------------------------------------//
+//              Vectorized Execution
+//----------------------------------------------------//
+
+namespace {
+
+const size_t kBlockRows = 2048;
+
+// Rows that survived so far ('all' avoids materializing 0..n-1)
+struct Selection
+{
+    bool                  all = true;
+    std::vector<uint32_t> rows;
+
+    size_t size(size_t total) const { return all ? total : rows.size(); }
+};
+
+// The loops below are branch-free over contiguous int32 columns, so the
+// compiler turns them into SIMD compares
+void compareBlock(const int32_t* v, size_t n, QueryCmp cmp, int32_t c, uint8_t* out)
+{
+    switch (cmp) {
+    case QueryCmp::Eq: for (size_t i = 0; i < n; ++i) out[i] = v[i] == c; break;
+    case QueryCmp::Ne: for (size_t i = 0; i < n; ++i) out[i] = v[i] != c; break;
+    case QueryCmp::Lt: for (size_t i = 0; i < n; ++i) out[i] = v[i] < c;  break;
+    case QueryCmp::Le: for (size_t i = 0; i < n; ++i) out[i] = v[i] <= c; break;
+    case QueryCmp::Gt: for (size_t i = 0; i < n; ++i) out[i] = v[i] > c;  break;
+    case QueryCmp::Ge: for (size_t i = 0; i < n; ++i) out[i] = v[i] >= c; break;
+    }
+}
+
+void rangeBlock(const int32_t* v, size_t n, int32_t lo, int32_t hi, uint8_t* out)
+{
+    if (lo > hi) {
+        std::memset(out, 0, n);
+        return;
+    }
+    // lo <= v <= hi as one unsigned compare
+    const uint32_t width = static_cast<uint32_t>(hi) - static_cast<uint32_t>(lo);
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = static_cast<uint32_t>(v[i]) - static_cast<uint32_t>(lo) <= width;
+    }
+}
+
+void inSetBlock(const int32_t* v, size_t n, const std::vector<int32_t>& set, uint8_t* out)
+{
+    std::memset(out, 0, n);
+    for (int32_t c : set) {
+        for (size_t i = 0; i < n; ++i) {
+            out[i] |= v[i] == c;
+        }
+    }
+}
+
+// Runs a predicate program over one block; returns the result mask
+const uint8_t* evalBlock(const QueryProgram& p, const int32_t* const* cols, size_t n,
+    std::vector<uint8_t>& stack)
+{
+    size_t top = 0; // number of masks on the stack
+    auto mask = [&stack](size_t k) { return stack.data() + k * kBlockRows; };
+
+    for (const QueryInstr& in : p.code) {
+        switch (in.op) {
+        case QueryOpcode::Compare:
+            compareBlock(cols[in.field], n, in.cmp, in.a, mask(top++));
+            break;
+        case QueryOpcode::Range:
+            rangeBlock(cols[in.field], n, in.a, in.b, mask(top++));
+            break;
+        case QueryOpcode::InSet:
+            inSetBlock(cols[in.field], n, p.sets[in.set], mask(top++));
+            break;
+        case QueryOpcode::All:
+            std::memset(mask(top++), 1, n);
+            break;
+        case QueryOpcode::And: {
+            uint8_t* a = mask(top - 2);
+            const uint8_t* b = mask(top - 1);
+            for (size_t i = 0; i < n; ++i) a[i] &= b[i];
+            --top;
+            break;
+        }
+        case QueryOpcode::Or: {
+            uint8_t* a = mask(top - 2);
+            const uint8_t* b = mask(top - 1);
+            for (size_t i = 0; i < n; ++i) a[i] |= b[i];
+            --top;
+            break;
+        }
+        case QueryOpcode::Not: {
+            uint8_t* a = mask(top - 1);
+            for (size_t i = 0; i < n; ++i) a[i] ^= 1;
+            break;
+        }
+        }
+    }
+    return mask(0);
+}
+
+void runWhere(const QueryProgram& p, const EventColumns& cols, Selection& sel)
+{
+    std::vector<uint8_t> stack(std::max<size_t>(1, p.stackDepth) * kBlockRows);
+    std::vector<uint32_t> out;
+
+    if (sel.all) {
+        // Contiguous scan straight over the columns
+        const size_t total = cols.size();
+        for (size_t start = 0; start < total; start += kBlockRows) {
+            const size_t n = std::min(kBlockRows, total - start);
+            const int32_t* ptrs[EventColumns::kFieldCount];
+            for (int f = 0; f < EventColumns::kFieldCount; ++f) {
+                ptrs[f] = cols.column(f) + start;
+            }
+            const uint8_t* m = evalBlock(p, ptrs, n, stack);
+            for (size_t i = 0; i < n; ++i) {
+                if (m[i]) {
+                    out.push_back(static_cast<uint32_t>(start + i));
+                }
+            }
+        }
+    }
+    else {
+        // Gather only the columns the program reads into block buffers
+        std::vector<int32_t> gathered(EventColumns::kFieldCount * kBlockRows);
+        for (size_t start = 0; start < sel.rows.size(); start += kBlockRows) {
+            const size_t n = std::min(kBlockRows, sel.rows.size() - start);
+            const uint32_t* idx = sel.rows.data() + start;
+            const int32_t* ptrs[EventColumns::kFieldCount];
+            for (int f = 0; f < EventColumns::kFieldCount; ++f) {
+                int32_t* buf = gathered.data() + f * kBlockRows;
+                ptrs[f] = buf;
+                if (p.fieldMask & (1u << f)) {
+                    const int32_t* col = cols.column(f);
+                    for (size_t i = 0; i < n; ++i) {
+                        buf[i] = col[idx[i]];
+                    }
+                }
+            }
+            const uint8_t* m = evalBlock(p, ptrs, n, stack);
+            for (size_t i = 0; i < n; ++i) {
+                if (m[i]) {
+                    out.push_back(idx[i]);
+                }
+            }
+        }
+    }
+
+    sel.all = false;
+    sel.rows.swap(out);
+}
+
+// Every row within [t + from, t + to] of a selected row, each once, in row
+// order. Rows are close to but not strictly in time order (a cursor sample
+// can be stamped before the hook event written ahead of it), so unless the
+// session is sorted the sweep walks a time-sorted permutation of the rows.
+void runWindow(int32_t fromMs, int32_t toMs, const EventColumns& cols, Selection& sel)
+{
+    if (sel.all) {
+        return; // windows around every row cover every row
+    }
+
+    const int32_t* t = cols.column(EventColumns::kTime);
+    const size_t total = cols.size();
+    bool sorted = true;
+    for (size_t i = 1; i < total && sorted; ++i) {
+        sorted = t[i - 1] <= t[i];
+    }
+
+    // Rows and selected times in time order (both as they are when sorted)
+    std::vector<uint32_t> order;
+    std::vector<int32_t> starts;
+    starts.reserve(sel.rows.size());
+    for (uint32_t r : sel.rows) {
+        starts.push_back(t[r]);
+    }
+    if (!sorted) {
+        order.resize(total);
+        for (size_t i = 0; i < total; ++i) {
+            order[i] = static_cast<uint32_t>(i);
+        }
+        std::stable_sort(order.begin(), order.end(),
+            [t](uint32_t a, uint32_t b) { return t[a] < t[b]; });
+        std::sort(starts.begin(), starts.end());
+    }
+    auto rowAt = [&](size_t k) { return sorted ? static_cast<uint32_t>(k) : order[k]; };
+
+    // Both window edges only move forward over the time order
+    std::vector<uint32_t> out;
+    std::vector<uint8_t> hit(sorted ? 0 : total);
+    size_t lo = 0, hi = 0, emitted = 0; // positions [0, emitted) are decided
+    for (int32_t start : starts) {
+        const int64_t begin = static_cast<int64_t>(start) + fromMs;
+        const int64_t end = static_cast<int64_t>(start) + toMs;
+        while (lo < total && t[rowAt(lo)] < begin) ++lo;
+        if (hi < lo) hi = lo;
+        while (hi < total && t[rowAt(hi)] <= end) ++hi;
+
+        for (size_t k = std::max(lo, emitted); k < hi; ++k) {
+            if (sorted) {
+                out.push_back(static_cast<uint32_t>(k));
+            }
+            else {
+                hit[order[k]] = 1;
+            }
+        }
+        emitted = std::max(emitted, hi);
+    }
+    for (size_t j = 0; j < hit.size(); ++j) {
+        if (hit[j]) {
+            out.push_back(static_cast<uint32_t>(j));
+        }
+    }
+    sel.rows.swap(out);
+}
+
+void addStats(const EventColumns& cols, const Selection& sel, QueryStats& stats)
+{
+    const size_t n = sel.size(cols.size());
+    if (n == 0) {
+        return;
+    }
+    const int32_t* t = cols.column(EventColumns::kTime);
+    const int32_t* kind = cols.column(EventColumns::kType);
+    const int32_t* key = cols.column(EventColumns::kKey);
+    const int32_t* x = cols.column(EventColumns::kX);
+    const int32_t* y = cols.column(EventColumns::kY);
+
+    auto add = [&](size_t r) {
+        stats.sumX += x[r];
+        stats.sumY += y[r];
+        ++stats.kinds[static_cast<size_t>(kind[r]) & 7];
+        if ((kind[r] == static_cast<int32_t>(EventKind::KeyDown) ||
+            kind[r] == static_cast<int32_t>(EventKind::KeyUp)) && key[r] >= 0 && key[r] < 256) {
+            ++stats.keys[static_cast<size_t>(key[r])];
+        }
+    };
+
+    size_t first, last;
+    if (sel.all) {
+        for (size_t r = 0; r < n; ++r) add(r);
+        first = 0;
+        last = n - 1;
+    }
+    else {
+        for (uint32_t r : sel.rows) add(r);
+        first = sel.rows.front();
+        last = sel.rows.back();
+    }
+    stats.rows += n;
+    ++stats.sessions;
+    if (t[last] > t[first]) {
+        stats.spanMs += static_cast<uint64_t>(t[last] - t[first]);
+    }
+}
+
+} // namespace
+
+void QueryStats::combine(const QueryStats& other)
+{
+    rows += other.rows;
+    sessions += other.sessions;
+    spanMs += other.spanMs;
+    sumX += other.sumX;
+    sumY += other.sumY;
+    for (size_t i = 0; i < kinds.size(); ++i) kinds[i] += other.kinds[i];
+    for (size_t i = 0; i < keys.size(); ++i) keys[i] += other.keys[i];
+}
+
+void EventQuery::run(const EventColumns& cols, QuerySessionResult& result,
+    std::vector<QueryStageProfile>& profile) const
+{
+    Selection sel;
+    const size_t total = cols.size();
+
+    for (size_t i = 0; i < m_stages.size(); ++i) {
+        const QueryStage& s = m_stages[i];
+        QueryStageProfile& prof = profile[i + 1];
+        const uint64_t start = threadCpuTimeNs();
+        prof.rowsIn += sel.size(total);
+
+        switch (s.kind) {
+        case QueryStageKind::Where:
+            runWhere(m_programs[s.program], cols, sel);
+            break;
+        case QueryStageKind::Window:
+            runWindow(s.fromMs, s.toMs, cols, sel);
+            break;
+        case QueryStageKind::Head: {
+            const size_t n = std::min<size_t>(s.limit, sel.size(total));
+            for (size_t k = 0; k < n; ++k) {
+                result.rows.push_back(cols.row(sel.all ? k : sel.rows[k]));
+            }
+            break;
+        }
+        case QueryStageKind::Count:
+            result.stats.rows += sel.size(total);
+            result.stats.sessions += sel.size(total) > 0 ? 1 : 0;
+            break;
+        case QueryStageKind::Stats:
+            addStats(cols, sel, result.stats);
+            break;
+        }
+
+        prof.rowsOut += s.kind == QueryStageKind::Head
+            ? result.rows.size() : sel.size(total);
+        prof.cpuNs += threadCpuTimeNs() - start;
+    }
+}
+
+//----------------------------------------------------//
+//               Multi-Session Runner
+//----------------------------------------------------//
+
+bool runQuery(const EventQuery& query, const std::vector<std::string>& paths,
+    const QueryRunOptions& options, QueryReport& report)
+{
+    report = QueryReport();
+    const auto wallStart = std::chrono::steady_clock::now();
+
+    unsigned threads = options.threads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    const size_t profileSize = query.stageCount() + 1;
+    std::vector<QuerySessionResult> results(paths.size());
+    std::vector<std::vector<QueryStageProfile>> perWorker(threads,
+        std::vector<QueryStageProfile>(profileSize));
+    std::atomic<size_t> failures{ 0 };
+
+    int64_t lo = 0, hi = 0;
+    uint32_t gameFromMs = 0, gameToMs = UINT32_MAX;
+    if (options.game > 0 && query.timeBounds(lo, hi)) {
+        gameFromMs = static_cast<uint32_t>(std::max<int64_t>(0, lo));
+        gameToMs = static_cast<uint32_t>(std::max<int64_t>(0, std::min<int64_t>(UINT32_MAX, hi)));
+    }
+
+    {
+        WorkStealingPool pool(threads);
+        for (size_t i = 0; i < paths.size(); ++i) {
+            pool.submit([&, i]() {
+                auto& profile = perWorker[static_cast<size_t>(WorkStealingPool::currentWorker())];
+                EventColumns cols;
+                const uint64_t start = threadCpuTimeNs();
+                bool ok = true;
+                if (options.game > 0) {
+                    // Reads just the part of that game the query can touch;
+                    // t counts from the game's first event
+                    uint32_t gameStart = 0;
+                    forEachGameEvent(paths[i], options.game, gameFromMs, gameToMs, gameStart,
+                        [&cols, &gameStart](const SessionEvent& evt) {
+                            if (!cols.hasBase) {
+                                cols.baseMs = gameStart;
+                                cols.hasBase = true;
+                            }
+                            cols.append(evt);
+                        });
+                }
+                else {
+                    ok = loadSessionColumns(paths[i], cols, options.storeColumns);
+                }
+                profile[0].rowsOut += cols.size();
+                profile[0].cpuNs += threadCpuTimeNs() - start;
+                if (!ok) {
+                    failures.fetch_add(1);
+                    return;
+                }
+                query.run(cols, results[i], profile);
+            });
+        }
+        pool.wait();
+    }
+
+    // Merge in file order so head output is deterministic
+    const QueryStage& last = query.stage(query.stageCount() - 1);
+    for (size_t i = 0; i < paths.size(); ++i) {
+        report.stats.combine(results[i].stats);
+        for (const auto& evt : results[i].rows) {
+            if (report.rows.size() >= last.limit) {
+                break;
+            }
+            report.rows.emplace_back(paths[i], evt);
+        }
+    }
+    report.profile.assign(profileSize, QueryStageProfile());
+    for (const auto& w : perWorker) {
+        for (size_t s = 0; s < profileSize; ++s) {
+            report.profile[s].rowsIn += w[s].rowsIn;
+            report.profile[s].rowsOut += w[s].rowsOut;
+            report.profile[s].cpuNs += w[s].cpuNs;
+        }
+    }
+    report.failures = failures.load();
+    report.wallMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - wallStart).count();
+    return report.failures == 0;
+}
@@ -0,0 +1,157 @@
+// event_query.h
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "session_event.h"
+#include "event_columns.h"
+
+//----------------------------------------------------//
+//              Event Query Language
+//----------------------------------------------------//
+//
+//   query     := [predicate] { "|" stage }
+//   stage     := "where" predicate | "window" dur ".." dur | "head" n
+//              | "count" | "stats"
+//   predicate := and-terms joined by "or"; terms joined by "and"; "not",
+//                parentheses, and comparisons:
+//                field (= != < <= > >=) value | field in (v, ...)
+//                | field between v and v
+//   field     := t | type | key | x | y
+//
+// t is the time since the session's (or selected game's) first event;
+// durations take ms, s, m or h (plain numbers are ms). type takes event
+// names (KEY_DOWN, ...), key takes key names (Q, CTRL, 1, ...). Example:
+//
+//   type=KEY_DOWN and key in (Q,E) and t between 10m and 20m | window -300ms..0 | stats
+
+enum class QueryCmp : uint8_t { Eq, Ne, Lt, Le, Gt, Ge };
+
+enum class QueryOpcode : uint8_t {
+    Compare,    // push field <cmp> a
+    Range,      // push a <= field <= b
+    InSet,      // push field in sets[set]
+    And,        // pop two, push both
+    Or,         // pop two, push either
+    Not,        // invert top
+    All         // push all rows (empty predicate)
+};
+
+// One predicate bytecode instruction. Programs run block-at-a-time over the
+// columns and leave one selection mask on a small mask stack.
+struct QueryInstr
+{
+    QueryOpcode op;
+    uint8_t     field;      // EventColumns::Field
+    QueryCmp    cmp;
+    int32_t     a;
+    int32_t     b;
+    uint32_t    set;
+};
+
+struct QueryProgram
+{
+    std::vector<QueryInstr>           code;
+    std::vector<std::vector<int32_t>> sets;
+    size_t                            stackDepth = 0;
+    uint32_t                          fieldMask = 0;  // columns the program reads
+};
+
+enum class QueryStageKind : uint8_t { Where, Window, Head, Count, Stats };
+
+struct QueryStage
+{
+    QueryStageKind kind;
+    size_t         program = 0;   // Where: index into the query's programs
+    int32_t        fromMs = 0;    // Window bounds relative to each row
+    int32_t        toMs = 0;
+    uint32_t       limit = 0;     // Head
+};
+
+// Aggregates of the 'stats' stage (mergeable across sessions)
+struct QueryStats
+{
+    uint64_t rows = 0;
+    uint64_t sessions = 0;                  // sessions with at least one row
+    uint64_t spanMs = 0;                    // first to last selected row, summed
+    int64_t  sumX = 0;
+    int64_t  sumY = 0;
+    std::array<uint64_t, 8>   kinds{};      // rows by EventKind
+    std::array<uint64_t, 256> keys{};       // key rows by key code
+
+    void combine(const QueryStats& other);
+};
+
+// Per-stage work, for EXPLAIN ANALYZE-style reports. Entry 0 is loading.
+struct QueryStageProfile
+{
+    uint64_t rowsIn = 0;
+    uint64_t rowsOut = 0;
+    uint64_t cpuNs = 0;
+};
+
+// What one session contributed
+struct QuerySessionResult
+{
+    QueryStats                stats;
+    std::vector<SessionEvent> rows;         // head stage only
+};
+
+class EventQuery {
+public:
+    // Parses and compiles; on failure 'error' says where and why
+    bool compile(const std::string& text, std::string& error);
+
+    // Human-readable plan: stages and the bytecode of every predicate
+    std::string explain() const;
+
+    // Runs the pipeline over one session. 'profile' has stageCount() + 1
+    // entries (0 = load, filled by the caller).
+    void run(const EventColumns& cols, QuerySessionResult& result,
+        std::vector<QueryStageProfile>& profile) const;
+
+    size_t stageCount() const { return m_stages.size(); }
+    const QueryStage& stage(size_t i) const { return m_stages[i]; }
+    std::string stageLabel(size_t i) const;
+
+    // Range of t the query can touch (the leading filter's time bounds,
+    // widened by any window stages). False when it is unbounded.
+    bool timeBounds(int64_t& lo, int64_t& hi) const;
+
+private:
+    friend class QueryParser;
+
+    std::vector<QueryProgram> m_programs;
+    std::vector<QueryStage>   m_stages;     // always ends in head, count or stats
+};
+
+//----------------------------------------------------//
+//               Multi-Session Runner
+//----------------------------------------------------//
+
+struct QueryRunOptions
+{
+    unsigned threads = 0;       // 0 = all hardware threads
+    bool     storeColumns = true; // write .cols sidecars for sessions parsed from CSV
+    uint32_t game = 0;          // > 0: only that game of each session, read through the
+                                // segment index (and only the part timeBounds() allows);
+                                // sessions with fewer games contribute nothing
+};
+
+struct QueryReport
+{
+    QueryStats                                       stats;
+    std::vector<std::pair<std::string, SessionEvent>> rows;   // head, in file order
+    std::vector<QueryStageProfile>                   profile;
+    size_t                                           failures = 0;
+    double                                           wallMs = 0.0;
+};
+
+// Runs the query over every session in parallel (one task per file)
+bool runQuery(const EventQuery& query, const std::vector<std::string>& paths,
+    const QueryRunOptions& options, QueryReport& report);
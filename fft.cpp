@@ -0,0 +1,104 @@
+#include "fft.h"
+
+#include <cmath>
+#include <utility>
+
+#include "simd.h"
+
+bool isPowerOfTwo(size_t n)
+{
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+//----------------------------------------------------//
+//                FftPlan Implementation
+//----------------------------------------------------//
+
+FftPlan::FftPlan(size_t n)
+    : m_n(n), m_bitrev(n), m_twRe(n), m_twIm(n)
+{
+    size_t bits = 0;
+    while ((static_cast<size_t>(1) << bits) < n) {
+        ++bits;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t r = 0;
+        for (size_t b = 0; b < bits; ++b) {
+            r |= static_cast<uint32_t>((i >> b) & 1) << (bits - 1 - b);
+        }
+        m_bitrev[i] = r;
+    }
+
+    // Twiddles in double, stored per stage so a stage reads them contiguously
+    const double pi = 3.14159265358979323846;
+    for (size_t h = 1; h < n; h <<= 1) {
+        for (size_t j = 0; j < h; ++j) {
+            const double a = -pi * static_cast<double>(j) / static_cast<double>(h);
+            m_twRe[h + j] = static_cast<float>(std::cos(a));
+            m_twIm[h + j] = static_cast<float>(std::sin(a));
+        }
+    }
+}
+
+// Stages of size 2 and 4 together: the twiddles are 1 and -i
+void FftPlan::radix4Pass(float* re, float* im) const
+{
+    for (size_t s = 0; s < m_n; s += 4) {
+        const float a0r = re[s] + re[s + 1], a0i = im[s] + im[s + 1];
+        const float a1r = re[s] - re[s + 1], a1i = im[s] - im[s + 1];
+        const float a2r = re[s + 2] + re[s + 3], a2i = im[s + 2] + im[s + 3];
+        const float a3r = re[s + 2] - re[s + 3], a3i = im[s + 2] - im[s + 3];
+
+        re[s] = a0r + a2r;      im[s] = a0i + a2i;
+        re[s + 2] = a0r - a2r;  im[s + 2] = a0i - a2i;
+        // -i * a3 = (a3i, -a3r)
+        re[s + 1] = a1r + a3i;  im[s + 1] = a1i - a3r;
+        re[s + 3] = a1r - a3i;  im[s + 3] = a1i + a3r;
+    }
+}
+
+void FftPlan::forward(float* re, float* im) const
+{
+    for (size_t i = 0; i < m_n; ++i) {
+        const size_t j = m_bitrev[i];
+        if (i < j) {
+            std::swap(re[i], re[j]);
+            std::swap(im[i], im[j]);
+        }
+    }
+
+    radix4Pass(re, im);
+
+    for (size_t h = 4; h < m_n; h <<= 1) {
+        const float* wr = &m_twRe[h];
+        const float* wi = &m_twIm[h];
+        for (size_t s = 0; s < m_n; s += 2 * h) {
+            float* ar = re + s;
+            float* ai = im + s;
+            float* br = re + s + h;
+            float* bi = im + s + h;
+#if SKILLSHOT_SSE2
+            for (size_t j = 0; j < h; j += 4) {
+                const __m128 xr = _mm_loadu_ps(br + j), xi = _mm_loadu_ps(bi + j);
+                const __m128 cr = _mm_loadu_ps(wr + j), ci = _mm_loadu_ps(wi + j);
+                const __m128 tr = _mm_sub_ps(_mm_mul_ps(xr, cr), _mm_mul_ps(xi, ci));
+                const __m128 ti = _mm_add_ps(_mm_mul_ps(xr, ci), _mm_mul_ps(xi, cr));
+                const __m128 ur = _mm_loadu_ps(ar + j), ui = _mm_loadu_ps(ai + j);
+                _mm_storeu_ps(ar + j, _mm_add_ps(ur, tr));
+                _mm_storeu_ps(ai + j, _mm_add_ps(ui, ti));
+                _mm_storeu_ps(br + j, _mm_sub_ps(ur, tr));
+                _mm_storeu_ps(bi + j, _mm_sub_ps(ui, ti));
+            }
+#else
+            for (size_t j = 0; j < h; ++j) {
+                const float tr = br[j] * wr[j] - bi[j] * wi[j];
+                const float ti = br[j] * wi[j] + bi[j] * wr[j];
+                br[j] = ar[j] - tr;
+                bi[j] = ai[j] - ti;
+                ar[j] += tr;
+                ai[j] += ti;
+            }
+#endif
+        }
+    }
+}
@@ -0,0 +1,37 @@
+// fft.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------//
+//                 Complex FFT
+//----------------------------------------------------//
+
+bool isPowerOfTwo(size_t n);
+
+// In-place forward DFT of power-of-two size on split arrays (real parts in
+// one array, imaginary parts in another), so butterflies load four values
+// per SSE2 register. The first two stages run as one radix-4 pass with
+// trivial twiddles; the rest are radix-2 stages vectorized four wide, with a
+// scalar fallback. A plan is read-only after construction and can be shared
+// between threads.
+class FftPlan {
+public:
+    explicit FftPlan(size_t n);     // n must be a power of two >= 4
+
+    size_t size() const { return m_n; }
+
+    // X[k] = sum_j x[j] * exp(-2 pi i j k / n)
+    void forward(float* re, float* im) const;
+
+private:
+    void radix4Pass(float* re, float* im) const;
+
+private:
+    size_t                m_n;
+    std::vector<uint32_t> m_bitrev;
+    std::vector<float>    m_twRe;   // stage with half-size h uses [h, 2h)
+    std::vector<float>    m_twIm;
+};
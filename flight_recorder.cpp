@@ -0,0 +1,121 @@
+#include "flight_recorder.h"
+
+#include <algorithm>
+
+//----------------------------------------------------//
+//            FlightRecorder Implementation
+//----------------------------------------------------//
+
+FlightRecorder::FlightRecorder(const FlightOptions& options)
+    : m_options(options)
+{
+    m_options.ringCapacity = std::max<size_t>(1, m_options.ringCapacity);
+    std::sort(m_options.triggerKeys.begin(), m_options.triggerKeys.end());
+    m_ring.resize(m_options.ringCapacity);
+}
+
+bool FlightRecorder::isTrigger(const SessionEvent& evt) const
+{
+    if (evt.kind == EventKind::KeyDown) {
+        return std::binary_search(m_options.triggerKeys.begin(), m_options.triggerKeys.end(),
+            evt.keyCode);
+    }
+    return m_options.clickTriggers &&
+        (evt.kind == EventKind::MouseLeftDown || evt.kind == EventKind::MouseRightDown);
+}
+
+void FlightRecorder::push(const SessionEvent& evt)
+{
+    uint32_t t = evt.timestamp;
+    if (m_stats.events > 0 && t < m_newest) {
+        if (m_newest - t > m_options.preMs + m_options.postMs) {
+            // The clock went backwards (new capture, tick wrap): close out
+            // the old timeline before anything on the new one is compared to it
+            finish();
+            m_triggers.clear();
+            m_hasBackground = false;
+        }
+        else {
+            // Hook and poll threads interleave a few ms out of order; keep
+            // the ring sorted by treating the late event as current
+            t = m_newest;
+        }
+    }
+    m_newest = t;
+    ++m_stats.events;
+
+    if (isTrigger(evt)) {
+        ++m_stats.triggers;
+        m_triggers.push_back(t);
+    }
+
+    if (m_count == m_ring.size()) {
+        ++m_stats.overflows;
+        decideOldest();
+    }
+    const bool sample = evt.kind == EventKind::MousePos;
+    m_ring[(m_head + m_count) % m_ring.size()] = Pending{ t, sample };
+    ++m_count;
+    if (sample) {
+        ++m_stats.samples;
+    }
+
+    // Anything further back than the pre-window has seen all its triggers
+    while (m_count > 0 && t - m_ring[m_head].timestamp > m_options.preMs) {
+        decideOldest();
+    }
+}
+
+void FlightRecorder::decideOldest()
+{
+    const Pending p = m_ring[m_head];
+    m_head = (m_head + 1) % m_ring.size();
+    --m_count;
+
+    if (!p.sample) {
+        m_decided.push_back(1);
+        return;
+    }
+
+    // Triggers are in time order, and so are the samples leaving the ring:
+    // once a window has ended for this sample it has ended for all later ones
+    const uint64_t t = p.timestamp;
+    while (!m_triggers.empty() && m_triggers.front() + static_cast<uint64_t>(m_options.postMs) < t) {
+        m_triggers.pop_front();
+    }
+    bool keep = false;
+    if (!m_triggers.empty() && t + m_options.preMs >= m_triggers.front()) {
+        keep = true;
+        ++m_stats.windowSamples;
+    }
+    else if (m_options.backgroundMs > 0 &&
+        (!m_hasBackground || t - m_lastKeptT >= m_options.backgroundMs)) {
+        keep = true;
+        ++m_stats.backgroundSamples;
+    }
+
+    if (keep) {
+        // Window samples count as background too, so the sparse track
+        // resumes one period after a window rather than right at its edge
+        m_hasBackground = true;
+        m_lastKeptT = p.timestamp;
+    }
+    m_decided.push_back(keep ? 1 : 0);
+}
+
+bool FlightRecorder::pop(bool& keep)
+{
+    if (m_decided.empty()) {
+        return false;
+    }
+    keep = m_decided.front() != 0;
+    m_decided.pop_front();
+    return true;
+}
+
+void FlightRecorder::finish()
+{
+    while (m_count > 0) {
+        decideOldest();
+    }
+}
@@ -0,0 +1,97 @@
+// flight_recorder.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "session_event.h"
+
+//----------------------------------------------------//
+//          Flight Recorder (Trigger Windows)
+//----------------------------------------------------//
+
+struct FlightOptions
+{
+    uint32_t preMs = 500;          // dense history kept before a trigger
+    uint32_t postMs = 500;         // dense samples kept after it
+    uint32_t backgroundMs = 100;   // sparse track outside the windows (0 = none)
+
+    std::vector<uint32_t> triggerKeys;   // VK codes whose key-down is a trigger
+    bool     clickTriggers = false;      // button downs too (off: right clicks are move orders)
+
+    size_t   ringCapacity = 8192;  // pending events; ~40 s at a 5 ms poll
+};
+
+struct FlightStats
+{
+    uint64_t events = 0;             // everything pushed
+    uint64_t samples = 0;            // MOUSE_POS among them
+    uint64_t windowSamples = 0;      // kept inside a trigger window
+    uint64_t backgroundSamples = 0;  // kept by the background track
+    uint64_t triggers = 0;
+    uint64_t overflows = 0;          // decided early because the ring was full
+
+    uint64_t keptSamples() const { return windowSamples + backgroundSamples; }
+    uint64_t keptEvents() const { return events - samples + keptSamples(); }
+
+    void add(const FlightStats& other)
+    {
+        events += other.events;
+        samples += other.samples;
+        windowSamples += other.windowSamples;
+        backgroundSamples += other.backgroundSamples;
+        triggers += other.triggers;
+        overflows += other.overflows;
+    }
+};
+
+// Decides which cursor samples of a high-rate capture are worth storing.
+// Every event waits in a fixed-size ring until it is preMs older than the
+// newest one; by then any trigger that would put it inside a pre-window has
+// arrived, so the decision is final and events leave in their original
+// order. Only MOUSE_POS samples are ever dropped.
+//
+// The recorder keeps no payloads: the caller queues its own events in push
+// order and takes one keep/drop decision per event from pop().
+class FlightRecorder {
+public:
+    explicit FlightRecorder(const FlightOptions& options = FlightOptions());
+
+    void push(const SessionEvent& evt);
+
+    // Decision for the oldest event not yet popped; false while it is
+    // still inside the look-ahead
+    bool pop(bool& keep);
+
+    // End of stream: decides everything still pending
+    void finish();
+
+    size_t pending() const { return m_count; }
+    const FlightStats& stats() const { return m_stats; }
+
+private:
+    struct Pending
+    {
+        uint32_t timestamp;
+        bool     sample;    // MOUSE_POS
+    };
+
+    bool isTrigger(const SessionEvent& evt) const;
+    void decideOldest();
+
+private:
+    FlightOptions         m_options;
+    FlightStats           m_stats;
+
+    std::vector<Pending>  m_ring;
+    size_t                m_head = 0;
+    size_t                m_count = 0;
+    uint32_t              m_newest = 0;
+
+    std::deque<uint32_t>  m_triggers;   // times not yet behind every pending sample
+    std::deque<char>      m_decided;    // 1 = keep, oldest first
+    bool                  m_hasBackground = false;
+    uint32_t              m_lastKeptT = 0;
+};
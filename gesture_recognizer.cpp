@@ -0,0 +1,407 @@
+#include "gesture_recognizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "session_reader.h"
+#include "simd.h"
+
+static const double kPi = 3.14159265358979323846;
+
+//----------------------------------------------------//
+//            MotionSegmenter Implementation
+//----------------------------------------------------//
+
+MotionSegmenter::MotionSegmenter(const MotionSegmentOptions& options)
+    : m_options(options)
+{
+}
+
+bool MotionSegmenter::close(MotionSegment& done)
+{
+    m_moving = false;
+    // Drop the resting tail after the last fast sample
+    m_current.points.resize(m_movingPoints);
+    if (m_current.points.size() < m_options.minPoints) {
+        return false;
+    }
+    double length = 0.0;
+    for (size_t i = 1; i < m_current.points.size(); ++i) {
+        length += std::hypot(static_cast<double>(m_current.points[i].x) - m_current.points[i - 1].x,
+            static_cast<double>(m_current.points[i].y) - m_current.points[i - 1].y);
+    }
+    if (length < m_options.minLengthPx) {
+        return false;
+    }
+    m_current.lengthPx = length;
+    m_current.endMs = m_current.points.back().timestamp;
+    done = std::move(m_current);
+    m_current = MotionSegment();
+    return true;
+}
+
+bool MotionSegmenter::onSample(const PathPoint& p, MotionSegment& done)
+{
+    if (!m_hasLast) {
+        m_last = p;
+        m_hasLast = true;
+        return false;
+    }
+
+    bool ended = false;
+    const uint32_t dt = p.timestamp - m_last.timestamp;
+    if (p.timestamp < m_last.timestamp || dt > m_options.maxGapMs) {
+        if (m_moving) {
+            ended = close(done);
+        }
+    }
+    else if (dt == 0) {
+        // Same timer tick: no speed to measure, keep the point
+        if (m_moving) {
+            m_current.points.push_back(p);
+        }
+    }
+    else {
+        const double speed = std::hypot(static_cast<double>(p.x) - m_last.x,
+            static_cast<double>(p.y) - m_last.y) / dt;
+        if (speed >= m_options.minSpeedPxPerMs) {
+            if (!m_moving) {
+                m_moving = true;
+                m_current = MotionSegment();
+                m_current.startMs = m_last.timestamp;
+                m_current.points.push_back(m_last);
+            }
+            m_current.points.push_back(p);
+            m_lastMoveMs = p.timestamp;
+            m_movingPoints = m_current.points.size();
+        }
+        else if (m_moving) {
+            m_current.points.push_back(p);
+            if (p.timestamp - m_lastMoveMs >= m_options.pauseMs) {
+                ended = close(done);
+            }
+        }
+
+        if (m_moving && p.timestamp - m_current.startMs >= m_options.maxDurationMs) {
+            // Long motion: cut here and go on from this point
+            m_movingPoints = m_current.points.size();
+            ended = close(done);
+            m_moving = true;
+            m_current = MotionSegment();
+            m_current.startMs = p.timestamp;
+            m_current.points.push_back(p);
+            m_lastMoveMs = p.timestamp;
+            m_movingPoints = 1;
+        }
+    }
+
+    m_last = p;
+    return ended;
+}
+
+bool MotionSegmenter::finish(MotionSegment& done)
+{
+    return m_moving && close(done);
+}
+
+//----------------------------------------------------//
+//                 Shape Normalization
+//----------------------------------------------------//
+
+// Resamples a polyline to n points spaced evenly along its length ($1 step 1)
+static void resamplePolyline(const std::vector<double>& xy, size_t n, std::vector<double>& out)
+{
+    const size_t count = xy.size() / 2;
+    double total = 0.0;
+    for (size_t i = 1; i < count; ++i) {
+        total += std::hypot(xy[2 * i] - xy[2 * i - 2], xy[2 * i + 1] - xy[2 * i - 1]);
+    }
+    out.assign(2 * n, 0.0);
+    out[0] = xy[0];
+    out[1] = xy[1];
+    const double step = total / (n - 1);
+    size_t written = 1;
+    double carried = 0.0;   // path length since the last output point
+    for (size_t i = 1; i < count && written < n; ++i) {
+        double px = xy[2 * i - 2], py = xy[2 * i - 1];
+        const double qx = xy[2 * i], qy = xy[2 * i + 1];
+        double d = std::hypot(qx - px, qy - py);
+        while (d > 0.0 && carried + d >= step && written < n) {
+            const double a = (step - carried) / d;
+            px += a * (qx - px);
+            py += a * (qy - py);
+            out[2 * written] = px;
+            out[2 * written + 1] = py;
+            ++written;
+            d = std::hypot(qx - px, qy - py);
+            carried = 0.0;
+        }
+        carried += d;
+    }
+    // Rounding can leave the last point short
+    for (; written < n; ++written) {
+        out[2 * written] = xy[2 * count - 2];
+        out[2 * written + 1] = xy[2 * count - 1];
+    }
+}
+
+bool GestureShape::fromPoints(const std::vector<double>& xy)
+{
+    if (xy.size() < 4) {
+        return false;
+    }
+    std::vector<double> r;
+    resamplePolyline(xy, kGesturePoints, r);
+
+    double cx = 0.0, cy = 0.0;
+    for (size_t i = 0; i < kGesturePoints; ++i) {
+        cx += r[2 * i];
+        cy += r[2 * i + 1];
+    }
+    cx /= kGesturePoints;
+    cy /= kGesturePoints;
+    double norm = 0.0;
+    for (size_t i = 0; i < kGesturePoints; ++i) {
+        r[2 * i] -= cx;
+        r[2 * i + 1] -= cy;
+        norm += r[2 * i] * r[2 * i] + r[2 * i + 1] * r[2 * i + 1];
+    }
+    if (norm <= 1e-9) {
+        return false;
+    }
+
+    // Uniform scale: unlike $1's bounding box, keeps straight and
+    // back-and-forth paths intact
+    norm = std::sqrt(norm);
+    for (size_t i = 0; i < kGesturePoints; ++i) {
+        x[i] = static_cast<float>(r[2 * i] / norm);
+        y[i] = static_cast<float>(r[2 * i + 1] / norm);
+    }
+
+    double tail = 0.0;
+    const size_t blocks = kGesturePoints / kGestureBlock;
+    tailNorm[blocks] = 0.0f;
+    for (size_t b = blocks; b-- > 0;) {
+        for (size_t i = b * kGestureBlock; i < (b + 1) * kGestureBlock; ++i) {
+            tail += static_cast<double>(x[i]) * x[i] + static_cast<double>(y[i]) * y[i];
+        }
+        tailNorm[b] = static_cast<float>(std::sqrt(tail));
+    }
+    return true;
+}
+
+bool GestureShape::fromPath(const std::vector<PathPoint>& path)
+{
+    std::vector<double> xy;
+    xy.reserve(path.size() * 2);
+    for (const auto& p : path) {
+        xy.push_back(p.x);
+        xy.push_back(p.y);
+    }
+    return fromPoints(xy);
+}
+
+//----------------------------------------------------//
+//           GestureRecognizer Implementation
+//----------------------------------------------------//
+
+void GestureRecognizer::addTemplate(const std::string& name, const GestureShape& shape)
+{
+    m_templates.push_back(GestureTemplate{ name, shape });
+}
+
+void GestureRecognizer::addBuiltinTemplates()
+{
+    auto add = [this](const std::string& name, const std::vector<double>& xy) {
+        GestureShape shape;
+        if (shape.fromPoints(xy)) {
+            addTemplate(name, shape);
+        }
+    };
+    std::vector<double> xy;
+
+    // Straight flick: so plain moves have somewhere to go
+    add("line", { 0.0, 0.0, 1.0, 0.0 });
+
+    // Circles, one and two turns, both directions. The start point does not
+    // matter: rotation takes care of it.
+    for (double turns : { 1.0, 2.0 }) {
+        for (double dir : { 1.0, -1.0 }) {
+            xy.clear();
+            for (int i = 0; i <= 64 * turns; ++i) {
+                const double a = dir * 2.0 * kPi * i / 64.0;
+                xy.push_back(std::cos(a));
+                xy.push_back(std::sin(a));
+            }
+            add("circle", xy);
+        }
+    }
+
+    // Zig-zag dodging: three periods of a triangle wave, either side first
+    for (double side : { 1.0, -1.0 }) {
+        xy.clear();
+        for (int i = 0; i <= 12; ++i) {
+            const double lateral = (i % 2 == 0) ? 0.0 : ((i / 2) % 2 == 0 ? side : -side);
+            xy.push_back(i * 0.5);
+            xy.push_back(lateral);
+        }
+        add("zigzag", xy);
+    }
+
+    // Strafing: back and forth along one line, three to five legs. The
+    // small sideways drift keeps the turns from folding onto each other.
+    for (int legs = 3; legs <= 5; ++legs) {
+        xy.clear();
+        for (int i = 0; i <= legs; ++i) {
+            xy.push_back(i % 2 == 0 ? 0.0 : 1.0);
+            xy.push_back(0.03 * i);
+        }
+        add("strafe", xy);
+    }
+}
+
+bool GestureRecognizer::loadTemplates(const std::string& path)
+{
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) {
+        std::cerr << "Failed to open template file: " << path << "\n";
+        return false;
+    }
+    std::string line;
+    size_t lineNo = 0;
+    while (std::getline(ifs, line)) {
+        ++lineNo;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream iss(line);
+        std::string name;
+        iss >> name;
+        std::vector<double> xy;
+        double v;
+        while (iss >> v) {
+            xy.push_back(v);
+        }
+        GestureShape shape;
+        if (xy.size() % 2 != 0 || !shape.fromPoints(xy)) {
+            std::cerr << path << ":" << lineNo << ": skipping malformed template\n";
+            continue;
+        }
+        addTemplate(name, shape);
+    }
+    return true;
+}
+
+bool GestureRecognizer::appendTemplate(const std::string& path, const std::string& name,
+    const std::vector<PathPoint>& points)
+{
+    std::ofstream ofs(path, std::ios::app);
+    if (!ofs.is_open()) {
+        std::cerr << "Failed to open template file for writing: " << path << "\n";
+        return false;
+    }
+    ofs << name;
+    for (const auto& p : points) {
+        ofs << " " << p.x << " " << p.y;
+    }
+    ofs << "\n";
+    return static_cast<bool>(ofs);
+}
+
+GestureMatch GestureRecognizer::recognize(const GestureShape& shape, double minScore,
+    GestureStats* stats) const
+{
+    // With both shapes at unit norm, c = sum(conj(t) * g) over the points as
+    // complex numbers; |c| is the cosine similarity at the best rotation,
+    // arg(c) that rotation (Protractor)
+    GestureMatch best;
+    double bar = minScore;
+    const size_t blocks = kGesturePoints / kGestureBlock;
+    for (size_t k = 0; k < m_templates.size(); ++k) {
+        const GestureShape& g = m_templates[k].shape;
+        double a = 0.0, b = 0.0;
+        bool rejected = false;
+        for (size_t blk = 0; blk < blocks; ++blk) {
+            const size_t begin = blk * kGestureBlock;
+#if SKILLSHOT_SSE2
+            __m128 va = _mm_setzero_ps(), vb = _mm_setzero_ps();
+            for (size_t i = begin; i < begin + kGestureBlock; i += 4) {
+                const __m128 tx = _mm_loadu_ps(shape.x + i), ty = _mm_loadu_ps(shape.y + i);
+                const __m128 gx = _mm_loadu_ps(g.x + i), gy = _mm_loadu_ps(g.y + i);
+                va = _mm_add_ps(va, _mm_add_ps(_mm_mul_ps(tx, gx), _mm_mul_ps(ty, gy)));
+                vb = _mm_add_ps(vb, _mm_sub_ps(_mm_mul_ps(tx, gy), _mm_mul_ps(ty, gx)));
+            }
+            float fa[4], fb[4];
+            _mm_storeu_ps(fa, va);
+            _mm_storeu_ps(fb, vb);
+            a += (fa[0] + fa[1]) + (fa[2] + fa[3]);
+            b += (fb[0] + fb[1]) + (fb[2] + fb[3]);
+#else
+            for (size_t i = begin; i < begin + kGestureBlock; ++i) {
+                a += shape.x[i] * g.x[i] + shape.y[i] * g.y[i];
+                b += shape.x[i] * g.y[i] - shape.y[i] * g.x[i];
+            }
+#endif
+            // Best case for the rest: |c_rest| <= |t_rest| * |g_rest|
+            const double bound = std::sqrt(a * a + b * b) +
+                static_cast<double>(shape.tailNorm[blk + 1]) * g.tailNorm[blk + 1];
+            if (bound <= bar && blk + 1 < blocks) {
+                rejected = true;
+                break;
+            }
+        }
+        if (stats) {
+            ++stats->comparisons;
+            stats->rejected += rejected ? 1 : 0;
+        }
+        if (rejected) {
+            continue;
+        }
+        const double score = std::sqrt(a * a + b * b);
+        if (score > bar || (best.templateIndex < 0 && score >= bar)) {
+            bar = score;
+            best.templateIndex = static_cast<int>(k);
+            best.score = std::min(1.0, score);
+            best.rotationDeg = std::atan2(b, a) * 180.0 / kPi;
+        }
+    }
+    return best;
+}
+
+//----------------------------------------------------//
+//                  Session Driver
+//----------------------------------------------------//
+
+bool recognizeSessionGestures(const std::string& path, const GestureRecognizer& recognizer,
+    const MotionSegmentOptions& options, double minScore, std::vector<GestureHit>& hits,
+    GestureStats& stats)
+{
+    MotionSegmenter segmenter(options);
+    MotionSegment segment;
+    GestureShape shape;
+    auto onSegment = [&]() {
+        ++stats.segments;
+        if (!shape.fromPath(segment.points)) {
+            return;
+        }
+        const GestureMatch m = recognizer.recognize(shape, minScore, &stats);
+        if (m.templateIndex >= 0) {
+            hits.push_back(GestureHit{ segment.startMs, segment.endMs, segment.lengthPx,
+                recognizer.at(m.templateIndex).name, m.score, m.rotationDeg });
+        }
+    };
+
+    bool ok = forEachSessionEvent(path, [&](const SessionEvent& evt) {
+        if (evt.kind == EventKind::MousePos &&
+            segmenter.onSample(PathPoint{ evt.x, evt.y, evt.timestamp }, segment)) {
+            onSegment();
+        }
+    });
+    if (segmenter.finish(segment)) {
+        onSegment();
+    }
+    return ok;
+}
@@ -0,0 +1,140 @@
+// gesture_recognizer.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "path_simplify.h"
+
+//----------------------------------------------------//
+//             Cursor Motion Segmentation
+//----------------------------------------------------//
+
+struct MotionSegmentOptions
+{
+    double   minSpeedPxPerMs = 0.3;   // slower samples count as resting
+    uint32_t pauseMs         = 150;   // resting this long ends a segment
+    uint32_t maxGapMs        = 100;   // sample gap that ends a segment
+    uint32_t maxDurationMs   = 3000;  // longer motion is cut into pieces
+    double   minLengthPx     = 200.0; // travelled; shorter segments are dropped
+    size_t   minPoints       = 8;
+};
+
+struct MotionSegment
+{
+    uint32_t               startMs;
+    uint32_t               endMs;
+    double                 lengthPx;
+    std::vector<PathPoint> points;
+};
+
+// Cuts the cursor track into continuous motion segments: a flick, a circle,
+// a series of dodges. Like FlickTracker, but with a lower speed threshold
+// and keeping the points, since gestures are judged by their shape.
+class MotionSegmenter {
+public:
+    explicit MotionSegmenter(const MotionSegmentOptions& options = MotionSegmentOptions());
+
+    // Returns true and fills 'done' when a segment ended before this sample
+    bool onSample(const PathPoint& p, MotionSegment& done);
+    bool finish(MotionSegment& done);
+
+private:
+    bool close(MotionSegment& done);
+
+private:
+    MotionSegmentOptions m_options;
+    bool          m_hasLast = false;
+    PathPoint     m_last{};
+    bool          m_moving = false;
+    uint32_t      m_lastMoveMs = 0;
+    size_t        m_movingPoints = 0;     // points up to the last fast sample
+    MotionSegment m_current;
+};
+
+//----------------------------------------------------//
+//                Gesture Templates
+//----------------------------------------------------//
+
+// Points per normalized path, compared in blocks of kGestureBlock
+const size_t kGesturePoints = 64;
+const size_t kGestureBlock = 16;
+
+// A path resampled to kGesturePoints equidistant points, centered on its
+// centroid and scaled to unit norm (as one 2 * kGesturePoints vector).
+// x and y are stored apart so distances vectorize.
+struct GestureShape
+{
+    float x[kGesturePoints];
+    float y[kGesturePoints];
+    float tailNorm[kGesturePoints / kGestureBlock + 1];   // norm of the points from block b on
+
+    // false if the path has no extent (a single spot)
+    bool fromPath(const std::vector<PathPoint>& path);
+    bool fromPoints(const std::vector<double>& xy);   // x0 y0 x1 y1 ...
+};
+
+struct GestureTemplate
+{
+    std::string  name;
+    GestureShape shape;
+};
+
+struct GestureMatch
+{
+    int    templateIndex = -1;   // -1: nothing scored above the minimum
+    double score = 0.0;          // cosine similarity at the best rotation, 0..1
+    double rotationDeg = 0.0;    // rotation that aligns the template with the path
+};
+
+struct GestureStats
+{
+    uint64_t segments = 0;
+    uint64_t comparisons = 0;    // template x segment pairs considered
+    uint64_t rejected = 0;       // abandoned before the last block
+};
+
+// Protractor-style recognizer ($1 family): the best rotation has a closed
+// form, so a comparison is two dot products over the shape vectors, done
+// four points at a time with SSE2. A comparison is abandoned after any
+// block of points once even a perfect match of the remaining points
+// (Cauchy-Schwarz on the tail norms) cannot beat the best score so far.
+class GestureRecognizer {
+public:
+    GestureRecognizer() {}
+
+    // Circles (both ways), zig-zags, strafing and straight lines
+    void addBuiltinTemplates();
+    void addTemplate(const std::string& name, const GestureShape& shape);
+
+    // One template per line: "name x0 y0 x1 y1 ...". '#' lines are comments.
+    bool loadTemplates(const std::string& path);
+    // Appends one template line to 'path'
+    static bool appendTemplate(const std::string& path, const std::string& name,
+        const std::vector<PathPoint>& points);
+
+    size_t size() const { return m_templates.size(); }
+    const GestureTemplate& at(size_t i) const { return m_templates[i]; }
+
+    GestureMatch recognize(const GestureShape& shape, double minScore, GestureStats* stats = nullptr) const;
+
+private:
+    std::vector<GestureTemplate> m_templates;
+};
+
+struct GestureHit
+{
+    uint32_t    startMs;
+    uint32_t    endMs;
+    double      lengthPx;
+    std::string name;
+    double      score;
+    double      rotationDeg;
+};
+
+// Segments one session and recognizes every segment
+bool recognizeSessionGestures(const std::string& path, const GestureRecognizer& recognizer,
+    const MotionSegmentOptions& options, double minScore, std::vector<GestureHit>& hits,
+    GestureStats& stats);
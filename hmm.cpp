@@ -0,0 +1,487 @@
+#include "hmm.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "simd.h"
+#include "thread_pool.h"
+
+static const char* const kModelHeader = "# skillshot hmm v1";
+static const double kMinProb = 1e-12;     // keeps every transition possible
+static const double kMinVariance = 1e-3;
+static const double kLog2Pi = 1.8378770664093453;
+
+//----------------------------------------------------//
+//                   Kernels
+//----------------------------------------------------//
+
+// out[j] = sum_i p[i] * m[i * padded + j] for all j < padded
+static void vecMat(const double* p, const double* m, size_t rows, size_t padded, double* out)
+{
+    std::fill(out, out + padded, 0.0);
+#if SKILLSHOT_SSE2
+    for (size_t i = 0; i < rows; ++i) {
+        const __m128d pi = _mm_set1_pd(p[i]);
+        const double* row = m + i * padded;
+        for (size_t j = 0; j < padded; j += 2) {
+            _mm_storeu_pd(out + j, _mm_add_pd(_mm_loadu_pd(out + j),
+                _mm_mul_pd(pi, _mm_loadu_pd(row + j))));
+        }
+    }
+#else
+    for (size_t i = 0; i < rows; ++i) {
+        const double* row = m + i * padded;
+        for (size_t j = 0; j < padded; ++j) {
+            out[j] += p[i] * row[j];
+        }
+    }
+#endif
+}
+
+//----------------------------------------------------//
+//               Parameter Handling
+//----------------------------------------------------//
+
+struct GaussianHmm::Accumulator
+{
+    double              logL = 0.0;
+    size_t              sequences = 0;
+    std::vector<double> initial;
+    std::vector<double> trans;      // states x states
+    std::vector<double> weight;     // per state
+    std::vector<double> sum;        // states x dims
+    std::vector<double> sumSq;
+
+    void reset(size_t states, size_t dims)
+    {
+        logL = 0.0;
+        sequences = 0;
+        initial.assign(states, 0.0);
+        trans.assign(states * states, 0.0);
+        weight.assign(states, 0.0);
+        sum.assign(states * dims, 0.0);
+        sumSq.assign(states * dims, 0.0);
+    }
+
+    void merge(const Accumulator& o)
+    {
+        logL += o.logL;
+        sequences += o.sequences;
+        for (size_t i = 0; i < initial.size(); ++i) initial[i] += o.initial[i];
+        for (size_t i = 0; i < trans.size(); ++i) trans[i] += o.trans[i];
+        for (size_t i = 0; i < weight.size(); ++i) weight[i] += o.weight[i];
+        for (size_t i = 0; i < sum.size(); ++i) sum[i] += o.sum[i];
+        for (size_t i = 0; i < sumSq.size(); ++i) sumSq[i] += o.sumSq[i];
+    }
+};
+
+GaussianHmm::GaussianHmm(size_t states, size_t dims)
+    : m_states(states), m_dims(dims), m_padded((states + 1) & ~static_cast<size_t>(1)),
+      m_initial(states, 1.0 / states),
+      m_trans(states * m_padded, 0.0), m_transT(states * m_padded, 0.0),
+      m_mean(states * dims, 0.0), m_var(states * dims, 1.0)
+{
+    for (size_t i = 0; i < states; ++i) {
+        for (size_t j = 0; j < states; ++j) {
+            m_trans[i * m_padded + j] = 1.0 / states;
+        }
+    }
+    normalize();
+}
+
+void GaussianHmm::setInitial(size_t state, double p)
+{
+    m_initial[state] = p;
+}
+
+void GaussianHmm::setTransition(size_t from, size_t to, double p)
+{
+    m_trans[from * m_padded + to] = p;
+}
+
+void GaussianHmm::setEmission(size_t state, const double* mean, const double* var)
+{
+    for (size_t d = 0; d < m_dims; ++d) {
+        m_mean[state * m_dims + d] = mean[d];
+        m_var[state * m_dims + d] = std::max(kMinVariance, var[d]);
+    }
+}
+
+void GaussianHmm::normalize()
+{
+    double total = 0.0;
+    for (auto& p : m_initial) {
+        p = std::max(p, kMinProb);
+        total += p;
+    }
+    for (auto& p : m_initial) {
+        p /= total;
+    }
+
+    for (size_t i = 0; i < m_states; ++i) {
+        double* row = &m_trans[i * m_padded];
+        double rowSum = 0.0;
+        for (size_t j = 0; j < m_states; ++j) {
+            row[j] = std::max(row[j], kMinProb);
+            rowSum += row[j];
+        }
+        for (size_t j = 0; j < m_states; ++j) {
+            row[j] /= rowSum;
+            m_transT[j * m_padded + i] = row[j];
+        }
+    }
+}
+
+//----------------------------------------------------//
+//                Forward-Backward
+//----------------------------------------------------//
+
+void GaussianHmm::emissions(const HmmSequence& seq, std::vector<double>& logB) const
+{
+    // Per state: 1 / var and the normalizing constant
+    std::vector<double> invVar(m_states * m_dims), logNorm(m_states);
+    for (size_t k = 0; k < m_states; ++k) {
+        double n = -0.5 * kLog2Pi * m_dims;
+        for (size_t d = 0; d < m_dims; ++d) {
+            invVar[k * m_dims + d] = 1.0 / m_var[k * m_dims + d];
+            n -= 0.5 * std::log(m_var[k * m_dims + d]);
+        }
+        logNorm[k] = n;
+    }
+
+    logB.assign(seq.length * m_padded, -INFINITY);
+    for (size_t t = 0; t < seq.length; ++t) {
+        const float* x = seq.data + t * m_dims;
+        double* out = &logB[t * m_padded];
+        for (size_t k = 0; k < m_states; ++k) {
+            const double* mu = &m_mean[k * m_dims];
+            const double* iv = &invVar[k * m_dims];
+            double q = 0.0;
+            for (size_t d = 0; d < m_dims; ++d) {
+                const double diff = x[d] - mu[d];
+                q += diff * diff * iv[d];
+            }
+            out[k] = logNorm[k] - 0.5 * q;
+        }
+    }
+}
+
+double GaussianHmm::forwardBackward(const std::vector<double>& logB, size_t length,
+    std::vector<double>& alpha, std::vector<double>& beta) const
+{
+    const size_t K = m_states, P = m_padded;
+    alpha.assign(length * P, -INFINITY);
+    beta.assign(length * P, -INFINITY);
+    std::vector<double> p(P, 0.0), q(P, 0.0);
+
+    for (size_t k = 0; k < K; ++k) {
+        alpha[k] = std::log(m_initial[k]) + logB[k];
+    }
+    for (size_t t = 1; t < length; ++t) {
+        const double* prev = &alpha[(t - 1) * P];
+        const double m = *std::max_element(prev, prev + K);
+        for (size_t i = 0; i < K; ++i) {
+            p[i] = std::exp(prev[i] - m);
+        }
+        vecMat(p.data(), m_trans.data(), K, P, q.data());
+        double* cur = &alpha[t * P];
+        const double* b = &logB[t * P];
+        for (size_t j = 0; j < K; ++j) {
+            cur[j] = b[j] + m + std::log(q[j]);
+        }
+    }
+
+    const double* last = &alpha[(length - 1) * P];
+    const double m = *std::max_element(last, last + K);
+    double s = 0.0;
+    for (size_t k = 0; k < K; ++k) {
+        s += std::exp(last[k] - m);
+    }
+    const double logL = m + std::log(s);
+
+    std::fill(beta.begin() + (length - 1) * P, beta.begin() + (length - 1) * P + K, 0.0);
+    for (size_t t = length - 1; t-- > 0;) {
+        const double* next = &beta[(t + 1) * P];
+        const double* b = &logB[(t + 1) * P];
+        double mb = -INFINITY;
+        for (size_t j = 0; j < K; ++j) {
+            mb = std::max(mb, b[j] + next[j]);
+        }
+        for (size_t j = 0; j < K; ++j) {
+            p[j] = std::exp(b[j] + next[j] - mb);
+        }
+        vecMat(p.data(), m_transT.data(), K, P, q.data());
+        double* cur = &beta[t * P];
+        for (size_t i = 0; i < K; ++i) {
+            cur[i] = mb + std::log(q[i]);
+        }
+    }
+    return logL;
+}
+
+void GaussianHmm::accumulate(const HmmSequence& seq, Accumulator& acc) const
+{
+    if (seq.length == 0) {
+        return;
+    }
+    const size_t K = m_states, P = m_padded, D = m_dims;
+    std::vector<double> logB, alpha, beta;
+    emissions(seq, logB);
+    const double logL = forwardBackward(logB, seq.length, alpha, beta);
+    acc.logL += logL;
+    ++acc.sequences;
+
+    std::vector<double> a(K), b(K);
+    for (size_t t = 0; t < seq.length; ++t) {
+        const double* al = &alpha[t * P];
+        const double* be = &beta[t * P];
+        const float* x = seq.data + t * D;
+
+        // State posteriors
+        for (size_t k = 0; k < K; ++k) {
+            const double g = std::exp(al[k] + be[k] - logL);
+            if (t == 0) {
+                acc.initial[k] += g;
+            }
+            acc.weight[k] += g;
+            for (size_t d = 0; d < D; ++d) {
+                acc.sum[k * D + d] += g * x[d];
+                acc.sumSq[k * D + d] += g * x[d] * x[d];
+            }
+        }
+
+        // Transition posteriors, with the same shift-and-scale as forward
+        if (t + 1 < seq.length) {
+            const double* bn = &logB[(t + 1) * P];
+            const double* ben = &beta[(t + 1) * P];
+            const double ma = *std::max_element(al, al + K);
+            double mb = -INFINITY;
+            for (size_t j = 0; j < K; ++j) {
+                mb = std::max(mb, bn[j] + ben[j]);
+            }
+            for (size_t k = 0; k < K; ++k) {
+                a[k] = std::exp(al[k] - ma);
+                b[k] = std::exp(bn[k] + ben[k] - mb);
+            }
+            const double scale = std::exp(ma + mb - logL);
+            for (size_t i = 0; i < K; ++i) {
+                const double* row = &m_trans[i * P];
+                for (size_t j = 0; j < K; ++j) {
+                    acc.trans[i * K + j] += a[i] * row[j] * b[j] * scale;
+                }
+            }
+        }
+    }
+}
+
+//----------------------------------------------------//
+//                 Training / Decoding
+//----------------------------------------------------//
+
+double GaussianHmm::baumWelchStep(const std::vector<HmmSequence>& sequences, WorkStealingPool* pool)
+{
+    // One accumulator per sequence, merged in order: results do not depend
+    // on scheduling
+    std::vector<Accumulator> parts(sequences.size());
+    for (size_t i = 0; i < sequences.size(); ++i) {
+        parts[i].reset(m_states, m_dims);
+        if (pool) {
+            pool->submit([this, &sequences, &parts, i]() { accumulate(sequences[i], parts[i]); });
+        }
+        else {
+            accumulate(sequences[i], parts[i]);
+        }
+    }
+    if (pool) {
+        pool->wait();
+    }
+
+    Accumulator acc;
+    acc.reset(m_states, m_dims);
+    for (const auto& part : parts) {
+        acc.merge(part);
+    }
+    if (acc.sequences == 0) {
+        return 0.0;
+    }
+
+    // M-step; a state nobody visited keeps its emission
+    for (size_t k = 0; k < m_states; ++k) {
+        m_initial[k] = acc.initial[k] / acc.sequences;
+        double rowSum = 0.0;
+        for (size_t j = 0; j < m_states; ++j) {
+            rowSum += acc.trans[k * m_states + j];
+        }
+        if (rowSum > 0.0) {
+            for (size_t j = 0; j < m_states; ++j) {
+                m_trans[k * m_padded + j] = acc.trans[k * m_states + j] / rowSum;
+            }
+        }
+        const double w = acc.weight[k];
+        if (w > 1e-6) {
+            for (size_t d = 0; d < m_dims; ++d) {
+                const double mu = acc.sum[k * m_dims + d] / w;
+                m_mean[k * m_dims + d] = mu;
+                m_var[k * m_dims + d] = std::max(kMinVariance, acc.sumSq[k * m_dims + d] / w - mu * mu);
+            }
+        }
+    }
+    normalize();
+    return acc.logL;
+}
+
+double GaussianHmm::logLikelihood(const HmmSequence& seq) const
+{
+    if (seq.length == 0) {
+        return 0.0;
+    }
+    std::vector<double> logB, alpha, beta;
+    emissions(seq, logB);
+    return forwardBackward(logB, seq.length, alpha, beta);
+}
+
+double GaussianHmm::viterbi(const HmmSequence& seq, std::vector<uint8_t>& path) const
+{
+    path.clear();
+    if (seq.length == 0) {
+        return 0.0;
+    }
+    const size_t K = m_states, P = m_padded;
+    std::vector<double> logB;
+    emissions(seq, logB);
+
+    std::vector<double> logA(K * K);
+    for (size_t i = 0; i < K; ++i) {
+        for (size_t j = 0; j < K; ++j) {
+            logA[i * K + j] = std::log(m_trans[i * P + j]);
+        }
+    }
+
+    std::vector<uint8_t> from(seq.length * K, 0);
+    std::vector<double> delta(K), next(K);
+    for (size_t k = 0; k < K; ++k) {
+        delta[k] = std::log(m_initial[k]) + logB[k];
+    }
+    for (size_t t = 1; t < seq.length; ++t) {
+        const double* b = &logB[t * P];
+        for (size_t j = 0; j < K; ++j) {
+            double best = delta[0] + logA[j];
+            uint8_t arg = 0;
+            for (size_t i = 1; i < K; ++i) {
+                const double v = delta[i] + logA[i * K + j];
+                if (v > best) {
+                    best = v;
+                    arg = static_cast<uint8_t>(i);
+                }
+            }
+            next[j] = best + b[j];
+            from[t * K + j] = arg;
+        }
+        delta.swap(next);
+    }
+
+    size_t state = std::max_element(delta.begin(), delta.end()) - delta.begin();
+    const double logP = delta[state];
+    path.resize(seq.length);
+    for (size_t t = seq.length; t-- > 0;) {
+        path[t] = static_cast<uint8_t>(state);
+        state = from[t * K + state];
+    }
+    return logP;
+}
+
+//----------------------------------------------------//
+//                  Model Files
+//----------------------------------------------------//
+
+bool GaussianHmm::save(const std::string& path) const
+{
+    std::ofstream ofs(path, std::ios::trunc);
+    if (!ofs.is_open()) {
+        std::cerr << "Failed to open model file for writing: " << path << "\n";
+        return false;
+    }
+    ofs << kModelHeader << "\n" << std::setprecision(17);
+    ofs << "size " << m_states << " " << m_dims << "\n";
+    ofs << "initial";
+    for (size_t k = 0; k < m_states; ++k) {
+        ofs << " " << m_initial[k];
+    }
+    ofs << "\n";
+    for (size_t i = 0; i < m_states; ++i) {
+        ofs << "transition " << i;
+        for (size_t j = 0; j < m_states; ++j) {
+            ofs << " " << transition(i, j);
+        }
+        ofs << "\n";
+    }
+    for (size_t k = 0; k < m_states; ++k) {
+        ofs << "emission " << k;
+        for (size_t d = 0; d < m_dims; ++d) {
+            ofs << " " << m_mean[k * m_dims + d] << " " << m_var[k * m_dims + d];
+        }
+        ofs << "\n";
+    }
+    return static_cast<bool>(ofs);
+}
+
+bool GaussianHmm::load(const std::string& path)
+{
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) {
+        std::cerr << "Failed to open model file: " << path << "\n";
+        return false;
+    }
+    std::string line;
+    if (!std::getline(ifs, line) || line != kModelHeader) {
+        std::cerr << "Not a model file: " << path << "\n";
+        return false;
+    }
+
+    bool sized = false;
+    while (std::getline(ifs, line)) {
+        std::istringstream iss(line);
+        std::string tag;
+        iss >> tag;
+        if (tag == "size") {
+            size_t states = 0, dims = 0;
+            if (!(iss >> states >> dims) || states == 0 || states > 255 || dims == 0) {
+                break;
+            }
+            *this = GaussianHmm(states, dims);
+            sized = true;
+        }
+        else if (!sized) {
+            break;
+        }
+        else if (tag == "initial") {
+            for (size_t k = 0; k < m_states; ++k) {
+                iss >> m_initial[k];
+            }
+        }
+        else if (tag == "transition") {
+            size_t i = 0;
+            iss >> i;
+            for (size_t j = 0; j < m_states && i < m_states; ++j) {
+                iss >> m_trans[i * m_padded + j];
+            }
+        }
+        else if (tag == "emission") {
+            size_t k = 0;
+            iss >> k;
+            for (size_t d = 0; d < m_dims && k < m_states; ++d) {
+                iss >> m_mean[k * m_dims + d] >> m_var[k * m_dims + d];
+            }
+        }
+    }
+    if (!sized) {
+        std::cerr << "Malformed model file: " << path << "\n";
+        return false;
+    }
+    normalize();
+    return true;
+}
@@ -0,0 +1,77 @@
+// hmm.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class WorkStealingPool;
+
+//----------------------------------------------------//
+//        Hidden Markov Model, Gaussian Emissions
+//----------------------------------------------------//
+
+// A sequence of observations, row-major (length * dims floats)
+struct HmmSequence
+{
+    const float* data;
+    size_t       length;
+};
+
+// Diagonal-Gaussian HMM with Baum-Welch training and Viterbi decoding.
+// Forward-backward stays in log space but pays for it once per step, not
+// once per transition: the previous column is shifted by its maximum,
+// exponentiated, multiplied by the (linear) transition matrix two states at
+// a time with SSE2 doubles, and the log taken again. States are padded to a
+// multiple of the vector width.
+class GaussianHmm {
+public:
+    GaussianHmm() {}
+    GaussianHmm(size_t states, size_t dims);
+
+    size_t states() const { return m_states; }
+    size_t dims() const { return m_dims; }
+
+    void setInitial(size_t state, double p);
+    void setTransition(size_t from, size_t to, double p);
+    void setEmission(size_t state, const double* mean, const double* var);
+    void normalize();   // rows of the transition matrix and the initial vector sum to 1
+
+    double initial(size_t state) const { return m_initial[state]; }
+    double transition(size_t from, size_t to) const { return m_trans[from * m_padded + to]; }
+    const double* mean(size_t state) const { return &m_mean[state * m_dims]; }
+    const double* variance(size_t state) const { return &m_var[state * m_dims]; }
+
+    // One EM iteration over all sequences (E-steps in parallel when a pool is
+    // given). Returns the total log-likelihood under the parameters before
+    // the update.
+    double baumWelchStep(const std::vector<HmmSequence>& sequences, WorkStealingPool* pool);
+
+    double logLikelihood(const HmmSequence& seq) const;
+
+    // Most likely state path; returns its log probability
+    double viterbi(const HmmSequence& seq, std::vector<uint8_t>& path) const;
+
+    // Text file: "# skillshot hmm v1" followed by one line per parameter group
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+private:
+    struct Accumulator;
+
+    void emissions(const HmmSequence& seq, std::vector<double>& logB) const;
+    double forwardBackward(const std::vector<double>& logB, size_t length,
+        std::vector<double>& alpha, std::vector<double>& beta) const;
+    void accumulate(const HmmSequence& seq, Accumulator& acc) const;
+
+private:
+    size_t              m_states = 0;
+    size_t              m_dims = 0;
+    size_t              m_padded = 0;     // states rounded up to the vector width
+    std::vector<double> m_initial;
+    std::vector<double> m_trans;          // states x padded, row-major, zero padding
+    std::vector<double> m_transT;         // transposed, same layout
+    std::vector<double> m_mean;           // states x dims
+    std::vector<double> m_var;
+};
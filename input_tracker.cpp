@@ -1,4 +1,7 @@
+#define NOMINMAX // keep std::min/std::max usable
 #include <windows.h>
+#include <algorithm>
+#include <cstdlib>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
@@ -12,185 +15,20 @@
 #include <cctype>
 #include <fstream>
 #include <queue>
-
-//----------------------------------------------------//
-//                  Data Structures
-//----------------------------------------------------//
-
-// Event structure to store any input event
-struct InputEvent
-{
-    std::string eventType;  // e.g. "MOUSE_LEFT_DOWN", "KEY_UP", "MOUSE_POS", etc.
-    DWORD       timestamp;  // in ms, from GetTickCount()
-    POINT       mousePos;   // relevant for mouse or for reference on keyboard
-    UINT        keyCode;    // relevant for keyboard events
-};
-
-// Returns a string like "20250118_162453"
-static std::string getTimestampString()
-{
-    std::time_t now = std::time(nullptr);
-    std::tm localTime;
-#if defined(_WIN32) || defined(_MSC_VER)
-    localtime_s(&localTime, &now);
-#else
-    localtime_r(&now, &localTime);
-#endif
-
-    std::ostringstream oss;
-    oss << std::put_time(&localTime, "%Y%m%d_%H%M%S");
-    return oss.str();
-}
-
-//----------------------------------------------------//
-//              CSVLogger Class Declaration
-//----------------------------------------------------//
-
-class CSVLogger {
-public:
-    CSVLogger(const std::string& filename = "input_log.csv",
-        int flushIntervalSeconds = 60);
-    ~CSVLogger();
-
-    void start();           // Starts the background flush thread
-    void stop();            // Stops the background flush thread (flushes remaining events)
-
-    // Thread-safe method to queue an event
-    void logEvent(const InputEvent& evt);
-
-private:
-    void flushThreadFunc(); // Thread loop that periodically flushes
-    void flushToDisk();     // Writes buffered events to file
-
-private:
-    std::string                     m_filename;
-    int                             m_flushIntervalSec;
-    std::atomic<bool>               m_running{ false };
-
-    // A thread-safe queue for events
-    std::mutex                      m_queueMutex;
-    std::queue<InputEvent>          m_eventQueue;
-
-    // Background flush thread
-    std::thread                     m_flushThread;
-};
-
-//----------------------------------------------------//
-//             CSVLogger Implementation
-//----------------------------------------------------//
-
-CSVLogger::CSVLogger(const std::string& filename, int flushIntervalSeconds)
-    : m_flushIntervalSec(flushIntervalSeconds)
-{
-    if (filename.empty()) {
-        // Generate a unique filename based on timestamp
-        std::string ts = getTimestampString();  // e.g. "20250118_162453"
-        m_filename = "input_log_" + ts + ".csv";
-    }
-    else {
-        m_filename = filename;
-    }
-}
-
-
-CSVLogger::~CSVLogger()
-{
-    // Make sure to stop and flush if the user forgot
-    if (m_running.load()) {
-        stop();
-    }
-}
-
-void CSVLogger::start()
-{
-    if (m_running.load()) {
-        return; // already running
-    }
-    m_running.store(true);
-
-    // Optionally, create or truncate the CSV file if you want a clean start:
-    {
-        std::ofstream ofs(m_filename, std::ios::trunc);
-        // Write header if desired
-        ofs << "timestamp_ms,event_type,x,y,key_code\n";
-    }
-
-    // Launch background flush thread
-    m_flushThread = std::thread(&CSVLogger::flushThreadFunc, this);
-}
-
-void CSVLogger::stop()
-{
-    if (!m_running.load()) {
-        return; // not running
-    }
-    m_running.store(false);
-
-    // Wait for the flush thread to exit
-    if (m_flushThread.joinable()) {
-        m_flushThread.join();
-    }
-
-    // Final flush in case there are leftover events
-    flushToDisk();
-}
-
-void CSVLogger::logEvent(const InputEvent& evt)
-{
-    // Thread-safe insertion
-    std::lock_guard<std::mutex> lock(m_queueMutex);
-    m_eventQueue.push(evt);
-}
-
-void CSVLogger::flushThreadFunc()
-{
-    // Loop until m_running is set to false
-    while (m_running.load()) {
-        // Sleep for flush interval
-        std::this_thread::sleep_for(std::chrono::seconds(m_flushIntervalSec));
-        if (!m_running.load()) {
-            break;
-        }
-        flushToDisk();
-    }
-}
-
-void CSVLogger::flushToDisk()
-{
-    // Move events from the queue into a local vector (so we don't hold the lock while writing)
-    std::vector<InputEvent> localBuffer;
-    {
-        std::lock_guard<std::mutex> lock(m_queueMutex);
-
-        // Move all events from queue to localBuffer
-        while (!m_eventQueue.empty()) {
-            localBuffer.push_back(m_eventQueue.front());
-            m_eventQueue.pop();
-        }
-    }
-
-    if (localBuffer.empty()) {
-        return; // nothing to write
-    }
-
-    // Open file in append mode
-    std::ofstream ofs(m_filename, std::ios::app);
-    if (!ofs.is_open()) {
-        std::cerr << "Failed to open CSV file for appending: " << m_filename << "\n";
-        return;
-    }
-
-    // Write events
-    // CSV format: timestamp_ms,event_type,x,y,key_code
-    for (const auto& evt : localBuffer) {
-        ofs << evt.timestamp << ","
-            << evt.eventType << ","
-            << evt.mousePos.x << ","
-            << evt.mousePos.y << ","
-            << evt.keyCode << "\n";
-    }
-    ofs.close();
-}
+#include <functional>
+#include <memory>
+
+#include "session_event.h"
+#include "combo_matcher.h"
+#include "panic_detector.h"
+#include "path_simplify.h"
+#include "live_analysis.h"
+#include "change_points.h"
+#include "skill_model.h"
+#include "csv_logger.h"
+#include "flight_recorder.h"
+#include "capture_metrics.h"
+#include "capture_trace.h"
 
 //----------------------------------------------------//
 //   Global Config & Original Tracker Functionality
@@ -212,9 +50,42 @@ public:
     HHOOK mouseHook = nullptr;
     HHOOK keyboardHook = nullptr;
 
+    // Cursor polling; joined by 'stop' before the logger's final flush
+    std::thread pollThread;
+
+    // Capture metrics, published in shared memory for external readers
+    // ('stats'); declared first so it outlives the logger
+    CaptureMetrics metrics{ kDefaultMetricsName };
+    MetricsSnapshot lastStats;
+    bool            haveLastStats = false;
+
+    // Pipeline tracing ('trace on|off'): written as Chrome JSON on 'stop'
+    std::string     tracePath;      // empty = capture_trace_<time>.json
+    size_t          traceSpans = 1 << 20;
+
     // CSV logger to reduce memory usage
     // By default, flush every 60 seconds
     CSVLogger csvLogger{ "input_log.csv", 60 };
+
+    // Combo patterns matched on the live tap ('combos <file|off>'; empty = off)
+    std::vector<ComboPattern>     comboPatterns;
+
+    // Panic-click detection on the live tap ('panic on|off')
+    bool                          panicOn = false;
+
+    // Live analysis thread fed straight from the logger. It runs the
+    // 'live on|off|stats' operators, the combo matcher and the panic-click
+    // detector, and exists while any of them is enabled.
+    std::unique_ptr<LiveAnalyzer>  liveAnalyzer;
+    bool                           liveOn = false;
+    bool                           liveReported = false;  // running analyzer has the 'live' set
+    uint32_t                       liveLatencyMs = 50;
+    std::string                    liveModelPath;
+
+    // Flight-recorder capture ('flight on|off'): fast polling on a 1 ms timer
+    std::atomic<bool> fineTimer{ false };
+    int               normalPollMs = 20;   // restored by 'flight off'
+    FlightOptions     flightOptions;       // triggers follow 'setkeys'
 };
 
 // We keep a single global instance:
@@ -226,27 +97,24 @@ static TrackerConfig g_config;
 
 DWORD getCurrentTimeMs()
 {
-    return GetTickCount();
+    // GetTickCount only advances every ~16 ms; timeGetTime counts from the
+    // same boot and follows the 1 ms timer period flight mode requests
+    return g_config.fineTimer.load() ? timeGetTime() : GetTickCount();
+}
+
+// Hook bookkeeping: time spent in the callback and how late the OS
+// delivered the event (its stamp is GetTickCount-based)
+static void recordHook(std::chrono::steady_clock::time_point begin, DWORD eventTime)
+{
+    const DWORD now = GetTickCount();
+    g_config.metrics.onHook(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - begin).count()), now >= eventTime ? now - eventTime : 0);
 }
 
 // Convert a VK code to a debug string (basic)
 std::string vkCodeToString(UINT vkCode)
 {
-    switch (vkCode) {
-    case VK_CONTROL: return "CTRL";
-    case VK_SHIFT:   return "SHIFT";
-    case VK_MENU:    return "ALT";
-    default:
-        if ((vkCode >= '0' && vkCode <= '9') ||
-            (vkCode >= 'A' && vkCode <= 'Z')) {
-            return std::string(1, static_cast<char>(vkCode));
-        }
-        {
-            std::ostringstream oss;
-            oss << "VK(" << vkCode << ")";
-            return oss.str();
-        }
-    }
+    return vkToKeyName(static_cast<uint32_t>(vkCode));
 }
 
 //----------------------------------------------------//
@@ -256,6 +124,8 @@ std::string vkCodeToString(UINT vkCode)
 LRESULT CALLBACK LowLevelMouseProc(int nCode, WPARAM wParam, LPARAM lParam)
 {
     if (nCode >= 0 && g_config.isRunning.load()) {
+        TraceScope trace("mouse_hook");
+        const auto begin = std::chrono::steady_clock::now();
         MSLLHOOKSTRUCT* pMouse = reinterpret_cast<MSLLHOOKSTRUCT*>(lParam);
         POINT pt = pMouse->pt;
         DWORD time = getCurrentTimeMs();
@@ -273,11 +143,14 @@ LRESULT CALLBACK LowLevelMouseProc(int nCode, WPARAM wParam, LPARAM lParam)
 
         InputEvent evt{
             eventType,
-            time,
-            pt,
-            0 // no keyCode for mouse events
+            static_cast<uint32_t>(time),
+            CursorPos{ static_cast<int32_t>(pt.x), static_cast<int32_t>(pt.y) },
+            0, // no keyCode for mouse events
+            CaptureSource::MouseHook,
+            g_config.csvLogger.nextSequence(CaptureSource::MouseHook)
         };
         g_config.csvLogger.logEvent(evt);
+        recordHook(begin, pMouse->time);
     }
 
     return CallNextHookEx(NULL, nCode, wParam, lParam);
@@ -286,6 +159,8 @@ LRESULT CALLBACK LowLevelMouseProc(int nCode, WPARAM wParam, LPARAM lParam)
 LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam)
 {
     if (nCode >= 0 && g_config.isRunning.load()) {
+        TraceScope trace("keyboard_hook");
+        const auto begin = std::chrono::steady_clock::now();
         KBDLLHOOKSTRUCT* pKeyboard = reinterpret_cast<KBDLLHOOKSTRUCT*>(lParam);
         DWORD time = getCurrentTimeMs();
         UINT vkCode = pKeyboard->vkCode;
@@ -319,11 +194,14 @@ LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam)
 
         InputEvent evt{
             eventType,
-            time,
-            pt,
-            vkCode
+            static_cast<uint32_t>(time),
+            CursorPos{ static_cast<int32_t>(pt.x), static_cast<int32_t>(pt.y) },
+            static_cast<uint32_t>(vkCode),
+            CaptureSource::KeyboardHook,
+            g_config.csvLogger.nextSequence(CaptureSource::KeyboardHook)
         };
         g_config.csvLogger.logEvent(evt);
+        recordHook(begin, pKeyboard->time);
     }
     return CallNextHookEx(NULL, nCode, wParam, lParam);
 }
@@ -334,17 +212,38 @@ LRESULT CALLBACK LowLevelKeyboardProc(int nCode, WPARAM wParam, LPARAM lParam)
 
 void cursorPollingThread()
 {
+    captureTrace().setThreadName("poll");
+    auto lastPoll = std::chrono::steady_clock::now();
+    bool first = true;
     while (g_config.isRunning.load()) {
-        POINT pt;
-        if (GetCursorPos(&pt)) {
-            DWORD time = getCurrentTimeMs();
-            InputEvent evt{
-                "MOUSE_POS",
-                time,
-                pt,
-                0
-            };
-            g_config.csvLogger.logEvent(evt);
+        // Jitter: how far the actual period strays from the configured one
+        const auto now = std::chrono::steady_clock::now();
+        if (!first) {
+            const int64_t periodUs = std::chrono::duration_cast<std::chrono::microseconds>(now - lastPoll).count();
+            const int64_t targetUs = static_cast<int64_t>(g_config.pollIntervalMs.load()) * 1000;
+            g_config.metrics.onPoll(static_cast<uint64_t>(std::abs(periodUs - targetUs)));
+        }
+        lastPoll = now;
+        first = false;
+
+        {
+            TraceScope trace("poll");
+
+            // Numbered per attempt: a failed read (secure desktop, ...) is a gap
+            const uint32_t sequence = g_config.csvLogger.nextSequence(CaptureSource::CursorPoll);
+            POINT pt;
+            if (GetCursorPos(&pt)) {
+                DWORD time = getCurrentTimeMs();
+                InputEvent evt{
+                    "MOUSE_POS",
+                    static_cast<uint32_t>(time),
+                    CursorPos{ static_cast<int32_t>(pt.x), static_cast<int32_t>(pt.y) },
+                    0,
+                    CaptureSource::CursorPoll,
+                    sequence
+                };
+                g_config.csvLogger.logEvent(evt);
+            }
         }
         std::this_thread::sleep_for(std::chrono::milliseconds(g_config.pollIntervalMs.load()));
     }
@@ -396,7 +295,13 @@ void startLogging(int intervalMs)
         return;
     }
 
-    if (intervalMs > 0) {
+    if (intervalMs > 0 && g_config.fineTimer.load()) {
+        // Flight mode owns the interval; this one applies after 'flight off'
+        g_config.normalPollMs = intervalMs;
+        std::cout << "Flight mode keeps polling every " << g_config.pollIntervalMs.load()
+            << " ms; " << intervalMs << " ms applies after 'flight off'.\n";
+    }
+    else if (intervalMs > 0) {
         g_config.pollIntervalMs.store(intervalMs);
     }
 
@@ -409,8 +314,7 @@ void startLogging(int intervalMs)
     installHooks();
 
     // Launch the polling thread
-    std::thread polling(cursorPollingThread);
-    polling.detach();
+    g_config.pollThread = std::thread(cursorPollingThread);
 
     std::cout << "Logging started (poll interval = "
         << g_config.pollIntervalMs.load() << " ms).\n";
@@ -428,10 +332,30 @@ void stopLogging()
     // Remove hooks
     removeHooks();
 
+    // The poller may be between taking a sequence number and logging the
+    // sample; let it finish before the final flush counts what arrived
+    if (g_config.pollThread.joinable()) {
+        g_config.pollThread.join();
+    }
+
     // Stop the CSV logger (flushes any remaining events)
     g_config.csvLogger.stop();
 
     std::cout << "Logging stopped.\n";
+
+    if (captureTrace().enabled()) {
+        captureTrace().stop();
+        const std::string path = g_config.tracePath.empty()
+            ? "capture_trace_" + getTimestampString() + ".json"
+            : g_config.tracePath;
+        uint64_t spans = 0, dropped = 0;
+        if (captureTrace().write(path, &spans, &dropped)) {
+            std::cout << "Trace: " << spans << " spans (" << dropped << " dropped) written to "
+                << path << "\n";
+        }
+        // Keep tracing; the next capture starts from an empty trace
+        captureTrace().start(g_config.traceSpans);
+    }
 }
 
 //----------------------------------------------------//
@@ -442,6 +366,7 @@ static std::atomic<bool> g_hookThreadActive{ true };
 
 DWORD WINAPI hookThreadProc(LPVOID)
 {
+    captureTrace().setThreadName("hooks");
     MSG msg;
     while (g_hookThreadActive.load()) {
         BOOL res = GetMessage(&msg, NULL, 0, 0);
@@ -472,22 +397,11 @@ std::vector<std::string> splitTokens(const std::string& line)
 // Convert a single key string (like "Q", "CTRL") to a virtual-key code
 UINT keyStringToVk(const std::string& keyStr)
 {
-    std::string upper;
-    for (char c : keyStr) upper.push_back(static_cast<char>(toupper(c)));
-
-    if (upper == "CTRL")  return VK_CONTROL;
-    if (upper == "SHIFT") return VK_SHIFT;
-    if (upper == "ALT")   return VK_MENU;
-
-    if (upper.size() == 1) {
-        char c = upper[0];
-        if ((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z')) {
-            return static_cast<UINT>(c);
-        }
-    }
-    return 0; // not recognized
+    return static_cast<UINT>(keyNameToVk(keyStr));
 }
 
+void restartLiveAnalysis(); // Live Analysis, below
+
 void setTrackedKeys(const std::vector<std::string>& keys)
 {
     std::vector<UINT> newVk;
@@ -500,6 +414,307 @@ void setTrackedKeys(const std::vector<std::string>& keys)
 
     g_config.trackedKeys = newVk;
     std::cout << "Tracked keys updated. Count = " << newVk.size() << "\n";
+
+    if (g_config.fineTimer.load()) {
+        // New recorder with the new triggers; the old one decides what it
+        // still holds without further look-ahead
+        g_config.flightOptions.triggerKeys.assign(newVk.begin(), newVk.end());
+        g_config.csvLogger.setFlightRecorder(&g_config.flightOptions);
+        std::cout << "Flight-recorder triggers updated.\n";
+    }
+    if (g_config.liveOn) {
+        // The reaction, change-point and cast-score operators copied the
+        // old keys when they were built
+        restartLiveAnalysis();
+        std::cout << "Live analysis restarted with the new keys.\n";
+    }
+}
+
+//----------------------------------------------------//
+//                 Lossy Path Storage
+//----------------------------------------------------//
+
+void setLossyPath(const std::string& arg)
+{
+    double tolerance = 0.0;
+    if (arg != "off") {
+        try {
+            tolerance = std::stod(arg);
+        }
+        catch (...) {
+            std::cout << "Usage: lossy <tolerancePx|off>\n";
+            return;
+        }
+    }
+
+    g_config.csvLogger.setPathTolerance(tolerance);
+    if (tolerance > 0.0) {
+        std::cout << "Cursor track will be simplified to within " << tolerance << " px.\n";
+    }
+    else {
+        std::cout << "Lossy path mode disabled (every cursor sample is written).\n";
+    }
+}
+
+//----------------------------------------------------//
+//             Flight-Recorder Capture
+//----------------------------------------------------//
+
+void setFlightRecorder(const std::vector<std::string>& tokens)
+{
+    const std::string mode = tokens.size() > 1 ? tokens[1] : "";
+    if (mode == "on") {
+        FlightOptions options;
+        int pollMs = 5;
+        try {
+            uint32_t* fields[] = { &options.preMs, &options.postMs, &options.backgroundMs };
+            for (size_t i = 0; i < 3 && i + 2 < tokens.size(); ++i) {
+                *fields[i] = static_cast<uint32_t>(std::stoul(tokens[i + 2]));
+            }
+            if (tokens.size() > 5) {
+                pollMs = std::max(1, std::stoi(tokens[5]));
+            }
+        }
+        catch (...) {
+            std::cout << "Usage: flight <on [preMs] [postMs] [backgroundMs] [pollMs]|off>\n";
+            return;
+        }
+        // Casts of the tracked keys are the triggers
+        options.triggerKeys.assign(g_config.trackedKeys.begin(), g_config.trackedKeys.end());
+        g_config.flightOptions = options;
+        g_config.csvLogger.setFlightRecorder(&options);
+
+        if (!g_config.fineTimer.load()) {
+            timeBeginPeriod(1);
+            g_config.fineTimer.store(true);
+            g_config.normalPollMs = g_config.pollIntervalMs.load();
+        }
+        g_config.pollIntervalMs.store(pollMs);
+        std::cout << "Flight recorder on: cursor polled every " << pollMs << " ms, kept "
+            << options.preMs << " ms before to " << options.postMs << " ms after each cast, "
+            << "every " << options.backgroundMs << " ms elsewhere.\n";
+    }
+    else if (mode == "off") {
+        g_config.csvLogger.setFlightRecorder(nullptr);
+        if (g_config.fineTimer.load()) {
+            g_config.fineTimer.store(false);
+            timeEndPeriod(1);
+            g_config.pollIntervalMs.store(g_config.normalPollMs);
+        }
+        std::cout << "Flight recorder off (poll interval = "
+            << g_config.pollIntervalMs.load() << " ms).\n";
+    }
+    else {
+        std::cout << "Usage: flight <on [preMs] [postMs] [backgroundMs] [pollMs]|off>\n";
+    }
+}
+
+//----------------------------------------------------//
+//                 Capture Metrics
+//----------------------------------------------------//
+
+// Rates and distributions since the previous 'stats' (or since launch)
+void printCaptureStats()
+{
+    MetricsSnapshot now;
+    g_config.metrics.snapshot(now);
+    printMetrics(std::cout, now, g_config.haveLastStats ? &g_config.lastStats : nullptr);
+    if (!g_config.metrics.shared()) {
+        std::cout << "  (not published in shared memory)\n";
+    }
+    g_config.lastStats = now;
+    g_config.haveLastStats = true;
+}
+
+//----------------------------------------------------//
+//                 Pipeline Tracing
+//----------------------------------------------------//
+
+void setTracing(const std::vector<std::string>& tokens)
+{
+    const std::string mode = tokens.size() > 1 ? tokens[1] : "";
+    if (mode == "on") {
+        size_t spans = g_config.traceSpans;
+        try {
+            if (tokens.size() > 3) {
+                spans = std::max<size_t>(1, std::stoul(tokens[3]));
+            }
+        }
+        catch (...) {
+            std::cout << "Usage: trace <on [file] [spansPerThread]|off>\n";
+            return;
+        }
+        g_config.traceSpans = spans;
+        g_config.tracePath = tokens.size() > 2 ? tokens[2] : "";
+        captureTrace().start(spans);
+        std::cout << "Tracing on: written to "
+            << (g_config.tracePath.empty() ? "capture_trace_<time>.json" : g_config.tracePath)
+            << " on every 'stop'.\n";
+    }
+    else if (mode == "off") {
+        captureTrace().stop();
+        std::cout << "Tracing off.\n";
+    }
+    else {
+        std::cout << "Usage: trace <on [file] [spansPerThread]|off>\n";
+    }
+}
+
+//----------------------------------------------------//
+//                  Live Analysis
+//----------------------------------------------------//
+
+static void printLiveStats(const LiveStats& stats)
+{
+    std::cout << "Live analysis: " << stats.events << " events, "
+        << stats.results << " results, " << stats.dropped << " dropped; latency mean "
+        << stats.meanLatencyMs << " ms, max " << stats.maxLatencyMs << " ms ("
+        << stats.overBudget << " events over budget).\n";
+}
+
+void stopLiveAnalysis()
+{
+    if (!g_config.liveAnalyzer) {
+        return;
+    }
+    g_config.csvLogger.setLiveTap(nullptr);
+    g_config.liveAnalyzer->stop(); // reports anything still open
+    if (g_config.liveReported) {
+        printLiveStats(g_config.liveAnalyzer->stats());
+    }
+    g_config.liveAnalyzer.reset();
+}
+
+// Operators are fixed once the thread runs, so every change of what is
+// enabled builds a new analyzer (open results of the old one are reported)
+void restartLiveAnalysis()
+{
+    stopLiveAnalysis();
+    if (!g_config.liveOn && g_config.comboPatterns.empty() && !g_config.panicOn) {
+        return;
+    }
+
+    LiveOptions options;
+    options.latencyMs = g_config.liveLatencyMs;
+    std::unique_ptr<LiveAnalyzer> live(new LiveAnalyzer(options, [](const LiveResult& r) {
+        if (std::string(r.op) == "combo") {
+            std::cout << "[COMBO] " << r.text << "\n";
+        }
+        else if (std::string(r.op) == "spam") {
+            std::cout << "[PANIC] " << r.text << "\n";
+        }
+        else {
+            std::cout << "[LIVE] " << r.op << " " << r.text << "\n";
+        }
+    }));
+
+    if (!g_config.comboPatterns.empty()) {
+        live->addOperator(std::unique_ptr<LiveOperator>(new ComboOperator(g_config.comboPatterns)));
+    }
+    // 'panic on' and 'live on' share one spam operator
+    if (g_config.liveOn || g_config.panicOn) {
+        live->addOperator(std::unique_ptr<LiveOperator>(new SpamOperator()));
+    }
+
+    if (g_config.liveOn) {
+        // Reaction times are measured for the tracked keys
+        std::vector<uint32_t> castKeys(g_config.trackedKeys.begin(), g_config.trackedKeys.end());
+        live->addOperator(std::unique_ptr<LiveOperator>(new FlickOperator()));
+        live->addOperator(std::unique_ptr<LiveOperator>(new ReactionTimeOperator(castKeys)));
+
+        MetricOptions metrics;
+        metrics.castKeys = castKeys;
+        live->addOperator(std::unique_ptr<LiveOperator>(new ChangePointOperator(metrics)));
+
+        // Hit chance per cast, from a model trained with 'analyzer castmodel train'
+        if (!g_config.liveModelPath.empty()) {
+            LogisticModel model;
+            if (model.load(g_config.liveModelPath)) {
+                live->addOperator(std::unique_ptr<LiveOperator>(new CastScoreOperator(model, castKeys)));
+            }
+        }
+    }
+    live->start();
+
+    g_config.liveAnalyzer = std::move(live);
+    g_config.liveReported = g_config.liveOn;
+    g_config.csvLogger.setLiveTap(g_config.liveAnalyzer.get());
+}
+
+void setLiveAnalysis(const std::vector<std::string>& tokens)
+{
+    const std::string mode = tokens.size() > 1 ? tokens[1] : "";
+    if (mode == "on") {
+        uint32_t latencyMs = 50;
+        if (tokens.size() > 2) {
+            try {
+                latencyMs = static_cast<uint32_t>(std::stoul(tokens[2]));
+            }
+            catch (...) {}
+        }
+        g_config.liveOn = true;
+        g_config.liveLatencyMs = latencyMs;
+        g_config.liveModelPath = tokens.size() > 3 ? tokens[3] : "";
+        restartLiveAnalysis();
+        std::cout << "Live analysis enabled (latency bound " << latencyMs << " ms).\n";
+    }
+    else if (mode == "off") {
+        if (!g_config.liveOn) {
+            std::cout << "Live analysis is not running.\n";
+            return;
+        }
+        g_config.liveOn = false;
+        restartLiveAnalysis();
+        std::cout << "Live analysis disabled.\n";
+    }
+    else if (mode == "stats") {
+        if (!g_config.liveOn) {
+            std::cout << "Live analysis is not running.\n";
+            return;
+        }
+        printLiveStats(g_config.liveAnalyzer->stats());
+    }
+    else {
+        std::cout << "Usage: live <on [latencyMs] [castModel]|off|stats>\n";
+    }
+}
+
+//----------------------------------------------------//
+//                 Combo Matching
+//----------------------------------------------------//
+
+// Combos are matched on the live tap, so they show up within the live
+// latency bound rather than at the next flush
+void loadCombos(const std::string& path)
+{
+    if (path == "off") {
+        g_config.comboPatterns.clear();
+        restartLiveAnalysis();
+        std::cout << "Combo matching disabled.\n";
+        return;
+    }
+
+    std::vector<ComboPattern> patterns;
+    if (!loadComboPatterns(path, patterns)) {
+        return;
+    }
+    g_config.comboPatterns = patterns;
+    restartLiveAnalysis();
+    std::cout << "Loaded " << patterns.size() << " combo patterns ("
+        << ComboMatcher(patterns).stateCount() << " automaton states).\n";
+}
+
+//----------------------------------------------------//
+//               Panic-Click Detection
+//----------------------------------------------------//
+
+// Bursts are reported by the live spam operator as '[PANIC] ...'; turning
+// it off closes and reports the ones still in progress
+void setPanicDetection(bool enabled)
+{
+    g_config.panicOn = enabled;
+    restartLiveAnalysis();
+    std::cout << (enabled ? "Panic-click detection enabled.\n" : "Panic-click detection disabled.\n");
 }
 
 //----------------------------------------------------//
@@ -508,6 +723,9 @@ void setTrackedKeys(const std::vector<std::string>& keys)
 
 int main()
 {
+    // The final flush of each capture runs here, inside 'stop'
+    captureTrace().setThreadName("main");
+
     // 1) Start a dedicated thread with a message loop for hooking
     HANDLE hHookThread = CreateThread(NULL, 0, hookThreadProc, NULL, 0, NULL);
     if (!hHookThread) {
@@ -515,11 +733,20 @@ int main()
         return 1;
     }
 
+    g_config.csvLogger.setMetrics(&g_config.metrics);
+
     std::cout << "Welcome to Input Tracker CLI (with CSV logging)!\n";
     std::cout << "Commands:\n"
         << "  start [intervalMs]\n"
         << "  stop\n"
         << "  setkeys [key1 key2 ...]\n"
+        << "  combos <file|off>\n"
+        << "  panic <on|off>\n"
+        << "  lossy <tolerancePx|off>\n"
+        << "  live <on [latencyMs] [castModel]|off|stats>\n"
+        << "  flight <on [preMs] [postMs] [backgroundMs] [pollMs]|off>\n"
+        << "  stats\n"
+        << "  trace <on [file] [spansPerThread]|off>\n"
         << "  exit\n";
 
     // 2) Main command loop
@@ -538,7 +765,7 @@ int main()
         std::string cmd = tokens[0];
 
         if (cmd == "start") {
-            int interval = 20; // default
+            int interval = 0; // keep the current interval (20 ms at launch)
             if (tokens.size() > 1) {
                 try {
                     interval = std::stoi(tokens[1]);
@@ -559,6 +786,42 @@ int main()
                 std::cout << "Usage: setkeys [key1 key2 ...]\n";
             }
         }
+        else if (cmd == "combos") {
+            if (tokens.size() > 1) {
+                loadCombos(tokens[1]);
+            }
+            else {
+                std::cout << "Usage: combos <file|off>\n";
+            }
+        }
+        else if (cmd == "panic") {
+            if (tokens.size() > 1 && (tokens[1] == "on" || tokens[1] == "off")) {
+                setPanicDetection(tokens[1] == "on");
+            }
+            else {
+                std::cout << "Usage: panic <on|off>\n";
+            }
+        }
+        else if (cmd == "lossy") {
+            if (tokens.size() > 1) {
+                setLossyPath(tokens[1]);
+            }
+            else {
+                std::cout << "Usage: lossy <tolerancePx|off>\n";
+            }
+        }
+        else if (cmd == "live") {
+            setLiveAnalysis(tokens);
+        }
+        else if (cmd == "flight") {
+            setFlightRecorder(tokens);
+        }
+        else if (cmd == "stats") {
+            printCaptureStats();
+        }
+        else if (cmd == "trace") {
+            setTracing(tokens);
+        }
         else if (cmd == "exit") {
             break;
         }
@@ -571,6 +834,10 @@ int main()
     if (g_config.isRunning.load()) {
         stopLogging();
     }
+    stopLiveAnalysis();
+    if (g_config.fineTimer.load()) {
+        timeEndPeriod(1);
+    }
 
     // Signal hook thread to exit
     g_hookThreadActive.store(false);
@@ -0,0 +1,247 @@
+#include "key_timing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "session_reader.h"
+#include "session_segments.h"
+
+static const double kGamma = 1.04;
+static const uint32_t kTableLimit = 4096;   // bucketOf() by lookup below this
+
+//----------------------------------------------------//
+//            DurationSketch Implementation
+//----------------------------------------------------//
+
+DurationSketch::DurationSketch()
+{
+    std::fill(m_counts, m_counts + kBuckets, 0u);
+}
+
+static size_t computeBucket(uint32_t ms)
+{
+    if (ms == 0) {
+        return 0;
+    }
+    const size_t i = 1 + static_cast<size_t>(std::floor(std::log(static_cast<double>(ms)) / std::log(kGamma) + 1e-9));
+    return std::min(i, DurationSketch::kBuckets - 1);
+}
+
+size_t DurationSketch::bucketOf(uint32_t ms)
+{
+    // Key timings are almost always short: no log on the hot path
+    static const std::vector<uint16_t> table = []() {
+        std::vector<uint16_t> t(kTableLimit);
+        for (uint32_t v = 0; v < kTableLimit; ++v) {
+            t[v] = static_cast<uint16_t>(computeBucket(v));
+        }
+        return t;
+    }();
+    return ms < kTableLimit ? table[ms] : computeBucket(ms);
+}
+
+void DurationSketch::add(uint32_t ms)
+{
+    ++m_counts[bucketOf(ms)];
+    ++m_count;
+    m_sum += ms;
+    m_min = std::min(m_min, ms);
+    m_max = std::max(m_max, ms);
+}
+
+void DurationSketch::merge(const DurationSketch& other)
+{
+    for (size_t i = 0; i < kBuckets; ++i) {
+        m_counts[i] += other.m_counts[i];
+    }
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+}
+
+double DurationSketch::quantile(double q) const
+{
+    if (m_count == 0) {
+        return 0.0;
+    }
+    const uint64_t rank = static_cast<uint64_t>(std::ceil(std::max(0.0, std::min(1.0, q)) * m_count));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += m_counts[i];
+        if (seen >= std::max<uint64_t>(1, rank)) {
+            if (i == 0) {
+                return 0.0;
+            }
+            // Middle of the bucket, inside the observed range
+            const double lo = std::pow(kGamma, static_cast<double>(i - 1));
+            const double mid = lo * (1.0 + kGamma) / 2.0;
+            return std::max<double>(m_min, std::min<double>(m_max, mid));
+        }
+    }
+    return m_max;
+}
+
+std::string DurationSketch::encode() const
+{
+    std::ostringstream oss;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        if (m_counts[i]) {
+            oss << (oss.tellp() > 0 ? ";" : "") << i << ":" << m_counts[i];
+        }
+    }
+    return oss.str();
+}
+
+//----------------------------------------------------//
+//            KeyTimingTable Implementation
+//----------------------------------------------------//
+
+KeyTimingTable::KeyTimingTable()
+    : m_slot(kChannelCount, 0xFFFF)
+{
+}
+
+KeyTimingStats& KeyTimingTable::at(uint32_t channel)
+{
+    if (m_slot[channel] == 0xFFFF) {
+        m_slot[channel] = static_cast<uint16_t>(m_rows.size());
+        m_rows.emplace_back();
+        m_rows.back().channel = channel;
+    }
+    return m_rows[m_slot[channel]];
+}
+
+//----------------------------------------------------//
+//          KeyTimingAggregator Implementation
+//----------------------------------------------------//
+
+KeyTimingAggregator::KeyTimingAggregator(const KeyTimingOptions& options)
+    : m_options(options), m_tables(1),
+      m_open(kChannelCount, 0), m_downAt(kChannelCount, 0), m_lastDownAt(kChannelCount, 0),
+      m_hasPress(kChannelCount, 0), m_lastPressAt(kChannelCount, 0), m_pressGame(kChannelCount, 0)
+{
+}
+
+void KeyTimingAggregator::setGames(const std::vector<uint32_t>& starts, const std::vector<uint32_t>& ends)
+{
+    m_gameStarts = starts;
+    m_gameEnds = ends;
+    m_gameCursor = 0;
+    m_tables.resize(1 + starts.size());
+}
+
+size_t KeyTimingAggregator::gameAt(uint32_t t)
+{
+    // Events come in time order: the cursor only moves forward
+    while (m_gameCursor < m_gameEnds.size() && t > m_gameEnds[m_gameCursor]) {
+        ++m_gameCursor;
+    }
+    if (m_gameCursor < m_gameStarts.size() && t >= m_gameStarts[m_gameCursor]) {
+        return m_gameCursor + 1;
+    }
+    return 0;
+}
+
+void KeyTimingAggregator::closeOpen(uint32_t channel)
+{
+    // The up was lost: no hold duration
+    m_open[channel] = 0;
+    ++m_tables[0].at(channel).missingUps;
+    if (m_pressGame[channel]) {
+        ++m_tables[m_pressGame[channel]].at(channel).missingUps;
+    }
+}
+
+void KeyTimingAggregator::onEvent(const SessionEvent& evt)
+{
+    const uint32_t t = evt.timestamp;
+    uint32_t channel = pressChannel(evt);
+    if (channel != kNoChannel) {
+        if (m_open[channel]) {
+            if (t - m_lastDownAt[channel] <= m_options.repeatGapMs) {
+                m_lastDownAt[channel] = t;
+                ++m_tables[0].at(channel).repeats;
+                if (m_pressGame[channel]) {
+                    ++m_tables[m_pressGame[channel]].at(channel).repeats;
+                }
+                return;
+            }
+            closeOpen(channel);
+        }
+
+        // Counted for the session and, inside a game, for the game too
+        const size_t game = gameAt(t);
+        auto count = [&](KeyTimingStats& stats) {
+            ++stats.presses;
+            if (m_hasPress[channel]) {
+                stats.interval.add(t - m_lastPressAt[channel]);
+            }
+        };
+        count(m_tables[0].at(channel));
+        if (game) {
+            count(m_tables[game].at(channel));
+        }
+        m_open[channel] = 1;
+        m_downAt[channel] = t;
+        m_lastDownAt[channel] = t;
+        m_hasPress[channel] = 1;
+        m_lastPressAt[channel] = t;
+        m_pressGame[channel] = static_cast<uint32_t>(game);
+        return;
+    }
+
+    channel = releaseChannel(evt);
+    if (channel == kNoChannel) {
+        return;
+    }
+    if (!m_open[channel]) {
+        ++m_tables[0].at(channel).orphanUps;
+        const size_t game = gameAt(t);
+        if (game) {
+            ++m_tables[game].at(channel).orphanUps;
+        }
+        return;
+    }
+    m_open[channel] = 0;
+    const uint32_t hold = t - m_downAt[channel];
+    m_tables[0].at(channel).hold.add(hold);
+    if (m_pressGame[channel]) {
+        m_tables[m_pressGame[channel]].at(channel).hold.add(hold);
+    }
+}
+
+void KeyTimingAggregator::finish()
+{
+    for (uint32_t channel = 0; channel < kChannelCount; ++channel) {
+        if (m_open[channel]) {
+            closeOpen(channel);
+        }
+    }
+}
+
+bool aggregateKeyTiming(const std::string& path, const KeyTimingOptions& options, bool byGame,
+    KeyTimingAggregator& out)
+{
+    out = KeyTimingAggregator(options);
+    if (byGame) {
+        SegmentIndex index;
+        if (!loadOrBuildSegmentIndex(path, SegmentOptions(), index)) {
+            return false;
+        }
+        std::vector<uint32_t> starts, ends;
+        for (const auto& s : index.segments()) {
+            if (s.kind == SegmentKind::Game) {
+                starts.push_back(s.startMs);
+                ends.push_back(s.endMs);
+            }
+        }
+        out.setGames(starts, ends);
+    }
+    bool ok = forEachSessionEvent(path, [&out](const SessionEvent& evt) {
+        out.onEvent(evt);
+    });
+    out.finish();
+    return ok;
+}
@@ -0,0 +1,122 @@
+// key_timing.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "session_event.h"
+
+//----------------------------------------------------//
+//               Duration Sketch
+//----------------------------------------------------//
+
+// Log-bucketed histogram of millisecond durations: bucket i > 0 holds
+// [g^(i-1), g^i) with g = 1.04, so quantiles are within about 2% of the
+// true value. Fixed size, mergeable, and cheap enough to keep per key.
+class DurationSketch {
+public:
+    static const size_t kBuckets = 400;   // up to about 1.5 hours
+
+    DurationSketch();
+
+    void add(uint32_t ms);
+    void merge(const DurationSketch& other);
+
+    uint64_t count() const { return m_count; }
+    double mean() const { return m_count ? static_cast<double>(m_sum) / m_count : 0.0; }
+    uint32_t min() const { return m_count ? m_min : 0; }
+    uint32_t max() const { return m_max; }
+    double quantile(double q) const;
+
+    // Non-empty buckets as "index:count;..." (the bucket layout is fixed, so
+    // encoded sketches from different runs can be merged later)
+    std::string encode() const;
+
+    static size_t bucketOf(uint32_t ms);
+
+private:
+    uint32_t m_counts[kBuckets];
+    uint64_t m_count = 0;
+    uint64_t m_sum = 0;
+    uint32_t m_min = UINT32_MAX;
+    uint32_t m_max = 0;
+};
+
+//----------------------------------------------------//
+//            Per-Key Timing Aggregation
+//----------------------------------------------------//
+
+struct KeyTimingOptions
+{
+    // A second down without an up in between: auto-repeat if it comes
+    // within this long of the previous down or repeat, otherwise the up was
+    // lost and a new press starts (as in PressFilter, session_event.h)
+    uint32_t repeatGapMs = kAutoRepeatGapMs;
+};
+
+struct KeyTimingStats
+{
+    uint32_t       channel = kNoChannel;   // press channel (key VK, LMB, RMB)
+    uint64_t       presses = 0;
+    uint64_t       repeats = 0;            // auto-repeat downs
+    uint64_t       missingUps = 0;         // presses that never saw their up
+    uint64_t       orphanUps = 0;          // ups without a down
+    DurationSketch hold;                   // down to up
+    DurationSketch interval;               // down to next down of the same key
+};
+
+// Stats of one group (whole session or one game), one row per channel that
+// was used, found through a dense channel-indexed slot table
+class KeyTimingTable {
+public:
+    KeyTimingTable();
+
+    KeyTimingStats& at(uint32_t channel);
+    const std::vector<KeyTimingStats>& rows() const { return m_rows; }
+
+private:
+    std::vector<uint16_t>       m_slot;    // per channel, 0xFFFF if unused
+    std::vector<KeyTimingStats> m_rows;
+};
+
+// Single pass over a session. Open downs live in dense arrays indexed by
+// press channel, so an event costs O(1) whatever the number of keys.
+// Group 0 is the whole session; groups 1..n are games (see setGames).
+class KeyTimingAggregator {
+public:
+    explicit KeyTimingAggregator(const KeyTimingOptions& options = KeyTimingOptions());
+
+    // Game time ranges (game g is [starts[g-1], ends[g-1]]), sorted
+    void setGames(const std::vector<uint32_t>& starts, const std::vector<uint32_t>& ends);
+
+    void onEvent(const SessionEvent& evt);
+    void finish();     // presses still open count as missing ups
+
+    size_t groups() const { return m_tables.size(); }
+    const KeyTimingTable& group(size_t index) const { return m_tables[index]; }
+
+private:
+    size_t gameAt(uint32_t t);
+    void closeOpen(uint32_t channel);
+
+private:
+    KeyTimingOptions            m_options;
+    std::vector<KeyTimingTable> m_tables;
+    std::vector<uint32_t>       m_gameStarts, m_gameEnds;
+    size_t                      m_gameCursor = 0;
+
+    // Dense per-channel state
+    std::vector<uint8_t>        m_open;
+    std::vector<uint32_t>       m_downAt;
+    std::vector<uint32_t>       m_lastDownAt;   // press or repeat
+    std::vector<uint8_t>        m_hasPress;
+    std::vector<uint32_t>       m_lastPressAt;
+    std::vector<uint32_t>       m_pressGame;    // game the open press belongs to
+};
+
+// One session; with byGame the games come from the segment index
+// (built and saved next to the session if needed)
+bool aggregateKeyTiming(const std::string& path, const KeyTimingOptions& options, bool byGame,
+    KeyTimingAggregator& out);
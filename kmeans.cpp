@@ -0,0 +1,318 @@
+#include "kmeans.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <thread>
+
+#include "simd.h"
+
+//----------------------------------------------------//
+//      Centroid Table (transposed for SIMD)
+//----------------------------------------------------//
+
+namespace {
+
+// Centroids stored dimension-major and padded to a multiple of four, so the
+// distance from one point to four centroids is a handful of vector ops.
+class CentroidTable {
+public:
+    CentroidTable(size_t k, size_t dim)
+        : m_k(k), m_dim(dim), m_kPadded((k + 3) & ~static_cast<size_t>(3)),
+          m_soa(dim * m_kPadded, kPadValue)
+    {
+    }
+
+    void set(const std::vector<float>& centroids)
+    {
+        for (size_t c = 0; c < m_k; ++c) {
+            for (size_t j = 0; j < m_dim; ++j) {
+                m_soa[j * m_kPadded + c] = centroids[c * m_dim + j];
+            }
+        }
+    }
+
+    // Index of the closest centroid and its squared distance
+    uint32_t nearest(const float* x, float& bestDist) const
+    {
+        uint32_t best = 0;
+        bestDist = std::numeric_limits<float>::infinity();
+        alignas(16) float dist[4];
+
+        for (size_t c = 0; c < m_kPadded; c += 4) {
+#if SKILLSHOT_SSE2
+            __m128 acc = _mm_setzero_ps();
+            for (size_t j = 0; j < m_dim; ++j) {
+                __m128 diff = _mm_sub_ps(_mm_loadu_ps(&m_soa[j * m_kPadded + c]), _mm_set1_ps(x[j]));
+                acc = _mm_add_ps(acc, _mm_mul_ps(diff, diff));
+            }
+            _mm_store_ps(dist, acc);
+#else
+            dist[0] = dist[1] = dist[2] = dist[3] = 0.0f;
+            for (size_t j = 0; j < m_dim; ++j) {
+                const float* row = &m_soa[j * m_kPadded + c];
+                for (int l = 0; l < 4; ++l) {
+                    float diff = row[l] - x[j];
+                    dist[l] += diff * diff;
+                }
+            }
+#endif
+            for (int l = 0; l < 4; ++l) {
+                if (dist[l] < bestDist) {
+                    bestDist = dist[l];
+                    best = static_cast<uint32_t>(c + l);
+                }
+            }
+        }
+        return best;
+    }
+
+private:
+    // Padding lanes are far enough away to never win
+    static constexpr float kPadValue = 1e18f;
+
+    size_t             m_k;
+    size_t             m_dim;
+    size_t             m_kPadded;
+    std::vector<float> m_soa;
+};
+
+constexpr float CentroidTable::kPadValue;
+
+static float squaredDistance(const float* a, const float* b, size_t dim)
+{
+    float s = 0.0f;
+    for (size_t j = 0; j < dim; ++j) {
+        float d = a[j] - b[j];
+        s += d * d;
+    }
+    return s;
+}
+
+// Runs fn(begin, end, threadIndex) over [0, count) split across threads
+template <typename Fn>
+static void parallelChunks(size_t count, unsigned threads, Fn fn)
+{
+    threads = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(count / 4096 + 1)));
+    if (threads == 1) {
+        fn(static_cast<size_t>(0), count, 0u);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    const size_t chunk = (count + threads - 1) / threads;
+    for (unsigned t = 0; t < threads; ++t) {
+        size_t begin = std::min(count, t * chunk);
+        size_t end = std::min(count, begin + chunk);
+        workers.emplace_back(fn, begin, end, t);
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+}
+
+} // namespace
+
+//----------------------------------------------------//
+//                 k-means++ Seeding
+//----------------------------------------------------//
+
+static void seedPlusPlus(const std::vector<float>& data, size_t n, size_t dim,
+    const KMeansOptions& options, std::mt19937& rng, std::vector<float>& centroids)
+{
+    // Seed on a uniform sample when the corpus is huge
+    std::vector<size_t> sample;
+    if (n <= options.seedSampleSize) {
+        sample.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            sample[i] = i;
+        }
+    }
+    else {
+        std::uniform_int_distribution<size_t> pick(0, n - 1);
+        sample.resize(options.seedSampleSize);
+        for (auto& s : sample) {
+            s = pick(rng);
+        }
+    }
+
+    centroids.assign(options.k * dim, 0.0f);
+    std::uniform_int_distribution<size_t> first(0, sample.size() - 1);
+    std::copy_n(&data[sample[first(rng)] * dim], dim, centroids.begin());
+
+    std::vector<double> d2(sample.size(), std::numeric_limits<double>::infinity());
+    for (size_t c = 1; c < options.k; ++c) {
+        // Distances to the newest centroid only
+        const float* latest = &centroids[(c - 1) * dim];
+        double total = 0.0;
+        for (size_t i = 0; i < sample.size(); ++i) {
+            double d = squaredDistance(&data[sample[i] * dim], latest, dim);
+            d2[i] = std::min(d2[i], d);
+            total += d2[i];
+        }
+
+        // Next centroid with probability proportional to D^2
+        size_t chosen = sample.size() - 1;
+        if (total > 0.0) {
+            double target = std::uniform_real_distribution<double>(0.0, total)(rng);
+            for (size_t i = 0; i < sample.size(); ++i) {
+                target -= d2[i];
+                if (target <= 0.0) {
+                    chosen = i;
+                    break;
+                }
+            }
+        }
+        else {
+            chosen = first(rng); // all points identical
+        }
+        std::copy_n(&data[sample[chosen] * dim], dim, centroids.begin() + c * dim);
+    }
+}
+
+//----------------------------------------------------//
+//                   Main Loop
+//----------------------------------------------------//
+
+// Full assignment pass: assignments, per-cluster sums/counts and inertia
+static double assignAll(const std::vector<float>& data, size_t n, size_t dim, size_t k,
+    const CentroidTable& table, unsigned threads, std::vector<uint32_t>& assignments,
+    std::vector<double>& sums, std::vector<uint32_t>& counts)
+{
+    std::vector<std::vector<double>> localSums(threads, std::vector<double>(k * dim, 0.0));
+    std::vector<std::vector<uint32_t>> localCounts(threads, std::vector<uint32_t>(k, 0));
+    std::vector<double> localInertia(threads, 0.0);
+
+    parallelChunks(n, threads, [&](size_t begin, size_t end, unsigned t) {
+        std::vector<double>& s = localSums[t];
+        std::vector<uint32_t>& cnt = localCounts[t];
+        double inertia = 0.0;
+        for (size_t i = begin; i < end; ++i) {
+            const float* x = &data[i * dim];
+            float dist = 0.0f;
+            uint32_t c = table.nearest(x, dist);
+            assignments[i] = c;
+            ++cnt[c];
+            inertia += dist;
+            for (size_t j = 0; j < dim; ++j) {
+                s[c * dim + j] += x[j];
+            }
+        }
+        localInertia[t] = inertia;
+    });
+
+    sums.assign(k * dim, 0.0);
+    counts.assign(k, 0);
+    double inertia = 0.0;
+    for (unsigned t = 0; t < threads; ++t) {
+        for (size_t i = 0; i < k * dim; ++i) {
+            sums[i] += localSums[t][i];
+        }
+        for (size_t c = 0; c < k; ++c) {
+            counts[c] += localCounts[t][c];
+        }
+        inertia += localInertia[t];
+    }
+    return inertia;
+}
+
+bool runKMeans(const std::vector<float>& data, size_t dim, const KMeansOptions& options,
+    KMeansResult& result)
+{
+    const size_t n = dim == 0 ? 0 : data.size() / dim;
+    const size_t k = options.k;
+    if (k == 0 || n < k) {
+        std::cerr << "k-means needs at least k = " << k << " points (got " << n << ").\n";
+        return false;
+    }
+    const unsigned threads = std::max(1u, options.threads);
+
+    std::mt19937 rng(options.seed);
+    std::vector<float> centroids;
+    seedPlusPlus(data, n, dim, options, rng, centroids);
+
+    CentroidTable table(k, dim);
+    table.set(centroids);
+
+    std::vector<uint32_t> assignments(n, 0);
+    std::vector<double> sums;
+    std::vector<uint32_t> counts;
+    size_t iteration = 0;
+
+    if (options.batchSize == 0) {
+        // Lloyd: assign everything, move each centroid to its mean
+        for (; iteration < options.maxIterations; ++iteration) {
+            assignAll(data, n, dim, k, table, threads, assignments, sums, counts);
+
+            double maxShift = 0.0;
+            for (size_t c = 0; c < k; ++c) {
+                if (counts[c] == 0) {
+                    continue; // empty cluster keeps its position
+                }
+                double shift = 0.0;
+                for (size_t j = 0; j < dim; ++j) {
+                    float updated = static_cast<float>(sums[c * dim + j] / counts[c]);
+                    double d = updated - centroids[c * dim + j];
+                    shift += d * d;
+                    centroids[c * dim + j] = updated;
+                }
+                maxShift = std::max(maxShift, std::sqrt(shift));
+            }
+            table.set(centroids);
+            if (maxShift <= options.tolerance) {
+                ++iteration;
+                break;
+            }
+        }
+    }
+    else {
+        // Mini-batch (Sculley 2010): per-centroid learning rate 1 / (points seen)
+        std::vector<uint64_t> seen(k, 0);
+        std::vector<size_t> batch(std::min(options.batchSize, n));
+        std::vector<uint32_t> batchAssign(batch.size());
+        std::uniform_int_distribution<size_t> pick(0, n - 1);
+
+        for (; iteration < options.maxIterations; ++iteration) {
+            for (auto& b : batch) {
+                b = pick(rng);
+            }
+            parallelChunks(batch.size(), threads, [&](size_t begin, size_t end, unsigned) {
+                for (size_t i = begin; i < end; ++i) {
+                    float dist = 0.0f;
+                    batchAssign[i] = table.nearest(&data[batch[i] * dim], dist);
+                }
+            });
+
+            double maxShift = 0.0;
+            for (size_t i = 0; i < batch.size(); ++i) {
+                uint32_t c = batchAssign[i];
+                double eta = 1.0 / static_cast<double>(++seen[c]);
+                const float* x = &data[batch[i] * dim];
+                double shift = 0.0;
+                for (size_t j = 0; j < dim; ++j) {
+                    float& cj = centroids[c * dim + j];
+                    double step = eta * (x[j] - cj);
+                    cj += static_cast<float>(step);
+                    shift += step * step;
+                }
+                maxShift = std::max(maxShift, std::sqrt(shift));
+            }
+            table.set(centroids);
+            if (maxShift <= options.tolerance) {
+                ++iteration;
+                break;
+            }
+        }
+    }
+
+    // Final assignment against the converged centroids
+    result.dim = dim;
+    result.inertia = assignAll(data, n, dim, k, table, threads, assignments, sums, counts);
+    result.centroids = centroids;
+    result.counts = counts;
+    result.assignments.swap(assignments);
+    result.iterations = iteration;
+    return true;
+}
@@ -0,0 +1,38 @@
+// kmeans.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------//
+//                k-Means Clustering
+//----------------------------------------------------//
+
+struct KMeansOptions
+{
+    size_t   k              = 8;
+    size_t   maxIterations  = 100;
+    double   tolerance      = 1e-4;   // stop when no centroid moves more than this
+    size_t   batchSize      = 0;      // 0 = full Lloyd iterations, else mini-batch size
+    size_t   seedSampleSize = 100000; // k-means++ seeding runs on at most this many points
+    unsigned threads        = 4;
+    uint32_t seed           = 1;
+};
+
+struct KMeansResult
+{
+    size_t                dim = 0;
+    std::vector<float>    centroids;    // k * dim, row-major
+    std::vector<uint32_t> counts;       // points per cluster
+    std::vector<uint32_t> assignments;  // cluster of each input point
+    double                inertia = 0;  // sum of squared distances to the assigned centroid
+    size_t                iterations = 0;
+};
+
+// Clusters 'data' (row-major, n = data.size() / dim points) with k-means++
+// seeding followed by Lloyd or mini-batch iterations. Distances to all
+// centroids are computed four at a time with SSE; assignment passes are
+// split across threads. Returns false if there are fewer points than k.
+bool runKMeans(const std::vector<float>& data, size_t dim, const KMeansOptions& options,
+    KMeansResult& result);
@@ -0,0 +1,366 @@
+#include "live_analysis.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+
+static int64_t steadyMicros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//----------------------------------------------------//
+//              FlickTracker Implementation
+//----------------------------------------------------//
+
+FlickTracker::FlickTracker(const FlickOptions& options)
+    : m_options(options)
+{
+}
+
+bool FlickTracker::close(Flick& done)
+{
+    m_inFlick = false;
+    if (m_current.distancePx < m_options.minDistancePx) {
+        return false;
+    }
+    done = m_current;
+    return true;
+}
+
+bool FlickTracker::onSample(const PathPoint& p, Flick& done)
+{
+    if (!m_hasLast) {
+        m_last = p;
+        m_hasLast = true;
+        return false;
+    }
+
+    bool ended = false;
+    const double step = std::hypot(static_cast<double>(p.x) - m_last.x,
+        static_cast<double>(p.y) - m_last.y);
+    const uint32_t dt = p.timestamp - m_last.timestamp;
+
+    if (dt == 0) {
+        // Same timer tick: no speed to measure, keep the distance
+        if (m_inFlick) {
+            m_current.distancePx += step;
+            m_current.to = p;
+        }
+    }
+    else if (dt > m_options.maxGapMs) {
+        if (m_inFlick) {
+            ended = close(done);
+        }
+    }
+    else {
+        const double speed = step / dt;
+        if (speed >= m_options.minSpeedPxPerMs) {
+            if (!m_inFlick) {
+                m_inFlick = true;
+                m_current = Flick();
+                m_current.startMs = m_last.timestamp;
+                m_current.from = m_last;
+            }
+            m_current.distancePx += step;
+            m_current.peakSpeedPxPerMs = std::max(m_current.peakSpeedPxPerMs, speed);
+            m_current.to = p;
+            m_current.endMs = p.timestamp;
+        }
+        else if (m_inFlick) {
+            ended = close(done); // the cursor landed at the previous sample
+        }
+    }
+
+    m_last = p;
+    return ended;
+}
+
+bool FlickTracker::onIdle(uint32_t nowMs, Flick& done)
+{
+    if (m_inFlick && nowMs - m_last.timestamp > m_options.maxGapMs) {
+        return close(done);
+    }
+    return false;
+}
+
+//----------------------------------------------------//
+//                 Operator Implementations
+//----------------------------------------------------//
+
+FlickOperator::FlickOperator(const FlickOptions& options)
+    : m_tracker(options)
+{
+}
+
+void FlickOperator::report(const Flick& f, std::vector<LiveResult>& out)
+{
+    std::ostringstream oss;
+    oss << static_cast<int>(f.distancePx) << " px in " << (f.endMs - f.startMs) << " ms"
+        << " (" << f.from.x << "," << f.from.y << " -> " << f.to.x << "," << f.to.y
+        << ", peak " << static_cast<int>(f.peakSpeedPxPerMs * 1000.0) << " px/s)";
+    out.push_back(LiveResult{ name(), f.startMs, f.endMs, f.distancePx, oss.str() });
+}
+
+void FlickOperator::onEvent(const SessionEvent& evt, std::vector<LiveResult>& out)
+{
+    if (evt.kind != EventKind::MousePos) {
+        return;
+    }
+    Flick f;
+    if (m_tracker.onSample(PathPoint{ evt.x, evt.y, evt.timestamp }, f)) {
+        report(f, out);
+    }
+}
+
+void FlickOperator::onIdle(uint32_t nowMs, std::vector<LiveResult>& out)
+{
+    Flick f;
+    if (m_tracker.onIdle(nowMs, f)) {
+        report(f, out);
+    }
+}
+
+ReactionTimeOperator::ReactionTimeOperator(const std::vector<uint32_t>& castKeys,
+    uint32_t maxDelayMs, const FlickOptions& options)
+    : m_castKeys(castKeys), m_maxDelayMs(maxDelayMs), m_tracker(options)
+{
+}
+
+void ReactionTimeOperator::onEvent(const SessionEvent& evt, std::vector<LiveResult>& out)
+{
+    if (evt.kind == EventKind::MousePos) {
+        Flick f;
+        if (m_tracker.onSample(PathPoint{ evt.x, evt.y, evt.timestamp }, f)) {
+            m_landing = f;
+            m_hasLanding = true;
+        }
+        return;
+    }
+
+    const bool newPress = m_pressFilter.isNewPress(evt);
+    if (!newPress || evt.kind != EventKind::KeyDown || !m_hasLanding || m_tracker.inFlick() ||
+        std::find(m_castKeys.begin(), m_castKeys.end(), evt.keyCode) == m_castKeys.end()) {
+        return;
+    }
+
+    // One cast per landing; later presses are not reactions to it
+    m_hasLanding = false;
+    const uint32_t delay = evt.timestamp - m_landing.endMs;
+    if (delay > m_maxDelayMs) {
+        return;
+    }
+
+    std::ostringstream oss;
+    oss << vkToKeyName(evt.keyCode) << " " << delay << " ms after a "
+        << static_cast<int>(m_landing.distancePx) << " px flick";
+    out.push_back(LiveResult{ name(), m_landing.endMs, evt.timestamp,
+        static_cast<double>(delay), oss.str() });
+}
+
+void ReactionTimeOperator::onIdle(uint32_t nowMs, std::vector<LiveResult>&)
+{
+    Flick f;
+    if (m_tracker.onIdle(nowMs, f)) {
+        m_landing = f;
+        m_hasLanding = true;
+    }
+}
+
+SpamOperator::SpamOperator(const PanicRule& rule)
+    : m_detector(rule)
+{
+}
+
+void SpamOperator::report(std::vector<LiveResult>& out)
+{
+    for (const auto& ep : m_episodes) {
+        std::ostringstream oss;
+        oss << channelName(ep.channel) << " x" << ep.pressCount
+            << " over " << (ep.endMs - ep.startMs) << " ms"
+            << " (peak " << ep.peakRateHz << "/s, intensity " << ep.intensity << ")";
+        out.push_back(LiveResult{ name(), ep.startMs, ep.endMs,
+            static_cast<double>(ep.pressCount), oss.str() });
+    }
+    m_episodes.clear();
+}
+
+void SpamOperator::onEvent(const SessionEvent& evt, std::vector<LiveResult>& out)
+{
+    m_detector.onEvent(evt, m_episodes);
+    report(out);
+}
+
+void SpamOperator::onIdle(uint32_t nowMs, std::vector<LiveResult>& out)
+{
+    // A non-press event only lets time pass
+    SessionEvent tick{ nowMs, EventKind::Unknown, 0, 0, 0 };
+    m_detector.onEvent(tick, m_episodes);
+    report(out);
+}
+
+//----------------------------------------------------//
+//             LiveAnalyzer Implementation
+//----------------------------------------------------//
+
+LiveAnalyzer::LiveAnalyzer(const LiveOptions& options, ResultSink sink)
+    : m_options(options), m_sink(std::move(sink))
+{
+    if (m_options.latencyMs == 0) {
+        m_options.latencyMs = 1;
+    }
+    m_ring.resize(std::max<size_t>(2, m_options.queueCapacity));
+}
+
+LiveAnalyzer::~LiveAnalyzer()
+{
+    stop();
+}
+
+void LiveAnalyzer::addOperator(std::unique_ptr<LiveOperator> op)
+{
+    m_operators.push_back(std::move(op));
+}
+
+void LiveAnalyzer::start()
+{
+    if (m_running.load()) {
+        return;
+    }
+    m_running.store(true);
+    m_thread = std::thread(&LiveAnalyzer::threadFunc, this);
+}
+
+void LiveAnalyzer::stop()
+{
+    if (!m_running.load()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_running.store(false);
+    }
+    m_wake.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+bool LiveAnalyzer::push(const SessionEvent& evt)
+{
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    const size_t next = (head + 1) % m_ring.size();
+    if (next == m_tail.load(std::memory_order_acquire)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_ring[head].evt = evt;
+    m_ring[head].enqueuedUs = steadyMicros();
+    m_head.store(next, std::memory_order_release);
+    return true;
+}
+
+LiveStats LiveAnalyzer::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    LiveStats s = m_stats;
+    s.dropped = m_dropped.load();
+    return s;
+}
+
+size_t LiveAnalyzer::drain(std::vector<LiveResult>& results)
+{
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    const size_t head = m_head.load(std::memory_order_acquire);
+    if (tail == head) {
+        return 0;
+    }
+
+    size_t count = 0;
+    int64_t oldestUs = 0;
+    int64_t sinceOldestUs = 0; // sum of enqueue times relative to the oldest
+    while (tail != head) {
+        const Slot& slot = m_ring[tail];
+        for (auto& op : m_operators) {
+            op->onEvent(slot.evt, results);
+        }
+        m_hasClock = true;
+        m_lastEventMs = slot.evt.timestamp;
+        m_lastEventUs = slot.enqueuedUs;
+        if (count == 0) {
+            oldestUs = slot.enqueuedUs;
+        }
+        sinceOldestUs += slot.enqueuedUs - oldestUs;
+        ++count;
+        tail = (tail + 1) % m_ring.size();
+    }
+    m_tail.store(tail, std::memory_order_release);
+
+    // Latency = time from push() until the operators were done with the event
+    const int64_t nowUs = steadyMicros();
+    const double latencySumMs =
+        (static_cast<int64_t>(count) * (nowUs - oldestUs) - sinceOldestUs) / 1000.0;
+    const double worstMs = (nowUs - oldestUs) / 1000.0;
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_stats.events += count;
+    m_latencySumMs += latencySumMs;
+    m_stats.meanLatencyMs = m_latencySumMs / m_stats.events;
+    m_stats.maxLatencyMs = std::max(m_stats.maxLatencyMs, worstMs);
+    if (worstMs > m_options.latencyMs) {
+        // Only the events enqueued before the budget ran out are late, but
+        // counting the batch keeps the hot loop free of per-event clocks
+        m_stats.overBudget += count;
+    }
+    return count;
+}
+
+void LiveAnalyzer::publish(std::vector<LiveResult>& results)
+{
+    if (results.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_stats.results += results.size();
+    }
+    if (m_sink) {
+        for (const auto& r : results) {
+            m_sink(r);
+        }
+    }
+    results.clear();
+}
+
+void LiveAnalyzer::threadFunc()
+{
+    const auto tick = std::chrono::microseconds(
+        std::max<uint32_t>(1, m_options.latencyMs * 1000 / 4));
+    std::vector<LiveResult> results;
+
+    while (m_running.load()) {
+        if (drain(results) == 0 && m_hasClock) {
+            // Advance the event clock by the wall time since the last event
+            const uint32_t nowMs = m_lastEventMs +
+                static_cast<uint32_t>((steadyMicros() - m_lastEventUs) / 1000);
+            for (auto& op : m_operators) {
+                op->onIdle(nowMs, results);
+            }
+        }
+        publish(results);
+
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_wake.wait_for(lock, tick, [this]() { return !m_running.load(); });
+    }
+
+    // Final drain, then close whatever is still open
+    drain(results);
+    if (m_hasClock) {
+        for (auto& op : m_operators) {
+            op->onIdle(UINT32_MAX, results);
+        }
+    }
+    publish(results);
+}
@@ -0,0 +1,220 @@
+// live_analysis.h
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "session_event.h"
+#include "panic_detector.h"
+#include "path_simplify.h"
+
+//----------------------------------------------------//
+//                  Live Operators
+//----------------------------------------------------//
+
+// One finding of a live operator
+struct LiveResult
+{
+    const char* op;       // operator name ("flick", "reaction", "spam")
+    uint32_t    startMs;  // event time span the result covers
+    uint32_t    endMs;
+    double      value;    // main measurement (px, ms, presses)
+    std::string text;     // human-readable details
+};
+
+// Incremental analyzer over the live event stream. Operators only ever run on
+// the analysis thread, so they need no locking of their own.
+class LiveOperator {
+public:
+    virtual ~LiveOperator() {}
+
+    virtual const char* name() const = 0;
+    virtual void onEvent(const SessionEvent& evt, std::vector<LiveResult>& out) = 0;
+
+    // The event clock moved to 'nowMs' without new events; lets operators
+    // close what timed out instead of waiting for the next input
+    virtual void onIdle(uint32_t nowMs, std::vector<LiveResult>& out) = 0;
+};
+
+struct FlickOptions
+{
+    double   minSpeedPxPerMs = 1.5;   // cursor speed that counts as flicking
+    double   minDistancePx   = 120.0; // shorter fast moves are jitter
+    uint32_t maxGapMs        = 100;   // sample gap that ends a flick
+};
+
+struct Flick
+{
+    uint32_t startMs;
+    uint32_t endMs;
+    PathPoint from;
+    PathPoint to;
+    double   distancePx;     // travelled, not just net displacement
+    double   peakSpeedPxPerMs;
+};
+
+// Segments the cursor track into flicks (shared by the flick and reaction
+// operators)
+class FlickTracker {
+public:
+    explicit FlickTracker(const FlickOptions& options = FlickOptions());
+
+    // Returns true and fills 'done' when a flick ended before this sample
+    bool onSample(const PathPoint& p, Flick& done);
+    bool onIdle(uint32_t nowMs, Flick& done);
+
+    bool inFlick() const { return m_inFlick; }
+
+private:
+    bool close(Flick& done);
+
+private:
+    FlickOptions m_options;
+    bool         m_hasLast = false;
+    PathPoint    m_last{};
+    bool         m_inFlick = false;
+    Flick        m_current{};
+};
+
+// Reports fast, long cursor moves
+class FlickOperator : public LiveOperator {
+public:
+    explicit FlickOperator(const FlickOptions& options = FlickOptions());
+
+    const char* name() const override { return "flick"; }
+    void onEvent(const SessionEvent& evt, std::vector<LiveResult>& out) override;
+    void onIdle(uint32_t nowMs, std::vector<LiveResult>& out) override;
+
+private:
+    void report(const Flick& f, std::vector<LiveResult>& out);
+
+private:
+    FlickTracker m_tracker;
+};
+
+// Flick-to-cast reaction time: delay between the cursor landing (end of a
+// flick) and the next cast key press
+class ReactionTimeOperator : public LiveOperator {
+public:
+    ReactionTimeOperator(const std::vector<uint32_t>& castKeys,
+        uint32_t maxDelayMs = 1000,
+        const FlickOptions& options = FlickOptions());
+
+    const char* name() const override { return "reaction"; }
+    void onEvent(const SessionEvent& evt, std::vector<LiveResult>& out) override;
+    void onIdle(uint32_t nowMs, std::vector<LiveResult>& out) override;
+
+private:
+    std::vector<uint32_t> m_castKeys;
+    uint32_t              m_maxDelayMs;
+    FlickTracker          m_tracker;
+    PressFilter           m_pressFilter;
+    bool                  m_hasLanding = false;
+    Flick                 m_landing{};
+};
+
+// Press spam on a single key or button (PanicDetector on the live stream)
+class SpamOperator : public LiveOperator {
+public:
+    explicit SpamOperator(const PanicRule& rule = PanicRule());
+
+    const char* name() const override { return "spam"; }
+    void onEvent(const SessionEvent& evt, std::vector<LiveResult>& out) override;
+    void onIdle(uint32_t nowMs, std::vector<LiveResult>& out) override;
+
+private:
+    void report(std::vector<LiveResult>& out);
+
+private:
+    PanicDetector             m_detector;
+    std::vector<PanicEpisode> m_episodes;
+};
+
+//----------------------------------------------------//
+//              Live Analysis Thread
+//----------------------------------------------------//
+
+struct LiveOptions
+{
+    uint32_t latencyMs     = 50;       // target delay from capture to result
+    size_t   queueCapacity = 1 << 16;  // events buffered between capture and analysis
+};
+
+struct LiveStats
+{
+    uint64_t events = 0;        // processed by the operators
+    uint64_t dropped = 0;       // lost because the queue was full
+    uint64_t results = 0;
+    uint64_t overBudget = 0;    // events that waited longer than latencyMs
+    double   maxLatencyMs = 0.0;
+    double   meanLatencyMs = 0.0;
+};
+
+// Runs operators on their own thread, fed by a bounded single-producer
+// ring. push() never blocks and never allocates: if analysis falls behind,
+// events are dropped (and counted) instead of stalling the hooks. The thread
+// wakes every latencyMs / 4, so results show up well within the bound.
+class LiveAnalyzer {
+public:
+    using ResultSink = std::function<void(const LiveResult&)>;
+
+    LiveAnalyzer(const LiveOptions& options, ResultSink sink);
+    ~LiveAnalyzer();
+
+    LiveAnalyzer(const LiveAnalyzer&) = delete;
+    LiveAnalyzer& operator=(const LiveAnalyzer&) = delete;
+
+    // Call before start()
+    void addOperator(std::unique_ptr<LiveOperator> op);
+
+    void start();
+    void stop();    // drains the queue, then lets operators close open results
+
+    // Producer side. Callers must serialize pushes (one producer at a time).
+    bool push(const SessionEvent& evt);
+
+    LiveStats stats() const;
+
+private:
+    struct Slot
+    {
+        SessionEvent evt;
+        int64_t      enqueuedUs;
+    };
+
+    void threadFunc();
+    size_t drain(std::vector<LiveResult>& results);
+    void publish(std::vector<LiveResult>& results);
+
+private:
+    LiveOptions                                m_options;
+    ResultSink                                 m_sink;
+    std::vector<std::unique_ptr<LiveOperator>> m_operators;
+
+    // Ring: the producer owns m_head, the analysis thread owns m_tail
+    std::vector<Slot>                          m_ring;
+    std::atomic<size_t>                        m_head{ 0 };
+    std::atomic<size_t>                        m_tail{ 0 };
+    std::atomic<uint64_t>                      m_dropped{ 0 };
+
+    std::atomic<bool>                          m_running{ false };
+    std::thread                                m_thread;
+    std::mutex                                 m_wakeMutex;
+    std::condition_variable                    m_wake;
+
+    // Event clock for idle ticks (analysis thread only)
+    bool                                       m_hasClock = false;
+    uint32_t                                   m_lastEventMs = 0;
+    int64_t                                    m_lastEventUs = 0;
+
+    mutable std::mutex                         m_statsMutex;
+    LiveStats                                  m_stats;
+    double                                     m_latencySumMs = 0.0;
+};
@@ -0,0 +1,211 @@
+#include "movement_entropy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <utility>
+
+#include "session_reader.h"
+
+//----------------------------------------------------//
+//          MovementSymbolizer Implementation
+//----------------------------------------------------//
+
+MovementSymbolizer::MovementSymbolizer(const MovementSymbolOptions& options)
+    : m_options(options)
+{
+}
+
+bool MovementSymbolizer::onSample(int32_t x, int32_t y, uint32_t t, uint8_t& symbol)
+{
+    if (!m_hasLast) {
+        m_hasLast = true;
+        m_lastX = x;
+        m_lastY = y;
+        m_lastT = t;
+        return false;
+    }
+    if (t == m_lastT) {
+        return false;   // same timer tick: wait for the next one
+    }
+
+    const double dx = static_cast<double>(x) - m_lastX;
+    const double dy = static_cast<double>(y) - m_lastY;
+    const double step = std::sqrt(dx * dx + dy * dy);
+    const bool gap = t < m_lastT || t - m_lastT > m_options.maxGapMs;
+    m_lastX = x;
+    m_lastY = y;
+    m_lastT = t;
+
+    if (gap || step < m_options.restPx) {
+        if (m_resting) {
+            return false;
+        }
+        m_resting = true;
+        symbol = kRestSymbol;
+        return true;
+    }
+    m_resting = false;
+
+    // Heading sector 0..7, counter-clockwise from +x, centered on the axes
+    const double pi = 3.14159265358979323846;
+    const int sector = static_cast<int>(std::floor((std::atan2(dy, dx) + pi / 8.0) / (pi / 4.0)) + 8) % 8;
+    const int size = step < m_options.mediumPx ? 0 : (step < m_options.fastPx ? 1 : 2);
+    symbol = static_cast<uint8_t>(1 + sector * 3 + size);
+    return true;
+}
+
+//----------------------------------------------------//
+//             EntropyModel Implementation
+//----------------------------------------------------//
+
+EntropyModel::EntropyModel(const EntropyOptions& options)
+    : m_options(options)
+{
+    m_options.maxOrder = std::min<size_t>(m_options.maxOrder, 7);
+    m_options.tableBits = std::max<size_t>(4, std::min<size_t>(m_options.tableBits, 24));
+    m_options.countLimit = std::max<uint16_t>(m_options.countLimit, 2);
+    m_slots.assign(1 + (m_options.maxOrder << m_options.tableBits), Slot());
+    m_weights.assign(m_options.maxOrder + 1, 1.0 / (m_options.maxOrder + 1));
+}
+
+double EntropyModel::maxBitsPerSymbol()
+{
+    return std::log2(static_cast<double>(kMovementSymbols));
+}
+
+EntropyModel::Slot& EntropyModel::slotFor(size_t order)
+{
+    if (order == 0) {
+        return m_slots[0];
+    }
+    const uint64_t context = m_history & ((static_cast<uint64_t>(1) << (8 * order)) - 1);
+    const uint64_t h = (context + 1) * 0x9E3779B97F4A7C15ull ^ (order * 0xC2B2AE3D27D4EB4Full);
+    const size_t index = 1 + ((order - 1) << m_options.tableBits) +
+        static_cast<size_t>(h >> (64 - m_options.tableBits));
+    const uint32_t tag = static_cast<uint32_t>(h) | 1;   // 0 marks an empty slot
+
+    Slot& slot = m_slots[index];
+    if (slot.tag != tag) {
+        // Someone else's context (or empty): the newer one takes the slot
+        slot = Slot();
+        slot.tag = tag;
+    }
+    return slot;
+}
+
+void EntropyModel::learn(Slot& slot, uint8_t symbol, uint16_t limit)
+{
+    ++slot.counts[symbol];
+    ++slot.total;
+    if (slot.counts[symbol] >= limit) {
+        slot.total = 0;
+        for (auto& c : slot.counts) {
+            c = static_cast<uint16_t>(c / 2);
+            slot.total = static_cast<uint16_t>(slot.total + c);
+        }
+    }
+}
+
+double EntropyModel::code(uint8_t symbol)
+{
+    symbol = static_cast<uint8_t>(std::min<size_t>(symbol, kMovementSymbols - 1));
+    const size_t orders = std::min(m_options.maxOrder, m_seen) + 1;
+
+    // Only the probability of the actual symbol is needed per order (KT estimate)
+    Slot* slots[8];
+    double p[8];
+    double mixed = 0.0, active = 0.0;
+    for (size_t k = 0; k < orders; ++k) {
+        slots[k] = &slotFor(k);
+        p[k] = (slots[k]->counts[symbol] + 0.5) / (slots[k]->total + 0.5 * kMovementSymbols);
+        mixed += m_weights[k] * p[k];
+        active += m_weights[k];
+    }
+    mixed /= active;
+
+    // Posterior weights, then a little leaked back to every order so a
+    // model that was wrong for a while can take over again
+    const double share = m_options.share / m_weights.size();
+    double total = 0.0;
+    for (size_t k = 0; k < m_weights.size(); ++k) {
+        if (k < orders) {
+            m_weights[k] *= p[k] / mixed;
+        }
+        total += m_weights[k];
+    }
+    for (auto& w : m_weights) {
+        w = (1.0 - m_options.share) * w / total + share;
+    }
+
+    for (size_t k = 0; k < orders; ++k) {
+        learn(*slots[k], symbol, m_options.countLimit);
+    }
+    m_history = (m_history << 8) | symbol;
+    ++m_seen;
+    return -std::log2(mixed);
+}
+
+//----------------------------------------------------//
+//                 Session Analysis
+//----------------------------------------------------//
+
+double PredictabilityReport::score(double bits, uint64_t symbols)
+{
+    if (symbols == 0) {
+        return 0.0;
+    }
+    return std::max(0.0, 1.0 - bits / symbols / EntropyModel::maxBitsPerSymbol());
+}
+
+bool analyzeMovementPredictability(const std::string& path, const PredictabilityOptions& options,
+    PredictabilityReport& out)
+{
+    out = PredictabilityReport();
+    MovementSymbolizer symbolizer(options.symbols);
+    EntropyModel model(options.model);
+    const uint32_t windowMs = std::max<uint32_t>(1, options.windowMs);
+
+    // Code lengths of the last lookbackMs, for attributing them to casts
+    std::deque<std::pair<uint32_t, double>> recent;
+    uint32_t countedUpTo = 0;   // symbols at or before this time are already pre-cast
+    bool counted = false;
+    PressFilter presses;
+
+    bool ok = forEachSessionEvent(path, [&](const SessionEvent& evt) {
+        if (evt.kind == EventKind::MousePos) {
+            uint8_t symbol;
+            if (!symbolizer.onSample(evt.x, evt.y, evt.timestamp, symbol)) {
+                return;
+            }
+            const double bits = model.code(symbol);
+            ++out.symbols;
+            out.bits += bits;
+
+            const uint32_t windowStart = evt.timestamp - evt.timestamp % windowMs;
+            if (out.windows.empty() || out.windows.back().startMs != windowStart) {
+                out.windows.push_back(PredictabilityWindow{ windowStart, 0, 0.0 });
+            }
+            ++out.windows.back().symbols;
+            out.windows.back().bits += bits;
+
+            recent.emplace_back(evt.timestamp, bits);
+            while (!recent.empty() && evt.timestamp - recent.front().first > options.lookbackMs) {
+                recent.pop_front();
+            }
+        }
+        else if (presses.isNewPress(evt) && evt.kind == EventKind::KeyDown &&
+            std::find(options.castKeys.begin(), options.castKeys.end(), evt.keyCode) != options.castKeys.end()) {
+            ++out.casts;
+            for (const auto& r : recent) {
+                if (evt.timestamp - r.first <= options.lookbackMs && (!counted || r.first > countedUpTo)) {
+                    ++out.preCastSymbols;
+                    out.preCastBits += r.second;
+                }
+            }
+            counted = true;
+            countedUpTo = evt.timestamp;
+        }
+    });
+    return ok;
+}
@@ -0,0 +1,125 @@
+// movement_entropy.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "session_event.h"
+
+//----------------------------------------------------//
+//          Cursor Movement Symbols
+//----------------------------------------------------//
+
+// One symbol per cursor step: "resting", or one of 8 heading sectors times
+// 3 step sizes
+const size_t  kMovementSymbols = 25;
+const uint8_t kRestSymbol = 0;
+
+struct MovementSymbolOptions
+{
+    double   restPx = 3.0;       // shorter steps are resting
+    double   mediumPx = 12.0;    // step size classes (per poll, 20 ms by default)
+    double   fastPx = 40.0;
+    uint32_t maxGapMs = 100;     // longer sample gaps count as resting
+};
+
+// Turns MOUSE_POS samples into symbols. A resting stretch gives a single
+// rest symbol, so idle time does not read as "very predictable".
+class MovementSymbolizer {
+public:
+    explicit MovementSymbolizer(const MovementSymbolOptions& options = MovementSymbolOptions());
+
+    // Returns true and fills 'symbol' when the sample completes a step
+    bool onSample(int32_t x, int32_t y, uint32_t t, uint8_t& symbol);
+
+private:
+    MovementSymbolOptions m_options;
+    bool     m_hasLast = false;
+    bool     m_resting = false;
+    int32_t  m_lastX = 0, m_lastY = 0;
+    uint32_t m_lastT = 0;
+};
+
+//----------------------------------------------------//
+//            Context-Mixing Entropy Model
+//----------------------------------------------------//
+
+struct EntropyOptions
+{
+    size_t   maxOrder = 3;       // contexts of 0..maxOrder previous symbols
+    size_t   tableBits = 12;     // slots per hashed order (memory bound)
+    uint16_t countLimit = 255;   // counts halve past this: old habits fade
+    double   share = 0.002;      // weight leaked back to every order (fixed share)
+};
+
+// Online predictor over the movement alphabet. Every order keeps symbol
+// counts per context; order 0 directly, higher orders in a fixed-size hash
+// table whose slots are reclaimed on a tag mismatch. The order predictions
+// are mixed with weights that follow each order's recent coding success
+// (Bayesian mixture with fixed share). Each symbol costs
+// O(orders * alphabet), and memory is fixed by tableBits.
+class EntropyModel {
+public:
+    explicit EntropyModel(const EntropyOptions& options = EntropyOptions());
+
+    // Code length of 'symbol' in bits under the current model, then learns it
+    double code(uint8_t symbol);
+
+    static double maxBitsPerSymbol();   // log2 of the alphabet
+
+private:
+    struct Slot
+    {
+        uint32_t tag;
+        uint16_t total;
+        uint16_t counts[kMovementSymbols];
+    };
+
+    Slot& slotFor(size_t order);
+    static void learn(Slot& slot, uint8_t symbol, uint16_t limit);
+
+private:
+    EntropyOptions      m_options;
+    std::vector<Slot>   m_slots;       // order 0 first, then 2^tableBits per order
+    std::vector<double> m_weights;     // per order
+    uint64_t            m_history = 0; // last symbols, 8 bits each
+    size_t              m_seen = 0;
+};
+
+//----------------------------------------------------//
+//                Session Analysis
+//----------------------------------------------------//
+
+struct PredictabilityOptions
+{
+    MovementSymbolOptions symbols;
+    EntropyOptions        model;
+    std::vector<uint32_t> castKeys = { 'Q', 'W', 'E', 'R' };
+    uint32_t              lookbackMs = 1000;   // "pre-cast" movement window
+    uint32_t              windowMs = 60000;    // per-window rows
+};
+
+struct PredictabilityWindow
+{
+    uint32_t startMs;
+    uint64_t symbols;
+    double   bits;
+};
+
+struct PredictabilityReport
+{
+    uint64_t symbols = 0;
+    double   bits = 0.0;
+    uint64_t casts = 0;
+    uint64_t preCastSymbols = 0;    // symbols in the lookback of any cast
+    double   preCastBits = 0.0;
+    std::vector<PredictabilityWindow> windows;
+
+    // 1 - entropy rate / log2(alphabet): 0 is random, 1 fully predictable
+    static double score(double bits, uint64_t symbols);
+};
+
+bool analyzeMovementPredictability(const std::string& path, const PredictabilityOptions& options,
+    PredictabilityReport& out);
@@ -0,0 +1,197 @@
+#include "movement_states.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "session_reader.h"
+
+const char* movementStateName(MovementState state)
+{
+    switch (state) {
+    case MovementState::Idle:     return "idle";
+    case MovementState::Drifting: return "drifting";
+    case MovementState::Aiming:   return "aiming";
+    case MovementState::Kiting:   return "kiting";
+    case MovementState::Panic:    return "panic";
+    default:                      return "unknown";
+    }
+}
+
+//----------------------------------------------------//
+//                Feature Extraction
+//----------------------------------------------------//
+
+namespace {
+
+// Raw counters of one bin
+struct BinCounts
+{
+    double   distance = 0.0;
+    uint32_t right = 0;
+    uint32_t left = 0;
+    uint32_t keys = 0;
+};
+
+class FeatureBuilder {
+public:
+    FeatureBuilder(const MovementOptions& options, MovementFeatures& out)
+        : m_options(options), m_out(out),
+          m_ring(std::max<uint32_t>(1, options.rateWindowMs / std::max<uint32_t>(1, options.binMs)))
+    {
+        m_options.binMs = std::max<uint32_t>(1, m_options.binMs);
+        m_out.binMs = m_options.binMs;
+        m_out.values.clear();
+    }
+
+    void onEvent(const SessionEvent& evt)
+    {
+        if (!m_started) {
+            m_started = true;
+            m_binStart = evt.timestamp;
+            m_out.startMs = evt.timestamp;
+        }
+        // A clock that went backwards leaves the sample in the current bin
+        while (evt.timestamp >= m_binStart && evt.timestamp - m_binStart >= m_options.binMs) {
+            closeBin();
+        }
+
+        switch (evt.kind) {
+        case EventKind::MousePos:
+            if (m_hasCursor) {
+                const double dx = evt.x - m_cursorX, dy = evt.y - m_cursorY;
+                m_current.distance += std::sqrt(dx * dx + dy * dy);
+            }
+            m_hasCursor = true;
+            m_cursorX = evt.x;
+            m_cursorY = evt.y;
+            break;
+        case EventKind::MouseRightDown: ++m_current.right; break;
+        case EventKind::MouseLeftDown:  ++m_current.left; break;
+        case EventKind::KeyDown:        ++m_current.keys; break;
+        default: break;
+        }
+    }
+
+    void finish()
+    {
+        if (m_started) {
+            closeBin();
+        }
+    }
+
+private:
+    void closeBin()
+    {
+        // Trailing window sums, kept incrementally over a ring of bins
+        BinCounts& slot = m_ring[m_head];
+        m_right += m_current.right - slot.right;
+        m_left += m_current.left - slot.left;
+        m_keys += m_current.keys - slot.keys;
+        slot = m_current;
+        m_head = (m_head + 1) % m_ring.size();
+
+        const double binS = m_options.binMs / 1000.0;
+        const double windowS = binS * m_ring.size();
+        m_out.values.push_back(static_cast<float>(std::log1p(m_current.distance / binS)));
+        m_out.values.push_back(static_cast<float>(std::log1p(m_right / windowS)));
+        m_out.values.push_back(static_cast<float>(std::log1p(m_left / windowS)));
+        m_out.values.push_back(static_cast<float>(std::log1p(m_keys / windowS)));
+
+        m_current = BinCounts();
+        m_binStart += m_options.binMs;
+    }
+
+private:
+    MovementOptions        m_options;
+    MovementFeatures&      m_out;
+    std::vector<BinCounts> m_ring;
+    size_t    m_head = 0;
+    uint32_t  m_right = 0, m_left = 0, m_keys = 0;
+
+    bool      m_started = false;
+    uint32_t  m_binStart = 0;
+    BinCounts m_current;
+    bool      m_hasCursor = false;
+    int32_t   m_cursorX = 0, m_cursorY = 0;
+};
+
+} // namespace
+
+bool extractMovementFeatures(const std::string& path, const MovementOptions& options,
+    MovementFeatures& out)
+{
+    FeatureBuilder builder(options, out);
+    bool ok = forEachSessionEvent(path, [&builder](const SessionEvent& evt) {
+        builder.onEvent(evt);
+    });
+    builder.finish();
+    return ok;
+}
+
+//----------------------------------------------------//
+//                  Default Model
+//----------------------------------------------------//
+
+GaussianHmm defaultMovementModel()
+{
+    const size_t K = static_cast<size_t>(MovementState::Count);
+
+    // log1p(speed px/s), log1p(right/s), log1p(left/s), log1p(keys/s)
+    static const double kMeans[5][kMovementFeatureDims] = {
+        { 0.0, 0.0,  0.0,  0.0  },   // idle
+        { 5.0, 0.1,  0.0,  0.1  },   // drifting: ~150 px/s, hardly any input
+        { 7.6, 0.26, 0.26, 0.9  },   // aiming: ~2000 px/s, casts
+        { 6.7, 1.25, 0.26, 0.7  },   // kiting: ~2.5 right clicks/s
+        { 6.2, 1.4,  1.1,  1.95 },   // panic: ~6 keys/s and both buttons
+    };
+    static const double kVar[kMovementFeatureDims] = { 0.5, 0.1, 0.1, 0.2 };
+
+    GaussianHmm model(K, kMovementFeatureDims);
+    for (size_t k = 0; k < K; ++k) {
+        model.setEmission(k, kMeans[k], kVar);
+        model.setInitial(k, k == 0 ? 0.6 : 0.1);
+        // Sticky states: a run lasts about a second at 100 ms bins
+        for (size_t j = 0; j < K; ++j) {
+            model.setTransition(k, j, k == j ? 0.9 : 0.1 / (K - 1));
+        }
+    }
+    model.normalize();
+    return model;
+}
+
+//----------------------------------------------------//
+//                   Summaries
+//----------------------------------------------------//
+
+void summarizeMovementPath(const MovementFeatures& features, const std::vector<uint8_t>& path,
+    MovementSummary& out)
+{
+    const size_t K = static_cast<size_t>(MovementState::Count);
+    out = MovementSummary();
+    out.bins = path.size();
+    if (path.empty()) {
+        return;
+    }
+
+    uint64_t counts[K] = {}, runCounts[K] = {};
+    size_t runStart = 0;
+    for (size_t t = 1; t <= path.size(); ++t) {
+        if (t < path.size() && path[t] == path[runStart]) {
+            continue;
+        }
+        const uint8_t s = std::min<uint8_t>(path[runStart], static_cast<uint8_t>(K - 1));
+        const uint32_t startMs = features.startMs + static_cast<uint32_t>(runStart * features.binMs);
+        const uint32_t endMs = features.startMs + static_cast<uint32_t>(t * features.binMs);
+        out.runs.push_back(MovementRun{ static_cast<MovementState>(s), startMs, endMs });
+        counts[s] += t - runStart;
+        ++runCounts[s];
+        runStart = t;
+    }
+    out.switches = out.runs.size() - 1;
+    for (size_t k = 0; k < K; ++k) {
+        out.share[k] = static_cast<double>(counts[k]) / path.size();
+        if (runCounts[k] > 0) {
+            out.meanRunMs[k] = static_cast<double>(counts[k]) * features.binMs / runCounts[k];
+        }
+    }
+}
@@ -0,0 +1,71 @@
+// movement_states.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "hmm.h"
+
+//----------------------------------------------------//
+//            Movement States (HMM labels)
+//----------------------------------------------------//
+
+enum class MovementState : uint8_t {
+    Idle,
+    Drifting,   // slow cursor, little input
+    Aiming,     // fast cursor with casts
+    Kiting,     // steady right-click cadence while moving
+    Panic,      // everything pressed at once
+    Count
+};
+
+const char* movementStateName(MovementState state);
+
+struct MovementOptions
+{
+    uint32_t binMs = 100;          // one observation per bin
+    uint32_t rateWindowMs = 1000;  // trailing window for the press rates
+};
+
+// Features per bin, all log1p-scaled so they are roughly Gaussian:
+// cursor speed (px/s), right clicks/s, left clicks/s, key presses/s
+const size_t kMovementFeatureDims = 4;
+
+struct MovementFeatures
+{
+    uint32_t           startMs = 0;    // start of the first bin
+    uint32_t           binMs = 0;
+    std::vector<float> values;         // bins x kMovementFeatureDims
+
+    size_t bins() const { return values.size() / kMovementFeatureDims; }
+    HmmSequence sequence() const { return HmmSequence{ values.data(), bins() }; }
+};
+
+bool extractMovementFeatures(const std::string& path, const MovementOptions& options,
+    MovementFeatures& out);
+
+// Five states seeded from archetype means, so the state indices keep their
+// MovementState meaning through Baum-Welch
+GaussianHmm defaultMovementModel();
+
+struct MovementRun
+{
+    MovementState state;
+    uint32_t      startMs;
+    uint32_t      endMs;
+};
+
+struct MovementSummary
+{
+    uint64_t bins = 0;
+    uint64_t switches = 0;
+    double   share[static_cast<size_t>(MovementState::Count)] = {};
+    double   meanRunMs[static_cast<size_t>(MovementState::Count)] = {};
+    std::vector<MovementRun> runs;
+};
+
+// Collapses a Viterbi path into runs and per-state shares
+void summarizeMovementPath(const MovementFeatures& features, const std::vector<uint8_t>& path,
+    MovementSummary& out);
@@ -0,0 +1,125 @@
+#include "panic_detector.h"
+
+#include <algorithm>
+
+//----------------------------------------------------//
+//             PanicDetector Implementation
+//----------------------------------------------------//
+
+PanicDetector::PanicDetector(const PanicRule& rule)
+    : m_rule(rule), m_pressFilter(rule.repeatGapMs)
+{
+    if (m_rule.bucketMs == 0) {
+        m_rule.bucketMs = 1;
+    }
+    if (m_rule.triggerCount == 0) {
+        m_rule.triggerCount = 1;
+    }
+    m_bucketCount = std::max<uint32_t>(1, m_rule.windowMs / m_rule.bucketMs);
+    m_channels.resize(kChannelCount);
+}
+
+void PanicDetector::advance(Channel& ch, uint32_t bucket)
+{
+    if (bucket <= ch.headBucket) {
+        return; // same bucket (or a slightly out-of-order event)
+    }
+
+    uint32_t steps = bucket - ch.headBucket;
+    if (steps >= m_bucketCount) {
+        // Idle for a whole window: everything expired
+        std::fill(ch.counts.begin(), ch.counts.end(), 0);
+        ch.windowCount = 0;
+    }
+    else {
+        for (uint32_t k = 1; k <= steps; ++k) {
+            uint32_t slot = (ch.headBucket + k) % m_bucketCount;
+            ch.windowCount -= ch.counts[slot];
+            ch.counts[slot] = 0;
+        }
+    }
+    ch.headBucket = bucket;
+}
+
+void PanicDetector::closeEpisode(Channel& ch, std::vector<PanicEpisode>& episodes)
+{
+    PanicEpisode ep = ch.episode;
+    ep.peakRateHz = ep.peakCount * 1000.0 / (m_bucketCount * m_rule.bucketMs);
+    ep.intensity = static_cast<double>(ep.peakCount) / m_rule.triggerCount;
+    episodes.push_back(ep);
+    ch.active = false;
+}
+
+void PanicDetector::onEvent(const SessionEvent& evt, std::vector<PanicEpisode>& episodes)
+{
+    const uint32_t bucket = evt.timestamp / m_rule.bucketMs;
+
+    // 1) Let time pass for channels with an open episode (usually none or one)
+    for (size_t i = 0; i < m_active.size();) {
+        Channel& ch = m_channels[m_active[i]];
+        advance(ch, bucket);
+        if (ch.windowCount < m_rule.releaseCount) {
+            closeEpisode(ch, episodes);
+            m_active[i] = m_active.back();
+            m_active.pop_back();
+        }
+        else {
+            ++i;
+        }
+    }
+
+    // 2) Count the press in its channel
+    if (!m_pressFilter.isNewPress(evt)) {
+        return;
+    }
+
+    const uint32_t c = pressChannel(evt);
+    Channel& ch = m_channels[c];
+    if (!ch.seen) {
+        ch.counts.assign(m_bucketCount, 0);
+        ch.firstMs.assign(m_bucketCount, 0);
+        ch.headBucket = bucket;
+        ch.seen = true;
+    }
+    else {
+        advance(ch, bucket);
+    }
+
+    uint32_t slot = ch.headBucket % m_bucketCount;
+    if (ch.counts[slot] == 0) {
+        ch.firstMs[slot] = evt.timestamp;
+    }
+    ++ch.counts[slot];
+    ++ch.windowCount;
+
+    // 3) Evaluate the burst rule
+    if (ch.active) {
+        ch.episode.endMs = evt.timestamp;
+        ++ch.episode.pressCount;
+        ch.episode.peakCount = std::max(ch.episode.peakCount, ch.windowCount);
+    }
+    else if (ch.windowCount >= m_rule.triggerCount) {
+        // The burst started with the oldest press still inside the window
+        uint32_t startMs = evt.timestamp;
+        for (uint32_t k = 1; k <= m_bucketCount; ++k) {
+            uint32_t s = (ch.headBucket + k) % m_bucketCount; // oldest first
+            if (ch.counts[s] != 0) {
+                startMs = ch.firstMs[s];
+                break;
+            }
+        }
+
+        ch.active = true;
+        ch.episode = PanicEpisode{ c, startMs, evt.timestamp,
+            ch.windowCount, ch.windowCount, 0.0, 0.0 };
+        m_active.push_back(c);
+    }
+}
+
+void PanicDetector::finish(std::vector<PanicEpisode>& episodes)
+{
+    for (uint32_t c : m_active) {
+        closeEpisode(m_channels[c], episodes);
+    }
+    m_active.clear();
+}
@@ -0,0 +1,79 @@
+// panic_detector.h
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "session_event.h"
+
+//----------------------------------------------------//
+//        Panic-Click / Spam Detection Settings
+//----------------------------------------------------//
+
+struct PanicRule
+{
+    uint32_t windowMs     = 1000; // sliding window length
+    uint32_t bucketMs     = 50;   // ring bucket width (window resolution)
+    uint32_t triggerCount = 7;    // presses in the window that open an episode
+    uint32_t releaseCount = 3;    // episode closes once the window drops below this
+
+    // A down while the key is still held is OS auto-repeat, not a press,
+    // if it comes within this long of the previous down (see PressFilter)
+    uint32_t repeatGapMs  = kAutoRepeatGapMs;
+};
+
+// One burst of presses on a single key or button
+struct PanicEpisode
+{
+    uint32_t channel;     // press channel (see session_event.h)
+    uint32_t startMs;     // first press of the burst
+    uint32_t endMs;       // last press of the burst
+    uint32_t pressCount;  // presses between start and end
+    uint32_t peakCount;   // highest presses-per-window seen
+    double   peakRateHz;  // peakCount scaled to presses per second
+    double   intensity;   // peakCount / triggerCount (1.0 = just over the rule)
+};
+
+//----------------------------------------------------//
+//                  PanicDetector
+//----------------------------------------------------//
+
+// Keeps a ring of time buckets per press channel, so the windowed press count
+// is updated in O(1) per event. Auto-repeat downs of a held key are not
+// presses and are skipped. Feed it events in time order, live or from a
+// recorded session; episodes are reported once they are over.
+class PanicDetector {
+public:
+    explicit PanicDetector(const PanicRule& rule = PanicRule());
+
+    // Appends any episodes that ended by 'evt.timestamp'
+    void onEvent(const SessionEvent& evt, std::vector<PanicEpisode>& episodes);
+
+    // Closes episodes that are still open (end of session)
+    void finish(std::vector<PanicEpisode>& episodes);
+
+    const PanicRule& rule() const { return m_rule; }
+
+private:
+    struct Channel
+    {
+        std::vector<uint16_t> counts;       // presses per bucket (ring)
+        std::vector<uint32_t> firstMs;      // first press time per bucket
+        uint32_t              headBucket = 0; // absolute index of the newest bucket
+        uint32_t              windowCount = 0;
+        bool                  seen = false;
+
+        bool                  active = false;
+        PanicEpisode          episode{};
+    };
+
+    void advance(Channel& ch, uint32_t bucket);
+    void closeEpisode(Channel& ch, std::vector<PanicEpisode>& episodes);
+
+private:
+    PanicRule              m_rule;
+    uint32_t               m_bucketCount;
+    PressFilter            m_pressFilter;
+    std::vector<Channel>   m_channels;    // indexed by press channel
+    std::vector<uint32_t>  m_active;      // channels with an open episode
+};
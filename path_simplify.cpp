@@ -0,0 +1,256 @@
+#include "path_simplify.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <utility>
+
+//----------------------------------------------------//
+//                Distance Helpers
+//----------------------------------------------------//
+
+// Distance from p to the segment a-b
+static double segmentDistance(const PathPoint& p, const PathPoint& a, const PathPoint& b)
+{
+    double dx = static_cast<double>(b.x) - a.x;
+    double dy = static_cast<double>(b.y) - a.y;
+    double px = static_cast<double>(p.x) - a.x;
+    double py = static_cast<double>(p.y) - a.y;
+
+    double len2 = dx * dx + dy * dy;
+    double u = len2 > 0.0 ? (px * dx + py * dy) / len2 : 0.0;
+    u = std::min(1.0, std::max(0.0, u));
+    return std::hypot(px - u * dx, py - u * dy);
+}
+
+// Distance from p to where the cursor would be at p's time when moving
+// linearly from a to b
+static double synchronizedDistance(const PathPoint& p, const PathPoint& a, const PathPoint& b)
+{
+    double span = static_cast<double>(b.timestamp - a.timestamp);
+    double u = span > 0.0 ? static_cast<double>(p.timestamp - a.timestamp) / span : 0.0;
+    u = std::min(1.0, std::max(0.0, u));
+    double qx = a.x + u * (static_cast<double>(b.x) - a.x);
+    double qy = a.y + u * (static_cast<double>(b.y) - a.y);
+    return std::hypot(p.x - qx, p.y - qy);
+}
+
+static double deviation(const PathPoint& p, const PathPoint& a, const PathPoint& b,
+    DeviationMetric metric)
+{
+    return metric == DeviationMetric::Synchronized
+        ? synchronizedDistance(p, a, b)
+        : segmentDistance(p, a, b);
+}
+
+static double triangleArea(const PathPoint& a, const PathPoint& p, const PathPoint& b)
+{
+    double cross = (static_cast<double>(p.x) - a.x) * (static_cast<double>(b.y) - a.y) -
+        (static_cast<double>(p.y) - a.y) * (static_cast<double>(b.x) - a.x);
+    return 0.5 * std::fabs(cross);
+}
+
+//----------------------------------------------------//
+//          Ramer-Douglas-Peucker (iterative)
+//----------------------------------------------------//
+
+static void simplifyDouglasPeucker(const std::vector<PathPoint>& path,
+    const SimplifyOptions& options, std::vector<char>& kept)
+{
+    std::vector<std::pair<size_t, size_t>> stack;
+    stack.emplace_back(0, path.size() - 1);
+
+    while (!stack.empty()) {
+        size_t first = stack.back().first;
+        size_t last = stack.back().second;
+        stack.pop_back();
+        if (last <= first + 1) {
+            continue;
+        }
+
+        size_t farthest = first;
+        double farthestDist = -1.0;
+        for (size_t i = first + 1; i < last; ++i) {
+            double d = deviation(path[i], path[first], path[last], options.metric);
+            if (d > farthestDist) {
+                farthestDist = d;
+                farthest = i;
+            }
+        }
+
+        if (farthestDist > options.tolerancePx) {
+            kept[farthest] = 1;
+            stack.emplace_back(first, farthest);
+            stack.emplace_back(farthest, last);
+        }
+    }
+}
+
+//----------------------------------------------------//
+//        Visvalingam-Whyatt (heap + lazy deletion)
+//----------------------------------------------------//
+
+// Longest run of original points one kept segment may replace. Checking a
+// removal costs one distance per point in the run, so without a limit a
+// long idle stretch (every area zero) would cost quadratic time.
+static const size_t kMaxVisvalingamSpan = 512;
+
+// True if every original point strictly between a and b is within the
+// tolerance of the segment a-b (not just the one about to be removed:
+// points dropped earlier now depend on the new segment too)
+static bool spanWithinTolerance(const std::vector<PathPoint>& path, size_t a, size_t b,
+    const SimplifyOptions& options)
+{
+    if (b - a > kMaxVisvalingamSpan) {
+        return false;
+    }
+    for (size_t j = a + 1; j < b; ++j) {
+        if (deviation(path[j], path[a], path[b], options.metric) > options.tolerancePx) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void simplifyVisvalingam(const std::vector<PathPoint>& path,
+    const SimplifyOptions& options, std::vector<char>& kept)
+{
+    const size_t n = path.size();
+    std::vector<size_t> prev(n), next(n);
+    std::vector<uint32_t> version(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        prev[i] = i - 1; // unused for i == 0
+        next[i] = i + 1;
+    }
+
+    struct Entry
+    {
+        double   area;
+        size_t   index;
+        uint32_t version;
+        bool operator>(const Entry& o) const { return area > o.area; }
+    };
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+
+    for (size_t i = 1; i + 1 < n; ++i) {
+        heap.push(Entry{ triangleArea(path[i - 1], path[i], path[i + 1]), i, 0 });
+    }
+
+    // Start with everything kept, drop the least significant points first
+    std::fill(kept.begin(), kept.end(), 1);
+    while (!heap.empty()) {
+        Entry e = heap.top();
+        heap.pop();
+        if (!kept[e.index] || e.version != version[e.index]) {
+            continue; // removed or stale
+        }
+
+        size_t i = e.index;
+        if (!spanWithinTolerance(path, prev[i], next[i], options)) {
+            continue; // too significant for now; re-queued if a neighbor goes away
+        }
+
+        kept[i] = 0;
+        size_t p = prev[i];
+        size_t q = next[i];
+        next[p] = q;
+        prev[q] = p;
+
+        if (p > 0) {
+            heap.push(Entry{ triangleArea(path[prev[p]], path[p], path[q]), p, ++version[p] });
+        }
+        if (q + 1 < n) {
+            heap.push(Entry{ triangleArea(path[p], path[q], path[next[q]]), q, ++version[q] });
+        }
+    }
+}
+
+//----------------------------------------------------//
+//                  Public Functions
+//----------------------------------------------------//
+
+void simplifyPath(const std::vector<PathPoint>& path, const SimplifyOptions& options,
+    std::vector<size_t>& keep)
+{
+    keep.clear();
+    const size_t n = path.size();
+    if (n <= 2) {
+        for (size_t i = 0; i < n; ++i) {
+            keep.push_back(i);
+        }
+        return;
+    }
+
+    std::vector<char> kept(n, 0);
+    kept[0] = 1;
+    kept[n - 1] = 1;
+    if (options.method == SimplifyMethod::Visvalingam) {
+        simplifyVisvalingam(path, options, kept);
+    }
+    else {
+        simplifyDouglasPeucker(path, options, kept);
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (kept[i]) {
+            keep.push_back(i);
+        }
+    }
+}
+
+double maxPathDeviation(const std::vector<PathPoint>& path,
+    const std::vector<size_t>& keep, DeviationMetric metric)
+{
+    double worst = 0.0;
+    for (size_t k = 1; k < keep.size(); ++k) {
+        const PathPoint& a = path[keep[k - 1]];
+        const PathPoint& b = path[keep[k]];
+        for (size_t i = keep[k - 1] + 1; i < keep[k]; ++i) {
+            worst = std::max(worst, deviation(path[i], a, b, metric));
+        }
+    }
+    return worst;
+}
+
+void extractCursorPath(const std::vector<SessionEvent>& events, std::vector<PathPoint>& path)
+{
+    path.clear();
+    for (const auto& evt : events) {
+        if (evt.kind == EventKind::MousePos) {
+            path.push_back(PathPoint{ evt.x, evt.y, evt.timestamp });
+        }
+    }
+}
+
+SimplifyStats simplifySessionPath(const std::vector<SessionEvent>& events,
+    const SimplifyOptions& options, std::vector<SessionEvent>& out)
+{
+    std::vector<PathPoint> path;
+    extractCursorPath(events, path);
+
+    std::vector<size_t> keep;
+    simplifyPath(path, options, keep);
+
+    SimplifyStats stats;
+    stats.inputPoints = path.size();
+    stats.outputPoints = keep.size();
+    stats.maxDeviationPx = maxPathDeviation(path, keep, options.metric);
+
+    // Walk the events again; the k-th MOUSE_POS survives if k is in 'keep'
+    out.clear();
+    out.reserve(events.size() - path.size() + keep.size());
+    size_t posIndex = 0;
+    size_t keepPos = 0;
+    for (const auto& evt : events) {
+        if (evt.kind != EventKind::MousePos) {
+            out.push_back(evt);
+            continue;
+        }
+        if (keepPos < keep.size() && keep[keepPos] == posIndex) {
+            out.push_back(evt);
+            ++keepPos;
+        }
+        ++posIndex;
+    }
+    return stats;
+}
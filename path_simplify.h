@@ -0,0 +1,68 @@
+// path_simplify.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "session_event.h"
+
+//----------------------------------------------------//
+//            Cursor Path Simplification
+//----------------------------------------------------//
+
+struct PathPoint
+{
+    int32_t  x;
+    int32_t  y;
+    uint32_t timestamp;
+};
+
+enum class SimplifyMethod {
+    DouglasPeucker,  // Ramer-Douglas-Peucker: hard error bound
+    Visvalingam      // Visvalingam-Whyatt: smaller area first, same error bound
+};
+
+enum class DeviationMetric {
+    Perpendicular,   // distance to the simplified line (shape only, for display)
+    Synchronized     // distance to the time-interpolated position (keeps timing, for storage)
+};
+
+struct SimplifyOptions
+{
+    double          tolerancePx = 2.0;
+    SimplifyMethod  method      = SimplifyMethod::DouglasPeucker;
+    DeviationMetric metric      = DeviationMetric::Perpendicular;
+};
+
+struct SimplifyStats
+{
+    size_t inputPoints    = 0;
+    size_t outputPoints   = 0;
+    double maxDeviationPx = 0.0;
+
+    double compressionRatio() const
+    {
+        return outputPoints == 0 ? 0.0 : static_cast<double>(inputPoints) / outputPoints;
+    }
+};
+
+// Picks the points to keep (indices into 'path', ascending; the first and
+// last points are always kept). No dropped point is further than the
+// tolerance from the kept segment replacing it, whichever the method. Both
+// are iterative (explicit stack / heap), so very long paths never recurse.
+void simplifyPath(const std::vector<PathPoint>& path, const SimplifyOptions& options,
+    std::vector<size_t>& keep);
+
+// Largest distance (under 'metric') between a dropped point and the kept
+// segment that replaces it
+double maxPathDeviation(const std::vector<PathPoint>& path,
+    const std::vector<size_t>& keep, DeviationMetric metric);
+
+// The MOUSE_POS samples of a session, in order
+void extractCursorPath(const std::vector<SessionEvent>& events, std::vector<PathPoint>& path);
+
+// Read-time level of detail: simplifies the cursor track of a session and
+// returns the events with the dropped MOUSE_POS samples removed
+SimplifyStats simplifySessionPath(const std::vector<SessionEvent>& events,
+    const SimplifyOptions& options, std::vector<SessionEvent>& out);
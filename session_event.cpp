@@ -0,0 +1,124 @@
+#include "session_event.h"
+
+#include <cctype>
+#include <sstream>
+
+// Same values as VK_SHIFT/VK_CONTROL/VK_MENU in <windows.h>
+static const uint32_t kVkShift   = 0x10;
+static const uint32_t kVkControl = 0x11;
+static const uint32_t kVkMenu    = 0x12;
+
+EventKind eventKindFromString(const std::string& eventType)
+{
+    // Ordered roughly by frequency in a real session
+    if (eventType == "MOUSE_POS")        return EventKind::MousePos;
+    if (eventType == "KEY_DOWN")         return EventKind::KeyDown;
+    if (eventType == "KEY_UP")           return EventKind::KeyUp;
+    if (eventType == "MOUSE_RIGHT_DOWN") return EventKind::MouseRightDown;
+    if (eventType == "MOUSE_RIGHT_UP")   return EventKind::MouseRightUp;
+    if (eventType == "MOUSE_LEFT_DOWN")  return EventKind::MouseLeftDown;
+    if (eventType == "MOUSE_LEFT_UP")    return EventKind::MouseLeftUp;
+    return EventKind::Unknown;
+}
+
+const char* eventKindToString(EventKind kind)
+{
+    switch (kind) {
+    case EventKind::MousePos:       return "MOUSE_POS";
+    case EventKind::MouseLeftDown:  return "MOUSE_LEFT_DOWN";
+    case EventKind::MouseLeftUp:    return "MOUSE_LEFT_UP";
+    case EventKind::MouseRightDown: return "MOUSE_RIGHT_DOWN";
+    case EventKind::MouseRightUp:   return "MOUSE_RIGHT_UP";
+    case EventKind::KeyDown:        return "KEY_DOWN";
+    case EventKind::KeyUp:          return "KEY_UP";
+    default:                        return "UNKNOWN";
+    }
+}
+
+uint32_t pressChannel(const SessionEvent& evt)
+{
+    switch (evt.kind) {
+    case EventKind::KeyDown:
+        return evt.keyCode < 256 ? evt.keyCode : kNoChannel;
+    case EventKind::MouseLeftDown:  return kChannelLeftClick;
+    case EventKind::MouseRightDown: return kChannelRightClick;
+    default:                        return kNoChannel;
+    }
+}
+
+uint32_t releaseChannel(const SessionEvent& evt)
+{
+    switch (evt.kind) {
+    case EventKind::KeyUp:
+        return evt.keyCode < 256 ? evt.keyCode : kNoChannel;
+    case EventKind::MouseLeftUp:  return kChannelLeftClick;
+    case EventKind::MouseRightUp: return kChannelRightClick;
+    default:                      return kNoChannel;
+    }
+}
+
+PressFilter::PressFilter(uint32_t repeatGapMs)
+    : m_repeatGapMs(repeatGapMs), m_held(kChannelCount, 0), m_lastDownMs(kChannelCount, 0)
+{
+}
+
+bool PressFilter::isNewPress(const SessionEvent& evt)
+{
+    uint32_t c = pressChannel(evt);
+    if (c == kNoChannel) {
+        c = releaseChannel(evt);
+        if (c != kNoChannel) {
+            m_held[c] = 0;
+        }
+        return false;
+    }
+
+    const bool repeat = m_held[c] && evt.timestamp - m_lastDownMs[c] <= m_repeatGapMs;
+    m_held[c] = 1;              // (a stale hold means the up was lost)
+    m_lastDownMs[c] = evt.timestamp;
+    return !repeat;
+}
+
+std::string channelName(uint32_t channel)
+{
+    if (channel == kChannelLeftClick)  return "LMB";
+    if (channel == kChannelRightClick) return "RMB";
+    return vkToKeyName(channel);
+}
+
+uint32_t keyNameToVk(const std::string& keyName)
+{
+    std::string upper;
+    for (char c : keyName) upper.push_back(static_cast<char>(toupper(static_cast<unsigned char>(c))));
+
+    if (upper == "CTRL")  return kVkControl;
+    if (upper == "SHIFT") return kVkShift;
+    if (upper == "ALT")   return kVkMenu;
+
+    if (upper.size() == 1) {
+        char c = upper[0];
+        if ((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z')) {
+            return static_cast<uint32_t>(c);
+        }
+    }
+    return 0; // not recognized
+}
+
+std::string vkToKeyName(uint32_t vkCode)
+{
+    switch (vkCode) {
+    case kVkControl: return "CTRL";
+    case kVkShift:   return "SHIFT";
+    case kVkMenu:    return "ALT";
+    default:
+        if ((vkCode >= '0' && vkCode <= '9') ||
+            (vkCode >= 'A' && vkCode <= 'Z')) {
+            return std::string(1, static_cast<char>(vkCode));
+        }
+        {
+            std::ostringstream oss;
+            oss << "VK(" << vkCode << ")";
+            return oss.str();
+        }
+    }
+}
@@ -0,0 +1,88 @@
+// session_event.h
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------//
+//        Portable Event Record (for analyzers)
+//----------------------------------------------------//
+
+// Compact event kind; mirrors the event_type strings written to the CSV
+enum class EventKind : uint8_t {
+    MousePos,
+    MouseLeftDown,
+    MouseLeftUp,
+    MouseRightDown,
+    MouseRightUp,
+    KeyDown,
+    KeyUp,
+    Unknown
+};
+
+// One input event as the analyzers see it (no Win32 types, so it builds anywhere)
+struct SessionEvent
+{
+    uint32_t  timestamp;  // in ms, same clock as the capture (GetTickCount)
+    EventKind kind;
+    int32_t   x;
+    int32_t   y;
+    uint32_t  keyCode;    // VK code for key events, 0 otherwise
+};
+
+// "MOUSE_LEFT_DOWN" -> EventKind::MouseLeftDown, unknown strings -> EventKind::Unknown
+EventKind eventKindFromString(const std::string& eventType);
+
+// EventKind::KeyUp -> "KEY_UP"
+const char* eventKindToString(EventKind kind);
+
+// True for the "press" events (key down, left/right button down)
+inline bool isPressEvent(EventKind kind)
+{
+    return kind == EventKind::KeyDown ||
+        kind == EventKind::MouseLeftDown ||
+        kind == EventKind::MouseRightDown;
+}
+
+// Press events as one dense channel index: 0..255 are key-down VK codes,
+// followed by the left and right mouse buttons
+const uint32_t kChannelLeftClick  = 256;
+const uint32_t kChannelRightClick = 257;
+const uint32_t kChannelCount      = 258;
+const uint32_t kNoChannel         = 0xFFFFFFFF;
+
+// Channel for a press event (kNoChannel for moves, releases, ...)
+uint32_t pressChannel(const SessionEvent& evt);
+
+// Channel for a release event (kNoChannel for anything else)
+uint32_t releaseChannel(const SessionEvent& evt);
+
+// A down while its key is still held is OS auto-repeat, not a press, if it
+// comes within this long of the previous down (a longer gap means the up
+// was lost)
+const uint32_t kAutoRepeatGapMs = 1000;
+
+// Tells new presses from auto-repeat downs. Feed it every event in time
+// order (releases too, they end the hold).
+class PressFilter {
+public:
+    explicit PressFilter(uint32_t repeatGapMs = kAutoRepeatGapMs);
+
+    // True for a press event that is not an auto-repeat
+    bool isNewPress(const SessionEvent& evt);
+
+private:
+    uint32_t              m_repeatGapMs;
+    std::vector<uint8_t>  m_held;       // per channel: down seen, no up yet
+    std::vector<uint32_t> m_lastDownMs; // per channel: press or repeat
+};
+
+// "Q", "LMB", "RMB", ...
+std::string channelName(uint32_t channel);
+
+// "Q", "ctrl", "4" -> VK code (0 if not recognized)
+uint32_t keyNameToVk(const std::string& keyName);
+
+// VK code -> "Q", "CTRL", or "VK(123)" for anything else
+std::string vkToKeyName(uint32_t vkCode);
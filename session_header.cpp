@@ -0,0 +1,173 @@
+#include "session_header.h"
+
+#include <cstdio>
+#include <iostream>
+
+static const size_t kMaxHeaderBytes = 64 * 1024;
+
+//----------------------------------------------------//
+//             SessionHeader Implementation
+//----------------------------------------------------//
+
+const std::string* SessionHeader::get(const std::string& key) const
+{
+    for (const auto& f : fields) {
+        if (f.first == key) {
+            return &f.second;
+        }
+    }
+    return nullptr;
+}
+
+void SessionHeader::set(const std::string& key, const std::string& value)
+{
+    for (auto& f : fields) {
+        if (f.first == key) {
+            f.second = value;
+            return;
+        }
+    }
+    fields.emplace_back(key, value);
+}
+
+void SessionHeader::erase(const std::string& key)
+{
+    for (auto it = fields.begin(); it != fields.end(); ++it) {
+        if (it->first == key) {
+            fields.erase(it);
+            return;
+        }
+    }
+}
+
+//----------------------------------------------------//
+//                  Header Block
+//----------------------------------------------------//
+
+static std::string trim(const std::string& s)
+{
+    const size_t b = s.find_first_not_of(" \t\r");
+    if (b == std::string::npos) {
+        return "";
+    }
+    const size_t e = s.find_last_not_of(" \t\r");
+    return s.substr(b, e - b + 1);
+}
+
+// "# key: value"; false for lines without a key (padding, notes)
+static bool parseFieldLine(const std::string& line, std::pair<std::string, std::string>& field)
+{
+    const std::string body = line.substr(1);
+    const size_t colon = body.find(':');
+    if (colon == std::string::npos || trim(body.substr(0, colon)).empty()) {
+        return false;
+    }
+    field.first = trim(body.substr(0, colon));
+    field.second = trim(body.substr(colon + 1));
+    return true;
+}
+
+// Parses the block at the start of the file; returns its size in bytes
+static uint64_t parseHeaderBlock(const std::string& data, SessionHeader& header,
+    std::string& columnsLine)
+{
+    header.fields.clear();
+    columnsLine.clear();
+
+    size_t pos = 0;
+    bool first = true;
+    while (pos < data.size()) {
+        const size_t nl = data.find('\n', pos);
+        if (nl == std::string::npos) {
+            break; // incomplete line: not part of the block
+        }
+        const std::string line = data.substr(pos, nl - pos);
+        if (first && line.compare(0, 12, "timestamp_ms") == 0) {
+            columnsLine = trim(line);
+        }
+        else if (!line.empty() && line[0] == '#') {
+            std::pair<std::string, std::string> field;
+            if (parseFieldLine(line, field)) {
+                header.fields.push_back(field);
+            }
+        }
+        else {
+            break; // first event row
+        }
+        first = false;
+        pos = nl + 1;
+    }
+    return pos;
+}
+
+bool readSessionHeader(const std::string& path, SessionHeader& header, uint64_t* blockBytes)
+{
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        std::cerr << "Failed to open session file: " << path << "\n";
+        return false;
+    }
+    std::string data(kMaxHeaderBytes, '\0');
+    data.resize(std::fread(&data[0], 1, data.size(), f));
+    std::fclose(f);
+
+    std::string columnsLine;
+    const uint64_t bytes = parseHeaderBlock(data, header, columnsLine);
+    if (blockBytes) {
+        *blockBytes = bytes;
+    }
+    return true;
+}
+
+bool readSessionTrailer(const std::string& path, SessionHeader& trailer)
+{
+    trailer.fields.clear();
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        std::cerr << "Failed to open session file: " << path << "\n";
+        return false;
+    }
+    // The trailer is a few hundred bytes; the tail block is plenty
+    const bool fromStart = std::fseek(f, -static_cast<long>(kMaxHeaderBytes), SEEK_END) != 0;
+    if (fromStart) {
+        std::fseek(f, 0, SEEK_SET);
+    }
+    std::string data(kMaxHeaderBytes, '\0');
+    data.resize(std::fread(&data[0], 1, data.size(), f));
+    std::fclose(f);
+
+    // Walk back over the comment lines at the end of the file
+    std::vector<std::string> lines;
+    size_t end = data.size();
+    while (end > 0) {
+        size_t begin = data.rfind('\n', end - 1);
+        if (begin == std::string::npos) {
+            if (!fromStart) {
+                break; // first line of the block may be cut
+            }
+            begin = 0;
+        }
+        else {
+            ++begin;
+        }
+        const std::string line = trim(data.substr(begin, end - begin));
+        if (!line.empty()) {
+            if (line[0] != '#') {
+                break; // last event row (or the column header)
+            }
+            lines.push_back(line);
+        }
+        if (begin == 0) {
+            break;
+        }
+        end = begin - 1;
+    }
+
+    for (auto it = lines.rbegin(); it != lines.rend(); ++it) {
+        std::pair<std::string, std::string> field;
+        if (parseFieldLine(*it, field)) {
+            trailer.fields.push_back(field);
+        }
+    }
+    return true;
+}
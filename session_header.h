@@ -0,0 +1,31 @@
+// session_header.h
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+//----------------------------------------------------//
+//              Session Metadata Header
+//----------------------------------------------------//
+
+// "# key: value" lines right after the column header of a session file.
+// Event parsing skips them, so older readers keep working.
+struct SessionHeader
+{
+    std::vector<std::pair<std::string, std::string>> fields;
+
+    const std::string* get(const std::string& key) const;    // nullptr if absent
+    void set(const std::string& key, const std::string& value);
+    void erase(const std::string& key);
+};
+
+// Reads the header block; 'blockBytes' receives its size in the file
+// (column header plus metadata lines). A file without metadata is fine.
+bool readSessionHeader(const std::string& path, SessionHeader& header,
+    uint64_t* blockBytes = nullptr);
+
+// "# key: value" lines after the last event row, as the capture appends on
+// stop (per-source loss accounting). Empty for files without a trailer.
+bool readSessionTrailer(const std::string& path, SessionHeader& trailer);
@@ -0,0 +1,250 @@
+#include "session_reader.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <sys/stat.h>
+
+//----------------------------------------------------//
+//                 Row Parsing
+//----------------------------------------------------//
+
+// Reads an optionally negative integer up to the next ',' (or 'end')
+static bool parseIntField(const char*& p, const char* end, long long& out)
+{
+    bool negative = false;
+    if (p < end && *p == '-') {
+        negative = true;
+        ++p;
+    }
+    if (p >= end || *p < '0' || *p > '9') {
+        return false;
+    }
+    long long v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (*p - '0');
+        ++p;
+    }
+    out = negative ? -v : v;
+    return true;
+}
+
+static bool skipComma(const char*& p, const char* end)
+{
+    if (p < end && *p == ',') {
+        ++p;
+        return true;
+    }
+    return false;
+}
+
+bool parseSessionLine(const char* begin, const char* end, SessionEvent& out)
+{
+    // Tolerate CRLF files
+    if (end > begin && end[-1] == '\r') {
+        --end;
+    }
+
+    const char* p = begin;
+    long long ts = 0, x = 0, y = 0, key = 0;
+    if (!parseIntField(p, end, ts) || !skipComma(p, end)) {
+        return false; // header, comment or garbage
+    }
+
+    const char* typeBegin = p;
+    while (p < end && *p != ',') {
+        ++p;
+    }
+    out.kind = eventKindFromString(std::string(typeBegin, p));
+
+    if (!skipComma(p, end) || !parseIntField(p, end, x) ||
+        !skipComma(p, end) || !parseIntField(p, end, y) ||
+        !skipComma(p, end) || !parseIntField(p, end, key)) {
+        return false;
+    }
+
+    out.timestamp = static_cast<uint32_t>(ts);
+    out.x = static_cast<int32_t>(x);
+    out.y = static_cast<int32_t>(y);
+    out.keyCode = static_cast<uint32_t>(key);
+    return true;
+}
+
+//----------------------------------------------------//
+//                 File Streaming
+//----------------------------------------------------//
+
+// 64-bit seek on both CRTs
+static bool seekTo(FILE* f, uint64_t offset)
+{
+#if defined(_WIN32)
+    return _fseeki64(f, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(f, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+bool forEachSessionEventAt(const std::string& path, uint64_t begin, uint64_t end,
+    const std::function<void(const SessionEvent&, uint64_t)>& fn)
+{
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        std::cerr << "Failed to open session file: " << path << "\n";
+        return false;
+    }
+
+    // Position on the first line that starts at or after 'begin'
+    uint64_t bufferOffset = 0;
+    if (begin > 0) {
+        if (!seekTo(f, begin - 1)) {
+            std::cerr << "Failed to seek in session file: " << path << "\n";
+            std::fclose(f);
+            return false;
+        }
+        bufferOffset = begin - 1;
+        int c = std::fgetc(f);
+        ++bufferOffset;
+        while (c != EOF && c != '\n') {
+            c = std::fgetc(f);
+            ++bufferOffset;
+        }
+    }
+
+    // Large block reads; a partial last line is carried over to the next block
+    const size_t kBlockSize = 1 << 20;
+    std::vector<char> buffer(kBlockSize);
+    size_t carry = 0;
+    SessionEvent evt;
+    bool done = false;
+
+    while (!done) {
+        size_t got = std::fread(buffer.data() + carry, 1, buffer.size() - carry, f);
+        size_t avail = carry + got;
+        if (avail == 0) {
+            break;
+        }
+
+        const char* data = buffer.data();
+        const char* last = data + avail;
+        const char* line = data;
+        while (true) {
+            if (bufferOffset + static_cast<uint64_t>(line - data) >= end) {
+                done = true; // this line belongs to the next range
+                break;
+            }
+            const char* nl = static_cast<const char*>(std::memchr(line, '\n', last - line));
+            if (!nl) {
+                break;
+            }
+            if (parseSessionLine(line, nl, evt)) {
+                fn(evt, bufferOffset + static_cast<uint64_t>(line - data));
+            }
+            line = nl + 1;
+        }
+        if (done) {
+            break;
+        }
+
+        carry = static_cast<size_t>(last - line);
+        if (got == 0) {
+            // EOF: last line without a trailing newline
+            if (carry > 0 && parseSessionLine(line, last, evt)) {
+                fn(evt, bufferOffset + static_cast<uint64_t>(line - data));
+            }
+            break;
+        }
+        if (carry == buffer.size()) {
+            buffer.resize(buffer.size() * 2); // absurdly long line, already at the front
+        }
+        else {
+            bufferOffset += static_cast<uint64_t>(line - data);
+            std::memmove(buffer.data(), line, carry);
+        }
+    }
+
+    std::fclose(f);
+    return true;
+}
+
+bool forEachSessionEventInRange(const std::string& path, uint64_t begin, uint64_t end,
+    const std::function<void(const SessionEvent&)>& fn)
+{
+    return forEachSessionEventAt(path, begin, end, [&fn](const SessionEvent& evt, uint64_t) {
+        fn(evt);
+    });
+}
+
+bool forEachSessionEvent(const std::string& path,
+    const std::function<void(const SessionEvent&)>& fn)
+{
+    return forEachSessionEventInRange(path, 0, UINT64_MAX, fn);
+}
+
+void splitSessionFile(uint64_t fileSize, uint64_t chunkBytes,
+    std::vector<std::pair<uint64_t, uint64_t>>& chunks)
+{
+    chunks.clear();
+    if (chunkBytes == 0) {
+        chunkBytes = fileSize;
+    }
+    for (uint64_t begin = 0; begin < fileSize; begin += chunkBytes) {
+        chunks.emplace_back(begin, std::min(fileSize, begin + chunkBytes));
+    }
+    if (chunks.empty()) {
+        chunks.emplace_back(0, 0);
+    }
+}
+
+uint64_t sessionFileSize(const std::string& path)
+{
+    std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+    if (!ifs.is_open()) {
+        return 0;
+    }
+    return static_cast<uint64_t>(ifs.tellg());
+}
+
+int64_t sessionFileMtime(const std::string& path)
+{
+#if defined(_WIN32)
+    struct _stat64 st;
+    if (_stat64(path.c_str(), &st) != 0) {
+        return 0;
+    }
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return 0;
+    }
+#endif
+    return static_cast<int64_t>(st.st_mtime);
+}
+
+bool readSession(const std::string& path, std::vector<SessionEvent>& out)
+{
+    return forEachSessionEvent(path, [&out](const SessionEvent& evt) {
+        out.push_back(evt);
+    });
+}
+
+bool writeSession(const std::string& path, const std::vector<SessionEvent>& events)
+{
+    std::ofstream ofs(path, std::ios::trunc);
+    if (!ofs.is_open()) {
+        std::cerr << "Failed to open session file for writing: " << path << "\n";
+        return false;
+    }
+
+    ofs << "timestamp_ms,event_type,x,y,key_code\n";
+    for (const auto& evt : events) {
+        ofs << evt.timestamp << ","
+            << eventKindToString(evt.kind) << ","
+            << evt.x << ","
+            << evt.y << ","
+            << evt.keyCode << "\n";
+    }
+    return true;
+}
@@ -0,0 +1,50 @@
+// session_reader.h
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "session_event.h"
+
+//----------------------------------------------------//
+//          Reading Recorded Sessions (CSV)
+//----------------------------------------------------//
+
+// Parses one CSV row "timestamp_ms,event_type,x,y,key_code" (extra columns
+// are ignored). Returns false for the header, comments and malformed rows.
+bool parseSessionLine(const char* begin, const char* end, SessionEvent& out);
+
+// Streams every event of a session file to 'fn' in file order, in a single
+// pass and without keeping the session in memory.
+// Returns false (and reports on std::cerr) if the file cannot be opened.
+bool forEachSessionEvent(const std::string& path,
+    const std::function<void(const SessionEvent&)>& fn);
+
+// Same, restricted to the rows that start inside [begin, end) bytes. Ranges
+// can split a file anywhere; every row lands in exactly one of them.
+bool forEachSessionEventInRange(const std::string& path, uint64_t begin, uint64_t end,
+    const std::function<void(const SessionEvent&)>& fn);
+
+// Same, also passing the byte offset where each event's row starts (for
+// building indexes that later jump straight to a part of the file)
+bool forEachSessionEventAt(const std::string& path, uint64_t begin, uint64_t end,
+    const std::function<void(const SessionEvent&, uint64_t)>& fn);
+
+// Cuts [0, fileSize) into byte ranges of about chunkBytes for parallel parsing
+void splitSessionFile(uint64_t fileSize, uint64_t chunkBytes,
+    std::vector<std::pair<uint64_t, uint64_t>>& chunks);
+
+// Size of a file in bytes (0 if it cannot be opened)
+uint64_t sessionFileSize(const std::string& path);
+
+// Last modification time in seconds since the epoch (0 if it cannot be read)
+int64_t sessionFileMtime(const std::string& path);
+
+// Loads a whole session into memory
+bool readSession(const std::string& path, std::vector<SessionEvent>& out);
+
+// Writes events in the logger's CSV format (header included)
+bool writeSession(const std::string& path, const std::vector<SessionEvent>& events);
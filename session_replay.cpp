@@ -0,0 +1,63 @@
+#include "session_replay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "session_reader.h"
+
+bool replaySession(const std::string& path, const ReplayOptions& options,
+    const std::function<void(const SessionEvent&)>& emit, ReplayStats& stats)
+{
+    using Clock = std::chrono::steady_clock;
+    using Micros = std::chrono::duration<double, std::micro>;
+
+    stats = ReplayStats();
+    const bool paced = options.speed > 0.0;
+    const auto spin = std::chrono::microseconds(options.spinUs);
+
+    Clock::time_point start;
+    bool started = false;
+    uint32_t lastT = 0;
+    double sessionMs = 0.0;   // replayed session time since the first event
+
+    bool ok = forEachSessionEvent(path, [&](const SessionEvent& evt) {
+        if (!started) {
+            started = true;
+            start = Clock::now();
+            lastT = evt.timestamp;
+        }
+
+        // Clock jumps back (wrap, concatenated captures) replay without delay
+        uint32_t step = evt.timestamp >= lastT ? evt.timestamp - lastT : 0;
+        if (options.maxGapMs > 0) {
+            step = std::min(step, options.maxGapMs);
+        }
+        lastT = evt.timestamp;
+        sessionMs += step;
+
+        if (paced) {
+            const auto deadline = start + std::chrono::duration_cast<Clock::duration>(
+                Micros(sessionMs * 1000.0 / options.speed));
+            if (deadline - Clock::now() > spin) {
+                std::this_thread::sleep_until(deadline - spin);
+            }
+            Clock::time_point now;
+            while ((now = Clock::now()) < deadline) {
+                // spin-finish
+            }
+            const double late = Micros(now - deadline).count();
+            stats.lateUs.add(static_cast<uint32_t>(std::min(late, 4e9)));
+            stats.lateEvents += late > 1000.0 ? 1 : 0;
+            emit(evt);
+        }
+        else {
+            emit(evt);
+        }
+        ++stats.events;
+    });
+
+    stats.spanMs = static_cast<uint64_t>(sessionMs);
+    stats.wallMs = started ? std::chrono::duration<double, std::milli>(Clock::now() - start).count() : 0.0;
+    return ok;
+}
@@ -0,0 +1,37 @@
+// session_replay.h
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "session_event.h"
+#include "key_timing.h"
+
+//----------------------------------------------------//
+//                 Session Replay
+//----------------------------------------------------//
+
+struct ReplayOptions
+{
+    double   speed = 1.0;       // 2.0 = twice as fast; 0 = as fast as possible
+    uint32_t spinUs = 1000;     // sleep until this close to a deadline, then spin
+    uint32_t maxGapMs = 0;      // longer pauses are shortened to this (0 = keep)
+};
+
+struct ReplayStats
+{
+    uint64_t       events = 0;
+    uint64_t       spanMs = 0;        // session time covered (after gap shortening)
+    double         wallMs = 0.0;
+    uint64_t       lateEvents = 0;    // emitted more than 1 ms after their deadline
+    DurationSketch lateUs;            // emit time minus deadline, microseconds
+};
+
+// Emits the events of a recorded session with their original relative
+// timing (scaled by 'speed'), or back to back. Every event has a deadline
+// from the replay start; the thread sleeps until shortly before it and then
+// spins, since sleeps alone overshoot by a scheduler tick. Lateness is
+// measured per event, so pacing error is part of every run's report.
+bool replaySession(const std::string& path, const ReplayOptions& options,
+    const std::function<void(const SessionEvent&)>& emit, ReplayStats& stats);
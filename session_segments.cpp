@@ -0,0 +1,356 @@
+#include "session_segments.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "session_reader.h"
+
+static const char* const kIndexHeader = "# skillshot segment index v1";
+
+const char* segmentKindToString(SegmentKind kind)
+{
+    switch (kind) {
+    case SegmentKind::Idle:   return "idle";
+    case SegmentKind::Active: return "active";
+    case SegmentKind::Game:   return "game";
+    default:                  return "?";
+    }
+}
+
+SegmentKind segmentKindFromString(const std::string& name)
+{
+    if (name == "game")   return SegmentKind::Game;
+    if (name == "active") return SegmentKind::Active;
+    return SegmentKind::Idle;
+}
+
+//----------------------------------------------------//
+//             SegmentIndex Implementation
+//----------------------------------------------------//
+
+namespace {
+
+// Activity of one time bin
+struct Bin
+{
+    bool     hasEvents = false;
+    uint32_t firstMs = 0;
+    uint32_t lastMs = 0;
+    uint64_t firstOffset = 0;
+    uint64_t events = 0;
+    uint32_t casts = 0;       // ability key presses
+    uint32_t moves = 0;       // right clicks (movement orders)
+    uint32_t clicks = 0;      // left clicks
+    uint32_t keys = 0;        // other key presses
+    double   travelPx = 0.0;  // cursor path length
+};
+
+} // namespace
+
+bool SegmentIndex::build(const std::string& sessionPath, const SegmentOptions& options)
+{
+    m_segments.clear();
+    m_checkpoints.clear();
+    m_sourceSize = sessionFileSize(sessionPath);
+
+    const uint32_t binMs = std::max<uint32_t>(1, options.binMs);
+    std::vector<Bin> bins;
+    bool started = false, hasCursor = false;
+    uint32_t firstMs = 0;
+    int32_t lastX = 0, lastY = 0;
+    PressFilter presses;
+
+    // 1) Per-bin activity in one pass
+    bool ok = forEachSessionEventAt(sessionPath, 0, UINT64_MAX,
+        [&](const SessionEvent& evt, uint64_t offset) {
+            if (!started) {
+                firstMs = evt.timestamp;
+                started = true;
+            }
+            const size_t b = evt.timestamp >= firstMs ? (evt.timestamp - firstMs) / binMs : 0;
+            if (b >= bins.size()) {
+                bins.resize(b + 1);
+            }
+            Bin& bin = bins[b];
+            if (!bin.hasEvents) {
+                bin.hasEvents = true;
+                bin.firstMs = evt.timestamp;
+                bin.firstOffset = offset;
+            }
+            bin.lastMs = evt.timestamp;
+            ++bin.events;
+
+            // Auto-repeat downs of a held key are not presses
+            if (!presses.isNewPress(evt) && isPressEvent(evt.kind)) {
+                return;
+            }
+            switch (evt.kind) {
+            case EventKind::MousePos:
+                if (hasCursor) {
+                    bin.travelPx += std::hypot(static_cast<double>(evt.x) - lastX,
+                        static_cast<double>(evt.y) - lastY);
+                }
+                lastX = evt.x;
+                lastY = evt.y;
+                hasCursor = true;
+                break;
+            case EventKind::MouseRightDown:
+                ++bin.moves;
+                break;
+            case EventKind::MouseLeftDown:
+                ++bin.clicks;
+                break;
+            case EventKind::KeyDown:
+                if (std::find(options.castKeys.begin(), options.castKeys.end(), evt.keyCode) !=
+                    options.castKeys.end()) {
+                    ++bin.casts;
+                }
+                else {
+                    ++bin.keys;
+                }
+                break;
+            default:
+                break;
+            }
+        });
+    if (!ok) {
+        return false;
+    }
+
+    // 2) Classify bins
+    const double perMin = 60000.0 / binMs;
+    auto isIdle = [&](const Bin& b) {
+        return b.casts + b.moves + b.clicks + b.keys == 0 && b.travelPx < options.idleTravelPx;
+    };
+    auto isGameLike = [&](const Bin& b) {
+        return b.casts * perMin >= options.gameCastsPerMin || b.moves * perMin >= options.gameMovesPerMin;
+    };
+
+    // 3) Games: game-like bins, bridged over short lulls but never over a
+    //    long idle stretch
+    const size_t n = bins.size();
+    std::vector<uint32_t> gameOf(n, 0);
+    uint32_t games = 0;
+    for (size_t i = 0; i < n;) {
+        if (!isGameLike(bins[i])) {
+            ++i;
+            continue;
+        }
+        size_t last = i;
+        uint64_t lullMs = 0, idleMs = 0;
+        for (size_t j = i + 1; j < n; ++j) {
+            if (isGameLike(bins[j])) {
+                last = j;
+                lullMs = 0;
+                idleMs = 0;
+                continue;
+            }
+            lullMs += binMs;
+            idleMs = isIdle(bins[j]) ? idleMs + binMs : 0;
+            if (lullMs > options.maxLullMs || idleMs >= options.idleGapMs) {
+                break;
+            }
+        }
+        if (static_cast<uint64_t>(last - i + 1) * binMs >= options.minGameMs) {
+            ++games;
+            std::fill(gameOf.begin() + i, gameOf.begin() + last + 1, games);
+        }
+        i = last + 1;
+    }
+
+    // 4) Label the rest: idle only when the silence is long enough
+    std::vector<SegmentKind> kinds(n, SegmentKind::Active);
+    for (size_t i = 0; i < n;) {
+        if (gameOf[i]) {
+            kinds[i++] = SegmentKind::Game;
+            continue;
+        }
+        size_t j = i;
+        while (j < n && !gameOf[j] && isIdle(bins[j])) ++j;
+        if (j > i && static_cast<uint64_t>(j - i) * binMs >= options.idleGapMs) {
+            std::fill(kinds.begin() + i, kinds.begin() + j, SegmentKind::Idle);
+        }
+        i = std::max(j, i + 1);
+    }
+
+    // 5) Runs of equal labels become segments; non-empty bins become checkpoints
+    for (size_t i = 0; i < n; ++i) {
+        const Bin& bin = bins[i];
+        if (!bin.hasEvents) {
+            continue;
+        }
+        m_checkpoints.push_back(SegmentCheckpoint{ bin.firstMs, bin.firstOffset });
+
+        if (m_segments.empty() || m_segments.back().kind != kinds[i] ||
+            m_segments.back().game != gameOf[i]) {
+            if (!m_segments.empty()) {
+                m_segments.back().endOffset = bin.firstOffset;
+            }
+            SessionSegment seg;
+            seg.kind = kinds[i];
+            seg.game = gameOf[i];
+            seg.startMs = bin.firstMs;
+            seg.beginOffset = bin.firstOffset;
+            m_segments.push_back(seg);
+        }
+        SessionSegment& seg = m_segments.back();
+        seg.endMs = bin.lastMs;
+        seg.events += bin.events;
+        seg.casts += bin.casts;
+    }
+    if (!m_segments.empty()) {
+        m_segments.back().endOffset = m_sourceSize;
+    }
+    return true;
+}
+
+bool SegmentIndex::save(const std::string& path) const
+{
+    std::ofstream ofs(path, std::ios::trunc);
+    if (!ofs.is_open()) {
+        std::cerr << "Failed to open segment index for writing: " << path << "\n";
+        return false;
+    }
+
+    ofs << kIndexHeader << "\n";
+    ofs << "source_size " << m_sourceSize << "\n";
+    for (const auto& s : m_segments) {
+        ofs << "segment " << segmentKindToString(s.kind) << " " << s.game << " "
+            << s.startMs << " " << s.endMs << " " << s.beginOffset << " " << s.endOffset << " "
+            << s.events << " " << s.casts << "\n";
+    }
+    for (const auto& c : m_checkpoints) {
+        ofs << "checkpoint " << c.timestamp << " " << c.offset << "\n";
+    }
+    return static_cast<bool>(ofs);
+}
+
+bool SegmentIndex::load(const std::string& path)
+{
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) {
+        return false; // not built yet; not an error
+    }
+
+    std::string line;
+    if (!std::getline(ifs, line) || line != kIndexHeader) {
+        std::cerr << "Ignoring unreadable segment index: " << path << "\n";
+        return false;
+    }
+
+    m_segments.clear();
+    m_checkpoints.clear();
+    m_sourceSize = 0;
+    while (std::getline(ifs, line)) {
+        std::istringstream iss(line);
+        std::string tag;
+        iss >> tag;
+        if (tag == "source_size") {
+            iss >> m_sourceSize;
+        }
+        else if (tag == "segment") {
+            SessionSegment s;
+            std::string kind;
+            if (iss >> kind >> s.game >> s.startMs >> s.endMs >> s.beginOffset >> s.endOffset
+                >> s.events >> s.casts) {
+                s.kind = segmentKindFromString(kind);
+                m_segments.push_back(s);
+            }
+        }
+        else if (tag == "checkpoint") {
+            SegmentCheckpoint c;
+            if (iss >> c.timestamp >> c.offset) {
+                m_checkpoints.push_back(c);
+            }
+        }
+    }
+    return true;
+}
+
+void SegmentIndex::byteRange(uint32_t t0, uint32_t t1, uint64_t& begin, uint64_t& end) const
+{
+    auto byTime = [](uint32_t t, const SegmentCheckpoint& c) { return t < c.timestamp; };
+
+    // Last checkpoint at or before t0, first one after t1
+    auto lo = std::upper_bound(m_checkpoints.begin(), m_checkpoints.end(), t0, byTime);
+    begin = lo == m_checkpoints.begin() ? 0 : (lo - 1)->offset;
+    auto hi = std::upper_bound(m_checkpoints.begin(), m_checkpoints.end(), t1, byTime);
+    end = hi == m_checkpoints.end() ? m_sourceSize : hi->offset;
+}
+
+const SessionSegment* SegmentIndex::game(uint32_t game) const
+{
+    for (const auto& s : m_segments) {
+        if (s.kind == SegmentKind::Game && s.game == game) {
+            return &s;
+        }
+    }
+    return nullptr;
+}
+
+size_t SegmentIndex::gameCount() const
+{
+    size_t count = 0;
+    for (const auto& s : m_segments) {
+        count += s.kind == SegmentKind::Game ? 1 : 0;
+    }
+    return count;
+}
+
+//----------------------------------------------------//
+//                  Index Files
+//----------------------------------------------------//
+
+std::string segmentIndexPath(const std::string& sessionPath)
+{
+    return sessionPath + ".segments";
+}
+
+bool loadOrBuildSegmentIndex(const std::string& sessionPath, const SegmentOptions& options,
+    SegmentIndex& index, bool rebuild)
+{
+    const std::string path = segmentIndexPath(sessionPath);
+    if (!rebuild && index.load(path) && index.sourceSize() == sessionFileSize(sessionPath)) {
+        return true;
+    }
+    if (!index.build(sessionPath, options)) {
+        return false;
+    }
+    index.save(path); // a read-only archive still gets its answer
+    return true;
+}
+
+bool forEachGameEvent(const std::string& sessionPath, uint32_t game,
+    uint32_t fromMs, uint32_t toMs, uint32_t& gameStartMs,
+    const std::function<void(const SessionEvent&)>& fn)
+{
+    SegmentIndex index;
+    if (!loadOrBuildSegmentIndex(sessionPath, SegmentOptions(), index)) {
+        return false;
+    }
+    const SessionSegment* seg = index.game(game);
+    if (!seg) {
+        return false;
+    }
+    gameStartMs = seg->startMs;
+
+    // Narrow the game's byte range with the checkpoints, then trim by time
+    const uint64_t t0 = std::max<uint64_t>(seg->startMs, static_cast<uint64_t>(seg->startMs) + fromMs);
+    const uint64_t t1 = std::min<uint64_t>(seg->endMs, static_cast<uint64_t>(seg->startMs) + toMs);
+    if (t0 > t1) {
+        return true; // nothing of the game in that window
+    }
+    uint64_t begin = 0, end = 0;
+    index.byteRange(static_cast<uint32_t>(t0), static_cast<uint32_t>(t1), begin, end);
+    begin = std::max(begin, seg->beginOffset);
+    end = std::min(end, seg->endOffset);
+
+    return forEachSessionEventInRange(sessionPath, begin, end, [&](const SessionEvent& evt) {
+        if (evt.timestamp >= t0 && evt.timestamp <= t1) {
+            fn(evt);
+        }
+    });
+}
@@ -0,0 +1,96 @@
+// session_segments.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "session_event.h"
+
+//----------------------------------------------------//
+//              Session Segmentation
+//----------------------------------------------------//
+
+enum class SegmentKind : uint8_t {
+    Idle,       // no input for at least idleGapMs
+    Active,     // input, but not game-like (queue, lobby, desktop)
+    Game        // sustained movement clicks and ability presses
+};
+
+const char* segmentKindToString(SegmentKind kind);
+SegmentKind segmentKindFromString(const std::string& name); // Idle if unknown
+
+struct SegmentOptions
+{
+    uint32_t binMs          = 10000;   // activity is measured per bin
+    uint32_t idleGapMs      = 60000;   // this much silence always splits
+    uint32_t idleTravelPx   = 50;      // cursor travel per bin that still counts as idle
+    uint32_t gameCastsPerMin  = 6;     // ability presses/min that make a bin game-like...
+    uint32_t gameMovesPerMin  = 20;    // ...or right clicks/min
+    uint32_t maxLullMs      = 120000;  // quieter stretches inside a game (deaths, shopping)
+    uint32_t minGameMs      = 300000;  // shorter game-like stretches are not games
+    std::vector<uint32_t> castKeys = { 'Q', 'W', 'E', 'R' };
+};
+
+struct SessionSegment
+{
+    SegmentKind kind;
+    uint32_t    game = 0;       // 1-based game number (Game segments only)
+    uint32_t    startMs = 0;    // first and last event
+    uint32_t    endMs = 0;
+    uint64_t    beginOffset = 0; // byte range of the segment's rows
+    uint64_t    endOffset = 0;
+    uint64_t    events = 0;
+    uint64_t    casts = 0;
+};
+
+// Where the first row of each bin starts, so time ranges map to byte ranges
+struct SegmentCheckpoint
+{
+    uint32_t timestamp;
+    uint64_t offset;
+};
+
+// Segments and checkpoints of one session, stored next to it as a small
+// text file so later passes can jump straight to a game
+class SegmentIndex {
+public:
+    // One pass over the session
+    bool build(const std::string& sessionPath, const SegmentOptions& options);
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    // Byte range that holds every row with a timestamp in [t0, t1]
+    // (it may hold a few rows outside it; filter by time when reading)
+    void byteRange(uint32_t t0, uint32_t t1, uint64_t& begin, uint64_t& end) const;
+
+    // Segment of game 'game' (1-based), or nullptr
+    const SessionSegment* game(uint32_t game) const;
+
+    uint64_t sourceSize() const { return m_sourceSize; }
+    const std::vector<SessionSegment>& segments() const { return m_segments; }
+    size_t gameCount() const;
+
+private:
+    uint64_t                        m_sourceSize = 0;
+    std::vector<SessionSegment>     m_segments;
+    std::vector<SegmentCheckpoint>  m_checkpoints;
+};
+
+// "<session>.segments"
+std::string segmentIndexPath(const std::string& sessionPath);
+
+// Loads the index next to the session, rebuilding it (and saving) when it is
+// missing, stale or 'rebuild' is set
+bool loadOrBuildSegmentIndex(const std::string& sessionPath, const SegmentOptions& options,
+    SegmentIndex& index, bool rebuild = false);
+
+// Streams the events of one game that lie [fromMs, toMs] after its first
+// event, reading only that part of the file. 'gameStartMs' receives the
+// game's first timestamp. Returns false if the session has no such game.
+bool forEachGameEvent(const std::string& sessionPath, uint32_t game,
+    uint32_t fromMs, uint32_t toMs, uint32_t& gameStartMs,
+    const std::function<void(const SessionEvent&)>& fn);
@@ -0,0 +1,11 @@
+// simd.h
+#pragma once
+
+// SSE2 is always there on x64 (MSVC and GCC/Clang) and on 32-bit builds with
+// /arch:SSE2 or -msse2. Everything that uses it keeps a scalar fallback.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SKILLSHOT_SSE2 1
+#include <emmintrin.h>
+#else
+#define SKILLSHOT_SSE2 0
+#endif
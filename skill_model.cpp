@@ -0,0 +1,383 @@
+#include "skill_model.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+
+#include "simd.h"
+
+static const uint32_t kAimLookbackMs = 150;
+static const uint32_t kSpeedLookbackMs = 60;
+static const uint32_t kPathLookbackMs = 500;
+static const uint32_t kHistoryMs = 1000;
+
+const char* castOutcomeFeatureName(size_t index)
+{
+    static const char* const kNames[kCastOutcomeDims] = {
+        "aim_px", "speed_px_s", "since_flick_ms", "flick_px", "straightness",
+        "presses_1s", "since_cast_ms", "path_px", "key_1", "key_2", "key_3", "key_4"
+    };
+    return index < kCastOutcomeDims ? kNames[index] : "";
+}
+
+//----------------------------------------------------//
+//            PreCastFeatures Implementation
+//----------------------------------------------------//
+
+PreCastFeatures::PreCastFeatures(const std::vector<uint32_t>& castKeys)
+    : m_castKeys(castKeys)
+{
+}
+
+const PreCastFeatures::Sample* PreCastFeatures::sampleAt(uint32_t t) const
+{
+    const Sample* found = nullptr;
+    for (auto it = m_samples.rbegin(); it != m_samples.rend(); ++it) {
+        found = &*it;
+        if (it->t <= t) {
+            break;
+        }
+    }
+    return found;   // the oldest sample if none is that old
+}
+
+bool PreCastFeatures::onEvent(const SessionEvent& evt, float* out)
+{
+    const uint32_t now = evt.timestamp;
+    while (!m_samples.empty() && now - m_samples.front().t > kHistoryMs) {
+        m_samples.pop_front();
+    }
+    while (!m_presses.empty() && now - m_presses.front() > kHistoryMs) {
+        m_presses.pop_front();
+    }
+
+    if (evt.kind == EventKind::MousePos) {
+        m_samples.push_back(Sample{ evt.x, evt.y, now });
+        Flick f;
+        if (m_flicks.onSample(PathPoint{ evt.x, evt.y, now }, f)) {
+            m_hasFlick = true;
+            m_lastFlick = f;
+        }
+        return false;
+    }
+    if (!m_pressFilter.isNewPress(evt)) {
+        return false;   // releases and auto-repeat
+    }
+    m_presses.push_back(now);
+
+    auto key = std::find(m_castKeys.begin(), m_castKeys.end(), evt.keyCode);
+    if (evt.kind != EventKind::KeyDown || key == m_castKeys.end()) {
+        return false;
+    }
+
+    std::fill(out, out + kCastOutcomeDims, 0.0f);
+    if (!m_samples.empty()) {
+        const Sample& cur = m_samples.back();
+        const Sample* aim = sampleAt(now - kAimLookbackMs);
+        const Sample* fast = sampleAt(now - kSpeedLookbackMs);
+        out[0] = static_cast<float>(std::log1p(std::hypot(cur.x - aim->x, cur.y - aim->y)));
+        if (cur.t > fast->t) {
+            out[1] = static_cast<float>(std::log1p(
+                std::hypot(cur.x - fast->x, cur.y - fast->y) * 1000.0 / (cur.t - fast->t)));
+        }
+
+        // Travelled vs. net distance over the last half second
+        double travelled = 0.0;
+        const Sample* start = nullptr;
+        const Sample* prev = nullptr;
+        for (const auto& s : m_samples) {
+            if (now - s.t > kPathLookbackMs) {
+                continue;
+            }
+            if (prev) {
+                travelled += std::hypot(s.x - prev->x, s.y - prev->y);
+            }
+            else {
+                start = &s;
+            }
+            prev = &s;
+        }
+        const double net = start ? std::hypot(cur.x - start->x, cur.y - start->y) : 0.0;
+        out[4] = travelled > 1.0 ? static_cast<float>(net / travelled) : 1.0f;
+        out[7] = static_cast<float>(std::log1p(travelled));
+    }
+    const double sinceFlick = m_hasFlick ? std::min(5000.0, static_cast<double>(now - m_lastFlick.endMs)) : 5000.0;
+    out[2] = static_cast<float>(std::log1p(sinceFlick));
+    out[3] = m_hasFlick ? static_cast<float>(std::log1p(m_lastFlick.distancePx)) : 0.0f;
+    out[5] = static_cast<float>(std::log1p(static_cast<double>(m_presses.size() - 1)));
+    const double sinceCast = m_hasCast ? std::min(10000.0, static_cast<double>(now - m_lastCastMs)) : 10000.0;
+    out[6] = static_cast<float>(std::log1p(sinceCast));
+    const size_t keyIndex = key - m_castKeys.begin();
+    if (keyIndex < 4) {
+        out[8 + keyIndex] = 1.0f;
+    }
+
+    m_hasCast = true;
+    m_lastCastMs = now;
+    return true;
+}
+
+//----------------------------------------------------//
+//                SIMD Kernels
+//----------------------------------------------------//
+
+static float dot(const float* a, const float* b)
+{
+#if SKILLSHOT_SSE2
+    __m128 acc = _mm_setzero_ps();
+    for (size_t i = 0; i < kCastOutcomeDims; i += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, acc);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+    float sum = 0.0f;
+    for (size_t i = 0; i < kCastOutcomeDims; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+#endif
+}
+
+// g += s * x
+static void axpy(float s, const float* x, float* g)
+{
+#if SKILLSHOT_SSE2
+    const __m128 vs = _mm_set1_ps(s);
+    for (size_t i = 0; i < kCastOutcomeDims; i += 4) {
+        _mm_storeu_ps(g + i, _mm_add_ps(_mm_loadu_ps(g + i), _mm_mul_ps(vs, _mm_loadu_ps(x + i))));
+    }
+#else
+    for (size_t i = 0; i < kCastOutcomeDims; ++i) {
+        g[i] += s * x[i];
+    }
+#endif
+}
+
+static double sigmoid(double z)
+{
+    return z >= 0.0 ? 1.0 / (1.0 + std::exp(-z)) : std::exp(z) / (1.0 + std::exp(z));
+}
+
+//----------------------------------------------------//
+//             LogisticModel Implementation
+//----------------------------------------------------//
+
+LogisticModel::LogisticModel()
+    : m_mean(kCastOutcomeDims, 0.0f), m_invStd(kCastOutcomeDims, 1.0f),
+      m_weights(kCastOutcomeDims, 0.0f), m_folded(kCastOutcomeDims, 0.0f)
+{
+}
+
+void LogisticModel::fold()
+{
+    double bias = m_bias;
+    for (size_t d = 0; d < kCastOutcomeDims; ++d) {
+        m_folded[d] = m_weights[d] * m_invStd[d];
+        bias -= static_cast<double>(m_folded[d]) * m_mean[d];
+    }
+    m_foldedBias = static_cast<float>(bias);
+}
+
+void LogisticModel::train(const std::vector<float>& x, const std::vector<uint8_t>& y,
+    const LogisticOptions& options)
+{
+    const size_t D = kCastOutcomeDims;
+    const size_t rows = y.size();
+    if (rows == 0) {
+        return;
+    }
+
+    // Standardize once; constant features keep scale 1
+    std::vector<double> sum(D, 0.0), sumSq(D, 0.0);
+    for (size_t r = 0; r < rows; ++r) {
+        for (size_t d = 0; d < D; ++d) {
+            sum[d] += x[r * D + d];
+            sumSq[d] += static_cast<double>(x[r * D + d]) * x[r * D + d];
+        }
+    }
+    for (size_t d = 0; d < D; ++d) {
+        const double mean = sum[d] / rows;
+        const double var = sumSq[d] / rows - mean * mean;
+        m_mean[d] = static_cast<float>(mean);
+        m_invStd[d] = var > 1e-8 ? static_cast<float>(1.0 / std::sqrt(var)) : 1.0f;
+    }
+    std::vector<float> z(rows * D);
+    for (size_t r = 0; r < rows; ++r) {
+        for (size_t d = 0; d < D; ++d) {
+            z[r * D + d] = (x[r * D + d] - m_mean[d]) * m_invStd[d];
+        }
+    }
+
+    // Start from the base rate
+    const double positives = std::accumulate(y.begin(), y.end(), 0.0);
+    const double rate = std::min(1.0 - 1e-3, std::max(1e-3, positives / rows));
+    std::fill(m_weights.begin(), m_weights.end(), 0.0f);
+    m_bias = static_cast<float>(std::log(rate / (1.0 - rate)));
+
+    std::vector<size_t> order(rows);
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937 rng(options.seed);
+    const size_t batch = std::max<uint32_t>(1, options.batch);
+    std::vector<float> grad(D);
+
+    for (uint32_t epoch = 0; epoch < options.epochs; ++epoch) {
+        std::shuffle(order.begin(), order.end(), rng);
+        const float lr = static_cast<float>(options.learningRate / std::sqrt(1.0 + epoch));
+        for (size_t begin = 0; begin < rows; begin += batch) {
+            const size_t end = std::min(rows, begin + batch);
+            std::fill(grad.begin(), grad.end(), 0.0f);
+            float gradBias = 0.0f;
+            for (size_t i = begin; i < end; ++i) {
+                const float* row = &z[order[i] * D];
+                const float err = static_cast<float>(sigmoid(dot(m_weights.data(), row) + m_bias)) - y[order[i]];
+                axpy(err, row, grad.data());
+                gradBias += err;
+            }
+            const float scale = lr / static_cast<float>(end - begin);
+            const float decay = 1.0f - lr * static_cast<float>(options.l2);
+            for (size_t d = 0; d < D; ++d) {
+                m_weights[d] = m_weights[d] * decay - scale * grad[d];
+            }
+            m_bias -= scale * gradBias;
+        }
+    }
+    fold();
+}
+
+double LogisticModel::predict(const float* features) const
+{
+    return sigmoid(dot(m_folded.data(), features) + m_foldedBias);
+}
+
+LogisticMetrics LogisticModel::evaluate(const std::vector<float>& x, const std::vector<uint8_t>& y) const
+{
+    LogisticMetrics m;
+    m.rows = y.size();
+    if (m.rows == 0) {
+        return m;
+    }
+    std::vector<std::pair<double, uint8_t>> scored(m.rows);
+    size_t correct = 0;
+    for (size_t r = 0; r < m.rows; ++r) {
+        const double p = std::min(1.0 - 1e-12, std::max(1e-12, predict(&x[r * kCastOutcomeDims])));
+        m.logLoss -= y[r] ? std::log(p) : std::log(1.0 - p);
+        correct += (p >= 0.5) == (y[r] != 0) ? 1 : 0;
+        scored[r] = std::make_pair(p, y[r]);
+    }
+    m.logLoss /= m.rows;
+    m.accuracy = static_cast<double>(correct) / m.rows;
+
+    // AUC from ranks (ties get their mean rank)
+    std::sort(scored.begin(), scored.end());
+    double rankSum = 0.0, pos = 0.0;
+    for (size_t i = 0; i < scored.size();) {
+        size_t j = i;
+        while (j < scored.size() && scored[j].first == scored[i].first) {
+            ++j;
+        }
+        const double rank = (i + j + 1) / 2.0;
+        for (size_t k = i; k < j; ++k) {
+            if (scored[k].second) {
+                rankSum += rank;
+                pos += 1.0;
+            }
+        }
+        i = j;
+    }
+    const double neg = m.rows - pos;
+    m.auc = (pos > 0.0 && neg > 0.0) ? (rankSum - pos * (pos + 1.0) / 2.0) / (pos * neg) : 0.5;
+    return m;
+}
+
+bool LogisticModel::save(const std::string& path) const
+{
+    std::ofstream ofs(path, std::ios::trunc);
+    if (!ofs.is_open()) {
+        std::cerr << "Failed to open model file for writing: " << path << "\n";
+        return false;
+    }
+    ofs << "# skillshot logistic v1\n" << std::setprecision(9);
+    auto line = [&ofs](const char* tag, const std::vector<float>& v) {
+        ofs << tag;
+        for (float f : v) {
+            ofs << " " << f;
+        }
+        ofs << "\n";
+    };
+    line("mean", m_mean);
+    line("scale", m_invStd);
+    line("weights", m_weights);
+    ofs << "bias " << m_bias << "\n";
+    return static_cast<bool>(ofs);
+}
+
+bool LogisticModel::load(const std::string& path)
+{
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) {
+        std::cerr << "Failed to open model file: " << path << "\n";
+        return false;
+    }
+    std::string line;
+    if (!std::getline(ifs, line) || line != "# skillshot logistic v1") {
+        std::cerr << "Not a logistic model file: " << path << "\n";
+        return false;
+    }
+    size_t groups = 0;
+    while (std::getline(ifs, line)) {
+        std::istringstream iss(line);
+        std::string tag;
+        iss >> tag;
+        std::vector<float>* target = tag == "mean" ? &m_mean :
+            tag == "scale" ? &m_invStd : tag == "weights" ? &m_weights : nullptr;
+        if (target) {
+            size_t n = 0;
+            while (n < kCastOutcomeDims && iss >> (*target)[n]) {
+                ++n;
+            }
+            groups += n == kCastOutcomeDims ? 1 : 0;
+        }
+        else if (tag == "bias" && iss >> m_bias) {
+            ++groups;
+        }
+    }
+    if (groups != 4) {
+        std::cerr << "Malformed logistic model file: " << path << "\n";
+        return false;
+    }
+    fold();
+    return true;
+}
+
+//----------------------------------------------------//
+//               Live Inference
+//----------------------------------------------------//
+
+CastScoreOperator::CastScoreOperator(const LogisticModel& model, const std::vector<uint32_t>& castKeys)
+    : m_model(model), m_features(castKeys)
+{
+}
+
+void CastScoreOperator::onEvent(const SessionEvent& evt, std::vector<LiveResult>& out)
+{
+    float features[kCastOutcomeDims];
+    const auto begin = std::chrono::steady_clock::now();
+    if (!m_features.onEvent(evt, features)) {
+        return;
+    }
+    const double p = m_model.predict(features);
+    const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+
+    std::ostringstream oss;
+    oss << vkToKeyName(evt.keyCode) << " hit chance " << static_cast<int>(p * 100.0 + 0.5)
+        << "% (scored in " << std::fixed << std::setprecision(1) << us << " us)";
+    out.push_back(LiveResult{ name(), evt.timestamp, evt.timestamp, p, oss.str() });
+}
@@ -0,0 +1,124 @@
+// skill_model.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "session_event.h"
+#include "live_analysis.h"
+
+//----------------------------------------------------//
+//               Pre-Cast Features
+//----------------------------------------------------//
+
+// Floats per cast; a multiple of the SIMD width. See castOutcomeFeatureName.
+const size_t kCastOutcomeDims = 12;
+
+const char* castOutcomeFeatureName(size_t index);
+
+// Features of a cast from what happened just before it: aim movement,
+// cursor speed, time since the last flick landed, straightness, press rate,
+// time since the previous cast and which key it was. Streaming and the same
+// code offline and live, so training and inference see identical inputs.
+class PreCastFeatures {
+public:
+    explicit PreCastFeatures(const std::vector<uint32_t>& castKeys);
+
+    // Returns true and fills 'out' (kCastOutcomeDims floats) for cast presses
+    bool onEvent(const SessionEvent& evt, float* out);
+
+private:
+    struct Sample
+    {
+        int32_t  x, y;
+        uint32_t t;
+    };
+
+    const Sample* sampleAt(uint32_t t) const;   // last sample at or before t
+
+private:
+    std::vector<uint32_t> m_castKeys;
+    std::deque<Sample>    m_samples;      // last second of cursor positions
+    std::deque<uint32_t>  m_presses;      // press times of the last second
+    PressFilter           m_pressFilter;
+    FlickTracker          m_flicks;
+    bool                  m_hasFlick = false;
+    Flick                 m_lastFlick{};
+    bool                  m_hasCast = false;
+    uint32_t              m_lastCastMs = 0;
+};
+
+//----------------------------------------------------//
+//               Logistic Regression
+//----------------------------------------------------//
+
+struct LogisticOptions
+{
+    uint32_t epochs = 60;
+    uint32_t batch = 32;
+    double   learningRate = 0.1;   // decays with 1 / sqrt(epoch)
+    double   l2 = 1e-4;
+    uint32_t seed = 1;             // shuffling; fixed so runs repeat
+};
+
+struct LogisticMetrics
+{
+    size_t rows = 0;
+    double logLoss = 0.0;
+    double accuracy = 0.0;
+    double auc = 0.0;
+};
+
+// P(hit | features). Features are standardized with the training mean and
+// deviation; after training the scaling is folded into the weights, so
+// inference is one dot product (SSE2) and a sigmoid.
+class LogisticModel {
+public:
+    LogisticModel();
+
+    // 'x' is rows x kCastOutcomeDims, 'y' 0/1 per row
+    void train(const std::vector<float>& x, const std::vector<uint8_t>& y, const LogisticOptions& options);
+
+    double predict(const float* features) const;
+
+    LogisticMetrics evaluate(const std::vector<float>& x, const std::vector<uint8_t>& y) const;
+
+    // Standardized-space weight per feature (comparable across features)
+    double weight(size_t index) const { return m_weights[index]; }
+
+    // Text file: "# skillshot logistic v1" then mean, scale, weights, bias
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+private:
+    void fold();
+
+private:
+    std::vector<float> m_mean;
+    std::vector<float> m_invStd;
+    std::vector<float> m_weights;     // standardized space
+    float              m_bias = 0.0f;
+    std::vector<float> m_folded;      // weights * invStd, for raw features
+    float              m_foldedBias = 0.0f;
+};
+
+//----------------------------------------------------//
+//                Live Inference
+//----------------------------------------------------//
+
+// Scores every cast on the live stream ("hitprob")
+class CastScoreOperator : public LiveOperator {
+public:
+    CastScoreOperator(const LogisticModel& model, const std::vector<uint32_t>& castKeys);
+
+    const char* name() const override { return "hitprob"; }
+    void onEvent(const SessionEvent& evt, std::vector<LiveResult>& out) override;
+    void onIdle(uint32_t, std::vector<LiveResult>&) override {}
+
+private:
+    LogisticModel   m_model;
+    PreCastFeatures m_features;
+};
@@ -0,0 +1,299 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <thread>
+#include <utility>
+
+// Ranges this small are scanned instead of split further
+static const size_t kLeafSize = 8;
+
+// Split dimensions cycle x, y, time
+static const unsigned kDims    = 3;
+static const unsigned kTimeDim = 2;
+
+static inline int64_t coord(const SpatialPoint& p, unsigned dim)
+{
+    return dim == 0 ? p.x : dim == 1 ? p.y : static_cast<int64_t>(p.timestamp);
+}
+
+static inline int64_t dist2(const SpatialPoint& a, const SpatialPoint& b)
+{
+    int64_t dx = static_cast<int64_t>(a.x) - b.x;
+    int64_t dy = static_cast<int64_t>(a.y) - b.y;
+    return dx * dx + dy * dy;
+}
+
+void collectSpatialPoints(const std::vector<SessionEvent>& events,
+    std::vector<SpatialPoint>& out)
+{
+    out.clear();
+    PressFilter presses;
+    for (size_t i = 0; i < events.size(); ++i) {
+        const SessionEvent& evt = events[i];
+        if (presses.isNewPress(evt)) {
+            out.push_back(SpatialPoint{ evt.x, evt.y, evt.timestamp, evt.kind,
+                evt.keyCode, static_cast<uint32_t>(i) });
+        }
+    }
+}
+
+//----------------------------------------------------//
+//                      Build
+//----------------------------------------------------//
+
+void SpatialIndex::build(std::vector<SpatialPoint> points, unsigned threads)
+{
+    m_points = std::move(points);
+
+    // Each parallel level doubles the number of concurrent subtrees
+    unsigned parallelDepth = 0;
+    while ((1u << parallelDepth) < threads && parallelDepth < 6) {
+        ++parallelDepth;
+    }
+    buildRange(0, m_points.size(), 0, parallelDepth);
+}
+
+void SpatialIndex::buildRange(size_t lo, size_t hi, unsigned depth, unsigned parallelDepth)
+{
+    if (hi - lo <= kLeafSize) {
+        return;
+    }
+
+    const unsigned dim = depth % kDims;
+    const size_t mid = lo + (hi - lo) / 2;
+    std::nth_element(m_points.begin() + lo, m_points.begin() + mid, m_points.begin() + hi,
+        [dim](const SpatialPoint& a, const SpatialPoint& b) {
+            return coord(a, dim) < coord(b, dim);
+        });
+
+    if (parallelDepth > 0) {
+        std::thread left(&SpatialIndex::buildRange, this, lo, mid, depth + 1, parallelDepth - 1);
+        buildRange(mid + 1, hi, depth + 1, parallelDepth - 1);
+        left.join();
+    }
+    else {
+        buildRange(lo, mid, depth + 1, 0);
+        buildRange(mid + 1, hi, depth + 1, 0);
+    }
+}
+
+//----------------------------------------------------//
+//                     Queries
+//----------------------------------------------------//
+
+namespace {
+
+struct Range
+{
+    size_t   lo;
+    size_t   hi;
+    unsigned depth;
+    int64_t  planeDist2; // lower bound on the distance to anything in the range
+};
+
+// Absolute time bounds of a window around the query
+struct TimeBounds
+{
+    int64_t min;
+    int64_t max;
+
+    TimeBounds(const SpatialPoint& q, const SpatialTimeWindow& window)
+        : min(static_cast<int64_t>(q.timestamp) - window.before)
+        , max(static_cast<int64_t>(q.timestamp) + window.after)
+    {
+    }
+
+    bool contains(const SpatialPoint& p) const { return p.timestamp >= min && p.timestamp <= max; }
+};
+
+} // namespace
+
+void SpatialIndex::radius(const SpatialPoint& q, double radius, std::vector<uint32_t>& out,
+    const SpatialTimeWindow& window, const Filter& filter) const
+{
+    out.clear();
+    const int64_t r = static_cast<int64_t>(std::ceil(radius));
+    const int64_t r2 = static_cast<int64_t>(std::floor(radius * radius));
+    const TimeBounds time(q, window);
+
+    auto visit = [&](size_t i) {
+        if (time.contains(m_points[i]) && dist2(q, m_points[i]) <= r2 &&
+            (!filter || filter(q, m_points[i]))) {
+            out.push_back(static_cast<uint32_t>(i));
+        }
+    };
+
+    std::vector<Range> stack;
+    stack.push_back(Range{ 0, m_points.size(), 0, 0 });
+    while (!stack.empty()) {
+        Range n = stack.back();
+        stack.pop_back();
+        if (n.hi - n.lo <= kLeafSize) {
+            for (size_t i = n.lo; i < n.hi; ++i) {
+                visit(i);
+            }
+            continue;
+        }
+
+        const unsigned dim = n.depth % kDims;
+        const size_t mid = n.lo + (n.hi - n.lo) / 2;
+        visit(mid);
+
+        if (dim == kTimeDim) {
+            const int64_t split = coord(m_points[mid], dim);
+            if (time.min <= split) {
+                stack.push_back(Range{ n.lo, mid, n.depth + 1, 0 });
+            }
+            if (time.max >= split) {
+                stack.push_back(Range{ mid + 1, n.hi, n.depth + 1, 0 });
+            }
+            continue;
+        }
+
+        int64_t diff = coord(q, dim) - coord(m_points[mid], dim);
+        if (diff - r <= 0) {
+            stack.push_back(Range{ n.lo, mid, n.depth + 1, 0 });
+        }
+        if (diff + r >= 0) {
+            stack.push_back(Range{ mid + 1, n.hi, n.depth + 1, 0 });
+        }
+    }
+}
+
+void SpatialIndex::nearest(const SpatialPoint& q, size_t k, std::vector<uint32_t>& out,
+    const SpatialTimeWindow& window, const Filter& filter) const
+{
+    out.clear();
+    if (k == 0) {
+        return;
+    }
+    const TimeBounds time(q, window);
+
+    // Max-heap of the best k so far: top is the current worst
+    std::priority_queue<std::pair<int64_t, uint32_t>> best;
+    auto visit = [&](size_t i) {
+        if (!time.contains(m_points[i])) {
+            return;
+        }
+        int64_t d = dist2(q, m_points[i]);
+        if (best.size() == k && d >= best.top().first) {
+            return;
+        }
+        if (filter && !filter(q, m_points[i])) {
+            return;
+        }
+        best.push(std::make_pair(d, static_cast<uint32_t>(i)));
+        if (best.size() > k) {
+            best.pop();
+        }
+    };
+
+    std::vector<Range> stack;
+    stack.push_back(Range{ 0, m_points.size(), 0, 0 });
+    while (!stack.empty()) {
+        Range n = stack.back();
+        stack.pop_back();
+        if (best.size() == k && n.planeDist2 >= best.top().first) {
+            continue; // whole range is farther than the current worst
+        }
+        if (n.hi - n.lo <= kLeafSize) {
+            for (size_t i = n.lo; i < n.hi; ++i) {
+                visit(i);
+            }
+            continue;
+        }
+
+        const unsigned dim = n.depth % kDims;
+        const size_t mid = n.lo + (n.hi - n.lo) / 2;
+        visit(mid);
+
+        if (dim == kTimeDim) {
+            // No distance bound from a time split, only the window
+            const int64_t split = coord(m_points[mid], dim);
+            if (time.min <= split) {
+                stack.push_back(Range{ n.lo, mid, n.depth + 1, n.planeDist2 });
+            }
+            if (time.max >= split) {
+                stack.push_back(Range{ mid + 1, n.hi, n.depth + 1, n.planeDist2 });
+            }
+            continue;
+        }
+
+        int64_t diff = coord(q, dim) - coord(m_points[mid], dim);
+        Range left{ n.lo, mid, n.depth + 1, n.planeDist2 };
+        Range right{ mid + 1, n.hi, n.depth + 1, n.planeDist2 };
+        int64_t plane = std::max(n.planeDist2, diff * diff);
+
+        // Far side first so the near side is popped (and tightens the bound) first
+        if (diff <= 0) {
+            right.planeDist2 = plane;
+            stack.push_back(right);
+            stack.push_back(left);
+        }
+        else {
+            left.planeDist2 = plane;
+            stack.push_back(left);
+            stack.push_back(right);
+        }
+    }
+
+    out.resize(best.size());
+    for (size_t i = best.size(); i > 0; --i) {
+        out[i - 1] = best.top().second;
+        best.pop();
+    }
+}
+
+//----------------------------------------------------//
+//                  Batch Queries
+//----------------------------------------------------//
+
+// Runs fn(i) for i in [0, count), split into contiguous chunks per thread
+template <typename Fn>
+static void parallelFor(size_t count, unsigned threads, Fn fn)
+{
+    threads = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(count / 64 + 1)));
+    if (threads == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    const size_t chunk = (count + threads - 1) / threads;
+    for (unsigned t = 0; t < threads; ++t) {
+        size_t begin = t * chunk;
+        size_t end = std::min(count, begin + chunk);
+        workers.emplace_back([begin, end, &fn]() {
+            for (size_t i = begin; i < end; ++i) {
+                fn(i);
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+}
+
+void SpatialIndex::radiusBatch(const std::vector<SpatialPoint>& queries, double radius,
+    std::vector<std::vector<uint32_t>>& out, unsigned threads, const SpatialTimeWindow& window,
+    const Filter& filter) const
+{
+    out.assign(queries.size(), std::vector<uint32_t>());
+    parallelFor(queries.size(), threads, [&](size_t i) {
+        this->radius(queries[i], radius, out[i], window, filter);
+    });
+}
+
+void SpatialIndex::nearestBatch(const std::vector<SpatialPoint>& queries, size_t k,
+    std::vector<std::vector<uint32_t>>& out, unsigned threads, const SpatialTimeWindow& window,
+    const Filter& filter) const
+{
+    out.assign(queries.size(), std::vector<uint32_t>());
+    parallelFor(queries.size(), threads, [&](size_t i) {
+        nearest(queries[i], k, out[i], window, filter);
+    });
+}
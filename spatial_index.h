@@ -0,0 +1,81 @@
+// spatial_index.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "session_event.h"
+
+//----------------------------------------------------//
+//           Click / Cast Location Records
+//----------------------------------------------------//
+
+struct SpatialPoint
+{
+    int32_t   x;
+    int32_t   y;
+    uint32_t  timestamp;
+    EventKind kind;
+    uint32_t  keyCode;
+    uint32_t  eventIndex; // position in the session's event list
+};
+
+// Candidate times relative to a query point: q.timestamp - before through
+// q.timestamp + after, inclusive
+struct SpatialTimeWindow
+{
+    uint32_t before;
+    uint32_t after;
+};
+
+static const SpatialTimeWindow kAnyTime = { 0xFFFFFFFFu, 0xFFFFFFFFu };
+
+// Press events (clicks and key downs, without auto-repeat) with their cursor positions
+void collectSpatialPoints(const std::vector<SessionEvent>& events,
+    std::vector<SpatialPoint>& out);
+
+//----------------------------------------------------//
+//            SpatialIndex (static k-d tree)
+//----------------------------------------------------//
+
+// Implicit k-d tree: the points are reordered in place so every subtree is
+// one contiguous range with its splitting point in the middle. No node
+// objects or pointers, so queries walk a single cache-friendly array.
+// Levels split on x, y and time in turn; time never counts towards the
+// distance, it only lets a query with a time window skip whole subtrees.
+//
+// Query results are indices into points(). Filters are optional and see the
+// query point and a candidate, e.g. "right clicks".
+class SpatialIndex {
+public:
+    using Filter = std::function<bool(const SpatialPoint& query, const SpatialPoint& candidate)>;
+
+    // O(n log n); the top levels are split across 'threads' threads
+    void build(std::vector<SpatialPoint> points, unsigned threads = 1);
+
+    const std::vector<SpatialPoint>& points() const { return m_points; }
+
+    // All points within 'radius' pixels of q and inside the time window (unordered)
+    void radius(const SpatialPoint& q, double radius, std::vector<uint32_t>& out,
+        const SpatialTimeWindow& window = kAnyTime, const Filter& filter = Filter()) const;
+
+    // The k nearest points to q inside the time window, closest first
+    void nearest(const SpatialPoint& q, size_t k, std::vector<uint32_t>& out,
+        const SpatialTimeWindow& window = kAnyTime, const Filter& filter = Filter()) const;
+
+    // Batch versions: one result list per query, queries split across threads
+    void radiusBatch(const std::vector<SpatialPoint>& queries, double radius,
+        std::vector<std::vector<uint32_t>>& out, unsigned threads,
+        const SpatialTimeWindow& window = kAnyTime, const Filter& filter = Filter()) const;
+    void nearestBatch(const std::vector<SpatialPoint>& queries, size_t k,
+        std::vector<std::vector<uint32_t>>& out, unsigned threads,
+        const SpatialTimeWindow& window = kAnyTime, const Filter& filter = Filter()) const;
+
+private:
+    void buildRange(size_t lo, size_t hi, unsigned depth, unsigned parallelDepth);
+
+private:
+    std::vector<SpatialPoint> m_points;
+};
@@ -0,0 +1,160 @@
+#include "thread_pool.h"
+
+#if defined(_WIN32)
+#define NOMINMAX // keep std::min/std::max usable
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// Worker index of the current thread (-1 for threads outside any pool)
+static thread_local int t_workerIndex = -1;
+
+//----------------------------------------------------//
+//           WorkStealingPool Implementation
+//----------------------------------------------------//
+
+WorkStealingPool::WorkStealingPool(unsigned threads)
+{
+    if (threads == 0) {
+        threads = 1;
+    }
+    for (unsigned i = 0; i < threads; ++i) {
+        m_workers.emplace_back(new Worker());
+    }
+    for (unsigned i = 0; i < threads; ++i) {
+        m_threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop.store(true);
+    }
+    m_workAvailable.notify_all();
+    for (auto& t : m_threads) {
+        t.join();
+    }
+}
+
+int WorkStealingPool::currentWorker()
+{
+    return t_workerIndex;
+}
+
+void WorkStealingPool::submit(Task task)
+{
+    m_pending.fetch_add(1);
+
+    // Own deque when called from a worker, otherwise round-robin
+    unsigned target = (t_workerIndex >= 0 && static_cast<size_t>(t_workerIndex) < m_workers.size())
+        ? static_cast<unsigned>(t_workerIndex)
+        : m_nextWorker.fetch_add(1) % static_cast<unsigned>(m_workers.size());
+    {
+        std::lock_guard<std::mutex> lock(m_workers[target]->mutex);
+        m_workers[target]->tasks.push_back(std::move(task));
+    }
+
+    {
+        // Pairs with the predicate check in workerLoop so no wake-up is lost
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_queued.fetch_add(1);
+    }
+    m_workAvailable.notify_one();
+}
+
+void WorkStealingPool::wait()
+{
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_allDone.wait(lock, [this]() { return m_pending.load() == 0; });
+}
+
+bool WorkStealingPool::popLocal(unsigned index, Task& task)
+{
+    Worker& w = *m_workers[index];
+    std::lock_guard<std::mutex> lock(w.mutex);
+    if (w.tasks.empty()) {
+        return false;
+    }
+    task = std::move(w.tasks.back());
+    w.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(unsigned thief, Task& task)
+{
+    const unsigned n = static_cast<unsigned>(m_workers.size());
+    for (unsigned k = 1; k < n; ++k) {
+        Worker& victim = *m_workers[(thief + k) % n];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.tasks.empty()) {
+            continue;
+        }
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        m_steals.fetch_add(1);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(unsigned index)
+{
+    t_workerIndex = static_cast<int>(index);
+
+    while (true) {
+        Task task;
+        if (popLocal(index, task) || steal(index, task)) {
+            m_queued.fetch_sub(1);
+            task();
+
+            if (m_pending.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(m_sleepMutex);
+                m_allDone.notify_all();
+            }
+            continue;
+        }
+
+        // Nothing to do: sleep until something is queued. A steal attempt can
+        // miss a deque whose lock was busy, so wake up now and then anyway.
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        if (m_stop.load()) {
+            break;
+        }
+        m_workAvailable.wait_for(lock, std::chrono::milliseconds(2), [this]() {
+            return m_stop.load() || m_queued.load() > 0;
+        });
+        if (m_stop.load() && m_queued.load() == 0) {
+            break;
+        }
+    }
+
+    t_workerIndex = -1;
+}
+
+//----------------------------------------------------//
+//                  Thread CPU Time
+//----------------------------------------------------//
+
+uint64_t threadCpuTimeNs()
+{
+#if defined(_WIN32)
+    FILETIME creation, exitTime, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exitTime, &kernel, &user)) {
+        return 0;
+    }
+    auto toNs = [](const FILETIME& ft) {
+        return ((static_cast<uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime) * 100;
+    };
+    return toNs(kernel) + toNs(user);
+#else
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+#endif
+}
@@ -0,0 +1,72 @@
+// thread_pool.h
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------//
+//              Work-Stealing Thread Pool
+//----------------------------------------------------//
+
+// Every worker owns a deque. Tasks submitted from a worker go to the back of
+// its own deque and are taken LIFO (hot caches, depth-first); idle workers
+// steal from the front of someone else's deque (oldest, usually the biggest
+// remaining piece of work). Tasks submitted from outside are spread
+// round-robin.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(unsigned threads = std::thread::hardware_concurrency());
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Safe from any thread, including from inside a running task
+    void submit(Task task);
+
+    // Blocks until every submitted task (and everything they submitted) ran
+    void wait();
+
+    unsigned threadCount() const { return static_cast<unsigned>(m_threads.size()); }
+    uint64_t stealCount() const { return m_steals.load(); }
+
+    // Index of the calling worker in [0, threadCount()), or -1 outside the pool
+    static int currentWorker();
+
+private:
+    struct Worker
+    {
+        std::mutex       mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(unsigned index);
+    bool popLocal(unsigned index, Task& task);
+    bool steal(unsigned thief, Task& task);
+
+private:
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread>             m_threads;
+
+    std::atomic<bool>                    m_stop{ false };
+    std::atomic<size_t>                  m_queued{ 0 };   // tasks sitting in deques
+    std::atomic<size_t>                  m_pending{ 0 };  // submitted but not finished
+    std::atomic<unsigned>                m_nextWorker{ 0 };
+    std::atomic<uint64_t>                m_steals{ 0 };
+
+    std::mutex                           m_sleepMutex;
+    std::condition_variable              m_workAvailable;
+    std::condition_variable              m_allDone;
+};
+
+// CPU time consumed by the calling thread, in nanoseconds
+uint64_t threadCpuTimeNs();
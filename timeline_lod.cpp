@@ -0,0 +1,334 @@
+#include "timeline_lod.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+//----------------------------------------------------//
+//                Series Extraction
+//----------------------------------------------------//
+
+// Presses per second over the trailing second, sampled every 'stepMs'
+static void pressRateSeries(const std::vector<SessionEvent>& events, bool mouse,
+    std::vector<SeriesPoint>& out)
+{
+    const uint32_t kWindowMs = 1000;
+    const uint32_t kStepMs = 100;
+    if (events.empty()) {
+        return;
+    }
+
+    std::vector<uint32_t> presses;
+    for (const auto& evt : events) {
+        bool isMouse = evt.kind == EventKind::MouseLeftDown || evt.kind == EventKind::MouseRightDown;
+        bool isKey = evt.kind == EventKind::KeyDown;
+        if ((mouse && isMouse) || (!mouse && isKey)) {
+            presses.push_back(evt.timestamp);
+        }
+    }
+
+    const uint32_t first = events.front().timestamp;
+    const uint32_t last = events.back().timestamp;
+    size_t head = 0; // first press after the sample time
+    size_t tail = 0; // first press inside the window
+    for (uint32_t t = first; t <= last; t += kStepMs) {
+        while (head < presses.size() && presses[head] <= t) {
+            ++head;
+        }
+        while (tail < head && presses[tail] + kWindowMs <= t) {
+            ++tail;
+        }
+        out.push_back(SeriesPoint{ static_cast<double>(t),
+            (head - tail) * 1000.0 / kWindowMs });
+    }
+}
+
+bool extractSeries(const std::vector<SessionEvent>& events, const std::string& column,
+    std::vector<SeriesPoint>& out)
+{
+    out.clear();
+    if (column == "clickrate" || column == "keyrate") {
+        pressRateSeries(events, column == "clickrate", out);
+        return true;
+    }
+    if (column != "x" && column != "y" && column != "speed") {
+        std::cerr << "Unknown timeline column: " << column << "\n";
+        return false;
+    }
+
+    const SessionEvent* prev = nullptr;
+    for (const auto& evt : events) {
+        if (evt.kind != EventKind::MousePos) {
+            continue;
+        }
+        double t = static_cast<double>(evt.timestamp);
+        if (column == "x") {
+            out.push_back(SeriesPoint{ t, static_cast<double>(evt.x) });
+        }
+        else if (column == "y") {
+            out.push_back(SeriesPoint{ t, static_cast<double>(evt.y) });
+        }
+        else if (prev && evt.timestamp > prev->timestamp) {
+            double dist = std::hypot(static_cast<double>(evt.x) - prev->x,
+                static_cast<double>(evt.y) - prev->y);
+            out.push_back(SeriesPoint{ t, dist * 1000.0 / (evt.timestamp - prev->timestamp) });
+        }
+        prev = &evt;
+    }
+    return true;
+}
+
+//----------------------------------------------------//
+//                      LTTB
+//----------------------------------------------------//
+
+void lttbDownsample(const SeriesPoint* data, size_t count, size_t threshold,
+    std::vector<SeriesPoint>& out)
+{
+    out.clear();
+    if (threshold >= count || threshold < 3) {
+        out.assign(data, data + count);
+        return;
+    }
+    out.reserve(threshold);
+
+    // Interior points are split into threshold-2 buckets
+    const double every = static_cast<double>(count - 2) / (threshold - 2);
+    size_t a = 0;
+    out.push_back(data[0]);
+
+    for (size_t i = 0; i < threshold - 2; ++i) {
+        // Average of the next bucket is the third triangle corner
+        size_t avgBegin = static_cast<size_t>(std::floor((i + 1) * every)) + 1;
+        size_t avgEnd = std::min(static_cast<size_t>(std::floor((i + 2) * every)) + 1, count);
+        double avgT = 0.0, avgV = 0.0;
+        if (avgBegin >= avgEnd) {
+            avgT = data[count - 1].t;
+            avgV = data[count - 1].v;
+        }
+        else {
+            for (size_t j = avgBegin; j < avgEnd; ++j) {
+                avgT += data[j].t;
+                avgV += data[j].v;
+            }
+            avgT /= static_cast<double>(avgEnd - avgBegin);
+            avgV /= static_cast<double>(avgEnd - avgBegin);
+        }
+
+        // Pick the point of this bucket with the largest triangle
+        size_t begin = static_cast<size_t>(std::floor(i * every)) + 1;
+        size_t end = std::min(static_cast<size_t>(std::floor((i + 1) * every)) + 1, count - 1);
+        const double at = data[a].t, av = data[a].v;
+        double bestArea = -1.0;
+        size_t best = begin;
+        for (size_t j = begin; j < end; ++j) {
+            double area = std::fabs((at - avgT) * (data[j].v - av) -
+                (at - data[j].t) * (avgV - av));
+            if (area > bestArea) {
+                bestArea = area;
+                best = j;
+            }
+        }
+
+        out.push_back(data[best]);
+        a = best;
+    }
+
+    out.push_back(data[count - 1]);
+}
+
+//----------------------------------------------------//
+//               TimelineCache Implementation
+//----------------------------------------------------//
+
+static const size_t   kLevelFactor    = 4;    // each level is 1/4 of the previous
+static const size_t   kMinLevelPoints = 1024; // stop once a level is this small
+static const size_t   kOversample     = 4;    // a level may hold 4x the requested points
+static const uint32_t kMaxLevels      = 64;
+static const char     kCacheMagic[4]  = { 'S', 'S', 'L', 'T' };
+static const uint32_t kCacheVersion   = 2;    // 2: level directory, source mtime
+
+// magic, version, source size, source mtime, level count
+static const uint64_t kHeaderBytes = sizeof(kCacheMagic) + sizeof(uint32_t) +
+    sizeof(uint64_t) + sizeof(int64_t) + sizeof(uint32_t);
+
+void TimelineCache::build(const std::vector<SeriesPoint>& raw)
+{
+    m_file.close();
+    m_directory.clear();
+    m_levels.clear();
+    m_levels.push_back(raw);
+
+    size_t target = raw.size() / kLevelFactor;
+    while (m_levels.back().size() > kMinLevelPoints && target >= 3) {
+        std::vector<SeriesPoint> level;
+        lttbDownsample(raw.data(), raw.size(), target, level);
+        m_levels.push_back(std::move(level));
+        target /= kLevelFactor;
+    }
+
+    for (const auto& level : m_levels) {
+        m_directory.push_back(LevelEntry{ 0, level.size() });
+    }
+}
+
+double TimelineCache::timeAt(size_t level, uint64_t index) const
+{
+    if (!m_levels.empty()) {
+        return m_levels[level][static_cast<size_t>(index)].t;
+    }
+    double t = 0.0;
+    m_file.seekg(static_cast<std::streamoff>(m_directory[level].offset + index * sizeof(SeriesPoint)));
+    m_file.read(reinterpret_cast<char*>(&t), sizeof(t));
+    return t;
+}
+
+uint64_t TimelineCache::searchTime(size_t level, double t, bool after, uint64_t begin) const
+{
+    uint64_t end = m_directory[level].count;
+    while (begin < end) {
+        uint64_t mid = begin + (end - begin) / 2;
+        double tm = timeAt(level, mid);
+        if (tm < t || (after && tm == t)) {
+            begin = mid + 1;
+        }
+        else {
+            end = mid;
+        }
+    }
+    return begin;
+}
+
+bool TimelineCache::readPoints(size_t level, uint64_t index, size_t count,
+    std::vector<SeriesPoint>& out) const
+{
+    out.resize(count);
+    if (!m_levels.empty()) {
+        const SeriesPoint* first = m_levels[level].data() + index;
+        std::copy(first, first + count, out.begin());
+        return true;
+    }
+    m_file.seekg(static_cast<std::streamoff>(m_directory[level].offset + index * sizeof(SeriesPoint)));
+    m_file.read(reinterpret_cast<char*>(out.data()),
+        static_cast<std::streamsize>(count * sizeof(SeriesPoint)));
+    return static_cast<bool>(m_file);
+}
+
+size_t TimelineCache::query(double t0, double t1, size_t maxPoints,
+    std::vector<SeriesPoint>& out) const
+{
+    out.clear();
+    if (m_directory.empty() || t1 < t0) {
+        return 0;
+    }
+
+    // Finest level whose slice is small enough; the coarsest one otherwise.
+    // Only the counts are needed to choose, so nothing but the chosen slice is read.
+    size_t chosen = m_directory.size() - 1;
+    uint64_t first = 0, count = 0;
+    for (size_t level = 0; level < m_directory.size(); ++level) {
+        uint64_t lo = searchTime(level, t0, false, 0);
+        uint64_t hi = searchTime(level, t1, true, lo);
+        first = lo;
+        count = hi - lo;
+        if (count <= maxPoints * kOversample) {
+            chosen = level;
+            break;
+        }
+    }
+
+    std::vector<SeriesPoint> slice;
+    if (!readPoints(chosen, first, static_cast<size_t>(count), slice)) {
+        std::cerr << "Failed to read timeline cache level " << chosen << "\n";
+        return chosen;
+    }
+    lttbDownsample(slice.data(), slice.size(), maxPoints, out);
+    return chosen;
+}
+
+bool TimelineCache::save(const std::string& path, uint64_t sourceSize, int64_t sourceMtime) const
+{
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open()) {
+        std::cerr << "Failed to open timeline cache for writing: " << path << "\n";
+        return false;
+    }
+
+    // Levels follow the directory back to back
+    uint32_t levels = static_cast<uint32_t>(m_levels.size());
+    std::vector<LevelEntry> directory;
+    uint64_t offset = kHeaderBytes + levels * sizeof(LevelEntry);
+    for (const auto& level : m_levels) {
+        directory.push_back(LevelEntry{ offset, level.size() });
+        offset += level.size() * sizeof(SeriesPoint);
+    }
+
+    ofs.write(kCacheMagic, sizeof(kCacheMagic));
+    ofs.write(reinterpret_cast<const char*>(&kCacheVersion), sizeof(kCacheVersion));
+    ofs.write(reinterpret_cast<const char*>(&sourceSize), sizeof(sourceSize));
+    ofs.write(reinterpret_cast<const char*>(&sourceMtime), sizeof(sourceMtime));
+    ofs.write(reinterpret_cast<const char*>(&levels), sizeof(levels));
+    ofs.write(reinterpret_cast<const char*>(directory.data()),
+        static_cast<std::streamsize>(directory.size() * sizeof(LevelEntry)));
+    for (const auto& level : m_levels) {
+        ofs.write(reinterpret_cast<const char*>(level.data()),
+            static_cast<std::streamsize>(level.size() * sizeof(SeriesPoint)));
+    }
+    return static_cast<bool>(ofs);
+}
+
+bool TimelineCache::load(const std::string& path, uint64_t& sourceSize, int64_t& sourceMtime)
+{
+    m_file.close();
+    m_directory.clear();
+    m_levels.clear();
+
+    m_file.open(path, std::ios::binary);
+    if (!m_file.is_open()) {
+        return false; // no cache yet; not an error
+    }
+
+    char magic[4] = {};
+    uint32_t version = 0, levels = 0;
+    m_file.read(magic, sizeof(magic));
+    m_file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    m_file.read(reinterpret_cast<char*>(&sourceSize), sizeof(sourceSize));
+    m_file.read(reinterpret_cast<char*>(&sourceMtime), sizeof(sourceMtime));
+    m_file.read(reinterpret_cast<char*>(&levels), sizeof(levels));
+    if (!m_file || std::memcmp(magic, kCacheMagic, sizeof(magic)) != 0 ||
+        version != kCacheVersion || levels == 0 || levels > kMaxLevels) {
+        std::cerr << "Ignoring unreadable timeline cache: " << path << "\n";
+        m_file.close();
+        return false;
+    }
+
+    m_directory.resize(levels);
+    m_file.read(reinterpret_cast<char*>(m_directory.data()),
+        static_cast<std::streamsize>(levels * sizeof(LevelEntry)));
+    m_file.seekg(0, std::ios::end);
+    const uint64_t fileSize = static_cast<uint64_t>(m_file.tellg());
+
+    // Every level has to lie inside the file, after the directory
+    bool valid = static_cast<bool>(m_file);
+    const uint64_t dataBegin = kHeaderBytes + levels * sizeof(LevelEntry);
+    for (const auto& entry : m_directory) {
+        if (entry.offset < dataBegin || entry.offset > fileSize ||
+            entry.count > (fileSize - entry.offset) / sizeof(SeriesPoint)) {
+            valid = false;
+        }
+    }
+    if (!valid) {
+        std::cerr << "Truncated timeline cache: " << path << "\n";
+        m_file.close();
+        m_directory.clear();
+        return false;
+    }
+    return true;
+}
+
+std::string timelineCachePath(const std::string& sessionPath, const std::string& column)
+{
+    return sessionPath + ".lttb-" + column;
+}
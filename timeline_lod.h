@@ -0,0 +1,86 @@
+// timeline_lod.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "session_event.h"
+
+//----------------------------------------------------//
+//           Numeric Timeline Columns
+//----------------------------------------------------//
+
+struct SeriesPoint
+{
+    double t; // ms, capture clock
+    double v;
+};
+
+// Builds a plottable series from a session. Columns:
+//   x, y       - cursor position at each MOUSE_POS sample
+//   speed      - cursor speed in px/s between MOUSE_POS samples
+//   clickrate  - mouse presses per second over the trailing second, every 100 ms
+//   keyrate    - key presses per second over the trailing second, every 100 ms
+// Returns false for an unknown column.
+bool extractSeries(const std::vector<SessionEvent>& events, const std::string& column,
+    std::vector<SeriesPoint>& out);
+
+//----------------------------------------------------//
+//      Largest-Triangle-Three-Buckets Downsampling
+//----------------------------------------------------//
+
+// Reduces 'count' points to 'threshold' points that keep the visual shape
+// (first and last points are always kept). Copies the input when
+// threshold >= count or threshold < 3.
+void lttbDownsample(const SeriesPoint* data, size_t count, size_t threshold,
+    std::vector<SeriesPoint>& out);
+
+//----------------------------------------------------//
+//            Multi-Level Timeline Cache
+//----------------------------------------------------//
+
+// A pyramid of LTTB reductions (each level a quarter of the previous one,
+// all computed from the raw series). A query picks the finest level that is
+// small enough for the requested range, so any zoom level costs
+// O(maxPoints) instead of O(session length). A loaded cache stays on disk:
+// the header holds a directory of level offsets and sizes, the level is
+// chosen by binary searches over the file and only its [t0, t1] slice is read.
+class TimelineCache {
+public:
+    // Builds all levels from the raw series (sorted by time)
+    void build(const std::vector<SeriesPoint>& raw);
+
+    // Points covering [t0, t1], at most 'maxPoints' of them.
+    // Returns the level that served the query (0 = raw).
+    size_t query(double t0, double t1, size_t maxPoints, std::vector<SeriesPoint>& out) const;
+
+    // Binary sidecar file, stamped with the size and modification time of
+    // the session file it was built from
+    bool save(const std::string& path, uint64_t sourceSize, int64_t sourceMtime) const;
+    bool load(const std::string& path, uint64_t& sourceSize, int64_t& sourceMtime);
+
+    size_t levelCount() const { return m_directory.size(); }
+    size_t levelSize(size_t level) const { return static_cast<size_t>(m_directory[level].count); }
+
+private:
+    struct LevelEntry
+    {
+        uint64_t offset; // byte offset of the level's first point in the file
+        uint64_t count;
+    };
+
+    double timeAt(size_t level, uint64_t index) const;
+    // First index at or after 'begin' whose time is >= t (> t if 'after')
+    uint64_t searchTime(size_t level, double t, bool after, uint64_t begin) const;
+    bool readPoints(size_t level, uint64_t index, size_t count, std::vector<SeriesPoint>& out) const;
+
+    std::vector<LevelEntry> m_directory;
+    std::vector<std::vector<SeriesPoint>> m_levels; // after build(); empty after load()
+    mutable std::ifstream m_file;                   // after load()
+};
+
+// "<session>.lttb-<column>", stored next to the session file
+std::string timelineCachePath(const std::string& sessionPath, const std::string& column);